@@ -35,6 +35,7 @@ public class Compositor : ModuleRules
 				"CameraCalibrationCore",
 				"CameraCalibrationEditor",
 				"CinematicCamera",
+				"DisplayCluster",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -52,8 +53,12 @@ public class Compositor : ModuleRules
 				"MovieSceneCapture",
 
 				"RHI",
-				"DisplayCluster",
+				"RenderCore",
+				"Renderer",
 				"MediaAssets",
+				"Media",
+				"MediaUtils",
+				"CompositorShaders",
 
 				// ... add private dependencies that you statically link with here ...	
 			}
@@ -4,6 +4,8 @@
 #include "Assets/Composite.h"
 #include "Components/BillboardComponent.h"
 #include "Subsystems/CompositorSubsystem.h"
+#include "Subsystems/CompositeMaterialPoolSubsystem.h"
+#include "Subsystems/CompositeMeshBatchSubsystem.h"
 #include "Components/SoftMaskCaptureComponent.h"
 #include "UObject/ConstructorHelpers.h"
 
@@ -94,6 +96,11 @@ ACompositeMesh::ACompositeMesh(const FObjectInitializer& ObjectInitializer)
 	bAlignNormalsWithAtmosphereLight = true;
 
 	RenderSoftMask = ERenderSoftMaskType::OpaqueWhite;
+
+	bUseInstancedRendering = false;
+	bIsInstanced = false;
+	bIsRegisteringCompositeMesh = false;
+	AppliedSettingsGeneration = 0;
 	
 #if WITH_EDITORONLY_DATA
 	SpriteComponent = CreateEditorOnlyDefaultSubobject<UBillboardComponent>(TEXT("Sprite"));
@@ -127,17 +134,10 @@ void ACompositeMesh::OnConstruction(const FTransform& Transform)
 
 	if (WorldComposite == nullptr)
 	{
-		RegisterCompositeMesh();// Also calls OnCompositeUpdate_Implementation;
-	}
-
-	if (!OpaqueMID || OpaqueMID->Parent != OpaqueMaterial ||
-		!StencilMID || StencilMID->Parent != StencilMaterial ||
-		!TranslucentMID || TranslucentMID->Parent != TranslucentMaterial ||
-		!SoftMaskTranslucentMID || SoftMaskTranslucentMID->Parent != SoftMaskTranslucentMaterial)
-	{
-		InitializeMaterialData();
+		RegisterCompositeMesh();
 	}
 
+	// Also initializes the material data, the pool hands back the current instances when nothing changed, so reconstructing does not create new ones.
 	InitializeUserProperties();
 }
 
@@ -151,91 +151,185 @@ void ACompositeMesh::PostEditChangeProperty(FPropertyChangedEvent& PropertyChang
 	// Blueprint calls it because the function is marked as the BlueprintSetter for the property.
 	// The details panel doesn't follow any of those setters so we manually call the setter just so it is in sync (i.e. if it also needs to change a material parameter based on the changed property)
 	InitializeUserProperties();
+
+	// Any of the properties can change the soft mask, which a capture schedule can not detect by itself.
+	USoftMaskCaptureComponent* SoftMaskCaptureComponent = FindSoftMaskCaptureComponent();
+	if (IsValid(SoftMaskCaptureComponent))
+	{
+		SoftMaskCaptureComponent->RequestCapture();
+	}
 }
 #endif
 
 void ACompositeMesh::BeginPlay()
 {
-	RegisterCompositeMesh();
-	InitializeMaterialData();
-	InitializeUserProperties();
-
 	Super::BeginPlay();
+
+	// After the super call, the mesh can only join the instanced batches once it has begun play.
+	BeginCompositeMeshRegistration();
 }
 
 void ACompositeMesh::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	UnregisterCompositeMesh();
 
+	if (bIsInstanced)
+	{
+		UCompositeMeshBatchSubsystem* CompositeMeshBatchSubsystem = GetWorld() ? GetWorld()->GetSubsystem<UCompositeMeshBatchSubsystem>() : nullptr;
+		if (IsValid(CompositeMeshBatchSubsystem))
+		{
+			CompositeMeshBatchSubsystem->RemoveCompositeMesh(this);
+		}
+		bIsInstanced = false;
+	bIsRegisteringCompositeMesh = false;
+	AppliedSettingsGeneration = 0;
+	}
+
+	// Destroyed does not run when a level streams out or the world is torn down, the pool would keep the holder forever.
+	// Releasing clears the instances, so the call from Destroyed does nothing afterwards.
+	ReleaseMaterialInstances();
+
 	Super::EndPlay(EndPlayReason);
 }
 
+void ACompositeMesh::Destroyed()
+{
+	ReleaseMaterialInstances();
+
+	Super::Destroyed();
+}
+
 // Is also called directly after this CompositeUpdateInterface is registered in the CompositorSubsystem.
-void ACompositeMesh::OnCompositeUpdate(UComposite& InWorldComposite)
+void ACompositeMesh::OnCompositeUpdate(UComposite& InWorldComposite, ECompositeUpdateFlags UpdateFlags)
 {
-	if (WorldComposite != &InWorldComposite)
+	const bool bWorldCompositeChanged = WorldComposite != &InWorldComposite;
+	WorldComposite = &InWorldComposite;
+
+	// Registering applies all user properties right after, and nothing the materials read changed while the settings generation stayed the same.
+	if (bIsRegisteringCompositeMesh || (!bWorldCompositeChanged && AppliedSettingsGeneration == UComposite::GetSettingsGeneration()))
 	{
-		WorldComposite = &InWorldComposite;
+		return;
 	}
 
-	// Update the receive shadows since it uses the global parameters as well.
-	SetReceiveShadowsIntensity(ReceiveShadowsIntensity);
+	// Only the receive shadows intensity of the opaque material reads the composite, the components and the batch only change with its instance.
+	UMaterialInstanceDynamic* PreviousOpaqueMID = OpaqueMID;
+	UpdateMaterialInstances();
+	if (OpaqueMID != PreviousOpaqueMID)
+	{
+		AssignMaterialsToStaticMesh();
+		UpdateInstancedRendering();
+	}
 }
 
 void ACompositeMesh::InitializeMaterialData()
 {
-	OpaqueMID = UKismetMaterialLibrary::CreateDynamicMaterialInstance(this, OpaqueMaterial, NAME_None, EMIDCreationFlags::Transient);	
-	check(OpaqueMID)	
-	OpaqueMID->InitializeScalarParameterAndGetIndex("ShadowsIntensity", ReceiveShadowsIntensity, OpaqueShadowsIntensityParameterIndex);
-	OpaqueMID->InitializeScalarParameterAndGetIndex("PlanarReflectionColorIntensity", PlanarReflectionColorIntensity, OpaquePlanarReflectionColorIntensityParameterIndex);
-	OpaqueMID->InitializeScalarParameterAndGetIndex("PlanarReflectionBackgroundOcclusion", PlanarReflectionBackgroundOcclusion, OpaquePlanarReflectionBackgroundOcclusionParameterIndex);
-	OpaqueMID->InitializeScalarParameterAndGetIndex("IsTwoSided", bIsTwoSided ? 1.F : 0.F, OpaqueTwoSidedParameterIndex);
-	OpaqueMID->InitializeScalarParameterAndGetIndex("AlignNormalsWithAtmosphereLight", bAlignNormalsWithAtmosphereLight ? 1.F : 0.F, OpaqueAlignNormalsWithAtmosphereLightParameterIndex);
-	OpaqueMID->InitializeVectorParameterAndGetIndex("RayTracedBackfaceColor", RayTracedBackfaceColor, OpaqueRayTracedBackfaceColorParameterIndex);
-	OpaqueMID->InitializeVectorParameterAndGetIndex("RayTracedOutOfFrustumColor", RayTracedOutOfFrustumColor, OpaqueRayTracedOutOfFrustumColorParameterIndex);
-	OpaqueMID->InitializeScalarParameterAndGetIndex("RenderSoftMask", 1.F, OpaqueRenderSoftMaskParameterIndex);
-
-	StencilMID = UKismetMaterialLibrary::CreateDynamicMaterialInstance(this, StencilMaterial, NAME_None, EMIDCreationFlags::Transient);
-	check(StencilMID)
-	StencilMID->InitializeScalarParameterAndGetIndex("IsTwoSided", bIsTwoSided ? 1.F : 0.F, StencilTwoSidedParameterIndex);
-
-	TranslucentMID = UKismetMaterialLibrary::CreateDynamicMaterialInstance(this, TranslucentMaterial, NAME_None, EMIDCreationFlags::Transient);
-	check(TranslucentMID)
-	TranslucentMID->InitializeScalarParameterAndGetIndex("IsTwoSided", bIsTwoSided ? 1.F : 0.F, TranslucentTwoSidedParameterIndex);
-	TranslucentMID->InitializeVectorParameterAndGetIndex("RayTracedBackfaceColor", RayTracedBackfaceColor, TranslucentRayTracedBackfaceColorParameterIndex);
-	TranslucentMID->InitializeVectorParameterAndGetIndex("RayTracedOutOfFrustumColor", RayTracedOutOfFrustumColor, TranslucentRayTracedOutOfFrustumColorParameterIndex);
-	TranslucentMID->InitializeScalarParameterAndGetIndex("BypassDepthOfField", bBypassDepthOfField ? 1.F : 0.F, TranslucentBypassDepthOfFieldParameterIndex);
-	TranslucentMID->InitializeScalarParameterAndGetIndex("RenderSoftMask", 1.F, TranslucentRenderSoftMaskParameterIndex);
-	TranslucentMID->InitializeScalarParameterAndGetIndex("RenderSoftMaskBlack", 0.F, TranslucentRenderSoftMaskBlackParameterIndex);
-
-	SoftMaskOpaqueMID = UKismetMaterialLibrary::CreateDynamicMaterialInstance(this, SoftMaskOpaqueMaterial, NAME_None, EMIDCreationFlags::Transient);
-	check(SoftMaskOpaqueMID)
-	SoftMaskOpaqueMID->InitializeScalarParameterAndGetIndex("IsTwoSided", bIsTwoSided ? 1.F : 0.F, SoftMaskOpaqueTwoSidedParameterIndex);
-	SoftMaskOpaqueMID->InitializeScalarParameterAndGetIndex("CustomValue", 1.F, SoftMaskOpaqueCustomValueParameterIndex);
-	SoftMaskOpaqueMID->InitializeScalarParameterAndGetIndex("RenderVertexColor", 1.F, SoftMaskOpaqueRenderVertexColorParameterIndex);
-
-	SoftMaskTranslucentMID = UKismetMaterialLibrary::CreateDynamicMaterialInstance(this, SoftMaskTranslucentMaterial, NAME_None, EMIDCreationFlags::Transient);
-	check(SoftMaskTranslucentMID)
-	SoftMaskTranslucentMID->InitializeScalarParameterAndGetIndex("IsTwoSided", bIsTwoSided ? 1.F : 0.F, SoftMaskTranslucentTwoSidedParameterIndex);
-
+	UpdateMaterialInstances();
 	AssignMaterialsToStaticMesh();
 }
 
+void ACompositeMesh::UpdateMaterialInstances()
+{
+	AppliedSettingsGeneration = UComposite::GetSettingsGeneration();
+
+	const float IsTwoSidedFloat = bIsTwoSided ? 1.F : 0.F;
+
+	FCompositeMaterialParameters OpaqueParameters;
+	OpaqueParameters.AddScalarParameter("ShadowsIntensity", GetAppliedReceiveShadowsIntensity());
+	OpaqueParameters.AddScalarParameter("PlanarReflectionColorIntensity", PlanarReflectionColorIntensity);
+	OpaqueParameters.AddScalarParameter("PlanarReflectionBackgroundOcclusion", PlanarReflectionBackgroundOcclusion);
+	OpaqueParameters.AddScalarParameter("IsTwoSided", IsTwoSidedFloat);
+	OpaqueParameters.AddScalarParameter("AlignNormalsWithAtmosphereLight", bAlignNormalsWithAtmosphereLight ? 1.F : 0.F);
+	OpaqueParameters.AddScalarParameter("RenderSoftMask", 1.F);
+	OpaqueParameters.AddVectorParameter("RayTracedBackfaceColor", RayTracedBackfaceColor);
+	OpaqueParameters.AddVectorParameter("RayTracedOutOfFrustumColor", RayTracedOutOfFrustumColor);
+
+	FCompositeMaterialParameters StencilParameters;
+	StencilParameters.AddScalarParameter("IsTwoSided", IsTwoSidedFloat);
+
+	FCompositeMaterialParameters TranslucentParameters;
+	TranslucentParameters.AddScalarParameter("IsTwoSided", IsTwoSidedFloat);
+	TranslucentParameters.AddScalarParameter("BypassDepthOfField", bBypassDepthOfField ? 1.F : 0.F);
+	TranslucentParameters.AddScalarParameter("RenderSoftMask", 1.F);
+	TranslucentParameters.AddScalarParameter("RenderSoftMaskBlack", RenderSoftMask == ERenderSoftMaskType::OpaqueBlack ? 1.F : 0.F);
+	TranslucentParameters.AddVectorParameter("RayTracedBackfaceColor", RayTracedBackfaceColor);
+	TranslucentParameters.AddVectorParameter("RayTracedOutOfFrustumColor", RayTracedOutOfFrustumColor);
+
+	FCompositeMaterialParameters SoftMaskOpaqueParameters;
+	SoftMaskOpaqueParameters.AddScalarParameter("IsTwoSided", IsTwoSidedFloat);
+	SoftMaskOpaqueParameters.AddScalarParameter("CustomValue", RenderSoftMask == ERenderSoftMaskType::OpaqueWhite ? 1.F : 0.F);
+	SoftMaskOpaqueParameters.AddScalarParameter("RenderVertexColor", RenderSoftMask == ERenderSoftMaskType::OpaqueVertexColorAlpha ? 1.F : 0.F);
+
+	FCompositeMaterialParameters SoftMaskTranslucentParameters;
+	SoftMaskTranslucentParameters.AddScalarParameter("IsTwoSided", IsTwoSidedFloat);
+
+	const UWorld* World = GetWorld();
+	UCompositeMaterialPoolSubsystem* MaterialPoolSubsystem = IsValid(World) ? World->GetSubsystem<UCompositeMaterialPoolSubsystem>() : nullptr;
+
+	auto UpdateInstance = [this, MaterialPoolSubsystem](UMaterialInstanceDynamic*& MID, UMaterialInterface* Parent, const FCompositeMaterialParameters& Parameters)
+	{
+		if (IsValid(MaterialPoolSubsystem))
+		{
+			MID = MaterialPoolSubsystem->UpdateInstance(this, MID, Parent, Parameters);
+			return;
+		}
+
+		// Without a world there is nothing to share with, keep an instance of our own.
+		if (!MID || MID->Parent != Parent)
+		{
+			MID = UKismetMaterialLibrary::CreateDynamicMaterialInstance(this, Parent, NAME_None, EMIDCreationFlags::Transient);
+		}
+		if (MID)
+		{
+			Parameters.ApplyTo(MID);
+		}
+	};
+
+	UpdateInstance(OpaqueMID, OpaqueMaterial, OpaqueParameters);
+	UpdateInstance(StencilMID, StencilMaterial, StencilParameters);
+	UpdateInstance(TranslucentMID, TranslucentMaterial, TranslucentParameters);
+	UpdateInstance(SoftMaskOpaqueMID, SoftMaskOpaqueMaterial, SoftMaskOpaqueParameters);
+	UpdateInstance(SoftMaskTranslucentMID, SoftMaskTranslucentMaterial, SoftMaskTranslucentParameters);
+}
+
+void ACompositeMesh::ReleaseMaterialInstances()
+{
+	const UWorld* World = GetWorld();
+	UCompositeMaterialPoolSubsystem* MaterialPoolSubsystem = IsValid(World) ? World->GetSubsystem<UCompositeMaterialPoolSubsystem>() : nullptr;
+	if (IsValid(MaterialPoolSubsystem))
+	{
+		for (UMaterialInstanceDynamic* MID : { OpaqueMID, StencilMID, TranslucentMID, SoftMaskOpaqueMID, SoftMaskTranslucentMID })
+		{
+			MaterialPoolSubsystem->ReleaseInstance(this, MID);
+		}
+	}
+
+	OpaqueMID = nullptr;
+	StencilMID = nullptr;
+	TranslucentMID = nullptr;
+	SoftMaskOpaqueMID = nullptr;
+	SoftMaskTranslucentMID = nullptr;
+}
+
 void ACompositeMesh::InitializeUserProperties()
 {
-	SetStaticMesh(StaticMesh);
-	SetBypassDepthOfField(bBypassDepthOfField);
-	SetLightingChannels(LightingChannels.bChannel0, LightingChannels.bChannel1, LightingChannels.bChannel2);
-	SetCastShadows(bCastShadows);
-	SetAffectDistanceFieldLighting(bAffectDistanceFieldLighting);
-	SetReceiveShadowsIntensity(ReceiveShadowsIntensity);
-	SetPlanarReflectionColorIntensity(PlanarReflectionColorIntensity);
-	SetPlanarReflectionBackgroundOcclusion(PlanarReflectionBackgroundOcclusion);
-	SetIsTwoSided(bIsTwoSided);
-	SetRenderSoftMask(RenderSoftMask);
-	SetRayTracedBackfaceColor(RayTracedBackfaceColor);
-	SetRayTracedOutOfFrustumColor(RayTracedOutOfFrustumColor);
-	SetAlignNormalsWithAtmosphereLight(bAlignNormalsWithAtmosphereLight);
+	// Applied in one pass instead of through the setters, each of them updates the material instances and the instanced batch on its own.
+	// The soft mask capture picks up the soft mask component when the mesh registers, batched for queued registrations.
+	if (AreAllComponentsValid())
+	{
+		UpdateComponentStaticMeshes();
+
+		OpaqueComponent->SetLightingChannels(LightingChannels.bChannel0, LightingChannels.bChannel1, LightingChannels.bChannel2);
+		TranslucentComponent->SetLightingChannels(LightingChannels.bChannel0, LightingChannels.bChannel1, LightingChannels.bChannel2);
+		OpaqueComponent->SetCastShadow(bCastShadows);
+		OpaqueComponent->bAffectDistanceFieldLighting = bAffectDistanceFieldLighting;
+
+		UpdateComponentVisibility();
+	}
+
+	InitializeMaterialData();
+	UpdateStencilValues();
+
+	UpdateInstancedRendering();
 }
 
 void ACompositeMesh::RegisterCompositeMesh()
@@ -246,11 +340,37 @@ void ACompositeMesh::RegisterCompositeMesh()
 		UCompositorSubsystem* CompositorSubsystem = World->GetSubsystem<UCompositorSubsystem>();
 		if (IsValid(CompositorSubsystem))
 		{
+			TGuardValue<bool> RegisteringGuard(bIsRegisteringCompositeMesh, true);
 			CompositorSubsystem->RegisterCompositeUpdateInterface(this);
 		}
 	}
 }
 
+void ACompositeMesh::BeginCompositeMeshRegistration()
+{
+	const UWorld* World = GetWorld();
+	UCompositorSubsystem* CompositorSubsystem = IsValid(World) ? World->GetSubsystem<UCompositorSubsystem>() : nullptr;
+	if (IsValid(CompositorSubsystem) && CompositorSubsystem->QueueCompositeMeshRegistration(this))
+	{
+		// The material instances are transient, a loaded mesh would show its plain static mesh materials until the queue gets to it.
+		if (AreAllComponentsValid())
+		{
+			OpaqueComponent->SetVisibility(false);
+			TranslucentComponent->SetVisibility(false);
+			StencilComponent->SetVisibility(false);
+		}
+		return;
+	}
+
+	FinishCompositeMeshRegistration();
+}
+
+void ACompositeMesh::FinishCompositeMeshRegistration()
+{
+	RegisterCompositeMesh();
+	InitializeUserProperties();
+}
+
 void ACompositeMesh::UnregisterCompositeMesh()
 {
 	// Unregister Composite Mesh from the compositor subsystem.
@@ -306,10 +426,64 @@ void ACompositeMesh::UpdateStencilValues()
 	}
 }
 
+void ACompositeMesh::UpdateInstancedRendering()
+{
+	const UWorld* World = GetWorld();
+	UCompositeMeshBatchSubsystem* CompositeMeshBatchSubsystem = IsValid(World) ? World->GetSubsystem<UCompositeMeshBatchSubsystem>() : nullptr;
+
+	const bool bShouldBeInstanced = bUseInstancedRendering && HasActorBegunPlay() && IsValid(CompositeMeshBatchSubsystem) && AreAllComponentsValid();
+	if (bShouldBeInstanced == bIsInstanced)
+	{
+		if (bIsInstanced)
+		{
+			CompositeMeshBatchSubsystem->UpdateCompositeMesh(this);
+		}
+		return;
+	}
+
+	bIsInstanced = bShouldBeInstanced;
+
+	// Unregistered components don't have a scene proxy, so they don't cost any draw calls while the batch renders the mesh.
+	for (UStaticMeshComponent* Component : { OpaqueComponent, StencilComponent, TranslucentComponent, SoftMaskComponent })
+	{
+		if (bIsInstanced && Component->IsRegistered())
+		{
+			Component->UnregisterComponent();
+		}
+		else if (!bIsInstanced && !Component->IsRegistered())
+		{
+			Component->RegisterComponent();
+		}
+	}
+
+	if (bIsInstanced)
+	{
+		CompositeMeshBatchSubsystem->AddCompositeMesh(this);
+	}
+	else if (IsValid(CompositeMeshBatchSubsystem))
+	{
+		CompositeMeshBatchSubsystem->RemoveCompositeMesh(this);
+	}
+}
+
+void ACompositeMesh::SetUseInstancedRendering(const bool bNewUseInstancedRendering)
+{
+	bUseInstancedRendering = bNewUseInstancedRendering;
+	UpdateInstancedRendering();
+}
+
 void ACompositeMesh::SetStaticMesh(UStaticMesh* NewStaticMesh)
 {
 	StaticMesh = NewStaticMesh;
+	UpdateComponentStaticMeshes();
+
+	AssignMaterialsToStaticMesh();
 
+	UpdateInstancedRendering();
+}
+
+void ACompositeMesh::UpdateComponentStaticMeshes()
+{
 	if (IsValid(OpaqueComponent) && OpaqueComponent->GetStaticMesh() != StaticMesh)
 	{
 		OpaqueComponent->SetStaticMesh(StaticMesh);
@@ -329,156 +503,150 @@ void ACompositeMesh::SetStaticMesh(UStaticMesh* NewStaticMesh)
 	{
 		SoftMaskComponent->SetStaticMesh(StaticMesh);
 	}
-
-	AssignMaterialsToStaticMesh();
 }
 
 void ACompositeMesh::SetBypassDepthOfField(const bool bNewBypassDepthOfField)
 {
 	bBypassDepthOfField = bNewBypassDepthOfField;
-	TranslucentMID->SetScalarParameterByIndex(TranslucentBypassDepthOfFieldParameterIndex, bBypassDepthOfField);
+	InitializeMaterialData();
 	UpdateStencilValues();
+
+	UpdateInstancedRendering();
 }
 
 void ACompositeMesh::SetLightingChannels(const bool bChannel0, const bool bChannel1, const bool bChannel2)
 {
 	OpaqueComponent->SetLightingChannels(bChannel0, bChannel1, bChannel2);
 	TranslucentComponent->SetLightingChannels(bChannel0, bChannel1, bChannel2);
+
+	UpdateInstancedRendering();
 }
 
 void ACompositeMesh::SetCastShadows(const bool bNewCastShadows)
 {
 	bCastShadows = bNewCastShadows;
 	OpaqueComponent->SetCastShadow(bCastShadows);
+
+	UpdateInstancedRendering();
 }
 
 void ACompositeMesh::SetAffectDistanceFieldLighting(const bool bNewAffectDistanceFieldLighting)
 {
 	bAffectDistanceFieldLighting = bNewAffectDistanceFieldLighting;
 	OpaqueComponent->bAffectDistanceFieldLighting = bAffectDistanceFieldLighting;
+
+	UpdateInstancedRendering();
 }
 
 void ACompositeMesh::SetReceiveShadowsIntensity(const float NewReceiveShadowsIntensity)
 {
-	if (IsValid(OpaqueMID) && IsValid(WorldComposite))
-	{
-		ReceiveShadowsIntensity = NewReceiveShadowsIntensity;
+	ReceiveShadowsIntensity = NewReceiveShadowsIntensity;
+	InitializeMaterialData();
 
-		const float ShadowIntensityMaterial = ReceiveShadowsIntensity * (WorldComposite->GetEnableMediaShadows() ? 1.F : 0.F);
-		OpaqueMID->SetScalarParameterByIndex(OpaqueShadowsIntensityParameterIndex, ShadowIntensityMaterial);
-	}
+	UpdateInstancedRendering();
 }
 
-void ACompositeMesh::SetPlanarReflectionColorIntensity(const float NewPlanarReflectionColorIntensity)
+float ACompositeMesh::GetAppliedReceiveShadowsIntensity() const
 {
-	if (IsValid(OpaqueMID))
+	if (IsValid(WorldComposite))
 	{
-		PlanarReflectionColorIntensity = NewPlanarReflectionColorIntensity;
-		OpaqueMID->SetScalarParameterByIndex(OpaquePlanarReflectionColorIntensityParameterIndex, PlanarReflectionColorIntensity);
+		return ReceiveShadowsIntensity * (WorldComposite->GetResolvedSettings().bEnableMediaShadows ? 1.F : 0.F);
 	}
+
+	return ReceiveShadowsIntensity;
+}
+
+void ACompositeMesh::SetPlanarReflectionColorIntensity(const float NewPlanarReflectionColorIntensity)
+{
+	PlanarReflectionColorIntensity = NewPlanarReflectionColorIntensity;
+	InitializeMaterialData();
+
+	UpdateInstancedRendering();
 }
 
 void ACompositeMesh::SetPlanarReflectionBackgroundOcclusion(const float NewPlanarReflectionBackgroundOcclusion)
 {
-	if (IsValid(OpaqueMID))
-	{
-		PlanarReflectionBackgroundOcclusion = NewPlanarReflectionBackgroundOcclusion;
-		OpaqueMID->SetScalarParameterByIndex(OpaquePlanarReflectionBackgroundOcclusionParameterIndex, PlanarReflectionBackgroundOcclusion);
-	}
+	PlanarReflectionBackgroundOcclusion = NewPlanarReflectionBackgroundOcclusion;
+	InitializeMaterialData();
+
+	UpdateInstancedRendering();
 }
 
 void ACompositeMesh::SetIsTwoSided(const bool bNewIsTwoSided)
 {
-	if (IsValid(OpaqueMID) && IsValid(StencilMID) && IsValid(TranslucentMID) && IsValid(SoftMaskOpaqueMID) && IsValid(SoftMaskTranslucentMID))
-	{
-		bIsTwoSided = bNewIsTwoSided;
-		const float IsTwoSidedFloat = bIsTwoSided ? 1.F : 0.F;
-		
-		OpaqueMID->SetScalarParameterByIndex(OpaqueTwoSidedParameterIndex, IsTwoSidedFloat);
-		StencilMID->SetScalarParameterByIndex(StencilTwoSidedParameterIndex, IsTwoSidedFloat);
-		TranslucentMID->SetScalarParameterByIndex(TranslucentTwoSidedParameterIndex, IsTwoSidedFloat);
-		SoftMaskOpaqueMID->SetScalarParameterByIndex(SoftMaskOpaqueTwoSidedParameterIndex, IsTwoSidedFloat);
-		SoftMaskTranslucentMID->SetScalarParameterByIndex(SoftMaskTranslucentTwoSidedParameterIndex, IsTwoSidedFloat);
-	}
+	bIsTwoSided = bNewIsTwoSided;
+	InitializeMaterialData();
+
+	UpdateInstancedRendering();
 }
 
 void ACompositeMesh::SetAlignNormalsWithAtmosphereLight(const bool bNewAlignNormalsWithAtmosphereLight)
 {
-	if (IsValid(OpaqueMID))
-	{
-		bAlignNormalsWithAtmosphereLight = bNewAlignNormalsWithAtmosphereLight;
+	bAlignNormalsWithAtmosphereLight = bNewAlignNormalsWithAtmosphereLight;
+	InitializeMaterialData();
 
-		OpaqueMID->SetScalarParameterByIndex(OpaqueAlignNormalsWithAtmosphereLightParameterIndex, bAlignNormalsWithAtmosphereLight ? 1.F : 0.F);
-	}
+	UpdateInstancedRendering();
 }
 
 void ACompositeMesh::SetRayTracedBackfaceColor(const FLinearColor NewRayTracedBackfaceColor)
 {
-	if (IsValid(OpaqueMID) && IsValid(TranslucentMID))
-	{
-		RayTracedBackfaceColor = NewRayTracedBackfaceColor;
+	RayTracedBackfaceColor = NewRayTracedBackfaceColor;
+	InitializeMaterialData();
 
-		OpaqueMID->SetVectorParameterByIndex(OpaqueRayTracedBackfaceColorParameterIndex, RayTracedBackfaceColor);
-		TranslucentMID->SetVectorParameterByIndex(TranslucentRayTracedBackfaceColorParameterIndex, RayTracedBackfaceColor);
-	}
+	UpdateInstancedRendering();
 }
 
 void ACompositeMesh::SetRayTracedOutOfFrustumColor(const FLinearColor NewRayTracedOutOfFrustumColor)
 {
-	if (IsValid(OpaqueMID) && IsValid(TranslucentMID))
-	{
-		RayTracedOutOfFrustumColor = NewRayTracedOutOfFrustumColor;
+	RayTracedOutOfFrustumColor = NewRayTracedOutOfFrustumColor;
+	InitializeMaterialData();
 
-		OpaqueMID->SetVectorParameterByIndex(OpaqueRayTracedOutOfFrustumColorParameterIndex, RayTracedOutOfFrustumColor);
-		TranslucentMID->SetVectorParameterByIndex(TranslucentRayTracedOutOfFrustumColorParameterIndex, RayTracedOutOfFrustumColor);
-	}
+	UpdateInstancedRendering();
 }
 
 void ACompositeMesh::SetRenderSoftMask(const ERenderSoftMaskType NewRenderSoftMaskType)
 {
 	RenderSoftMask = NewRenderSoftMaskType;
-	const float RenderSoftMaskAsFloat = 1.F;
-	const bool bRenderOpaqueBlackSoftMask = RenderSoftMask == ERenderSoftMaskType::OpaqueBlack;
 
-	if (IsValid(OpaqueMID))
-	{
-		OpaqueMID->SetScalarParameterByIndex(OpaqueRenderSoftMaskParameterIndex, RenderSoftMaskAsFloat);
-		SoftMaskOpaqueMID->SetScalarParameterByIndex(SoftMaskOpaqueCustomValueParameterIndex, RenderSoftMask == ERenderSoftMaskType::OpaqueWhite ? 1.F : 0.F);
-		SoftMaskOpaqueMID->SetScalarParameterByIndex(SoftMaskOpaqueRenderVertexColorParameterIndex, RenderSoftMask == ERenderSoftMaskType::OpaqueVertexColorAlpha ? 1.F : 0.F);
-	}
+	InitializeMaterialData();
 
-	if (IsValid(TranslucentMID))
+	USoftMaskCaptureComponent* SoftMaskCaptureComponent = FindSoftMaskCaptureComponent();
+	if (IsValid(SoftMaskCaptureComponent))
 	{
-		TranslucentMID->SetScalarParameterByIndex(TranslucentRenderSoftMaskParameterIndex, RenderSoftMaskAsFloat);
-		TranslucentMID->SetScalarParameterByIndex(TranslucentRenderSoftMaskBlackParameterIndex, bRenderOpaqueBlackSoftMask);
-	}
+		//if (RenderSoftMask != ERenderSoftMaskType::Off)
+		//{
+			SoftMaskCaptureComponent->ShowOnlyComponent(SoftMaskComponent);
+		//}
+		//else
+		//{
+		//	SoftMaskCaptureComponent->RemoveShowOnlyComponent(SoftMaskComponent);
+		//}
 
-	const UWorld* World = GetWorld();
-	if (IsValid(World))
-	{
-		const UCompositorSubsystem* CompositorSubsystem = World->GetSubsystem<UCompositorSubsystem>(World);
-		if (IsValid(CompositorSubsystem))
-		{
-			USoftMaskCaptureComponent* SoftMaskCaptureComponent = CompositorSubsystem->GetSoftMaskCaptureComponent();
-			if (IsValid(SoftMaskCaptureComponent))
-			{
-				//if (RenderSoftMask != ERenderSoftMaskType::Off)
-				//{
-					SoftMaskCaptureComponent->ShowOnlyComponent(SoftMaskComponent);
-				//}
-				//else
-				//{
-				//	SoftMaskCaptureComponent->RemoveShowOnlyComponent(SoftMaskComponent);
-				//}
-			}
-		}
+		// The soft mask value might have changed, which a capture schedule can not detect by itself.
+		SoftMaskCaptureComponent->RequestCapture();
 	}
 
+	UpdateComponentVisibility();
+	
+	UpdateStencilValues();
+
+	UpdateInstancedRendering();
+}
+
+void ACompositeMesh::UpdateComponentVisibility()
+{
+	const bool bRenderOpaqueBlackSoftMask = RenderSoftMask == ERenderSoftMaskType::OpaqueBlack;
+
 	OpaqueComponent->SetVisibility(!bRenderOpaqueBlackSoftMask);
 	TranslucentComponent->SetVisibility(true);
 	StencilComponent->SetVisibility(!bRenderOpaqueBlackSoftMask);
-	
-	UpdateStencilValues();
+}
+
+USoftMaskCaptureComponent* ACompositeMesh::FindSoftMaskCaptureComponent() const
+{
+	const UWorld* World = GetWorld();
+	const UCompositorSubsystem* CompositorSubsystem = IsValid(World) ? World->GetSubsystem<UCompositorSubsystem>() : nullptr;
+	return IsValid(CompositorSubsystem) ? CompositorSubsystem->GetSoftMaskCaptureComponent() : nullptr;
 }
 
 bool ACompositeMesh::AreAllComponentsValid() const
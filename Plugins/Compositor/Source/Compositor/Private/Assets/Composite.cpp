@@ -8,8 +8,13 @@
 #include "Objects/CompositeColorGrade.h"
 #include "Components/CompositePlanarReflectionComponent.h"
 
+// Starts at 1 so a newly created Composite (generation 0) always resolves its settings on first use.
+uint32 UComposite::SettingsGeneration = 1;
+
 UComposite::UComposite()
 {
+    ResolvedSettingsGeneration = 0;
+
     bEnableMediaShadows = true;
     ShadowsBlackLevel = 0.F;
     ShadowsWhiteLevel = 1.F;
@@ -17,6 +22,7 @@ UComposite::UComposite()
     ShadowsTint = FLinearColor(0.F, 0.F, 0.F, 0.F);
 
     SoftMaskScreenPercentage = 25.F;
+    SoftMaskCaptureResolution = ESoftMaskCaptureResolution::Full;
     PlanarReflectionColor = FLinearColor(1.F, 1.F, 1.F, 0.F);
     PlanarReflectionScreenPercentage = 50.F;
     MediaBlend = EMediaBlend::PostToneCurve;
@@ -40,6 +46,7 @@ UComposite* UComposite::GetParentComposite() const
 void UComposite::SetParentComposite(UComposite* NewParentComposite)
 {
     ParentComposite = NewParentComposite;
+    MarkSettingsDirty();
 }
 
 UTexture* UComposite::GetMediaInputTexture() const
@@ -60,6 +67,7 @@ UTexture* UComposite::GetMediaInputTexture() const
 void UComposite::SetMediaInputTexture(UTexture* NewMediaInputTexture)
 {
     MediaInputTexture = NewMediaInputTexture;
+    MarkSettingsDirty();
 }
 
 bool UComposite::GetEnableSoftMask() const
@@ -81,6 +89,7 @@ bool UComposite::GetEnableSoftMask() const
 void UComposite::SetEnableSoftMask(bool bNewEnableSoftMask)
 {
     bEnableSoftMask = bNewEnableSoftMask;
+    MarkSettingsDirty();
 }
 
 float UComposite::GetSoftMaskScreenPercentage() const
@@ -101,6 +110,49 @@ float UComposite::GetSoftMaskScreenPercentage() const
 void UComposite::SetSoftMaskScreenPercentage(float NewSoftMaskScreenPercentage)
 {
     SoftMaskScreenPercentage = NewSoftMaskScreenPercentage;
+    MarkSettingsDirty();
+}
+
+FCompositeCaptureSchedule UComposite::GetSoftMaskCaptureSchedule() const
+{
+    if (bOverride_SoftMaskCaptureSchedule)
+    {
+        return SoftMaskCaptureSchedule;
+    }
+
+    if (ParentComposite)
+    {
+        return ParentComposite->GetSoftMaskCaptureSchedule();
+    }
+
+    return CompositeClassDefaults->SoftMaskCaptureSchedule;
+}
+
+void UComposite::SetSoftMaskCaptureSchedule(const FCompositeCaptureSchedule& NewSoftMaskCaptureSchedule)
+{
+    SoftMaskCaptureSchedule = NewSoftMaskCaptureSchedule;
+    MarkSettingsDirty();
+}
+
+ESoftMaskCaptureResolution UComposite::GetSoftMaskCaptureResolution() const
+{
+    if (bOverride_SoftMaskCaptureResolution)
+    {
+        return SoftMaskCaptureResolution;
+    }
+
+    if (ParentComposite)
+    {
+        return ParentComposite->GetSoftMaskCaptureResolution();
+    }
+
+    return CompositeClassDefaults->SoftMaskCaptureResolution;
+}
+
+void UComposite::SetSoftMaskCaptureResolution(ESoftMaskCaptureResolution NewSoftMaskCaptureResolution)
+{
+    SoftMaskCaptureResolution = NewSoftMaskCaptureResolution;
+    MarkSettingsDirty();
 }
 
 UCompositeKeyer* UComposite::GetMediaInputKeyer() const
@@ -121,6 +173,7 @@ UCompositeKeyer* UComposite::GetMediaInputKeyer() const
 void UComposite::SetMediaInputKeyer(UCompositeKeyer* NewMediaInputCompositeKeyer)
 {
     MediaInputKeyer = NewMediaInputCompositeKeyer;
+    MarkSettingsDirty();
 }
 
 bool UComposite::GetEnableMediaShadows() const
@@ -141,6 +194,7 @@ bool UComposite::GetEnableMediaShadows() const
 void UComposite::SetEnableMediaShadows(bool bNewEnableMediaShadows)
 {
     bEnableMediaShadows = bNewEnableMediaShadows;
+    MarkSettingsDirty();
 }
 
 float UComposite::GetShadowsOffset() const
@@ -161,6 +215,7 @@ float UComposite::GetShadowsOffset() const
 void UComposite::SetShadowsOffset(float NewShadowsOffset)
 {
     ShadowsOffset = NewShadowsOffset;
+    MarkSettingsDirty();
 }
 
 float UComposite::GetShadowsBlackLevel() const
@@ -181,6 +236,7 @@ float UComposite::GetShadowsBlackLevel() const
 void UComposite::SetShadowsBlackLevel(float NewShadowsBlackLevel)
 {
     ShadowsBlackLevel = NewShadowsBlackLevel;
+    MarkSettingsDirty();
 }
 
 float UComposite::GetShadowsWhiteLevel() const
@@ -201,6 +257,7 @@ float UComposite::GetShadowsWhiteLevel() const
 void UComposite::SetShadowsWhiteLevel(float NewShadowsWhiteLevel)
 {
     ShadowsWhiteLevel = NewShadowsWhiteLevel;
+    MarkSettingsDirty();
 }
 
 float UComposite::GetShadowsGamma() const
@@ -221,6 +278,7 @@ float UComposite::GetShadowsGamma() const
 void UComposite::SetShadowsGamma(float NewShadowsGamma)
 {
     ShadowsGamma = NewShadowsGamma;
+    MarkSettingsDirty();
 }
 
 FLinearColor UComposite::GetShadowsTint() const
@@ -241,6 +299,7 @@ FLinearColor UComposite::GetShadowsTint() const
 void UComposite::SetShadowsTint(FLinearColor NewShadowsTint)
 {
     ShadowsTint = NewShadowsTint;
+    MarkSettingsDirty();
 }
 
 bool UComposite::GetEnablePlanarReflection() const
@@ -261,6 +320,7 @@ bool UComposite::GetEnablePlanarReflection() const
 void UComposite::SetEnablePlanarReflection(bool bNewEnablePlanarReflection)
 {
     bEnablePlanarReflection = bNewEnablePlanarReflection;
+    MarkSettingsDirty();
 }
 
 FLinearColor UComposite::GetPlanarReflectionColor() const
@@ -281,6 +341,7 @@ FLinearColor UComposite::GetPlanarReflectionColor() const
 void UComposite::SetPlanarReflectionColor(FLinearColor NewPlanarReflectionColor)
 {
     PlanarReflectionColor = NewPlanarReflectionColor;
+    MarkSettingsDirty();
 }
 
 float UComposite::GetPlanarReflectionDistortionIntensity() const
@@ -301,6 +362,7 @@ float UComposite::GetPlanarReflectionDistortionIntensity() const
 void UComposite::SetPlanarReflectionDistortionIntensity(float NewPlanarReflectionDistortionIntensity)
 {
     PlanarReflectionDistortionIntensity = NewPlanarReflectionDistortionIntensity;
+    MarkSettingsDirty();
 }
 
 float UComposite::GetPlanarReflectionDistortionOffset() const
@@ -321,6 +383,7 @@ float UComposite::GetPlanarReflectionDistortionOffset() const
 void UComposite::SetPlanarReflectionDistortionOffset(float NewPlanarReflectionDistortionOffset)
 {
     PlanarReflectionDistortionOffset = NewPlanarReflectionDistortionOffset;
+    MarkSettingsDirty();
 }
 
 float UComposite::GetPlanarReflectionScreenPercentage() const
@@ -341,6 +404,28 @@ float UComposite::GetPlanarReflectionScreenPercentage() const
 void UComposite::SetPlanarReflectionScreenPercentage(float NewPlanarReflectionScreenPercentage)
 {
     PlanarReflectionScreenPercentage = NewPlanarReflectionScreenPercentage;
+    MarkSettingsDirty();
+}
+
+FCompositeCaptureSchedule UComposite::GetPlanarReflectionCaptureSchedule() const
+{
+    if (bOverride_PlanarReflectionCaptureSchedule)
+    {
+        return PlanarReflectionCaptureSchedule;
+    }
+
+    if (ParentComposite)
+    {
+        return ParentComposite->GetPlanarReflectionCaptureSchedule();
+    }
+
+    return CompositeClassDefaults->PlanarReflectionCaptureSchedule;
+}
+
+void UComposite::SetPlanarReflectionCaptureSchedule(const FCompositeCaptureSchedule& NewPlanarReflectionCaptureSchedule)
+{
+    PlanarReflectionCaptureSchedule = NewPlanarReflectionCaptureSchedule;
+    MarkSettingsDirty();
 }
 
 UCompositeColorGrade* UComposite::GetCompositeColorGrade() const
@@ -366,6 +451,7 @@ EMediaBlend UComposite::GetMediaBlend() const
 void UComposite::SetMediaBlend(EMediaBlend bNewMediaBlend)
 {
     MediaBlend = bNewMediaBlend;
+    MarkSettingsDirty();
 }
 
 float UComposite::GetBrightnessMaskGamma() const
@@ -386,6 +472,7 @@ float UComposite::GetBrightnessMaskGamma() const
 void UComposite::SetBrightnessMaskGamma(float NewBrightnessMaskGamma)
 {
     BrightnessMaskGamma = NewBrightnessMaskGamma;
+    MarkSettingsDirty();
 }
 
 bool UComposite::GetApplyInverseToneCurve() const
@@ -406,6 +493,7 @@ bool UComposite::GetApplyInverseToneCurve() const
 void UComposite::SetApplyInverseToneCurve(bool bNewApplyInverseToneCurve)
 {
     bApplyInverseToneCurve = bNewApplyInverseToneCurve;
+    MarkSettingsDirty();
 }
 
 EOutputRgbEncoding UComposite::GetOutputRgbEncoding() const
@@ -426,6 +514,7 @@ EOutputRgbEncoding UComposite::GetOutputRgbEncoding() const
 void UComposite::SetOutputRgbEncoding(EOutputRgbEncoding NewOutputRgbEncoding)
 {
     OutputRgbEncoding = NewOutputRgbEncoding;
+    MarkSettingsDirty();
 }
 
 EOutputAlpha UComposite::GetOutputAlpha() const
@@ -446,6 +535,7 @@ EOutputAlpha UComposite::GetOutputAlpha() const
 void UComposite::SetOutputAlpha(EOutputAlpha NewOutputAlpha)
 {
     OutputAlpha = NewOutputAlpha;
+    MarkSettingsDirty();
 }
 
 bool UComposite::IsThisCompositeAnAncestorOf(UComposite* PossibleDescendant) const
@@ -470,11 +560,125 @@ bool UComposite::IsKeyerEnabled() const
     return CurrentKeyer != nullptr && CurrentKeyer->GetIsKeyerEnabled();
 }
 
+const FResolvedCompositeSettings& UComposite::GetResolvedSettings() const
+{
+    if (ResolvedSettingsOverride.IsSet())
+    {
+        return ResolvedSettingsOverride.GetValue();
+    }
+
+    if (ResolvedSettingsGeneration != SettingsGeneration)
+    {
+        ResolvedSettings.MediaInputTexture = GetMediaInputTexture();
+        ResolvedSettings.MediaInputKeyer = GetMediaInputKeyer();
+
+        ResolvedSettings.bEnableSoftMask = GetEnableSoftMask();
+        ResolvedSettings.SoftMaskScreenPercentage = GetSoftMaskScreenPercentage();
+        ResolvedSettings.SoftMaskCaptureSchedule = GetSoftMaskCaptureSchedule();
+        ResolvedSettings.SoftMaskCaptureResolution = GetSoftMaskCaptureResolution();
+
+        ResolvedSettings.bEnableMediaShadows = GetEnableMediaShadows();
+        ResolvedSettings.ShadowsOffset = GetShadowsOffset();
+        ResolvedSettings.ShadowsBlackLevel = GetShadowsBlackLevel();
+        ResolvedSettings.ShadowsWhiteLevel = GetShadowsWhiteLevel();
+        ResolvedSettings.ShadowsGamma = GetShadowsGamma();
+        ResolvedSettings.ShadowsTint = GetShadowsTint();
+
+        ResolvedSettings.bEnablePlanarReflection = GetEnablePlanarReflection();
+        ResolvedSettings.PlanarReflectionColor = GetPlanarReflectionColor();
+        ResolvedSettings.PlanarReflectionDistortionIntensity = GetPlanarReflectionDistortionIntensity();
+        ResolvedSettings.PlanarReflectionDistortionOffset = GetPlanarReflectionDistortionOffset();
+        ResolvedSettings.PlanarReflectionScreenPercentage = GetPlanarReflectionScreenPercentage();
+        ResolvedSettings.PlanarReflectionCaptureSchedule = GetPlanarReflectionCaptureSchedule();
+
+        ResolvedSettings.MediaBlend = GetMediaBlend();
+        ResolvedSettings.BrightnessMaskGamma = GetBrightnessMaskGamma();
+        ResolvedSettings.bApplyInverseToneCurve = GetApplyInverseToneCurve();
+
+        ResolvedSettings.OutputRgbEncoding = GetOutputRgbEncoding();
+        ResolvedSettings.OutputAlpha = GetOutputAlpha();
+
+        if (CompositeColorGrade)
+        {
+            ResolvedSettings.ColorGradeScene = CompositeColorGrade->GetColorGradeScene();
+            ResolvedSettings.ColorGradeMedia = CompositeColorGrade->GetColorGradeMedia();
+            ResolvedSettings.ColorGradeCombined = CompositeColorGrade->GetColorGradeCombined();
+        }
+        else
+        {
+            ResolvedSettings.ColorGradeScene = FColorGradePerRangeSettings();
+            ResolvedSettings.ColorGradeMedia = FColorGradePerRangeSettings();
+            ResolvedSettings.ColorGradeCombined = FColorGradePerRangeSettings();
+        }
+
+        ResolvedSettingsGeneration = SettingsGeneration;
+    }
+
+    return ResolvedSettings;
+}
+
+void UComposite::SetResolvedSettingsOverride(const TOptional<FResolvedCompositeSettings>& InResolvedSettingsOverride)
+{
+    ResolvedSettingsOverride = InResolvedSettingsOverride;
+    MarkSettingsDirty();
+}
+
+void UComposite::MarkSettingsDirty()
+{
+    ++SettingsGeneration;
+
+    // Never wrap back onto the generation of a Composite that was never resolved.
+    if (SettingsGeneration == 0)
+    {
+        SettingsGeneration = 1;
+    }
+}
+
+bool UComposite::SetPropertyOverride(FName PropertyName, bool bOverride)
+{
+    const FName OverrideName(*FString::Printf(TEXT("bOverride_%s"), *PropertyName.ToString()));
+    const FBoolProperty* OverrideProperty = FindFProperty<FBoolProperty>(GetClass(), OverrideName);
+    if (OverrideProperty == nullptr)
+    {
+        UE_LOG(LogCompositor, Warning, TEXT("Composite %s has no override for the property %s."), *GetName(), *PropertyName.ToString());
+        return false;
+    }
+
+    OverrideProperty->SetPropertyValue_InContainer(this, bOverride);
+    MarkSettingsDirty();
+    return true;
+}
+
+void UComposite::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+    UComposite* This = CastChecked<UComposite>(InThis);
+    Collector.AddReferencedObject(This->ResolvedSettings.MediaInputTexture, This);
+    Collector.AddReferencedObject(This->ResolvedSettings.MediaInputKeyer, This);
+    if (This->ResolvedSettingsOverride.IsSet())
+    {
+        Collector.AddReferencedObject(This->ResolvedSettingsOverride->MediaInputTexture, This);
+        Collector.AddReferencedObject(This->ResolvedSettingsOverride->MediaInputKeyer, This);
+    }
+
+    Super::AddReferencedObjects(InThis, Collector);
+}
+
+void UComposite::PostLoad()
+{
+    Super::PostLoad();
+
+    // A parent that finished loading after its children resolved must invalidate them.
+    MarkSettingsDirty();
+}
+
 #if WITH_EDITOR
 void UComposite::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
 {
     Super::PostEditChangeProperty(PropertyChangedEvent);
 
+    // Also covers undo/redo and the bOverride_ toggles, which don't go through the setters.
+    MarkSettingsDirty();
+
     const FName PropertyName = (PropertyChangedEvent.Property != nullptr) ? PropertyChangedEvent.Property->GetFName() : NAME_None;
 
     if (PropertyName == NAME_None)
@@ -534,8 +738,10 @@ void UComposite::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEv
         {
             UComposite* WorldComposite = CompositorSubsystem->GetWorldComposite();
             if (WorldComposite != nullptr && (WorldComposite == this || IsThisCompositeAnAncestorOf(WorldComposite)))
-            {                
-                CompositorSubsystem->OnCompositeUpdate_Internal();
+            {
+                // Edits inside the color grade object arrive with the color grade as the member property.
+                const FProperty* ChangedProperty = PropertyChangedEvent.MemberProperty ? PropertyChangedEvent.MemberProperty : PropertyChangedEvent.Property;
+                CompositorSubsystem->OnCompositeUpdate_Internal(GetCompositeUpdateFlags(ChangedProperty));
             }
         }
     }
@@ -547,7 +753,10 @@ bool UComposite::CanEditChange(const FProperty* InProperty) const
     {
         const FString PropertyName = InProperty->GetName();
 
-        if (PropertyName == GET_MEMBER_NAME_STRING_CHECKED(UComposite, SoftMaskScreenPercentage))
+        if (PropertyName == GET_MEMBER_NAME_STRING_CHECKED(UComposite, SoftMaskScreenPercentage)
+            || PropertyName == GET_MEMBER_NAME_STRING_CHECKED(UComposite, SoftMaskCaptureSchedule)
+            || PropertyName == GET_MEMBER_NAME_STRING_CHECKED(UComposite, SoftMaskCaptureResolution)
+            )
         {
             return GetEnableSoftMask();
         }
@@ -564,6 +773,7 @@ bool UComposite::CanEditChange(const FProperty* InProperty) const
             || PropertyName == GET_MEMBER_NAME_STRING_CHECKED(UComposite, PlanarReflectionDistortionIntensity)
             || PropertyName == GET_MEMBER_NAME_STRING_CHECKED(UComposite, PlanarReflectionDistortionOffset)
             || PropertyName == GET_MEMBER_NAME_STRING_CHECKED(UComposite, PlanarReflectionScreenPercentage)
+            || PropertyName == GET_MEMBER_NAME_STRING_CHECKED(UComposite, PlanarReflectionCaptureSchedule)
             )
         {
             return GetEnablePlanarReflection();
@@ -582,4 +792,50 @@ bool UComposite::CanEditChange(const FProperty* InProperty) const
 
     return Super::CanEditChange(InProperty);    
 }
+
+ECompositeUpdateFlags UComposite::GetCompositeUpdateFlags(const FProperty* Property)
+{
+    if (Property == nullptr)
+    {
+        return ECompositeUpdateFlags::All;
+    }
+
+    const FString& Category = Property->GetMetaData(TEXT("Category"));
+
+    if (Category == TEXT("Media Input"))
+    {
+        return ECompositeUpdateFlags::MediaInput;
+    }
+    if (Category == TEXT("Media Soft Mask"))
+    {
+        return ECompositeUpdateFlags::SoftMask;
+    }
+    if (Category == TEXT("Media Keyer"))
+    {
+        return ECompositeUpdateFlags::Keyer;
+    }
+    if (Category == TEXT("Media Shadows"))
+    {
+        return ECompositeUpdateFlags::Shadows;
+    }
+    if (Category.StartsWith(TEXT("Planar Reflection")))
+    {
+        return ECompositeUpdateFlags::PlanarReflection;
+    }
+    if (Category == TEXT("Color Grading"))
+    {
+        return ECompositeUpdateFlags::ColorGrade;
+    }
+    if (Category == TEXT("Media Integration"))
+    {
+        return ECompositeUpdateFlags::MediaIntegration;
+    }
+    if (Category == TEXT("Output"))
+    {
+        return ECompositeUpdateFlags::Output;
+    }
+
+    // A new parent changes every inherited value.
+    return ECompositeUpdateFlags::All;
+}
 #endif
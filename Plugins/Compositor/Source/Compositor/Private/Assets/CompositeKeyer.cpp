@@ -3,16 +3,137 @@
 
 #include "Assets/CompositeKeyer.h"
 #include "Subsystems/CompositorSubsystem.h"
+#include "CompositorStats.h"
 
 #include "Kismet/KismetMaterialLibrary.h"
-#include "Kismet/KismetRenderingLibrary.h"
+#include "Engine/TextureRenderTarget2D.h"
 #include "Runtime/Engine/Classes/Materials/MaterialInstanceDynamic.h"
 
+namespace
+{
+	/** Key of the parameter bindings shared by all keyers of the same class using the same material. */
+	struct FCompositeKeyerParameterBindingsKey
+	{
+		TWeakObjectPtr<const UClass> KeyerClass;
+		TWeakObjectPtr<const UMaterialInterface> KeyerMaterial;
+
+		bool operator==(const FCompositeKeyerParameterBindingsKey& Other) const
+		{
+			return KeyerClass == Other.KeyerClass && KeyerMaterial == Other.KeyerMaterial;
+		}
+
+		friend uint32 GetTypeHash(const FCompositeKeyerParameterBindingsKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.KeyerClass), GetTypeHash(Key.KeyerMaterial));
+		}
+	};
+
+	TMap<FCompositeKeyerParameterBindingsKey, TSharedRef<const TArray<FCompositeKeyerParameterBinding>>> GCompositeKeyerParameterBindings;
+
+	/** Bumped whenever the shared bindings are invalidated so keyers know they have to rebuild theirs. */
+	uint32 GCompositeKeyerParameterBindingsGeneration = 1;
+
+	/** Whether the keyer material is the given material or one of the materials it inherits its parameters from. */
+	bool IsMaterialOrParent(const UMaterialInterface* KeyerMaterial, const UMaterialInterface* Material)
+	{
+		for (const UMaterialInterface* Current = KeyerMaterial; Current; )
+		{
+			if (Current == Material)
+			{
+				return true;
+			}
+
+			const UMaterialInstance* MaterialInstance = Cast<UMaterialInstance>(Current);
+			Current = MaterialInstance ? MaterialInstance->Parent.Get() : nullptr;
+		}
+		return false;
+	}
+
+	/** Finds all properties of the keyer class that match a parameter of the keyer material. */
+	TSharedRef<const TArray<FCompositeKeyerParameterBinding>> CompileParameterBindings(const UClass* KeyerClass, const UMaterialInterface* KeyerMaterial)
+	{
+		TSharedRef<TArray<FCompositeKeyerParameterBinding>> Bindings = MakeShared<TArray<FCompositeKeyerParameterBinding>>();
+
+		for (TFieldIterator<FProperty> PropertyIterator(KeyerClass, EFieldIteratorFlags::IncludeSuper); PropertyIterator; ++PropertyIterator)
+		{
+			const FProperty* Property = *PropertyIterator;
+			const FName PropertyName = Property->GetFName();
+
+			FCompositeKeyerParameterBinding Binding;
+			Binding.ParameterName = PropertyName;
+			Binding.Offset = Property->GetOffset_ForInternal();
+			Binding.BoolProperty = nullptr;
+
+			if (const FBoolProperty* BoolProperty = CastField<FBoolProperty>(Property))
+			{
+				Binding.Type = ECompositeKeyerParameterType::Bool;
+				Binding.BoolProperty = BoolProperty;
+			}
+			else if (CastField<FFloatProperty>(Property))
+			{
+				Binding.Type = ECompositeKeyerParameterType::Float;
+			}
+			else if (CastField<FDoubleProperty>(Property))
+			{
+				// Blueprint float variables are doubles.
+				Binding.Type = ECompositeKeyerParameterType::Double;
+			}
+			else if (const FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+			{
+				if (StructProperty->Struct != TBaseStructure<FLinearColor>::Get())
+				{
+					continue;
+				}
+				Binding.Type = ECompositeKeyerParameterType::LinearColor;
+			}
+			else
+			{
+				continue;
+			}
+
+			bool bIsMaterialParameter = false;
+			if (Binding.Type == ECompositeKeyerParameterType::LinearColor)
+			{
+				FLinearColor CurrentParameterValue;
+				bIsMaterialParameter = KeyerMaterial->GetVectorParameterValue(PropertyName, CurrentParameterValue, false);
+			}
+			else
+			{
+				float CurrentParameterValue;
+				bIsMaterialParameter = KeyerMaterial->GetScalarParameterValue(PropertyName, CurrentParameterValue, false);
+			}
+
+			if (bIsMaterialParameter)
+			{
+				Bindings->Add(Binding);
+			}
+		}
+
+		return Bindings;
+	}
+
+	float ReadScalarParameter(const FCompositeKeyerParameterWrite& ParameterWrite, const uint8* ValuePtr)
+	{
+		switch (ParameterWrite.Type)
+		{
+		case ECompositeKeyerParameterType::Bool:
+			return ParameterWrite.BoolProperty->GetPropertyValue(ValuePtr) ? 1.F : 0.F;
+		case ECompositeKeyerParameterType::Float:
+			return *reinterpret_cast<const float*>(ValuePtr);
+		case ECompositeKeyerParameterType::Double:
+			return static_cast<float>(*reinterpret_cast<const double*>(ValuePtr));
+		default:
+			return 0.F;
+		}
+	}
+}
+
 UCompositeKeyer::UCompositeKeyer(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
 	IsCompositeKeyerEnabled = true;
-	MediaInputKeyedRenderTarget = Cast<UTextureRenderTarget2D>(FSoftObjectPath(TEXT("/Compositor/CompositeKeyer/RT_MediaInputKeyed.RT_MediaInputKeyed")).TryLoad());
+	LastDrawHash = 0;
+	ParameterBindingsGeneration = 0;
 }
 
 void UCompositeKeyer::InitializeCompositeKeyer(UCompositorSubsystem* CompositorSubsystem)
@@ -28,66 +149,12 @@ void UCompositeKeyer::InitializeCompositeKeyer(UCompositorSubsystem* CompositorS
 		{
 			ReceiveInitializeCompositeKeyer();
 
-			BoolParametersForMID.Empty();
-			FloatParametersForMID.Empty();
-			LinearColorParametersForMID.Empty();
+			InitializeParameterWrites();
 
-			for (TFieldIterator<FProperty> PropertyIterator(GetClass(), EFieldIteratorFlags::IncludeSuper); PropertyIterator; ++PropertyIterator)
-			{
-				FProperty* Property = *PropertyIterator;
-				FName const PropertyName = Property->GetFName();
-				FString PropertyNameAsString = PropertyName.ToString();
-
-				FBoolProperty* BoolProperty = CastField<FBoolProperty>(Property);
-				if (BoolProperty)
-				{
-					const bool boolPropertyValue = BoolProperty->GetPropertyValue_InContainer(this);
-					float currentParameterValueInMID;
-					if (GetCompositeKeyerMID()->GetScalarParameterValue(PropertyName, currentParameterValueInMID, false))
-					{
-						int32 ParameterIndex;
-						if (GetCompositeKeyerMID()->InitializeScalarParameterAndGetIndex(PropertyName, boolPropertyValue ? 1.F : 0.F, ParameterIndex))
-						{
-							BoolParametersForMID.Add(ParameterIndex, BoolProperty);
-						}
-					}
-				}
-
-				FFloatProperty* FloatProperty = CastField<FFloatProperty>(Property);
-				if (FloatProperty)
-				{
-					float* floatPropertyValue = FloatProperty->GetPropertyValuePtr_InContainer(this);
-					float currentParameterValueInMID;
-					if (GetCompositeKeyerMID()->GetScalarParameterValue(PropertyName, currentParameterValueInMID, false))
-					{
-						int32 ParameterIndex;
-						if (GetCompositeKeyerMID()->InitializeScalarParameterAndGetIndex(PropertyName, *floatPropertyValue, ParameterIndex))
-						{
-							FloatParametersForMID.Add(ParameterIndex, floatPropertyValue);
-						}
-					}
-				}
-
-				FStructProperty* StructProperty = CastField<FStructProperty>(Property);
-				if (StructProperty)
-				{
-					FLinearColor* LinearColor = StructProperty->ContainerPtrToValuePtr<FLinearColor>(this);
-					if (LinearColor)
-					{
-						FLinearColor currentParameterValueInMID;
-						if (GetCompositeKeyerMID()->GetVectorParameterValue(PropertyName, currentParameterValueInMID, false))
-						{
-							int32 ParameterIndex;
-							if (GetCompositeKeyerMID()->InitializeVectorParameterAndGetIndex(PropertyName, *LinearColor, ParameterIndex))
-							{
-								LinearColorParametersForMID.Add(ParameterIndex, LinearColor);
-							}
-						}
-					}
-				}
-			}
-
-			UKismetRenderingLibrary::DrawMaterialToRenderTarget(CompositorSubsystem, MediaInputKeyedRenderTarget, GetCompositeKeyerMID());
+			CompositorSubsystem->DrawMaterialToRenderTarget(CompositorSubsystem->GetMediaInputKeyedRenderTarget(), GetCompositeKeyerMID());
+			INC_DWORD_STAT(STAT_CompositorKeyerDraws);
+			CompositorSubsystem->NotifyMediaInputKeyedUpdated();
+			LastDrawHash = ComputeDrawHash(CompositorSubsystem);
 		}
 		else
 		{
@@ -104,27 +171,57 @@ void UCompositeKeyer::UpdateCompositeKeyer(UCompositorSubsystem* CompositorSubsy
 {
 	if (GetCompositeKeyerMID() && GetCompositeKeyerMID()->Parent == GetCompositeKeyerMaterial())
 	{
-		// Update all bool parameters.
-		for (const TPair<int32, FBoolProperty*>& pair : BoolParametersForMID)
+		// The bindings were invalidated by a blueprint or material recompile.
+		if (ParameterBindingsGeneration != GCompositeKeyerParameterBindingsGeneration)
 		{
-			GetCompositeKeyerMID()->SetScalarParameterByIndex(pair.Key, pair.Value->GetPropertyValue_InContainer(this) ? 1.F : 0.F);
+			InitializeParameterWrites();
 		}
 
-		// Update all float parameters.
-		for (const TPair<int32, float*>& pair : FloatParametersForMID)
-		{
-			GetCompositeKeyerMID()->SetScalarParameterByIndex(pair.Key, *pair.Value);
-		}
+		UMaterialInstanceDynamic* MID = GetCompositeKeyerMID();
+		const uint8* KeyerData = reinterpret_cast<const uint8*>(this);
 
-		// Update all linear color parameters.
-		for (const TPair<int32, FLinearColor*>& pair : LinearColorParametersForMID)
+		for (FCompositeKeyerParameterWrite& ParameterWrite : ParameterWrites)
 		{
-			GetCompositeKeyerMID()->SetVectorParameterByIndex(pair.Key, *pair.Value);
+			const uint8* ValuePtr = KeyerData + ParameterWrite.Offset;
+
+			switch (ParameterWrite.Type)
+			{
+			case ECompositeKeyerParameterType::Bool:
+			case ECompositeKeyerParameterType::Float:
+			case ECompositeKeyerParameterType::Double:
+			{
+				const float Value = ReadScalarParameter(ParameterWrite, ValuePtr);
+				if (Value != ParameterWrite.LastValue.R)
+				{
+					MID->SetScalarParameterByIndex(ParameterWrite.ParameterIndex, Value);
+					ParameterWrite.LastValue.R = Value;
+				}
+				break;
+			}
+			case ECompositeKeyerParameterType::LinearColor:
+			{
+				const FLinearColor& Value = *reinterpret_cast<const FLinearColor*>(ValuePtr);
+				if (Value != ParameterWrite.LastValue)
+				{
+					MID->SetVectorParameterByIndex(ParameterWrite.ParameterIndex, Value);
+					ParameterWrite.LastValue = Value;
+				}
+				break;
+			}
+			}
 		}
 		
 		ReceiveUpdateCompositeKeyer();
 
-		UKismetRenderingLibrary::DrawMaterialToRenderTarget(CompositorSubsystem, MediaInputKeyedRenderTarget, GetCompositeKeyerMID());
+		// Only key again when the media frame or anything in the keyer changed, otherwise the keyed render target is still valid.
+		const uint32 DrawHash = ComputeDrawHash(CompositorSubsystem);
+		if (DrawHash != LastDrawHash)
+		{
+			CompositorSubsystem->DrawMaterialToRenderTarget(CompositorSubsystem->GetMediaInputKeyedRenderTarget(), GetCompositeKeyerMID());
+			INC_DWORD_STAT(STAT_CompositorKeyerDraws);
+			CompositorSubsystem->NotifyMediaInputKeyedUpdated();
+			LastDrawHash = DrawHash;
+		}
 	}
 	else
 	{
@@ -151,3 +248,119 @@ bool UCompositeKeyer::GetIsKeyerEnabled()
 {
 	return IsCompositeKeyerEnabled;
 }
+
+void UCompositeKeyer::InvalidateParameterBindings()
+{
+	GCompositeKeyerParameterBindings.Reset();
+	++GCompositeKeyerParameterBindingsGeneration;
+}
+
+void UCompositeKeyer::InvalidateParameterBindings(const UMaterialInterface* Material)
+{
+	int32 NumRemoved = 0;
+	for (auto It = GCompositeKeyerParameterBindings.CreateIterator(); It; ++It)
+	{
+		// Stale entries of destroyed materials go as well, their bindings can never be used again.
+		const UMaterialInterface* KeyerMaterial = It.Key().KeyerMaterial.Get();
+		if (!KeyerMaterial || IsMaterialOrParent(KeyerMaterial, Material))
+		{
+			It.RemoveCurrent();
+			++NumRemoved;
+		}
+	}
+
+	// Keyers using a material that is not in the cache yet build their bindings on their next initialization anyway.
+	if (NumRemoved > 0)
+	{
+		++GCompositeKeyerParameterBindingsGeneration;
+	}
+}
+
+void UCompositeKeyer::InitializeParameterWrites()
+{
+	ParameterWrites.Reset();
+	ParameterBindingsGeneration = GCompositeKeyerParameterBindingsGeneration;
+
+	UMaterialInstanceDynamic* MID = GetCompositeKeyerMID();
+	const UMaterialInterface* KeyerMaterial = MID ? MID->Parent : nullptr;
+	if (!KeyerMaterial)
+	{
+		return;
+	}
+
+	const FCompositeKeyerParameterBindingsKey Key{ GetClass(), KeyerMaterial };
+	const TSharedRef<const TArray<FCompositeKeyerParameterBinding>>* CachedBindings = GCompositeKeyerParameterBindings.Find(Key);
+	const TSharedRef<const TArray<FCompositeKeyerParameterBinding>> Bindings = CachedBindings ? *CachedBindings : GCompositeKeyerParameterBindings.Add(Key, CompileParameterBindings(GetClass(), KeyerMaterial));
+
+	const uint8* KeyerData = reinterpret_cast<const uint8*>(this);
+	ParameterWrites.Reserve(Bindings->Num());
+
+	for (const FCompositeKeyerParameterBinding& Binding : *Bindings)
+	{
+		FCompositeKeyerParameterWrite ParameterWrite;
+		ParameterWrite.Offset = Binding.Offset;
+		ParameterWrite.Type = Binding.Type;
+		ParameterWrite.BoolProperty = Binding.BoolProperty;
+
+		const uint8* ValuePtr = KeyerData + Binding.Offset;
+		bool bIsInitialized = false;
+
+		if (Binding.Type == ECompositeKeyerParameterType::LinearColor)
+		{
+			ParameterWrite.LastValue = *reinterpret_cast<const FLinearColor*>(ValuePtr);
+			bIsInitialized = MID->InitializeVectorParameterAndGetIndex(Binding.ParameterName, ParameterWrite.LastValue, ParameterWrite.ParameterIndex);
+		}
+		else
+		{
+			ParameterWrite.LastValue = FLinearColor(ReadScalarParameter(ParameterWrite, ValuePtr), 0.F, 0.F, 0.F);
+			bIsInitialized = MID->InitializeScalarParameterAndGetIndex(Binding.ParameterName, ParameterWrite.LastValue.R, ParameterWrite.ParameterIndex);
+		}
+
+		if (bIsInitialized)
+		{
+			ParameterWrites.Add(ParameterWrite);
+		}
+	}
+}
+
+void UCompositeKeyer::MarkCompositeKeyerDirty()
+{
+	LastDrawHash = 0;
+}
+
+uint32 UCompositeKeyer::ComputeDrawHash(const UCompositorSubsystem* CompositorSubsystem)
+{
+	uint32 Hash = GetTypeHash(CompositorSubsystem->GetActiveMediaFrameHash());
+
+	const UTextureRenderTarget2D* MediaInputKeyedRenderTarget = CompositorSubsystem->GetMediaInputKeyedRenderTarget();
+	if (IsValid(MediaInputKeyedRenderTarget))
+	{
+		Hash = HashCombine(Hash, PointerHash(MediaInputKeyedRenderTarget));
+		Hash = HashCombine(Hash, GetTypeHash(MediaInputKeyedRenderTarget->SizeX));
+		Hash = HashCombine(Hash, GetTypeHash(MediaInputKeyedRenderTarget->SizeY));
+	}
+
+	// Hash the material instance itself so changes made from blueprint or by the subsystem are picked up too.
+	if (const UMaterialInstanceDynamic* MID = GetCompositeKeyerMID())
+	{
+		Hash = HashCombine(Hash, PointerHash(MID));
+
+		for (const FScalarParameterValue& ScalarParameterValue : MID->ScalarParameterValues)
+		{
+			Hash = HashCombine(Hash, GetTypeHash(ScalarParameterValue.ParameterValue));
+		}
+
+		for (const FVectorParameterValue& VectorParameterValue : MID->VectorParameterValues)
+		{
+			Hash = HashCombine(Hash, GetTypeHash(VectorParameterValue.ParameterValue));
+		}
+
+		for (const FTextureParameterValue& TextureParameterValue : MID->TextureParameterValues)
+		{
+			Hash = HashCombine(Hash, PointerHash(TextureParameterValue.ParameterValue));
+		}
+	}
+
+	// Never collide with the value that forces a draw.
+	return Hash != 0 ? Hash : 1;
+}
@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Assets/CompositeKeyerColorDifference.h"
+
+#include "Materials/MaterialInterface.h"
+
+UCompositeKeyerColorDifference::UCompositeKeyerColorDifference(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	const FCompositeKeyerCPUSettings DefaultSettings;
+	KeyColor = DefaultSettings.KeyColor;
+	RedWeight = DefaultSettings.RedWeight;
+	BlueWeight = DefaultSettings.BlueWeight;
+	AlphaThreshold = DefaultSettings.AlphaThreshold;
+	AlphaOffset = DefaultSettings.AlphaOffset;
+	ClipBlack = DefaultSettings.ClipBlack;
+	ClipWhite = DefaultSettings.ClipWhite;
+	bUseFusedMediaPrePass = false;
+
+	ColorDifferenceMaterial = Cast<UMaterialInterface>(FSoftObjectPath(TEXT("/Compositor/CompositeKeyer/UnrealColorDifference/MI_CompositeKeyer_UnrealColorDifference.MI_CompositeKeyer_UnrealColorDifference")).TryLoad());
+}
+
+FCompositeKeyerCPUSettings UCompositeKeyerColorDifference::GetKeyerCPUSettings() const
+{
+	FCompositeKeyerCPUSettings Settings;
+	Settings.KeyColor = KeyColor;
+	Settings.RedWeight = RedWeight;
+	Settings.BlueWeight = BlueWeight;
+	Settings.AlphaThreshold = AlphaThreshold;
+	Settings.AlphaOffset = AlphaOffset;
+	Settings.ClipBlack = ClipBlack;
+	Settings.ClipWhite = ClipWhite;
+	return Settings;
+}
+
+void UCompositeKeyerColorDifference::SetUseFusedMediaPrePass(bool bNewUseFusedMediaPrePass)
+{
+	bUseFusedMediaPrePass = bNewUseFusedMediaPrePass;
+}
+
+UMaterialInterface* UCompositeKeyerColorDifference::GetCompositeKeyerMaterial_Implementation() const
+{
+	return ColorDifferenceMaterial;
+}
@@ -28,6 +28,14 @@ bool UCompositeKeyerFromAsset::GetIsKeyerEnabled()
 	return false;
 }
 
+void UCompositeKeyerFromAsset::MarkCompositeKeyerDirty()
+{
+	if (IsValid(CompositeKeyerAsset))
+	{
+		CompositeKeyerAsset->MarkCompositeKeyerDirty();
+	}
+}
+
 void UCompositeKeyerFromAsset::SetCompositeKeyerAsset(UCompositeKeyer* NewCompositeKeyerAsset)
 {
 	CompositeKeyerAsset = NewCompositeKeyerAsset;
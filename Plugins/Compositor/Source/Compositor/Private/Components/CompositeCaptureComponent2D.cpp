@@ -1,9 +1,11 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Components/CompositeCaptureComponent2D.h"
+#include "Actors/CompositeMesh.h"
 
 #include "Camera/CameraActor.h"
 #include "Subsystems/CompositorSubsystem.h"
+#include "CompositorStats.h"
 
 #include "Camera/PlayerCameraManager.h"
 #include "Camera/CameraComponent.h"
@@ -11,12 +13,14 @@
 #include "Engine/World.h"
 #include "Kismet/KismetRenderingLibrary.h" 
 #include "Objects/CompositeWorldData.h"
+#include "Objects/CompositorRenderTargetPool.h"
 
 UCompositeCaptureComponent2D::UCompositeCaptureComponent2D()
 {
 	PrimitiveRenderMode = ESceneCapturePrimitiveRenderMode::PRM_UseShowOnlyList;
 	CaptureSource = ESceneCaptureSource::SCS_SceneColorHDRNoAlpha;
 	bCaptureOnMovement = false;
+	bCaptureEveryFrame = false;
 	ShowFlags.AntiAliasing = false;
 	ShowFlags.Atmosphere = false;
 	ShowFlags.BSP = false;
@@ -46,6 +50,14 @@ UCompositeCaptureComponent2D::UCompositeCaptureComponent2D()
 	ShowFlags.Game = false;
 	ShowFlags.Lighting = false;
 	ShowFlags.PostProcessing = false;
+
+	bCaptureRequested = true;
+	bWasCaptureActive = false;
+	LastCaptureFrame = 0;
+	LastCaptureMediaFrameHash = 0;
+	LastCaptureLocation = FVector::ZeroVector;
+	LastCaptureRotation = FRotator::ZeroRotator;
+	LastCaptureFieldOfView = 0.F;
 }
 
 void UCompositeCaptureComponent2D::OnRegister()
@@ -53,6 +65,7 @@ void UCompositeCaptureComponent2D::OnRegister()
 	Super::OnRegister();
 
 	UKismetRenderingLibrary::ClearRenderTarget2D(this, TextureTarget, FLinearColor(0, 0, 0, 0));
+	bCaptureRequested = true;
 
 	const UWorld* World = GetWorld();
 	if (IsValid(World))
@@ -62,6 +75,7 @@ void UCompositeCaptureComponent2D::OnRegister()
 		{						
 			CompositorSubsystem->OnCompositeUpdateInterfaceRegistered.AddUObject(this, &UCompositeCaptureComponent2D::OnCompositeUpdateInterfaceRegistered);
 			CompositorSubsystem->OnCompositeUpdateInterfaceUnregistered.AddUObject(this, &UCompositeCaptureComponent2D::OnCompositeUpdateInterfaceUnregistered);
+			CompositorSubsystem->OnCompositeMeshesRegistered.AddUObject(this, &UCompositeCaptureComponent2D::OnCompositeMeshesRegistered);
 			
 			// Can fail on editor start up or during edit time, which is why we also try to get it during tick (IF WITH_EDITOR).
 			CompositeWorldData = CompositorSubsystem->GetCompositeWorldData();
@@ -83,6 +97,13 @@ void UCompositeCaptureComponent2D::OnUnregister()
 {
 	Super::OnUnregister();
 
+	if (IsValid(CompositorSubsystem))
+	{
+		CompositorSubsystem->UnbindMaterialTexture(MaterialTextureTarget, GetBoundTextureTarget());
+		CompositorSubsystem->GetRenderTargetPool().Release(TextureTarget);
+		TextureTarget = nullptr;
+	}
+
 	// if (CompositorSubsystem)
 	// {
 	// 	FViewport* CompositeViewport = CompositorSubsystem->GetCompositeViewport();
@@ -93,6 +114,14 @@ void UCompositeCaptureComponent2D::OnUnregister()
 	// }	
 }
 
+void UCompositeCaptureComponent2D::OnCompositeMeshesRegistered(TArrayView<ACompositeMesh* const> CompositeMeshes)
+{
+	for (ACompositeMesh* CompositeMesh : CompositeMeshes)
+	{
+		OnCompositeUpdateInterfaceRegistered(CompositeMesh);
+	}
+}
+
 void UCompositeCaptureComponent2D::BeginPlay()
 {
 	Super::BeginPlay();
@@ -110,18 +139,79 @@ bool UCompositeCaptureComponent2D::GetIsCompositeCaptureActive() const
 	return true;
 }
 
+FCompositeCaptureSchedule UCompositeCaptureComponent2D::GetCaptureSchedule() const
+{
+	return FCompositeCaptureSchedule();
+}
+
+bool UCompositeCaptureComponent2D::ShouldCaptureThisFrame(const FCompositeCaptureSchedule& CaptureSchedule) const
+{
+	const uint64 FramesSinceCapture = GFrameCounter - LastCaptureFrame;
+
+	switch (CaptureSchedule.UpdateMode)
+	{
+	case ECompositeCaptureUpdateMode::EveryNFrames:
+		return FramesSinceCapture >= static_cast<uint64>(FMath::Max(CaptureSchedule.FrameInterval, 1));
+
+	case ECompositeCaptureUpdateMode::Staggered:
+		return (GFrameCounter & 1) == GetStaggeredCaptureSlot();
+
+	case ECompositeCaptureUpdateMode::OnCameraChange:
+	case ECompositeCaptureUpdateMode::OnMediaFrame:
+	{
+		if (CaptureSchedule.MaxFramesBetweenCaptures > 0 && FramesSinceCapture >= static_cast<uint64>(CaptureSchedule.MaxFramesBetweenCaptures))
+		{
+			return true;
+		}
+
+		if (CaptureSchedule.UpdateMode == ECompositeCaptureUpdateMode::OnMediaFrame)
+		{
+			return CompositorSubsystem && CompositorSubsystem->GetActiveMediaFrameHash() != LastCaptureMediaFrameHash;
+		}
+
+		FVector CameraLocation = LastCaptureLocation;
+		FRotator CameraRotation = LastCaptureRotation;
+		float CameraFieldOfView = LastCaptureFieldOfView;
+		FVector CameraClipPlaneBase = FVector::ZeroVector;
+		FVector CameraClipPlaneNormal = FVector::UpVector;
+
+		UpdateCameraData(CameraLocation, CameraRotation, CameraFieldOfView, CameraClipPlaneBase, CameraClipPlaneNormal);
+
+		return FVector::DistSquared(CameraLocation, LastCaptureLocation) > FMath::Square(CaptureSchedule.LocationThreshold)
+			|| !CameraRotation.Equals(LastCaptureRotation, CaptureSchedule.RotationThreshold)
+			|| FMath::Abs(CameraFieldOfView - LastCaptureFieldOfView) > CaptureSchedule.FieldOfViewThreshold;
+	}
+
+	case ECompositeCaptureUpdateMode::EveryFrame:
+	default:
+		return true;
+	}
+}
+
+FIntPoint UCompositeCaptureComponent2D::GetTargetTextureSize() const
+{
+	if (!CompositorSubsystem)
+	{
+		return FIntPoint(2, 2);
+	}
+
+	const FIntPoint MediaTextureSize = CompositorSubsystem->GetMediaInputTextureSize();
+	const float NormalizedScreenPercentage = (GetTargetTextureScreenPercentage() / 100.F);
+	const int32 NewSizeX = FMath::Max(static_cast<float>(MediaTextureSize.X) * NormalizedScreenPercentage, 2.F);
+	const int32 NewSizeY = FMath::Max(static_cast<float>(MediaTextureSize.Y) * NormalizedScreenPercentage, 2.F);
+
+	// Snapped to buckets of the media size, dragging the screen percentage only swaps the render target every few percent
+	// and going back to a recent size picks up the render target the pool kept alive.
+	return FCompositorRenderTargetPool::QuantizeSize(FIntPoint(NewSizeX, NewSizeY), MediaTextureSize);
+}
+
 void UCompositeCaptureComponent2D::UpdateRenderTargetSize()
 {
 	if (CompositorSubsystem)
 	{
-		const FIntPoint MediaTextureSize = CompositorSubsystem->GetMediaInputTextureSize();
-		const float NormalizedScreenPercentage = (GetTargetTextureScreenPercentage() / 100.F);
-		const uint32 NewSizeX = FMath::Max(static_cast<float>(MediaTextureSize.X) * NormalizedScreenPercentage, 2.F);
-		const uint32 NewSizeY = FMath::Max(static_cast<float>(MediaTextureSize.Y) * NormalizedScreenPercentage, 2.F);
-
-		if (TextureTarget->SizeX != NewSizeX || TextureTarget->SizeY != NewSizeY)
+		if (CompositorSubsystem->GetRenderTargetPool().Update(TextureTarget, FCompositorRenderTargetDesc::FromTemplate(MaterialTextureTarget, GetTargetTextureSize())))
 		{
-			TextureTarget->ResizeTarget(NewSizeX, NewSizeY);
+			bCaptureRequested = true;
 		}
 	}	
 }
@@ -222,22 +312,29 @@ void UCompositeCaptureComponent2D::UpdateCameraData(FVector& OutLocation, FRotat
 
 void UCompositeCaptureComponent2D::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
+	COMPOSITOR_SCOPE_CYCLE_COUNTER(STAT_CompositorCaptureTick);
+
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	if (GetIsCompositeCaptureActive())
-	{
-		bCaptureEveryFrame = true;
-	}
-	else if (bCaptureEveryFrame)
+	// Captures are always requested by hand, so the schedule decides which frames render.
+	bCaptureEveryFrame = false;
+
+	const bool bIsCaptureActive = GetIsCompositeCaptureActive();
+	if (bIsCaptureActive && !bWasCaptureActive)
 	{
-		bCaptureEveryFrame = false;
+		bCaptureRequested = true;
 	}
+	bWasCaptureActive = bIsCaptureActive;
 
 	if (CompositorSubsystem)
 	{
 		FViewport* CompositeViewport = CompositorSubsystem->GetCompositeViewport();
 
-		UpdateRenderTargetSize();
+		// Inactive captures do not allocate, the pool hands them a render target once they are activated.
+		if (bIsCaptureActive)
+		{
+			UpdateRenderTargetSize();
+		}
 		
 		// if (CompositeViewport)
 		// {
@@ -276,22 +373,52 @@ void UCompositeCaptureComponent2D::TickComponent(float DeltaTime, enum ELevelTic
 		}
 #endif
 	}
+
+	if (bIsCaptureActive && TextureTarget)
+	{
+		// Other captures of the same kind bind the same asset, the active one wins.
+		if (CompositorSubsystem)
+		{
+			CompositorSubsystem->BindMaterialTexture(MaterialTextureTarget, GetBoundTextureTarget());
+		}
+
+		const FCompositeCaptureSchedule CaptureSchedule = GetCaptureSchedule();
+		if (bCaptureRequested || ShouldCaptureThisFrame(CaptureSchedule))
+		{
+			bCaptureRequested = false;
+			LastCaptureFrame = GFrameCounter;
+			LastCaptureMediaFrameHash = CompositorSubsystem ? CompositorSubsystem->GetActiveMediaFrameHash() : 0;
+			CaptureComposite();
+		}
+	}
 }
 
 void UCompositeCaptureComponent2D::UpdateSceneCaptureContents(FSceneInterface* Scene)
 {
-	FVector CameraLocation = FVector::ZeroVector;
-	FRotator CameraRotation = FRotator::ZeroRotator;
-	float CameraFieldOfView = 90.F;
+	COMPOSITOR_SCOPE_CYCLE_COUNTER(STAT_CompositorCaptureUpdate);
+	INC_DWORD_STAT(STAT_CompositorCaptureRenders);
+
 	FVector CameraClipPlaneBase = FVector::ZeroVector;
 	FVector CameraClipPlaneNormal = FVector::UpVector;
-	
-	UpdateCameraData(CameraLocation, CameraRotation, CameraFieldOfView, CameraClipPlaneBase, CameraClipPlaneNormal);
+	RecordCaptureCamera(CameraClipPlaneBase, CameraClipPlaneNormal);
 
-	SetWorldLocationAndRotation(CameraLocation, CameraRotation);
-	FOVAngle = CameraFieldOfView;
+	SetWorldLocationAndRotation(LastCaptureLocation, LastCaptureRotation);
+	FOVAngle = LastCaptureFieldOfView;
 	ClipPlaneBase = CameraClipPlaneBase;
 	ClipPlaneNormal = CameraClipPlaneNormal;
 
 	Super::UpdateSceneCaptureContents(Scene);
 }
+
+void UCompositeCaptureComponent2D::RecordCaptureCamera(FVector& OutClipPlaneBase, FVector& OutClipPlaneNormal)
+{
+	FVector CameraLocation = FVector::ZeroVector;
+	FRotator CameraRotation = FRotator::ZeroRotator;
+	float CameraFieldOfView = 90.F;
+
+	UpdateCameraData(CameraLocation, CameraRotation, CameraFieldOfView, OutClipPlaneBase, OutClipPlaneNormal);
+
+	LastCaptureLocation = CameraLocation;
+	LastCaptureRotation = CameraRotation;
+	LastCaptureFieldOfView = CameraFieldOfView;
+}
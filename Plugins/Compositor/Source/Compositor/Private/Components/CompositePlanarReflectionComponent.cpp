@@ -6,13 +6,17 @@
 #include "Actors/CompositePlanarReflection.h"
 #include "Assets/Composite.h"
 #include "Objects/CompositeWorldData.h"
+#include "CompositorStats.h"
 
+#include "Algo/Sort.h"
+#include "ConvexVolume.h"
 #include "Engine/TextureRenderTarget2D.h"
+#include "GameFramework/Actor.h"
 #include "Kismet/KismetMathLibrary.h"
 
 UCompositePlanarReflectionComponent::UCompositePlanarReflectionComponent()
 {
-	TextureTarget = Cast<UTextureRenderTarget2D>(FSoftObjectPath(TEXT("/Compositor/CompositePlanarReflection/RT_CompositePlanarReflection.RT_CompositePlanarReflection")).TryLoad());
+	MaterialTextureTarget = Cast<UTextureRenderTarget2D>(FSoftObjectPath(TEXT("/Compositor/CompositePlanarReflection/RT_CompositePlanarReflection.RT_CompositePlanarReflection")).TryLoad());
 
 	ProfilingEventName = "Composite Planar Reflection";
 
@@ -22,13 +26,164 @@ UCompositePlanarReflectionComponent::UCompositePlanarReflectionComponent()
 	ShowFlags.ReflectionEnvironment = true;
 	ShowFlags.Lighting = true;
 	bEnableClipPlane = true;
+
+	bCullShowOnlyActors = true;
+	CullDistance = 0.F;
+	MaxCapturedActors = 0;
+	LightingMode = ECompositePlanarReflectionLighting::Full;
+	NumCapturedActors = 0;
+	NumCapturedPrimitives = 0;
+}
+
+#if WITH_EDITOR
+void UCompositePlanarReflectionComponent::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Culling and lighting only apply when capturing, make sure the change shows up even if the schedule would skip it.
+	RequestCapture();
+}
+#endif
+
+void UCompositePlanarReflectionComponent::UpdateSceneCaptureContents(FSceneInterface* Scene)
+{
+	ApplyLightingMode();
+
+	// The same camera the capture renders from, the parent class sets it up again after the list is swapped in.
+	FVector CameraLocation = FVector::ZeroVector;
+	FRotator CameraRotation = FRotator::ZeroRotator;
+	float CameraFieldOfView = 90.F;
+	FVector CameraClipPlaneBase = FVector::ZeroVector;
+	FVector CameraClipPlaneNormal = FVector::UpVector;
+	UpdateCameraData(CameraLocation, CameraRotation, CameraFieldOfView, CameraClipPlaneBase, CameraClipPlaneNormal);
+
+	// ShowOnlyActors stays the list the user edits, the capture only sees the culled one while the scene renderer gathers its primitives.
+	TArray<TObjectPtr<AActor>> CulledShowOnlyActors;
+	CullShowOnlyActors(CameraLocation, CameraRotation, CameraFieldOfView, CameraClipPlaneBase, CameraClipPlaneNormal, CulledShowOnlyActors);
+
+	NumCapturedActors = CulledShowOnlyActors.Num();
+	NumCapturedPrimitives = 0;
+	for (const AActor* Actor : CulledShowOnlyActors)
+	{
+		Actor->ForEachComponent<UPrimitiveComponent>(true, [this](const UPrimitiveComponent* PrimitiveComponent)
+		{
+			if (PrimitiveComponent->IsRegistered() && PrimitiveComponent->IsVisible())
+			{
+				++NumCapturedPrimitives;
+			}
+		});
+	}
+
+	SET_DWORD_STAT(STAT_CompositorPlanarReflectionActors, NumCapturedActors);
+	SET_DWORD_STAT(STAT_CompositorPlanarReflectionPrimitives, NumCapturedPrimitives);
+
+	Swap(ShowOnlyActors, CulledShowOnlyActors);
+	Super::UpdateSceneCaptureContents(Scene);
+	Swap(ShowOnlyActors, CulledShowOnlyActors);
+}
+
+void UCompositePlanarReflectionComponent::ApplyLightingMode()
+{
+	const bool bLit = LightingMode != ECompositePlanarReflectionLighting::Unlit;
+	const bool bFullLighting = LightingMode == ECompositePlanarReflectionLighting::Full;
+
+	ShowFlags.Lighting = bLit;
+	ShowFlags.DeferredLighting = bLit;
+	ShowFlags.SkyLighting = bLit;
+	ShowFlags.ReflectionEnvironment = bFullLighting;
+	ShowFlags.GlobalIllumination = bFullLighting;
+}
+
+void UCompositePlanarReflectionComponent::CullShowOnlyActors(const FVector& CameraLocation, const FRotator& CameraRotation, float CameraFieldOfView, const FVector& CameraClipPlaneBase, const FVector& CameraClipPlaneNormal, TArray<TObjectPtr<AActor>>& OutActors) const
+{
+	OutActors.Reset(ShowOnlyActors.Num());
+
+	if (!bCullShowOnlyActors)
+	{
+		for (AActor* Actor : ShowOnlyActors)
+		{
+			if (IsValid(Actor))
+			{
+				OutActors.Add(Actor);
+			}
+		}
+		return;
+	}
+
+	// Same projection the scene capture builds, with the wider axis of the render target spanning the field of view.
+	const FIntPoint TargetSize = TextureTarget ? FIntPoint(TextureTarget->SizeX, TextureTarget->SizeY) : FIntPoint(1, 1);
+	const float HalfFieldOfView = FMath::DegreesToRadians(FMath::Clamp(CameraFieldOfView, 0.001F, 179.F)) * 0.5F;
+	const float XAxisMultiplier = TargetSize.X > TargetSize.Y ? 1.F : static_cast<float>(TargetSize.Y) / FMath::Max(TargetSize.X, 1);
+	const float YAxisMultiplier = TargetSize.X > TargetSize.Y ? static_cast<float>(TargetSize.X) / FMath::Max(TargetSize.Y, 1) : 1.F;
+
+	const FMatrix ViewMatrix = FTranslationMatrix(-CameraLocation) * FInverseRotationMatrix(CameraRotation) * FMatrix(
+		FPlane(0, 0, 1, 0),
+		FPlane(1, 0, 0, 0),
+		FPlane(0, 1, 0, 0),
+		FPlane(0, 0, 0, 1));
+	// Only the side planes are used, so the near plane distance does not matter.
+	const FMatrix ProjectionMatrix = FReversedZPerspectiveMatrix(HalfFieldOfView, HalfFieldOfView, XAxisMultiplier, YAxisMultiplier, 10.F, 10.F);
+
+	FConvexVolume ViewFrustum;
+	GetViewFrustumBounds(ViewFrustum, ViewMatrix * ProjectionMatrix, false);
+
+	struct FCandidate
+	{
+		AActor* Actor;
+		double DistanceSquared;
+	};
+	TArray<FCandidate, TInlineAllocator<64>> Candidates;
+
+	for (AActor* Actor : ShowOnlyActors)
+	{
+		if (!IsValid(Actor))
+		{
+			continue;
+		}
+
+		FVector Origin = FVector::ZeroVector;
+		FVector BoxExtent = FVector::ZeroVector;
+		Actor->GetActorBounds(false, Origin, BoxExtent, true);
+
+		// Everything below the reflection plane is clipped away.
+		const double DistanceToPlane = FVector::DotProduct(Origin - CameraClipPlaneBase, CameraClipPlaneNormal);
+		const double ExtentAlongNormal = FVector::DotProduct(BoxExtent, CameraClipPlaneNormal.GetAbs());
+		if (DistanceToPlane + ExtentAlongNormal < 0.0)
+		{
+			continue;
+		}
+
+		if (!ViewFrustum.IntersectBox(Origin, BoxExtent))
+		{
+			continue;
+		}
+
+		const double DistanceSquared = FMath::Square(FMath::Max(FVector::Dist(CameraLocation, Origin) - BoxExtent.Size(), 0.0));
+		if (CullDistance > 0.F && DistanceSquared > FMath::Square(static_cast<double>(CullDistance)))
+		{
+			continue;
+		}
+
+		Candidates.Add({ Actor, DistanceSquared });
+	}
+
+	if (MaxCapturedActors > 0 && Candidates.Num() > MaxCapturedActors)
+	{
+		Algo::SortBy(Candidates, &FCandidate::DistanceSquared);
+		Candidates.SetNum(MaxCapturedActors);
+	}
+
+	for (const FCandidate& Candidate : Candidates)
+	{
+		OutActors.Add(Candidate.Actor);
+	}
 }
 
 float UCompositePlanarReflectionComponent::GetTargetTextureScreenPercentage() const
 {
 	if (WorldComposite)
 	{
-		return WorldComposite->GetPlanarReflectionScreenPercentage();
+		return WorldComposite->GetResolvedSettings().PlanarReflectionScreenPercentage;
 	}
 
 	return Super::GetTargetTextureScreenPercentage();
@@ -42,13 +197,23 @@ bool UCompositePlanarReflectionComponent::GetIsCompositeCaptureActive() const
 		if (CompositePlanarReflection)
 		{
 			const bool bIsActivePlanarReflection = CompositeWorldData->GetCompositePlanarReflection()->CompositePlanarReflectionComponent == this;
-			return WorldComposite->GetEnablePlanarReflection() && bIsActivePlanarReflection;
+			return WorldComposite->GetResolvedSettings().bEnablePlanarReflection && bIsActivePlanarReflection;
 		}
 	}
 	
 	return false;
 }
 
+FCompositeCaptureSchedule UCompositePlanarReflectionComponent::GetCaptureSchedule() const
+{
+	if (WorldComposite)
+	{
+		return WorldComposite->GetResolvedSettings().PlanarReflectionCaptureSchedule;
+	}
+
+	return Super::GetCaptureSchedule();
+}
+
 void UCompositePlanarReflectionComponent::UpdateCameraData(FVector& OutLocation, FRotator& OutRotation, float& OutFieldOfView, FVector& OutClipPlaneBase, FVector& OutClipBaseNormal) const
 {
 	Super::UpdateCameraData(OutLocation, OutRotation, OutFieldOfView, OutClipPlaneBase, OutClipBaseNormal);
@@ -6,10 +6,13 @@
 #include "Interfaces/CompositeUpdateInterface.h"
 #include "Actors/CompositeMesh.h"
 #include "Assets/Composite.h"
+#include "Subsystems/CompositorSubsystem.h"
+#include "Objects/CompositeWorldData.h"
+#include "Objects/CompositorRenderTargetPool.h"
 
 USoftMaskCaptureComponent::USoftMaskCaptureComponent()
 {
-	TextureTarget = Cast<UTextureRenderTarget2D>(FSoftObjectPath(TEXT("/Compositor/SoftMask/RT_CompositorSoftMask.RT_CompositorSoftMask")).TryLoad());
+	MaterialTextureTarget = Cast<UTextureRenderTarget2D>(FSoftObjectPath(TEXT("/Compositor/SoftMask/RT_CompositorSoftMask.RT_CompositorSoftMask")).TryLoad());
 	
 	ProfilingEventName = "Composite Soft Mask";
 
@@ -18,6 +21,8 @@ USoftMaskCaptureComponent::USoftMaskCaptureComponent()
 	ShowFlags.TextRender = false;
 
 	bAllowDebugEditorCamera = true;
+
+	UpsampledTextureTarget = nullptr;
 }
 
 bool USoftMaskCaptureComponent::GetIsCompositeCaptureActive() const
@@ -26,7 +31,7 @@ bool USoftMaskCaptureComponent::GetIsCompositeCaptureActive() const
 
 	if (WorldComposite)
 	{
-		return WorldComposite->GetEnableSoftMask() && HasAnyComponentsToCapture;
+		return WorldComposite->GetResolvedSettings().bEnableSoftMask && HasAnyComponentsToCapture;
 	}
 
 	return HasAnyComponentsToCapture;
@@ -38,6 +43,7 @@ void USoftMaskCaptureComponent::OnCompositeUpdateInterfaceRegistered(TScriptInte
 	if (CompositeMesh != nullptr)// && CompositeMesh->GetRenderSoftMask() != ERenderSoftMaskType::Off)
 	{
 		ShowOnlyComponents.Add(CompositeMesh->GetSoftMaskComponent());
+		RequestCapture();
 	}
 }
 
@@ -47,15 +53,150 @@ void USoftMaskCaptureComponent::OnCompositeUpdateInterfaceUnregistered(TScriptIn
 	if (CompositeMesh != nullptr)// && CompositeMesh->GetRenderSoftMask() != ERenderSoftMaskType::Off)
 	{
 		ShowOnlyComponents.Remove(CompositeMesh->GetSoftMaskComponent());
+		RequestCapture();
+	}
+}
+
+void USoftMaskCaptureComponent::OnCompositeMeshesRegistered(TArrayView<ACompositeMesh* const> CompositeMeshes)
+{
+	// Only the new meshes are appended, the list also holds the instanced soft mask components of the composite mesh batches.
+	ShowOnlyComponents.Reserve(ShowOnlyComponents.Num() + CompositeMeshes.Num());
+	for (const ACompositeMesh* CompositeMesh : CompositeMeshes)
+	{
+		if (IsValid(CompositeMesh))
+		{
+			ShowOnlyComponents.Add(CompositeMesh->GetSoftMaskComponent());
+		}
 	}
+	RequestCapture();
 }
 
 float USoftMaskCaptureComponent::GetTargetTextureScreenPercentage() const
 {
 	if (WorldComposite)
 	{
-		return WorldComposite->GetSoftMaskScreenPercentage();
+		return WorldComposite->GetResolvedSettings().SoftMaskScreenPercentage;
 	}
 
 	return Super::GetTargetTextureScreenPercentage();
 }
+
+FCompositeCaptureSchedule USoftMaskCaptureComponent::GetCaptureSchedule() const
+{
+	if (WorldComposite)
+	{
+		return WorldComposite->GetResolvedSettings().SoftMaskCaptureSchedule;
+	}
+
+	return Super::GetCaptureSchedule();
+}
+
+void USoftMaskCaptureComponent::UpdateRenderTargetSize()
+{
+	const int32 Divisor = GetCaptureResolutionDivisor();
+	if (Divisor == 1 || !CompositorSubsystem)
+	{
+		ReleaseUpsampledTextureTarget();
+		CaptureSource = ESceneCaptureSource::SCS_SceneColorHDRNoAlpha;
+		Super::UpdateRenderTargetSize();
+		return;
+	}
+
+	FCompositorRenderTargetPool& RenderTargetPool = CompositorSubsystem->GetRenderTargetPool();
+	const FIntPoint OutputSize = GetTargetTextureSize();
+
+	FCompositorRenderTargetDesc OutputDesc = FCompositorRenderTargetDesc::FromTemplate(MaterialTextureTarget, OutputSize);
+	OutputDesc.bCanCreateUAV = true;
+	RenderTargetPool.Update(UpsampledTextureTarget, OutputDesc);
+
+	// The upsample reads the linear depth the capture writes into alpha, which needs a float format.
+	FCompositorRenderTargetDesc CaptureDesc = FCompositorRenderTargetDesc::FromTemplate(MaterialTextureTarget, FIntPoint::DivideAndRoundUp(OutputSize, Divisor));
+	CaptureDesc.Format = RTF_RGBA16f;
+	if (RenderTargetPool.Update(TextureTarget, CaptureDesc))
+	{
+		RequestCapture();
+	}
+
+	if (CaptureSource != ESceneCaptureSource::SCS_SceneColorSceneDepth)
+	{
+		CaptureSource = ESceneCaptureSource::SCS_SceneColorSceneDepth;
+		RequestCapture();
+	}
+
+	CompositorSubsystem->SetSoftMaskUpsample(TextureTarget, UpsampledTextureTarget);
+}
+
+UTextureRenderTarget2D* USoftMaskCaptureComponent::GetBoundTextureTarget() const
+{
+	return UpsampledTextureTarget ? UpsampledTextureTarget : TextureTarget;
+}
+
+void USoftMaskCaptureComponent::OnUnregister()
+{
+	Super::OnUnregister();
+
+	ReleaseUpsampledTextureTarget();
+}
+
+void USoftMaskCaptureComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// The upsample would keep running on the last capture otherwise.
+	if (CompositorSubsystem && !GetIsCompositeCaptureActive())
+	{
+		CompositorSubsystem->SetSoftMaskUpsample(nullptr, nullptr);
+	}
+}
+
+void USoftMaskCaptureComponent::CaptureComposite()
+{
+	const bool bUseMeshPass = CompositeWorldData && CompositeWorldData->GetSoftMaskRenderer() == ECompositeSoftMaskRenderer::MeshPass;
+	if (bUseMeshPass && CompositorSubsystem && CompositorSubsystem->RenderSoftMaskMeshPass(TextureTarget))
+	{
+		// The mesh pass draws from the composite view itself, the camera is only recorded for the capture schedule.
+		FVector CameraClipPlaneBase = FVector::ZeroVector;
+		FVector CameraClipPlaneNormal = FVector::UpVector;
+		RecordCaptureCamera(CameraClipPlaneBase, CameraClipPlaneNormal);
+		return;
+	}
+
+	Super::CaptureComposite();
+}
+
+int32 USoftMaskCaptureComponent::GetCaptureResolutionDivisor() const
+{
+	if (WorldComposite)
+	{
+		switch (WorldComposite->GetResolvedSettings().SoftMaskCaptureResolution)
+		{
+		case ESoftMaskCaptureResolution::Half:
+			return 2;
+
+		case ESoftMaskCaptureResolution::Quarter:
+			return 4;
+
+		default:
+			break;
+		}
+	}
+
+	return 1;
+}
+
+void USoftMaskCaptureComponent::ReleaseUpsampledTextureTarget()
+{
+	if (!UpsampledTextureTarget)
+	{
+		return;
+	}
+
+	if (IsValid(CompositorSubsystem))
+	{
+		CompositorSubsystem->SetSoftMaskUpsample(nullptr, nullptr);
+		CompositorSubsystem->UnbindMaterialTexture(MaterialTextureTarget, UpsampledTextureTarget);
+		CompositorSubsystem->GetRenderTargetPool().Release(UpsampledTextureTarget);
+	}
+
+	UpsampledTextureTarget = nullptr;
+}
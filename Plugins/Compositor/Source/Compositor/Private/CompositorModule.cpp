@@ -1,21 +1,89 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "CompositorModule.h"
+#include "CompositorStats.h"
+#include "Assets/CompositeKeyer.h"
+
+#if WITH_EDITOR
+#include "Editor.h"
+#include "Materials/Material.h"
+#endif
+
+UE_TRACE_CHANNEL_DEFINE(CompositorChannel);
+
+DEFINE_GPU_STAT(Compositor);
+
+DEFINE_STAT(STAT_CompositorTick);
+DEFINE_STAT(STAT_CompositorUpdateLensData);
+DEFINE_STAT(STAT_CompositorUpdateCompositeKeyer);
+DEFINE_STAT(STAT_CompositorUpdateCompositeViewportInfo);
+DEFINE_STAT(STAT_CompositorComputeCompositePostProcess);
+DEFINE_STAT(STAT_CompositorCompositeUpdate);
+DEFINE_STAT(STAT_CompositorCompositeMeshRegistration);
+DEFINE_STAT(STAT_CompositorSetupView);
+DEFINE_STAT(STAT_CompositorCaptureTick);
+DEFINE_STAT(STAT_CompositorCaptureUpdate);
+DEFINE_STAT(STAT_CompositorKeyerDraws);
+DEFINE_STAT(STAT_CompositorUndistortDraws);
+DEFINE_STAT(STAT_CompositorCaptureRenders);
+DEFINE_STAT(STAT_CompositorPlanarReflectionActors);
+DEFINE_STAT(STAT_CompositorPlanarReflectionPrimitives);
+DEFINE_STAT(STAT_CompositorCompositeUpdateListeners);
+DEFINE_STAT(STAT_CompositorCompositeUpdateListenersSkipped);
+DEFINE_STAT(STAT_CompositorCompositeMeshesRegistered);
+DEFINE_STAT(STAT_CompositorCompositeMeshesQueued);
+DEFINE_STAT(STAT_CompositorSoftMaskMeshDraws);
+DEFINE_STAT(STAT_CompositorRenderTargetResizes);
+DEFINE_STAT(STAT_CompositorRenderTargetAllocations);
+DEFINE_STAT(STAT_CompositorMPCParametersWritten);
+DEFINE_STAT(STAT_CompositorMPCParametersSkipped);
+DEFINE_STAT(STAT_CompositorMediaFramesDropped);
+DEFINE_STAT(STAT_CompositorMediaFramesRepeated);
+DEFINE_STAT(STAT_CompositorRenderTargetMemory);
+DEFINE_STAT(STAT_CompositorRenderTargetPoolFreeMemory);
 
 #define LOCTEXT_NAMESPACE "FCompositorModule"
 
 void FCompositorModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
-		
+
+#if WITH_EDITOR
+	// Keyer parameter bindings depend on the layout of the keyer class and the parameters of its material.
+	if (GEditor)
+	{
+		GEditor->OnBlueprintCompiled().AddRaw(this, &FCompositorModule::OnBlueprintCompiled);
+	}
+	UMaterial::OnMaterialCompilationFinished().AddRaw(this, &FCompositorModule::OnMaterialCompilationFinished);
+#endif
 }
 
 void FCompositorModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
-		
+
+#if WITH_EDITOR
+	if (GEditor)
+	{
+		GEditor->OnBlueprintCompiled().RemoveAll(this);
+	}
+	UMaterial::OnMaterialCompilationFinished().RemoveAll(this);
+#endif
+}
+
+#if WITH_EDITOR
+void FCompositorModule::OnBlueprintCompiled()
+{
+	UCompositeKeyer::InvalidateParameterBindings();
+}
+
+void FCompositorModule::OnMaterialCompilationFinished(UMaterialInterface* MaterialInterface)
+{
+	// Any material of the project can finish compiling, only the keyers built on it need new bindings.
+	UCompositeKeyer::InvalidateParameterBindings(MaterialInterface);
 }
+#endif
 
 #undef LOCTEXT_NAMESPACE
 	
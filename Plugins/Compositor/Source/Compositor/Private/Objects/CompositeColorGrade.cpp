@@ -2,6 +2,7 @@
 
 #include "Objects/CompositeColorGrade.h"
 #include "Assets/Composite.h"
+#include "Subsystems/CompositorSubsystem.h" // LogCompositor
 
 UCompositeColorGrade::UCompositeColorGrade()
 {
@@ -33,6 +34,7 @@ FColorGradePerRangeSettings UCompositeColorGrade::GetColorGradeScene() const
 void UCompositeColorGrade::SetColorGradeScene(FColorGradePerRangeSettings NewColorGradeScene)
 {
 	ColorGradeScene = NewColorGradeScene;
+	UComposite::MarkSettingsDirty();
 }
 
 FColorGradePerRangeSettings UCompositeColorGrade::GetColorGradeMedia() const
@@ -60,6 +62,7 @@ FColorGradePerRangeSettings UCompositeColorGrade::GetColorGradeMedia() const
 void UCompositeColorGrade::SetColorGradeMedia(FColorGradePerRangeSettings NewColorGradeMedia)
 {
 	ColorGradeMedia = NewColorGradeMedia;
+	UComposite::MarkSettingsDirty();
 }
 
 FColorGradePerRangeSettings UCompositeColorGrade::GetColorGradeCombined() const
@@ -87,4 +90,29 @@ FColorGradePerRangeSettings UCompositeColorGrade::GetColorGradeCombined() const
 void UCompositeColorGrade::SetColorGradeCombined(FColorGradePerRangeSettings NewColorGradeCombined)
 {
 	ColorGradeCombined = NewColorGradeCombined;
+	UComposite::MarkSettingsDirty();
 }
+
+bool UCompositeColorGrade::SetPropertyOverride(FName PropertyName, bool bOverride)
+{
+	const FName OverrideName(*FString::Printf(TEXT("bOverride_%s"), *PropertyName.ToString()));
+	const FBoolProperty* OverrideProperty = FindFProperty<FBoolProperty>(GetClass(), OverrideName);
+	if (OverrideProperty == nullptr)
+	{
+		UE_LOG(LogCompositor, Warning, TEXT("Composite Color Grade %s has no override for the property %s."), *GetName(), *PropertyName.ToString());
+		return false;
+	}
+
+	OverrideProperty->SetPropertyValue_InContainer(this, bOverride);
+	UComposite::MarkSettingsDirty();
+	return true;
+}
+
+#if WITH_EDITOR
+void UCompositeColorGrade::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	UComposite::MarkSettingsDirty();
+}
+#endif // WITH_EDITOR
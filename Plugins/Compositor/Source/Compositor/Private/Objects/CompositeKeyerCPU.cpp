@@ -0,0 +1,471 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Objects/CompositeKeyerCPU.h"
+
+#include "Subsystems/CompositorSubsystem.h" // LogCompositor
+
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/VectorRegister.h"
+
+namespace CompositeKeyerCPU
+{
+	/** Number of pixels converted to float at once for the integer formats. */
+	constexpr int32 ChunkSize = 64;
+
+	/** The first of the two channels that are not the key channel, in RGB order. */
+	constexpr int32 GetOtherChannel1(int32 KeyChannel)
+	{
+		return KeyChannel == 0 ? 1 : 0;
+	}
+
+	/** The second of the two channels that are not the key channel, in RGB order. */
+	constexpr int32 GetOtherChannel2(int32 KeyChannel)
+	{
+		return KeyChannel == 2 ? 1 : 2;
+	}
+
+	FCompositeKeyerCPU::FConstants ComputeConstants(const FCompositeKeyerCPUSettings& Settings)
+	{
+		const float Key[3] = { Settings.KeyColor.R, Settings.KeyColor.G, Settings.KeyColor.B };
+
+		FCompositeKeyerCPU::FConstants Constants;
+		Constants.KeyChannel = (Key[1] >= Key[0] && Key[1] >= Key[2]) ? 1 : (Key[2] >= Key[0] ? 2 : 0);
+		Constants.Weight1 = Settings.RedWeight;
+		Constants.Weight2 = Settings.BlueWeight;
+
+		// The color difference of the key color itself normalizes the matte, the screen keys to 0.
+		const float KeyDifference = Key[Constants.KeyChannel]
+			- (Key[GetOtherChannel1(Constants.KeyChannel)] * Constants.Weight1 + Key[GetOtherChannel2(Constants.KeyChannel)] * Constants.Weight2);
+		Constants.InvKeyDifference = 1.F / FMath::Max(KeyDifference, KINDA_SMALL_NUMBER);
+
+		Constants.AlphaThreshold = Settings.AlphaThreshold;
+		Constants.AlphaOffset = Settings.AlphaOffset;
+		Constants.ClipBlack = Settings.ClipBlack;
+		Constants.InvClipRange = 1.F / FMath::Max(Settings.ClipWhite - Settings.ClipBlack, KINDA_SMALL_NUMBER);
+
+		return Constants;
+	}
+
+	/** Keys a single pixel, also used for the pixels left over after the vectorized loop. */
+	template<int32 KeyChannel>
+	FORCEINLINE void KeyPixelScalar(const FCompositeKeyerCPU::FConstants& Constants, const float* Source, float* Destination)
+	{
+		constexpr int32 Other1 = GetOtherChannel1(KeyChannel);
+		constexpr int32 Other2 = GetOtherChannel2(KeyChannel);
+
+		const float Primary = Source[KeyChannel];
+		const float Other1Value = Source[Other1];
+		const float Other2Value = Source[Other2];
+
+		// DiffColorKeyer
+		const float Difference = Primary - (Other1Value * Constants.Weight1 + Other2Value * Constants.Weight2);
+		const float Matte = 1.F - Difference * Constants.InvKeyDifference;
+		const float OffsetMatte = Matte > Constants.AlphaThreshold ? FMath::Clamp(Matte + Constants.AlphaOffset, 0.F, 1.F) : 0.F;
+		const float Alpha = FMath::Clamp((OffsetMatte - Constants.ClipBlack) * Constants.InvClipRange, 0.F, 1.F);
+
+		// DespillByAvg
+		Destination[KeyChannel] = FMath::Min(Primary, (Other1Value + Other2Value) * 0.5F);
+		Destination[Other1] = Other1Value;
+		Destination[Other2] = Other2Value;
+		Destination[3] = Alpha;
+	}
+
+	/** Loads four interleaved RGBA pixels as one register per channel. */
+	FORCEINLINE void LoadDeinterleaved(const float* Source, VectorRegister4Float& R, VectorRegister4Float& G, VectorRegister4Float& B, VectorRegister4Float& A)
+	{
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+		const float32x4x4_t Pixels = vld4q_f32(Source);
+		R = Pixels.val[0];
+		G = Pixels.val[1];
+		B = Pixels.val[2];
+		A = Pixels.val[3];
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+		R = _mm_loadu_ps(Source);
+		G = _mm_loadu_ps(Source + 4);
+		B = _mm_loadu_ps(Source + 8);
+		A = _mm_loadu_ps(Source + 12);
+		_MM_TRANSPOSE4_PS(R, G, B, A);
+#else
+		R = MakeVectorRegisterFloat(Source[0], Source[4], Source[8], Source[12]);
+		G = MakeVectorRegisterFloat(Source[1], Source[5], Source[9], Source[13]);
+		B = MakeVectorRegisterFloat(Source[2], Source[6], Source[10], Source[14]);
+		A = MakeVectorRegisterFloat(Source[3], Source[7], Source[11], Source[15]);
+#endif
+	}
+
+	/** Stores one register per channel as four interleaved RGBA pixels. */
+	FORCEINLINE void StoreInterleaved(float* Destination, VectorRegister4Float R, VectorRegister4Float G, VectorRegister4Float B, VectorRegister4Float A)
+	{
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+		float32x4x4_t Pixels;
+		Pixels.val[0] = R;
+		Pixels.val[1] = G;
+		Pixels.val[2] = B;
+		Pixels.val[3] = A;
+		vst4q_f32(Destination, Pixels);
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+		_MM_TRANSPOSE4_PS(R, G, B, A);
+		_mm_storeu_ps(Destination, R);
+		_mm_storeu_ps(Destination + 4, G);
+		_mm_storeu_ps(Destination + 8, B);
+		_mm_storeu_ps(Destination + 12, A);
+#else
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			Destination[Index * 4 + 0] = R.V[Index];
+			Destination[Index * 4 + 1] = G.V[Index];
+			Destination[Index * 4 + 2] = B.V[Index];
+			Destination[Index * 4 + 3] = A.V[Index];
+		}
+#endif
+	}
+
+	/** Keys a run of interleaved linear RGBA pixels, four at a time. */
+	template<int32 KeyChannel>
+	void KeyPixels(const FCompositeKeyerCPU::FConstants& Constants, const float* Source, float* Destination, int32 NumPixels)
+	{
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		const VectorRegister4Float One = VectorOneFloat();
+		const VectorRegister4Float Half = VectorSetFloat1(0.5F);
+		const VectorRegister4Float Weight1 = VectorSetFloat1(Constants.Weight1);
+		const VectorRegister4Float Weight2 = VectorSetFloat1(Constants.Weight2);
+		const VectorRegister4Float InvKeyDifference = VectorSetFloat1(Constants.InvKeyDifference);
+		const VectorRegister4Float AlphaThreshold = VectorSetFloat1(Constants.AlphaThreshold);
+		const VectorRegister4Float AlphaOffset = VectorSetFloat1(Constants.AlphaOffset);
+		const VectorRegister4Float ClipBlack = VectorSetFloat1(Constants.ClipBlack);
+		const VectorRegister4Float InvClipRange = VectorSetFloat1(Constants.InvClipRange);
+
+		int32 PixelIndex = 0;
+		for (; PixelIndex + 4 <= NumPixels; PixelIndex += 4)
+		{
+			VectorRegister4Float Channels[3];
+			VectorRegister4Float SourceAlpha;
+			LoadDeinterleaved(Source + PixelIndex * 4, Channels[0], Channels[1], Channels[2], SourceAlpha);
+
+			VectorRegister4Float& Primary = Channels[KeyChannel];
+			const VectorRegister4Float Other1 = Channels[GetOtherChannel1(KeyChannel)];
+			const VectorRegister4Float Other2 = Channels[GetOtherChannel2(KeyChannel)];
+
+			const VectorRegister4Float Weighted = VectorMultiplyAdd(Other2, Weight2, VectorMultiply(Other1, Weight1));
+			const VectorRegister4Float Difference = VectorSubtract(Primary, Weighted);
+
+			const VectorRegister4Float Matte = VectorSubtract(One, VectorMultiply(Difference, InvKeyDifference));
+			const VectorRegister4Float OffsetMatte = VectorSelect(VectorCompareGT(Matte, AlphaThreshold), VectorMin(VectorMax(VectorAdd(Matte, AlphaOffset), Zero), One), Zero);
+			const VectorRegister4Float Alpha = VectorMin(VectorMax(VectorMultiply(VectorSubtract(OffsetMatte, ClipBlack), InvClipRange), Zero), One);
+
+			Primary = VectorMin(Primary, VectorMultiply(VectorAdd(Other1, Other2), Half));
+
+			StoreInterleaved(Destination + PixelIndex * 4, Channels[0], Channels[1], Channels[2], Alpha);
+		}
+
+		for (; PixelIndex < NumPixels; ++PixelIndex)
+		{
+			KeyPixelScalar<KeyChannel>(Constants, Source + PixelIndex * 4, Destination + PixelIndex * 4);
+		}
+	}
+
+	void KeyPixels(const FCompositeKeyerCPU::FConstants& Constants, const float* Source, float* Destination, int32 NumPixels)
+	{
+		switch (Constants.KeyChannel)
+		{
+		case 0:
+			KeyPixels<0>(Constants, Source, Destination, NumPixels);
+			break;
+		case 2:
+			KeyPixels<2>(Constants, Source, Destination, NumPixels);
+			break;
+		default:
+			KeyPixels<1>(Constants, Source, Destination, NumPixels);
+			break;
+		}
+	}
+
+	/** Grades the color of a single pixel in place, must match GradeColor in CompositeMediaPrePass.usf. */
+	FORCEINLINE void GradePixelScalar(const FCompositeKeyerCPUGrade& Grade, float* Pixel)
+	{
+		const float Luma = Pixel[0] * 0.2126F + Pixel[1] * 0.7152F + Pixel[2] * 0.0722F;
+
+		for (int32 Channel = 0; Channel < 3; ++Channel)
+		{
+			float Value = FMath::Max(FMath::Lerp(Luma, Pixel[Channel], Grade.Saturation[Channel] * Grade.Saturation.W), 0.F);
+			Value = FMath::Pow(Value * (1.F / 0.18F), Grade.Contrast[Channel] * Grade.Contrast.W) * 0.18F;
+			Value = FMath::Pow(Value, 1.F / (Grade.Gamma[Channel] * Grade.Gamma.W));
+			Pixel[Channel] = Value * (Grade.Gain[Channel] * Grade.Gain.W) + (Grade.Offset[Channel] + Grade.Offset.W);
+		}
+	}
+
+	/** Bilinear sample with clamped addressing and texel centers at half texels, like a GPU sampler. */
+	template<typename TexelType>
+	FORCEINLINE TexelType SampleBilinear(const TexelType* Texels, FIntPoint Size, FVector2f UV)
+	{
+		const float X = UV.X * Size.X - 0.5F;
+		const float Y = UV.Y * Size.Y - 0.5F;
+		const int32 X0 = FMath::FloorToInt(X);
+		const int32 Y0 = FMath::FloorToInt(Y);
+		const float FractionX = X - X0;
+		const float FractionY = Y - Y0;
+
+		auto Texel = [Texels, Size](int32 TexelX, int32 TexelY) -> const TexelType&
+		{
+			return Texels[static_cast<int64>(FMath::Clamp(TexelY, 0, Size.Y - 1)) * Size.X + FMath::Clamp(TexelX, 0, Size.X - 1)];
+		};
+
+		const TexelType Top = FMath::Lerp(Texel(X0, Y0), Texel(X0 + 1, Y0), FractionX);
+		const TexelType Bottom = FMath::Lerp(Texel(X0, Y0 + 1), Texel(X0 + 1, Y0 + 1), FractionX);
+		return FMath::Lerp(Top, Bottom, FractionY);
+	}
+
+	/** Converts and keys a frame in chunks, ConvertFunction turns a run of source pixels into linear RGBA floats. */
+	template<typename SourceType, typename ConvertFunctionType>
+	void KeyConverted(const FCompositeKeyerCPU::FConstants& Constants, const SourceType* Source, FLinearColor* Destination, FIntPoint Size, ConvertFunctionType ConvertFunction)
+	{
+		ParallelFor(Size.Y, [&Constants, Source, Destination, Size, &ConvertFunction](int32 Row)
+		{
+			MS_ALIGN(16) float Scratch[ChunkSize * 4] GCC_ALIGN(16);
+
+			const SourceType* SourceRow = Source + static_cast<int64>(Row) * Size.X;
+			FLinearColor* DestinationRow = Destination + static_cast<int64>(Row) * Size.X;
+
+			for (int32 Column = 0; Column < Size.X; Column += ChunkSize)
+			{
+				const int32 NumPixels = FMath::Min(ChunkSize, Size.X - Column);
+				ConvertFunction(SourceRow + Column, Scratch, NumPixels);
+				KeyPixels(Constants, Scratch, reinterpret_cast<float*>(DestinationRow + Column), NumPixels);
+			}
+		});
+	}
+}
+
+FCompositeKeyerCPUGrade::FCompositeKeyerCPUGrade(const FColorGradePerRangeSettings& InSettings)
+	: Saturation(InSettings.Saturation)
+	, Contrast(InSettings.Contrast)
+	, Gamma(InSettings.Gamma)
+	, Gain(InSettings.Gain)
+	, Offset(InSettings.Offset)
+{
+}
+
+FCompositeKeyerCPU::FCompositeKeyerCPU(const FCompositeKeyerCPUSettings& InSettings)
+{
+	SetSettings(InSettings);
+}
+
+void FCompositeKeyerCPU::SetSettings(const FCompositeKeyerCPUSettings& InSettings)
+{
+	Settings = InSettings;
+	Constants = CompositeKeyerCPU::ComputeConstants(Settings);
+}
+
+void FCompositeKeyerCPU::Key(const FLinearColor* Source, FLinearColor* Destination, FIntPoint Size) const
+{
+	if (!Source || !Destination || Size.X <= 0 || Size.Y <= 0)
+	{
+		return;
+	}
+
+	const FConstants& KernelConstants = Constants;
+	ParallelFor(Size.Y, [&KernelConstants, Source, Destination, Size](int32 Row)
+	{
+		const int64 RowOffset = static_cast<int64>(Row) * Size.X;
+		CompositeKeyerCPU::KeyPixels(KernelConstants, reinterpret_cast<const float*>(Source + RowOffset), reinterpret_cast<float*>(Destination + RowOffset), Size.X);
+	});
+}
+
+void FCompositeKeyerCPU::Key(const FColor* Source, FLinearColor* Destination, FIntPoint Size) const
+{
+	if (!Source || !Destination || Size.X <= 0 || Size.Y <= 0)
+	{
+		return;
+	}
+
+	CompositeKeyerCPU::KeyConverted(Constants, Source, Destination, Size, [](const FColor* Pixels, float* Scratch, int32 NumPixels)
+	{
+		for (int32 Index = 0; Index < NumPixels; ++Index)
+		{
+			Scratch[Index * 4 + 0] = FLinearColor::sRGBToLinearTable[Pixels[Index].R];
+			Scratch[Index * 4 + 1] = FLinearColor::sRGBToLinearTable[Pixels[Index].G];
+			Scratch[Index * 4 + 2] = FLinearColor::sRGBToLinearTable[Pixels[Index].B];
+			Scratch[Index * 4 + 3] = Pixels[Index].A * (1.F / 255.F);
+		}
+	});
+}
+
+void FCompositeKeyerCPU::KeyRGB10A2(const uint32* Source, FLinearColor* Destination, FIntPoint Size) const
+{
+	if (!Source || !Destination || Size.X <= 0 || Size.Y <= 0)
+	{
+		return;
+	}
+
+	CompositeKeyerCPU::KeyConverted(Constants, Source, Destination, Size, [](const uint32* Pixels, float* Scratch, int32 NumPixels)
+	{
+		for (int32 Index = 0; Index < NumPixels; ++Index)
+		{
+			const uint32 Pixel = Pixels[Index];
+			Scratch[Index * 4 + 0] = (Pixel & 0x3FF) * (1.F / 1023.F);
+			Scratch[Index * 4 + 1] = ((Pixel >> 10) & 0x3FF) * (1.F / 1023.F);
+			Scratch[Index * 4 + 2] = ((Pixel >> 20) & 0x3FF) * (1.F / 1023.F);
+			Scratch[Index * 4 + 3] = (Pixel >> 30) * (1.F / 3.F);
+		}
+	});
+}
+
+void FCompositeKeyerCPU::KeyUndistortGrade(const FLinearColor* Source, FIntPoint SourceSize, const FVector2f* Displacement, FIntPoint DisplacementSize, const FCompositeKeyerCPUGrade& Grade, FLinearColor* Destination, FIntPoint DestinationSize) const
+{
+	if (!Source || !Destination || SourceSize.X <= 0 || SourceSize.Y <= 0 || DestinationSize.X <= 0 || DestinationSize.Y <= 0)
+	{
+		return;
+	}
+
+	if (DisplacementSize.X <= 0 || DisplacementSize.Y <= 0)
+	{
+		Displacement = nullptr;
+	}
+
+	const FConstants& KernelConstants = Constants;
+	ParallelFor(DestinationSize.Y, [&KernelConstants, &Grade, Source, SourceSize, Displacement, DisplacementSize, Destination, DestinationSize](int32 Row)
+	{
+		MS_ALIGN(16) float Scratch[CompositeKeyerCPU::ChunkSize * 4] GCC_ALIGN(16);
+
+		const float V = (Row + 0.5F) / DestinationSize.Y;
+		FLinearColor* DestinationRow = Destination + static_cast<int64>(Row) * DestinationSize.X;
+
+		for (int32 Column = 0; Column < DestinationSize.X; Column += CompositeKeyerCPU::ChunkSize)
+		{
+			const int32 NumPixels = FMath::Min(CompositeKeyerCPU::ChunkSize, DestinationSize.X - Column);
+
+			FLinearColor* ScratchPixels = reinterpret_cast<FLinearColor*>(Scratch);
+			for (int32 Index = 0; Index < NumPixels; ++Index)
+			{
+				FVector2f UV((Column + Index + 0.5F) / DestinationSize.X, V);
+				if (Displacement)
+				{
+					UV += CompositeKeyerCPU::SampleBilinear(Displacement, DisplacementSize, UV);
+				}
+				ScratchPixels[Index] = CompositeKeyerCPU::SampleBilinear(Source, SourceSize, UV);
+			}
+
+			float* DestinationPixels = reinterpret_cast<float*>(DestinationRow + Column);
+			CompositeKeyerCPU::KeyPixels(KernelConstants, Scratch, DestinationPixels, NumPixels);
+
+			for (int32 Index = 0; Index < NumPixels; ++Index)
+			{
+				CompositeKeyerCPU::GradePixelScalar(Grade, DestinationPixels + Index * 4);
+			}
+		}
+	});
+}
+
+FLinearColor FCompositeKeyerCPU::KeyPixel(const FCompositeKeyerCPUSettings& InSettings, const FLinearColor& Pixel)
+{
+	const FConstants PixelConstants = CompositeKeyerCPU::ComputeConstants(InSettings);
+
+	FLinearColor Result;
+	switch (PixelConstants.KeyChannel)
+	{
+	case 0:
+		CompositeKeyerCPU::KeyPixelScalar<0>(PixelConstants, &Pixel.R, &Result.R);
+		break;
+	case 2:
+		CompositeKeyerCPU::KeyPixelScalar<2>(PixelConstants, &Pixel.R, &Result.R);
+		break;
+	default:
+		CompositeKeyerCPU::KeyPixelScalar<1>(PixelConstants, &Pixel.R, &Result.R);
+		break;
+	}
+
+	return Result;
+}
+
+FLinearColor FCompositeKeyerCPU::GradePixel(const FCompositeKeyerCPUGrade& Grade, const FLinearColor& Pixel)
+{
+	FLinearColor Result = Pixel;
+	CompositeKeyerCPU::GradePixelScalar(Grade, &Result.R);
+	return Result;
+}
+
+void FCompositeKeyerCPU::RunBenchmark(int32 NumFrames)
+{
+	NumFrames = FMath::Max(NumFrames, 1);
+
+	const FCompositeKeyerCPU Keyer;
+	const FIntPoint Resolutions[] = { FIntPoint(1920, 1080), FIntPoint(3840, 2160) };
+
+	for (const FIntPoint& Size : Resolutions)
+	{
+		const int32 NumPixels = Size.X * Size.Y;
+
+		// A noisy green screen with a gray subject in the middle, so the key and despill do real work.
+		FRandomStream RandomStream(NumPixels);
+		TArray<FLinearColor> LinearFrame;
+		LinearFrame.SetNumUninitialized(NumPixels);
+		for (int32 Index = 0; Index < NumPixels; ++Index)
+		{
+			const bool bIsSubject = FMath::Abs((Index % Size.X) - Size.X / 2) < Size.X / 6;
+			const float Noise = RandomStream.FRandRange(-0.05F, 0.05F);
+			LinearFrame[Index] = bIsSubject ? FLinearColor(0.4F + Noise, 0.45F + Noise, 0.4F + Noise, 1.F) : FLinearColor(0.1F + Noise, 0.7F + Noise, 0.15F + Noise, 1.F);
+		}
+
+		TArray<FColor> ColorFrame;
+		TArray<uint32> PackedFrame;
+		ColorFrame.SetNumUninitialized(NumPixels);
+		PackedFrame.SetNumUninitialized(NumPixels);
+		for (int32 Index = 0; Index < NumPixels; ++Index)
+		{
+			const FLinearColor Pixel = LinearFrame[Index].GetClamped();
+			ColorFrame[Index] = Pixel.ToFColor(true);
+			PackedFrame[Index] = static_cast<uint32>(Pixel.R * 1023.F)
+				| (static_cast<uint32>(Pixel.G * 1023.F) << 10)
+				| (static_cast<uint32>(Pixel.B * 1023.F) << 20)
+				| (3u << 30);
+		}
+
+		TArray<FLinearColor> KeyedFrame;
+		KeyedFrame.SetNumUninitialized(NumPixels);
+
+		// A mild barrel distortion at a quarter of the resolution, like the lens displacement maps.
+		const FIntPoint DisplacementSize(Size.X / 4, Size.Y / 4);
+		TArray<FVector2f> Displacement;
+		Displacement.SetNumUninitialized(DisplacementSize.X * DisplacementSize.Y);
+		for (int32 Index = 0; Index < Displacement.Num(); ++Index)
+		{
+			const FVector2f Centered((Index % DisplacementSize.X + 0.5F) / DisplacementSize.X - 0.5F, (Index / DisplacementSize.X + 0.5F) / DisplacementSize.Y - 0.5F);
+			Displacement[Index] = Centered * (Centered.SizeSquared() * 0.05F);
+		}
+
+		FCompositeKeyerCPUGrade Grade;
+		Grade.Saturation = FVector4f(1.F, 1.F, 1.F, 1.1F);
+		Grade.Gamma = FVector4f(1.F, 1.F, 1.F, 0.9F);
+
+		auto Measure = [NumFrames, &Size](const TCHAR* FormatName, TFunctionRef<void()> KeyFrame)
+		{
+			// Warm up the task graph and caches.
+			KeyFrame();
+
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				KeyFrame();
+			}
+			const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+			UE_LOG(LogCompositor, Display, TEXT("CPU keyer %dx%d %s: %.3f ms/frame, %.1f fps"),
+				Size.X, Size.Y, FormatName, Seconds * 1000.0 / NumFrames, NumFrames / FMath::Max(Seconds, SMALL_NUMBER));
+		};
+
+		Measure(TEXT("float"), [&]() { Keyer.Key(LinearFrame.GetData(), KeyedFrame.GetData(), Size); });
+		Measure(TEXT("8 bit"), [&]() { Keyer.Key(ColorFrame.GetData(), KeyedFrame.GetData(), Size); });
+		Measure(TEXT("10 bit"), [&]() { Keyer.KeyRGB10A2(PackedFrame.GetData(), KeyedFrame.GetData(), Size); });
+		Measure(TEXT("float undistort grade"), [&]() { Keyer.KeyUndistortGrade(LinearFrame.GetData(), Size, Displacement.GetData(), DisplacementSize, Grade, KeyedFrame.GetData(), Size); });
+	}
+}
+
+static FAutoConsoleCommand CompositeKeyerCPUBenchmarkCommand(
+	TEXT("Compositor.KeyerCPU.Benchmark"),
+	TEXT("Measures the throughput of the CPU keyer at 1080p and 2160p. Optional argument is the number of frames to key per test (default 100)."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumFrames = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
+		FCompositeKeyerCPU::RunBenchmark(NumFrames);
+	}));
@@ -0,0 +1,138 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Objects/CompositeMediaFrameQueue.h"
+
+#include "CompositorStats.h"
+
+bool FCompositeMediaSampleCounter::Enqueue(const TSharedRef<IMediaTextureSample, ESPMode::ThreadSafe>& Sample)
+{
+	NumReceivedSamples.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+FCompositeMediaFrameQueue::FCompositeMediaFrameQueue(int32 InCapacity)
+{
+	Slots.SetNum(FMath::Max(InCapacity, 1));
+}
+
+bool FCompositeMediaFrameQueue::Enqueue(const TSharedRef<IMediaTextureSample, ESPMode::ThreadSafe>& Sample)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (Count == Slots.Num())
+	{
+		PopOldest();
+	}
+
+	FSlot& Slot = GetSlot(Count);
+	Slot.Sample = Sample;
+	Slot.bWasSelected = false;
+	++Count;
+
+	return true;
+}
+
+int32 FCompositeMediaFrameQueue::Num() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return Count;
+}
+
+void FCompositeMediaFrameQueue::RequestFlush()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	// A flush happens on seeks and source changes, the samples were not late so they don't count as dropped.
+	for (FSlot& Slot : Slots)
+	{
+		Slot.Sample.Reset();
+	}
+	Head = 0;
+	Count = 0;
+}
+
+void FCompositeMediaFrameQueue::SelectFrame(const TOptional<FQualifiedFrameTime>& EngineFrameTime, int32 DelayFrames)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	DelayFrames = FMath::Max(DelayFrames, 0);
+
+	int32 SelectedIndex = INDEX_NONE;
+	if (Count > 0)
+	{
+		const TOptional<FTimecode> NewestTimecode = GetSlot(Count - 1).Sample->GetTimecode();
+		if (EngineFrameTime.IsSet() && NewestTimecode.IsSet())
+		{
+			// Compare in the engine frame rate, media timecode is expected to be genlocked to it.
+			const FFrameRate FrameRate = EngineFrameTime->Rate;
+			const int32 TargetFrame = EngineFrameTime->Time.GetFrame().Value - DelayFrames;
+
+			for (int32 Index = Count - 1; Index >= 0; --Index)
+			{
+				const TOptional<FTimecode> Timecode = GetSlot(Index).Sample->GetTimecode();
+				if (Timecode.IsSet() && Timecode->ToFrameNumber(FrameRate).Value <= TargetFrame)
+				{
+					SelectedIndex = Index;
+					break;
+				}
+			}
+		}
+		else
+		{
+			SelectedIndex = FMath::Max(Count - 1 - DelayFrames, 0);
+		}
+	}
+
+	if (SelectedIndex == INDEX_NONE)
+	{
+		if (SelectedSample.IsValid())
+		{
+			++NumRepeatedFrames;
+			INC_DWORD_STAT(STAT_CompositorMediaFramesRepeated);
+		}
+		return;
+	}
+
+	FSlot& SelectedSlot = GetSlot(SelectedIndex);
+	if (SelectedSlot.bWasSelected)
+	{
+		++NumRepeatedFrames;
+		INC_DWORD_STAT(STAT_CompositorMediaFramesRepeated);
+	}
+	SelectedSlot.bWasSelected = true;
+	SelectedSample = SelectedSlot.Sample;
+
+	// Older samples can never be selected again.
+	for (int32 Index = 0; Index < SelectedIndex; ++Index)
+	{
+		PopOldest();
+	}
+}
+
+bool FCompositeMediaFrameQueue::IsSampleFormatSupported(const IMediaTextureSample& Sample)
+{
+	switch (Sample.GetFormat())
+	{
+	case EMediaTextureSampleFormat::CharBGRA:
+	case EMediaTextureSampleFormat::CharBGR10A2:
+	case EMediaTextureSampleFormat::FloatRGB:
+	case EMediaTextureSampleFormat::FloatRGBA:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void FCompositeMediaFrameQueue::PopOldest()
+{
+	FSlot& Slot = Slots[Head];
+	if (!Slot.bWasSelected)
+	{
+		++NumDroppedFrames;
+		INC_DWORD_STAT(STAT_CompositorMediaFramesDropped);
+	}
+
+	Slot.Sample.Reset();
+	Head = (Head + 1) % Slots.Num();
+	--Count;
+}
@@ -0,0 +1,97 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Objects/CompositeSoftMaskUpsampleCPU.h"
+
+#include "Async/ParallelFor.h"
+
+namespace CompositeSoftMaskUpsampleCPU
+{
+	/** Below this no sample is within about three sigma of the output pixel depth, the surface is thinner than a low resolution pixel. */
+	constexpr float MinTotalWeight = 1.E-4F;
+
+	/** Depth weight above which a sample is on the surface of the output pixel, only those bound the history. */
+	constexpr float HistoryDepthMatch = 0.5F;
+}
+
+void FCompositeSoftMaskUpsampleCPU::Upsample(const FCompositeSoftMaskUpsampleCPUSettings& Settings, const float* LowResMask, const float* LowResDepth, FIntPoint LowResSize, const float* Depth, const float* History, float* Destination, FIntPoint Size)
+{
+	if (!LowResMask || !LowResDepth || !Depth || !Destination || LowResSize.X <= 0 || LowResSize.Y <= 0)
+	{
+		return;
+	}
+
+	ParallelFor(Size.Y, [&Settings, LowResMask, LowResDepth, LowResSize, Depth, History, Destination, Size](int32 Row)
+	{
+		const int64 RowOffset = static_cast<int64>(Row) * Size.X;
+		const float V = (Row + 0.5F) / Size.Y;
+
+		for (int32 Column = 0; Column < Size.X; ++Column)
+		{
+			const int64 Index = RowOffset + Column;
+			const FVector2f UV((Column + 0.5F) / Size.X, V);
+			Destination[Index] = UpsamplePixel(Settings, LowResMask, LowResDepth, LowResSize, UV, Depth[Index], History ? History + Index : nullptr);
+		}
+	});
+}
+
+float FCompositeSoftMaskUpsampleCPU::UpsamplePixel(const FCompositeSoftMaskUpsampleCPUSettings& Settings, const float* LowResMask, const float* LowResDepth, FIntPoint LowResSize, FVector2f UV, float PixelDepth, const float* PixelHistory)
+{
+	const FVector2f LowResPosition(UV.X * LowResSize.X - 0.5F, UV.Y * LowResSize.Y - 0.5F);
+	const int32 BaseX = FMath::FloorToInt(LowResPosition.X);
+	const int32 BaseY = FMath::FloorToInt(LowResPosition.Y);
+	const float FracX = LowResPosition.X - BaseX;
+	const float FracY = LowResPosition.Y - BaseY;
+
+	const float ClampedPixelDepth = FMath::Min(PixelDepth, FarDepth);
+	const float InvDepthRange = 1.F / FMath::Max(ClampedPixelDepth * Settings.DepthSigma, KINDA_SMALL_NUMBER);
+
+	float BilinearMask = 0.F;
+	float WeightedMask = 0.F;
+	float TotalWeight = 0.F;
+	float MinMask = MAX_flt;
+	float MaxMask = -MAX_flt;
+	float MinSurfaceMask = MAX_flt;
+	float MaxSurfaceMask = -MAX_flt;
+
+	for (int32 Tap = 0; Tap < 4; ++Tap)
+	{
+		const int32 OffsetX = Tap & 1;
+		const int32 OffsetY = Tap >> 1;
+		const int32 X = FMath::Clamp(BaseX + OffsetX, 0, LowResSize.X - 1);
+		const int32 Y = FMath::Clamp(BaseY + OffsetY, 0, LowResSize.Y - 1);
+		const int64 Index = static_cast<int64>(Y) * LowResSize.X + X;
+
+		const float Mask = LowResMask[Index];
+		const float SpatialWeight = (OffsetX ? FracX : 1.F - FracX) * (OffsetY ? FracY : 1.F - FracY);
+		const float DepthDifference = (FMath::Min(LowResDepth[Index], FarDepth) - ClampedPixelDepth) * InvDepthRange;
+		const float DepthWeight = FMath::Exp(-DepthDifference * DepthDifference);
+		const float Weight = SpatialWeight * DepthWeight;
+
+		BilinearMask += SpatialWeight * Mask;
+		WeightedMask += Weight * Mask;
+		TotalWeight += Weight;
+		MinMask = FMath::Min(MinMask, Mask);
+		MaxMask = FMath::Max(MaxMask, Mask);
+
+		if (!Settings.bBilinearOnly && DepthWeight > CompositeSoftMaskUpsampleCPU::HistoryDepthMatch)
+		{
+			MinSurfaceMask = FMath::Min(MinSurfaceMask, Mask);
+			MaxSurfaceMask = FMath::Max(MaxSurfaceMask, Mask);
+		}
+	}
+
+	float Result = (Settings.bBilinearOnly || TotalWeight < CompositeSoftMaskUpsampleCPU::MinTotalWeight) ? BilinearMask : WeightedMask / TotalWeight;
+
+	if (PixelHistory && Settings.TemporalWeight > 0.F)
+	{
+		// Only the samples on the surface of the pixel bound the history, all four span both sides of an edge and would let any history through.
+		if (MinSurfaceMask <= MaxSurfaceMask)
+		{
+			MinMask = MinSurfaceMask;
+			MaxMask = MaxSurfaceMask;
+		}
+		Result = FMath::Lerp(Result, FMath::Clamp(*PixelHistory, MinMask, MaxMask), Settings.TemporalWeight);
+	}
+
+	return Result;
+}
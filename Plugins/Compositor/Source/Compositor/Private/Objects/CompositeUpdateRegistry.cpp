@@ -0,0 +1,78 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Objects/CompositeUpdateRegistry.h"
+
+#include "Actors/CompositeMesh.h"
+
+bool FCompositeUpdateRegistry::Add(const TScriptInterface<ICompositeUpdateInterface>& CompositeUpdateInterface)
+{
+	UObject* Object = CompositeUpdateInterface.GetObject();
+	if (Object == nullptr)
+	{
+		return false;
+	}
+
+	const FObjectKey Key(Object);
+	int32& Index = Indices.FindOrAdd(Key, INDEX_NONE);
+	if (Index != INDEX_NONE)
+	{
+		return false;
+	}
+
+	if (ACompositeMesh* CompositeMesh = Cast<ACompositeMesh>(Object))
+	{
+		Index = CompositeMeshes.Add(CompositeMesh);
+		CompositeMeshKeys.Add(Key);
+	}
+	else
+	{
+		Index = Interfaces.Add(CompositeUpdateInterface);
+		InterfaceKeys.Add(Key);
+	}
+
+	return true;
+}
+
+bool FCompositeUpdateRegistry::Remove(const TScriptInterface<ICompositeUpdateInterface>& CompositeUpdateInterface)
+{
+	const UObject* Object = CompositeUpdateInterface.GetObject();
+
+	int32 Index = INDEX_NONE;
+	if (!Indices.RemoveAndCopyValue(FObjectKey(Object), Index))
+	{
+		return false;
+	}
+
+	if (Object->IsA<ACompositeMesh>())
+	{
+		RemoveAtSwap(CompositeMeshes, CompositeMeshKeys, Index);
+	}
+	else
+	{
+		RemoveAtSwap(Interfaces, InterfaceKeys, Index);
+	}
+
+	return true;
+}
+
+void FCompositeUpdateRegistry::Reset()
+{
+	CompositeMeshes.Reset();
+	Interfaces.Reset();
+	CompositeMeshKeys.Reset();
+	InterfaceKeys.Reset();
+	Indices.Reset();
+}
+
+template<typename ElementType>
+void FCompositeUpdateRegistry::RemoveAtSwap(TArray<ElementType>& Array, TArray<FObjectKey>& Keys, int32 Index)
+{
+	Array.RemoveAtSwap(Index, 1, false);
+	Keys.RemoveAtSwap(Index, 1, false);
+
+	// The last entry moved into the freed slot.
+	if (Keys.IsValidIndex(Index))
+	{
+		Indices.FindChecked(Keys[Index]) = Index;
+	}
+}
@@ -4,12 +4,21 @@
 
 #include "Subsystems/CompositorSubsystem.h"
 #include "Objects/CompositeWorldData.h"
+#include "Objects/CompositorMPCDeltaWriter.h"
+#include "CompositorStats.h"
 
 #include "Materials/MaterialParameterCollection.h"
-#include "Kismet/KismetMaterialLibrary.h"
 
 #include "SceneView.h"
 #include "Camera/CameraActor.h"
+#include "CompositeMediaPrePass.h"
+#include "CompositeSoftMaskUpsample.h"
+#include "Actors/CompositeMesh.h"
+#include "SceneRenderTargetParameters.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "StaticMeshResources.h"
+#include "TextureResource.h"
 
 //------------------------------------------------------------------------------
 FCompositeViewExtension::FCompositeViewExtension(const FAutoRegister& AutoRegister, UCompositorSubsystem* Owner)
@@ -19,6 +28,8 @@ FCompositeViewExtension::FCompositeViewExtension(const FAutoRegister& AutoRegist
 
 void FCompositeViewExtension::SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView)
 {	
+	COMPOSITOR_SCOPE_CYCLE_COUNTER(STAT_CompositorSetupView);
+
 	// Don't do anything for scene captures or orthographic views.
 	if (InView.bIsSceneCapture || !InView.IsPerspectiveProjection())
 		return;
@@ -41,16 +52,21 @@ void FCompositeViewExtension::SetupView(FSceneViewFamily& InViewFamily, FSceneVi
 		UMaterialParameterCollection* CompositorMaterialParameterCollection = CompositorSubsystem->GetCompositorMaterialParameterCollection();
 		if (IsValid(CompositorMaterialParameterCollection))
 		{
-			UKismetMaterialLibrary::SetScalarParameterValue(CompositorSubsystem.Get(), CompositorMaterialParameterCollection, FName("FilmBlackClip"), InView.FinalPostProcessSettings.FilmBlackClip);
-			UKismetMaterialLibrary::SetScalarParameterValue(CompositorSubsystem.Get(), CompositorMaterialParameterCollection, FName("FilmWhiteClip"), InView.FinalPostProcessSettings.FilmWhiteClip);
-			UKismetMaterialLibrary::SetScalarParameterValue(CompositorSubsystem.Get(), CompositorMaterialParameterCollection, FName("FilmShoulder"), InView.FinalPostProcessSettings.FilmShoulder);
-			UKismetMaterialLibrary::SetScalarParameterValue(CompositorSubsystem.Get(), CompositorMaterialParameterCollection, FName("FilmSlope"), InView.FinalPostProcessSettings.FilmSlope);
-			UKismetMaterialLibrary::SetScalarParameterValue(CompositorSubsystem.Get(), CompositorMaterialParameterCollection, FName("FilmToe"), InView.FinalPostProcessSettings.FilmToe);
+			FCompositorMPCDeltaWriter& MPCDeltaWriter = CompositorSubsystem->GetMPCDeltaWriter();
+			const FCompositorMPCParameters& MPCParameters = CompositorSubsystem->GetMPCParameters();
+
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.FilmBlackClip, InView.FinalPostProcessSettings.FilmBlackClip);
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.FilmWhiteClip, InView.FinalPostProcessSettings.FilmWhiteClip);
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.FilmShoulder, InView.FinalPostProcessSettings.FilmShoulder);
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.FilmSlope, InView.FinalPostProcessSettings.FilmSlope);
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.FilmToe, InView.FinalPostProcessSettings.FilmToe);
 
-			UKismetMaterialLibrary::SetScalarParameterValue(CompositorSubsystem.Get(), CompositorMaterialParameterCollection, FName("BlueCorrection"), InView.FinalPostProcessSettings.BlueCorrection);
-			UKismetMaterialLibrary::SetScalarParameterValue(CompositorSubsystem.Get(), CompositorMaterialParameterCollection, FName("ToneCurveAmount"), InView.FinalPostProcessSettings.ToneCurveAmount);
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.BlueCorrection, InView.FinalPostProcessSettings.BlueCorrection);
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.ToneCurveAmount, InView.FinalPostProcessSettings.ToneCurveAmount);
 
-			UKismetMaterialLibrary::SetScalarParameterValue(CompositorSubsystem.Get(), CompositorMaterialParameterCollection, FName("ToneCurveAmount"), 1);
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.ToneCurveAmount, 1);
+
+			MPCDeltaWriter.Flush();
 		}
 
 		UCompositeWorldData* CompositeWorldData = CompositorSubsystem->GetCompositeWorldData();
@@ -69,6 +85,346 @@ void FCompositeViewExtension::SetupView(FSceneViewFamily& InViewFamily, FSceneVi
 	InViewFamily.SceneCaptureSource = SCS_FinalColorHDR;
 }
 
+void FCompositeMaterialTextureBinding::Apply_RenderThread(FRHICommandListImmediate& RHICmdList) const
+{
+	// Material uniform buffers hold the texture reference rather than the texture, so repointing it needs no material update.
+	if (TextureReference && TextureReference->TextureReferenceRHI && BoundTexture && BoundTexture->TextureRHI)
+	{
+		RHICmdList.UpdateTextureReference(TextureReference->TextureReferenceRHI, BoundTexture->TextureRHI);
+	}
+}
+
+void FCompositeMaterialTextureBinding::Restore_RenderThread(FRHICommandListImmediate& RHICmdList) const
+{
+	if (TextureReference && TextureReference->TextureReferenceRHI && OwnTexture && OwnTexture->TextureRHI)
+	{
+		RHICmdList.UpdateTextureReference(TextureReference->TextureReferenceRHI, OwnTexture->TextureRHI);
+	}
+}
+
+/** Resolves a composite mesh into the buffers of its first LOD and how the soft mask mesh pass draws it. */
+static bool MakeSoftMaskMeshDraw(const FCompositeSoftMaskMesh& Mesh, FCompositeSoftMaskMeshDraw& OutDraw)
+{
+	if (!Mesh.RenderData || Mesh.RenderData->LODResources.Num() == 0)
+	{
+		return false;
+	}
+
+	const FStaticMeshLODResources& LODResources = Mesh.RenderData->LODResources[0];
+	OutDraw.PositionBuffer = LODResources.VertexBuffers.PositionVertexBuffer.VertexBufferRHI;
+	OutDraw.ColorBuffer = LODResources.VertexBuffers.ColorVertexBuffer.GetNumVertices() > 0 ? LODResources.VertexBuffers.ColorVertexBuffer.VertexBufferRHI : nullptr;
+	OutDraw.IndexBuffer = LODResources.IndexBuffer.IndexBufferRHI;
+	OutDraw.NumVertices = LODResources.VertexBuffers.PositionVertexBuffer.GetNumVertices();
+	OutDraw.NumIndices = LODResources.IndexBuffer.GetNumIndices();
+	OutDraw.LocalToWorld = Mesh.LocalToWorld;
+	OutDraw.bTwoSided = Mesh.bTwoSided;
+
+	// Same values the soft mask materials write, see ACompositeMesh::UpdateMaterialInstances.
+	switch (Mesh.RenderSoftMask)
+	{
+	case ERenderSoftMaskType::OpaqueBlack:
+		OutDraw.Value = 0.F;
+		break;
+
+	case ERenderSoftMaskType::OpaqueVertexColorAlpha:
+		OutDraw.bUseVertexColorAlpha = true;
+		break;
+
+	case ERenderSoftMaskType::TranslucentVertexColorAlpha:
+		OutDraw.bUseVertexColorAlpha = true;
+		OutDraw.bTranslucent = true;
+		break;
+
+	case ERenderSoftMaskType::OpaqueWhite:
+	default:
+		break;
+	}
+
+	return OutDraw.PositionBuffer && OutDraw.IndexBuffer;
+}
+
+void FCompositeViewExtension::PreRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily)
+{
+	LastActiveFrameNumber.store(InViewFamily.FrameNumber, std::memory_order_relaxed);
+
+	if (SoftMaskMeshPassFrameNumber != InViewFamily.FrameNumber)
+	{
+		// Lets go of the buffers of meshes that may have been removed since.
+		SoftMaskMeshPassOutput = nullptr;
+		SoftMaskMeshPassDraws.Reset();
+	}
+
+	if (PendingSoftMaskMeshPassOutput && InViewFamily.Views.Num() > 0)
+	{
+		SoftMaskMeshPassOutput = PendingSoftMaskMeshPassOutput;
+		SoftMaskMeshPassDraws = MoveTemp(PendingSoftMaskMeshPassDraws);
+		SoftMaskMeshPassFrameNumber = InViewFamily.FrameNumber;
+		bSoftMaskMeshPassCleared = false;
+		PendingSoftMaskMeshPassOutput = nullptr;
+		PendingSoftMaskMeshPassDraws.Reset();
+
+		SoftMaskMeshPassViewRect = InViewFamily.Views[0]->UnscaledViewRect;
+		for (const FSceneView* View : InViewFamily.Views)
+		{
+			SoftMaskMeshPassViewRect.Union(View->UnscaledViewRect);
+		}
+	}
+
+	if (!PendingMediaPrePass.IsSet() || LastMediaPrePassFrameNumber == InViewFamily.FrameNumber)
+	{
+		return;
+	}
+
+	// Every view family rendered after this one in the same frame reads the same output.
+	const FCompositeMediaPrePassRequest Request = PendingMediaPrePass.GetValue();
+	LastMediaPrePassFrameNumber = InViewFamily.FrameNumber;
+	if (!Request.bEveryFrame)
+	{
+		PendingMediaPrePass.Reset();
+	}
+
+	// Resolved here rather than on the game thread, so a media texture shows the sample it received this frame.
+	FRHITexture* MediaTextureRHI = Request.MediaTexture ? Request.MediaTexture->TextureRHI.GetReference() : nullptr;
+	if (FRHITexture* MediaSampleTextureRHI = Request.MediaSample.IsValid() ? Request.MediaSample->GetTexture() : nullptr)
+	{
+		// The passes expect linear color, sRGB encoded samples are only linear when the texture decodes them on read.
+		if (!Request.MediaSample->IsOutputSrgb() || EnumHasAnyFlags(MediaSampleTextureRHI->GetFlags(), TexCreate_SRGB))
+		{
+			MediaTextureRHI = MediaSampleTextureRHI;
+		}
+	}
+	FRHITexture* UndistortTextureRHI = Request.UndistortTexture ? Request.UndistortTexture->TextureRHI.GetReference() : nullptr;
+	FRHITexture* KeyedTextureRHI = Request.KeyedTexture ? Request.KeyedTexture->GetRenderTargetTexture().GetReference() : nullptr;
+	FRHITexture* OutputTextureRHI = Request.OutputTexture ? Request.OutputTexture->GetRenderTargetTexture().GetReference() : nullptr;
+
+	auto CanWrite = [](const FRHITexture* TextureRHI)
+	{
+		return TextureRHI && EnumHasAnyFlags(TextureRHI->GetFlags(), TexCreate_UAV);
+	};
+
+	if (!CanWrite(OutputTextureRHI))
+	{
+		return;
+	}
+
+	COMPOSITOR_RDG_EVENT_SCOPE(GraphBuilder, "Compositor");
+
+	FCompositeMediaPrePassInputs Inputs;
+	Inputs.UndistortTexture = UndistortTextureRHI ? RegisterExternalTexture(GraphBuilder, UndistortTextureRHI, TEXT("Compositor.UndistortDisplacement")) : nullptr;
+	Inputs.OutputTexture = RegisterExternalTexture(GraphBuilder, OutputTextureRHI, TEXT("Compositor.MediaInputUndistorted"));
+
+	if (Request.Mode == ECompositeMediaPrePassMode::Fused)
+	{
+		if (!MediaTextureRHI)
+		{
+			return;
+		}
+
+		Inputs.MediaTexture = RegisterExternalTexture(GraphBuilder, MediaTextureRHI, TEXT("Compositor.MediaInput"));
+
+		const FCompositeKeyerCPU::FConstants& KeyerConstants = Request.KeyerConstants;
+		Inputs.KeyChannel = KeyerConstants.KeyChannel;
+		Inputs.Weight1 = KeyerConstants.Weight1;
+		Inputs.Weight2 = KeyerConstants.Weight2;
+		Inputs.InvKeyDifference = KeyerConstants.InvKeyDifference;
+		Inputs.AlphaThreshold = KeyerConstants.AlphaThreshold;
+		Inputs.AlphaOffset = KeyerConstants.AlphaOffset;
+		Inputs.ClipBlack = KeyerConstants.ClipBlack;
+		Inputs.InvClipRange = KeyerConstants.InvClipRange;
+
+		Inputs.GradeSaturation = Request.Grade.Saturation;
+		Inputs.GradeContrast = Request.Grade.Contrast;
+		Inputs.GradeGamma = Request.Grade.Gamma;
+		Inputs.GradeGain = Request.Grade.Gain;
+		Inputs.GradeOffset = Request.Grade.Offset;
+	}
+	else if (Request.Mode == ECompositeMediaPrePassMode::PassThrough)
+	{
+		if (!MediaTextureRHI)
+		{
+			return;
+		}
+
+		Inputs.MediaTexture = RegisterExternalTexture(GraphBuilder, MediaTextureRHI, TEXT("Compositor.MediaInput"));
+		Inputs.bKey = false;
+		Inputs.bForceOpaque = true;
+	}
+	else
+	{
+		if (!KeyedTextureRHI)
+		{
+			return;
+		}
+
+		FRDGTextureRef KeyedTexture = RegisterExternalTexture(GraphBuilder, KeyedTextureRHI, TEXT("Compositor.MediaInputKeyed"));
+
+		if (Request.Mode == ECompositeMediaPrePassMode::Fallback)
+		{
+			if (!MediaTextureRHI || !CanWrite(KeyedTextureRHI))
+			{
+				return;
+			}
+
+			FCompositeMediaPrePassInputs CopyInputs;
+			CopyInputs.MediaTexture = RegisterExternalTexture(GraphBuilder, MediaTextureRHI, TEXT("Compositor.MediaInput"));
+			CopyInputs.OutputTexture = KeyedTexture;
+			CopyInputs.bKey = false;
+			CopyInputs.bForceOpaque = true;
+			AddCompositeMediaPrePass(GraphBuilder, CopyInputs);
+		}
+
+		Inputs.MediaTexture = KeyedTexture;
+		Inputs.bKey = false;
+	}
+
+	AddCompositeMediaPrePass(GraphBuilder, Inputs);
+}
+
+void FCompositeViewExtension::PreRenderView_RenderThread(FRDGBuilder& GraphBuilder, FSceneView& InView)
+{
+	if (!SoftMaskMeshPassOutput || InView.bIsSceneCapture || !InView.Family || InView.Family->FrameNumber != SoftMaskMeshPassFrameNumber)
+	{
+		return;
+	}
+
+	FRHITexture* OutputTextureRHI = SoftMaskMeshPassOutput->GetRenderTargetTexture().GetReference();
+	if (!OutputTextureRHI || SoftMaskMeshPassViewRect.Area() <= 0)
+	{
+		return;
+	}
+
+	COMPOSITOR_RDG_EVENT_SCOPE(GraphBuilder, "Compositor");
+
+	// Split screen and stereo views draw into the part of the soft mask matching where they sit in the family.
+	const FVector2f FamilyRectMin(SoftMaskMeshPassViewRect.Min);
+	const FVector2f FamilyRectSize(SoftMaskMeshPassViewRect.Size());
+
+	FCompositeSoftMaskMeshPassInputs Inputs;
+	Inputs.View = &InView;
+	Inputs.OutputTexture = RegisterExternalTexture(GraphBuilder, OutputTextureRHI, TEXT("Compositor.SoftMaskCapture"));
+	Inputs.ViewportMin = (FVector2f(InView.UnscaledViewRect.Min) - FamilyRectMin) / FamilyRectSize;
+	Inputs.ViewportMax = (FVector2f(InView.UnscaledViewRect.Max) - FamilyRectMin) / FamilyRectSize;
+	Inputs.bClear = !bSoftMaskMeshPassCleared;
+	Inputs.Draws = SoftMaskMeshPassDraws;
+	bSoftMaskMeshPassCleared = true;
+
+	AddCompositeSoftMaskMeshPass(GraphBuilder, MoveTemp(Inputs));
+}
+
+void FCompositeViewExtension::PostRenderBasePassDeferred_RenderThread(FRDGBuilder& GraphBuilder, FSceneView& InView, const FRenderTargetBindingSlots& RenderTargets, TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTextures)
+{
+	if (!SoftMaskUpsample.IsSet() || InView.bIsSceneCapture || !InView.Family || LastSoftMaskUpsampleFrameNumber == InView.Family->FrameNumber)
+	{
+		return;
+	}
+
+	const FCompositeSoftMaskUpsampleRequest& Request = SoftMaskUpsample.GetValue();
+	FRHITexture* SoftMaskTextureRHI = Request.SoftMaskTexture ? Request.SoftMaskTexture->GetRenderTargetTexture().GetReference() : nullptr;
+	FRHITexture* OutputTextureRHI = Request.OutputTexture ? Request.OutputTexture->GetRenderTargetTexture().GetReference() : nullptr;
+	if (!SoftMaskTextureRHI || !OutputTextureRHI || !EnumHasAnyFlags(OutputTextureRHI->GetFlags(), TexCreate_UAV))
+	{
+		return;
+	}
+
+	LastSoftMaskUpsampleFrameNumber = InView.Family->FrameNumber;
+
+	COMPOSITOR_RDG_EVENT_SCOPE(GraphBuilder, "Compositor");
+
+	FCompositeSoftMaskUpsampleInputs Inputs;
+	Inputs.View = &InView;
+	Inputs.SoftMaskTexture = RegisterExternalTexture(GraphBuilder, SoftMaskTextureRHI, TEXT("Compositor.SoftMaskCapture"));
+	Inputs.OutputTexture = RegisterExternalTexture(GraphBuilder, OutputTextureRHI, TEXT("Compositor.SoftMask"));
+	// Composite meshes use the top of the stencil range, the opaque hard mask without depth of field is the lowest of their values.
+	Inputs.MinStencilValue = ACompositeMesh::StencilValueOpaqueHardMaskNoDoF;
+	Inputs.DepthSigma = Request.Settings.DepthSigma;
+	Inputs.TemporalWeight = Request.Settings.TemporalWeight;
+
+	if (SceneTextures)
+	{
+		Inputs.CustomDepthTexture = SceneTextures->GetParameters()->CustomDepthTexture;
+		Inputs.CustomStencilTexture = SceneTextures->GetParameters()->CustomStencilTexture;
+	}
+
+	if (SoftMaskUpsampleHistory.IsValid())
+	{
+		Inputs.HistoryTexture = GraphBuilder.RegisterExternalTexture(SoftMaskUpsampleHistory, TEXT("Compositor.SoftMaskHistory"));
+	}
+
+	Inputs.HistoryOutputTexture = GraphBuilder.CreateTexture(
+		FRDGTextureDesc::Create2D(Inputs.OutputTexture->Desc.Extent, PF_R16F, FClearValueBinding::None, TexCreate_ShaderResource | TexCreate_UAV),
+		TEXT("Compositor.SoftMaskHistory"));
+
+	AddCompositeSoftMaskUpsamplePass(GraphBuilder, Inputs);
+
+	GraphBuilder.QueueTextureExtraction(Inputs.HistoryOutputTexture, &SoftMaskUpsampleHistory);
+}
+
+void FCompositeViewExtension::RequestMediaPrePass_GameThread(const FCompositeMediaPrePassRequest& Request)
+{
+	TWeakPtr<FCompositeViewExtension, ESPMode::ThreadSafe> WeakThis = StaticCastSharedRef<FCompositeViewExtension>(AsShared());
+
+	ENQUEUE_RENDER_COMMAND(CompositeMediaPrePassRequest)([WeakThis, Request](FRHICommandListImmediate& RHICmdList)
+	{
+		if (TSharedPtr<FCompositeViewExtension, ESPMode::ThreadSafe> This = WeakThis.Pin())
+		{
+			This->PendingMediaPrePass = Request;
+		}
+	});
+}
+
+void FCompositeViewExtension::ClearMediaPrePass_GameThread()
+{
+	TWeakPtr<FCompositeViewExtension, ESPMode::ThreadSafe> WeakThis = StaticCastSharedRef<FCompositeViewExtension>(AsShared());
+
+	ENQUEUE_RENDER_COMMAND(CompositeMediaPrePassClear)([WeakThis](FRHICommandListImmediate& RHICmdList)
+	{
+		if (TSharedPtr<FCompositeViewExtension, ESPMode::ThreadSafe> This = WeakThis.Pin())
+		{
+			This->PendingMediaPrePass.Reset();
+		}
+	});
+}
+
+void FCompositeViewExtension::SetSoftMaskUpsample_GameThread(const TOptional<FCompositeSoftMaskUpsampleRequest>& Request)
+{
+	TWeakPtr<FCompositeViewExtension, ESPMode::ThreadSafe> WeakThis = StaticCastSharedRef<FCompositeViewExtension>(AsShared());
+
+	ENQUEUE_RENDER_COMMAND(CompositeSoftMaskUpsample)([WeakThis, Request](FRHICommandListImmediate& RHICmdList)
+	{
+		if (TSharedPtr<FCompositeViewExtension, ESPMode::ThreadSafe> This = WeakThis.Pin())
+		{
+			This->SoftMaskUpsample = Request;
+			This->SoftMaskUpsampleHistory.SafeRelease();
+		}
+	});
+}
+
+void FCompositeViewExtension::RenderSoftMaskMeshPass_GameThread(const FCompositeSoftMaskMeshPassRequest& Request)
+{
+	TWeakPtr<FCompositeViewExtension, ESPMode::ThreadSafe> WeakThis = StaticCastSharedRef<FCompositeViewExtension>(AsShared());
+
+	ENQUEUE_RENDER_COMMAND(CompositeSoftMaskMeshPass)([WeakThis, Request](FRHICommandListImmediate& RHICmdList)
+	{
+		TSharedPtr<FCompositeViewExtension, ESPMode::ThreadSafe> This = WeakThis.Pin();
+		if (!This)
+		{
+			return;
+		}
+
+		// Resolved right away, a mesh releasing its render data has to enqueue that after this command.
+		This->PendingSoftMaskMeshPassOutput = Request.OutputTexture;
+		This->PendingSoftMaskMeshPassDraws.Reset(Request.Meshes.Num());
+		for (const FCompositeSoftMaskMesh& Mesh : Request.Meshes)
+		{
+			FCompositeSoftMaskMeshDraw Draw;
+			if (MakeSoftMaskMeshDraw(Mesh, Draw))
+			{
+				This->PendingSoftMaskMeshPassDraws.Add(MoveTemp(Draw));
+			}
+		}
+	});
+}
+
 int32 FCompositeViewExtension::GetPriority() const
 {
 	return 50;
@@ -77,30 +433,99 @@ int32 FCompositeViewExtension::GetPriority() const
 //------------------------------------------------------------------------------
 bool FCompositeViewExtension::IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const
 {
-// #if WITH_EDITOR
-// 	// Disable the compositing if the editor is in play mode but the context we receive is not in game.
-// 	if (GEditor && GEditor->IsPlaySessionInProgress() && (Context.GetWorld()->WorldType != EWorldType::Game && Context.GetWorld()->WorldType != EWorldType::PIE))
-// 	{
-// 		UE_LOG(LogTemp, Warning, TEXT("Play session in progress.") );
-// 		return  false;
-// 	}
-// #endif
-	
-	bool bActive = false;
-	if (CompositorSubsystem.IsValid())
+	// The subsystem decides between the render thread passes and the game thread draws with the same predicate.
+	return CompositorSubsystem.IsValid() && CompositorSubsystem->IsCompositeViewFamily(Context);
+}
+
+bool FCompositeViewExtension::IsRendering_GameThread() const
+{
+	// The render thread runs up to a frame behind the game thread, allow for one more before calling it stale.
+	constexpr uint32 MaxFrameLag = 2;
+	const uint32 LastFrameNumber = LastActiveFrameNumber.load(std::memory_order_relaxed);
+	return LastFrameNumber != 0 && GFrameNumber - LastFrameNumber <= MaxFrameLag;
+}
+
+//------------------------------------------------------------------------------
+FCompositeMaterialBindingViewExtension::FCompositeMaterialBindingViewExtension(const FAutoRegister& AutoRegister, UWorld* InWorld)
+	: FSceneViewExtensionBase(AutoRegister)
+	, World(InWorld)
+{}
+
+void FCompositeMaterialBindingViewExtension::PreRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily)
+{
+	// Passes rather than immediate commands, the graph executes after every family extension was called.
+	AddPass(GraphBuilder, RDG_EVENT_NAME("CompositeApplyMaterialTextureBindings"), [Bindings = Bindings](FRHICommandListImmediate& RHICmdList)
+	{
+		for (const FCompositeMaterialTextureBinding& Binding : Bindings)
+		{
+			Binding.Apply_RenderThread(RHICmdList);
+		}
+	});
+}
+
+void FCompositeMaterialBindingViewExtension::PostRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily)
+{
+	AddPass(GraphBuilder, RDG_EVENT_NAME("CompositeRestoreMaterialTextureBindings"), [Bindings = Bindings](FRHICommandListImmediate& RHICmdList)
 	{
-		if (CompositorSubsystem->GetCompositeViewport() == Context.Viewport)
+		for (const FCompositeMaterialTextureBinding& Binding : Bindings)
 		{
-			const UCompositeWorldData* CompositeWorldData = CompositorSubsystem->GetCompositeWorldData();
-			if (IsValid(CompositeWorldData))
+			Binding.Restore_RenderThread(RHICmdList);
+		}
+	});
+}
+
+int32 FCompositeMaterialBindingViewExtension::GetPriority() const
+{
+	// Before the composite view extension, its passes may draw materials too.
+	return 100;
+}
+
+void FCompositeMaterialBindingViewExtension::SetBindings_GameThread(const TArray<FCompositeMaterialTextureBinding>& InBindings)
+{
+	TWeakPtr<FCompositeMaterialBindingViewExtension, ESPMode::ThreadSafe> WeakThis = StaticCastSharedRef<FCompositeMaterialBindingViewExtension>(AsShared());
+
+	ENQUEUE_RENDER_COMMAND(CompositeMaterialTextureBindings)([WeakThis, InBindings](FRHICommandListImmediate& RHICmdList)
+	{
+		if (TSharedPtr<FCompositeMaterialBindingViewExtension, ESPMode::ThreadSafe> This = WeakThis.Pin())
+		{
+			This->Bindings = InBindings;
+		}
+	});
+}
+
+void FCompositeMaterialBindingViewExtension::ApplyBindings_GameThread()
+{
+	TWeakPtr<FCompositeMaterialBindingViewExtension, ESPMode::ThreadSafe> WeakThis = StaticCastSharedRef<FCompositeMaterialBindingViewExtension>(AsShared());
+
+	ENQUEUE_RENDER_COMMAND(CompositeApplyMaterialTextureBindings)([WeakThis](FRHICommandListImmediate& RHICmdList)
+	{
+		if (TSharedPtr<FCompositeMaterialBindingViewExtension, ESPMode::ThreadSafe> This = WeakThis.Pin())
+		{
+			for (const FCompositeMaterialTextureBinding& Binding : This->Bindings)
 			{
-				bActive = CompositeWorldData->GetIsWorldCompositeEnabled();
+				Binding.Apply_RenderThread(RHICmdList);
 			}
 		}
-	}
+	});
+}
 
-	//UE_LOG(LogTemp, Warning, TEXT("%s - Composite View Extension Active = %s"), *Context.GetWorld()->GetPathName(), bActive ? *FString("True") : *FString("False") );
-	
-	return bActive;
+void FCompositeMaterialBindingViewExtension::RestoreBindings_GameThread()
+{
+	TWeakPtr<FCompositeMaterialBindingViewExtension, ESPMode::ThreadSafe> WeakThis = StaticCastSharedRef<FCompositeMaterialBindingViewExtension>(AsShared());
+
+	ENQUEUE_RENDER_COMMAND(CompositeRestoreMaterialTextureBindings)([WeakThis](FRHICommandListImmediate& RHICmdList)
+	{
+		if (TSharedPtr<FCompositeMaterialBindingViewExtension, ESPMode::ThreadSafe> This = WeakThis.Pin())
+		{
+			for (const FCompositeMaterialTextureBinding& Binding : This->Bindings)
+			{
+				Binding.Restore_RenderThread(RHICmdList);
+			}
+		}
+	});
 }
 
+bool FCompositeMaterialBindingViewExtension::IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const
+{
+	return World.IsValid() && Context.GetWorld() == World.Get();
+}
@@ -23,6 +23,13 @@ UCompositeWorldData::UCompositeWorldData()
     bAutoPilotEditorPreviewCamera = true;
     bMatchViewportResolutionWithMediaInput = true;
     bEnableCameraMotionBlur = false; // Disable camera motion blur by defaults due to artifacts it can cause, especially when keying.
+    bProcessMediaOnRenderThread = false;
+    bPassThroughMediaWithoutKeyer = true;
+    SoftMaskRenderer = ECompositeSoftMaskRenderer::SceneCapture;
+    bUseMediaFrameQueue = false;
+    MediaFrameQueueDepth = 8;
+    MediaFrameDelay = 0;
+    CompositeMeshRegistrationBudget = 1.F;
 	WorldComposite = CreateDefaultSubobject<UComposite>(TEXT("Composite"), /* bTransient = */false);
 }
 
@@ -35,7 +42,6 @@ void UCompositeWorldData::SetCompositePlanarReflection(ACompositePlanarReflectio
 {
     if (CompositePlanarReflection)
     {
-        CompositePlanarReflection->GetCaptureComponent2D()->bCaptureEveryFrame = false;
         UKismetRenderingLibrary::ClearRenderTarget2D(this, CompositePlanarReflection->GetCaptureComponent2D()->TextureTarget, FLinearColor(0, 0, 0, 0));
     }
 
@@ -43,7 +49,8 @@ void UCompositeWorldData::SetCompositePlanarReflection(ACompositePlanarReflectio
 
     if (CompositePlanarReflection)
     {
-        CompositePlanarReflection->GetCaptureComponent2D()->bCaptureEveryFrame = true;
+        // The capture schedule only renders while this is the active planar reflection, make sure it starts with a fresh capture.
+        CompositePlanarReflection->GetCaptureComponent2D()->RequestCapture();
     }
 }
 
@@ -0,0 +1,319 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Objects/CompositorClusterSync.h"
+
+#include "Assets/Composite.h"
+#include "CompositorModule.h"
+#include "Subsystems/CompositorSubsystem.h"
+
+#include "Cluster/DisplayClusterClusterEvent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "IDisplayCluster.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+namespace CompositorClusterSync
+{
+	/** Written ahead of every state, nodes running another build drop states they can't read. */
+	constexpr uint32 StateVersion = 2;
+
+	template<typename EnumType>
+	void SerializeEnum(FArchive& Ar, EnumType& Value)
+	{
+		uint8 Byte = static_cast<uint8>(Value);
+		Ar << Byte;
+		Value = static_cast<EnumType>(Byte);
+	}
+
+	template<typename ObjectType>
+	void SerializeObject(FArchive& Ar, ObjectType*& Object)
+	{
+		UObject* BaseObject = Object;
+		Ar << BaseObject;
+		Object = Cast<ObjectType>(BaseObject);
+	}
+
+	template<typename StructType>
+	void SerializeStruct(FArchive& Ar, StructType& Value)
+	{
+		StructType::StaticStruct()->SerializeItem(Ar, &Value, nullptr);
+	}
+
+	/** Every field of the resolved settings, the archive has to write object references as paths. */
+	void SerializeSettings(FArchive& Ar, FResolvedCompositeSettings& Settings)
+	{
+		SerializeObject(Ar, Settings.MediaInputTexture);
+		SerializeObject(Ar, Settings.MediaInputKeyer);
+
+		Ar << Settings.bEnableSoftMask;
+		Ar << Settings.SoftMaskScreenPercentage;
+		SerializeStruct(Ar, Settings.SoftMaskCaptureSchedule);
+		SerializeEnum(Ar, Settings.SoftMaskCaptureResolution);
+
+		Ar << Settings.bEnableMediaShadows;
+		Ar << Settings.ShadowsOffset;
+		Ar << Settings.ShadowsBlackLevel;
+		Ar << Settings.ShadowsWhiteLevel;
+		Ar << Settings.ShadowsGamma;
+		Ar << Settings.ShadowsTint;
+
+		Ar << Settings.bEnablePlanarReflection;
+		Ar << Settings.PlanarReflectionColor;
+		Ar << Settings.PlanarReflectionDistortionIntensity;
+		Ar << Settings.PlanarReflectionDistortionOffset;
+		Ar << Settings.PlanarReflectionScreenPercentage;
+		SerializeStruct(Ar, Settings.PlanarReflectionCaptureSchedule);
+
+		SerializeEnum(Ar, Settings.MediaBlend);
+		Ar << Settings.BrightnessMaskGamma;
+		Ar << Settings.bApplyInverseToneCurve;
+
+		SerializeEnum(Ar, Settings.OutputRgbEncoding);
+		SerializeEnum(Ar, Settings.OutputAlpha);
+
+		SerializeStruct(Ar, Settings.ColorGradeScene);
+		SerializeStruct(Ar, Settings.ColorGradeMedia);
+		SerializeStruct(Ar, Settings.ColorGradeCombined);
+	}
+}
+
+bool FCompositorClusterSync::IsClusterCompositingEnabled()
+{
+	return FParse::Param(FCommandLine::Get(), TEXT("CompositorCluster"));
+}
+
+void FCompositorClusterSync::WriteState(const FResolvedCompositeSettings& Settings, const FCompositorClusterLensState& LensState, TArray<uint8>& OutData)
+{
+	OutData.Reset();
+
+	FMemoryWriter Writer(OutData);
+	uint32 Version = CompositorClusterSync::StateVersion;
+	FCompositorClusterLensState WrittenLensState = LensState;
+	Writer << Version;
+	Writer << WrittenLensState.CameraFovWithoutOverscan;
+	Writer << WrittenLensState.CameraOverscanFactor;
+
+	// Object references as paths, every node loaded the same level and assets.
+	FObjectAndNameAsStringProxyArchive SettingsWriter(Writer, false);
+	FResolvedCompositeSettings WrittenSettings = Settings;
+	CompositorClusterSync::SerializeSettings(SettingsWriter, WrittenSettings);
+}
+
+bool FCompositorClusterSync::ReadState(const TArray<uint8>& Data, FResolvedCompositeSettings& OutSettings, FCompositorClusterLensState& OutLensState)
+{
+	FMemoryReader Reader(Data);
+	uint32 Version = 0;
+	FCompositorClusterLensState LensState;
+	Reader << Version;
+	Reader << LensState.CameraFovWithoutOverscan;
+	Reader << LensState.CameraOverscanFactor;
+
+	if (Reader.IsError() || Version != CompositorClusterSync::StateVersion)
+	{
+		return false;
+	}
+
+	// Read into a copy, a state that fails half way must not leave the outputs half written.
+	FObjectAndNameAsStringProxyArchive SettingsReader(Reader, true);
+	FResolvedCompositeSettings Settings;
+	CompositorClusterSync::SerializeSettings(SettingsReader, Settings);
+	if (SettingsReader.IsError() || Reader.IsError() || !Reader.AtEnd())
+	{
+		return false;
+	}
+
+	OutSettings = Settings;
+	OutLensState = LensState;
+	return true;
+}
+
+void FCompositorClusterSync::Initialize()
+{
+	bIsActive = false;
+	bIsPrimary = false;
+
+	if (!IsClusterCompositingEnabled() || !IDisplayCluster::IsAvailable())
+	{
+		return;
+	}
+
+	IDisplayClusterClusterManager* ClusterManager = IDisplayCluster::Get().GetClusterMgr();
+	if (!ClusterManager || ClusterManager->GetClusterRole() == EDisplayClusterNodeRole::None)
+	{
+		return;
+	}
+
+	bIsActive = true;
+	bIsPrimary = ClusterManager->IsPrimary();
+
+	ClusterEventListener = FOnClusterEventBinaryListener::CreateRaw(this, &FCompositorClusterSync::OnClusterEventBinary);
+	ClusterManager->AddClusterEventBinaryListener(ClusterEventListener);
+
+	UE_LOG(LogCompositor, Log, TEXT("Compositing on cluster node %s as the %s node."), *ClusterManager->GetNodeId(), bIsPrimary ? TEXT("primary") : TEXT("secondary"));
+}
+
+void FCompositorClusterSync::Deinitialize()
+{
+	if (bIsActive && IDisplayCluster::IsAvailable())
+	{
+		if (IDisplayClusterClusterManager* ClusterManager = IDisplayCluster::Get().GetClusterMgr())
+		{
+			ClusterManager->RemoveClusterEventBinaryListener(ClusterEventListener);
+		}
+	}
+
+	if (UComposite* Composite = OverriddenComposite.Get())
+	{
+		Composite->SetResolvedSettingsOverride({});
+	}
+	OverriddenComposite.Reset();
+
+	ClusterEventListener.Unbind();
+	bIsActive = false;
+	bIsPrimary = false;
+	LastSentData.Reset();
+	LastSentComposite.Reset();
+	LastSentSettingsGeneration = 0;
+	ReceivedData.Reset();
+	bReceivedDataPending = false;
+	ReceivedSettings.Reset();
+	ReceivedLensState.Reset();
+}
+
+void FCompositorClusterSync::SendState(const UComposite* Composite, const FCompositorClusterLensState& LensState)
+{
+	if (!bIsActive || !bIsPrimary || !IsValid(Composite))
+	{
+		return;
+	}
+
+	// The settings generation moves whenever any composite changed, only then can the resolved settings differ.
+	const uint32 SettingsGeneration = UComposite::GetSettingsGeneration();
+	const bool bMayHaveChanged = LastSentComposite.Get() != Composite || LastSentSettingsGeneration != SettingsGeneration || !(LastSentLensState == LensState);
+	const bool bKeepAlive = GFrameCounter - LastSentFrame >= ResendInterval;
+	if (!bMayHaveChanged && !bKeepAlive)
+	{
+		return;
+	}
+
+	LastSentComposite = Composite;
+	LastSentSettingsGeneration = SettingsGeneration;
+	LastSentLensState = LensState;
+
+	TArray<uint8> Data;
+	WriteState(Composite->GetResolvedSettings(), LensState, Data);
+	if (Data == LastSentData && !bKeepAlive)
+	{
+		return;
+	}
+
+	IDisplayClusterClusterManager* ClusterManager = IDisplayCluster::Get().GetClusterMgr();
+	if (!ClusterManager)
+	{
+		return;
+	}
+
+	FDisplayClusterClusterEventBinary Event;
+	Event.EventId = StateEventId;
+	Event.bIsSystemEvent = false;
+	// Only the latest state of a frame matters.
+	Event.bShouldDiscardOnRepeat = true;
+	Event.EventData = Data;
+	ClusterManager->EmitClusterEventBinary(Event, true);
+
+	LastSentData = MoveTemp(Data);
+	LastSentFrame = GFrameCounter;
+	++NumStatesSent;
+}
+
+TOptional<FCompositorClusterLensState> FCompositorClusterSync::ApplyReceivedState(UComposite* Composite)
+{
+	if (!bIsActive || bIsPrimary)
+	{
+		return {};
+	}
+
+	bool bApplySettings = false;
+	if (bReceivedDataPending)
+	{
+		bReceivedDataPending = false;
+
+		FResolvedCompositeSettings Settings;
+		FCompositorClusterLensState LensState;
+		if (ReadState(ReceivedData, Settings, LensState))
+		{
+			ReceivedSettings = MakeShared<FResolvedCompositeSettings>(Settings);
+			ReceivedLensState = LensState;
+			bApplySettings = true;
+		}
+		else
+		{
+			UE_LOG(LogCompositor, Warning, TEXT("Dropped a composite state from the primary node that could not be read, is every node running the same build?"));
+		}
+	}
+
+	// A composite that stopped being the world composite goes back to its own settings.
+	if (OverriddenComposite.Get() != Composite)
+	{
+		if (UComposite* PreviousComposite = OverriddenComposite.Get())
+		{
+			PreviousComposite->SetResolvedSettingsOverride({});
+		}
+		OverriddenComposite = Composite;
+		bApplySettings = true;
+	}
+
+	if (bApplySettings && ReceivedSettings.IsValid() && IsValid(Composite))
+	{
+		Composite->SetResolvedSettingsOverride(*ReceivedSettings);
+	}
+
+	return ReceivedLensState;
+}
+
+void FCompositorClusterSync::OnClusterEventBinary(const FDisplayClusterClusterEventBinary& Event)
+{
+	if (Event.EventId != StateEventId || bIsPrimary)
+	{
+		return;
+	}
+
+	// The primary node sends the same state again now and then, only new ones have to be read.
+	if (Event.EventData != ReceivedData || !ReceivedLensState.IsSet())
+	{
+		ReceivedData = Event.EventData;
+		bReceivedDataPending = true;
+	}
+	++NumStatesReceived;
+}
+
+void FCompositorClusterSync::LogStatus() const
+{
+	if (!bIsActive)
+	{
+		UE_LOG(LogCompositor, Log, TEXT("Cluster compositing is off%s."), IsClusterCompositingEnabled() ? TEXT(", this process is not a cluster node") : TEXT(", start with -CompositorCluster to enable it"));
+		return;
+	}
+
+	UE_LOG(LogCompositor, Log, TEXT("Cluster compositing as the %s node, %u states sent, %u received, %d bytes last sent, lens state %s."),
+		bIsPrimary ? TEXT("primary") : TEXT("secondary"),
+		NumStatesSent,
+		NumStatesReceived,
+		LastSentData.Num(),
+		bIsPrimary || ReceivedLensState.IsSet() ? TEXT("in sync") : TEXT("not received yet"));
+}
+
+static FAutoConsoleCommandWithWorld CompositorClusterStatusCommand(
+	TEXT("Compositor.Cluster.Status"),
+	TEXT("Logs the cluster role and state traffic of this node."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UCompositorSubsystem* CompositorSubsystem = World ? World->GetSubsystem<UCompositorSubsystem>() : nullptr)
+		{
+			CompositorSubsystem->GetClusterSync().LogStatus();
+		}
+	}));
@@ -0,0 +1,231 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Objects/CompositorMPCDeltaWriter.h"
+
+#include "CompositorStats.h"
+#include "Subsystems/CompositorSubsystem.h" // LogCompositor
+
+#include "Engine/World.h"
+#include "Materials/MaterialParameterCollection.h"
+#include "Materials/MaterialParameterCollectionInstance.h"
+
+FCompositorMPCDeltaWriter::FCompositorMPCDeltaWriter()
+	: TotalParametersWritten(0)
+	, TotalParametersSkipped(0)
+{
+}
+
+void FCompositorMPCDeltaWriter::Initialize(UWorld* InWorld, UMaterialParameterCollection* InCollection)
+{
+	World = InWorld;
+	Collection = InCollection;
+	CollectionInstance = nullptr;
+
+	ScalarParameterNames.Reset();
+	StagedScalarValues.Reset();
+	WrittenScalarValues.Reset();
+	bIsScalarStaged.Reset();
+	bIsScalarWritten.Reset();
+
+	VectorParameterNames.Reset();
+	StagedVectorValues.Reset();
+	WrittenVectorValues.Reset();
+	bIsVectorStaged.Reset();
+	bIsVectorWritten.Reset();
+
+	TotalParametersWritten = 0;
+	TotalParametersSkipped = 0;
+}
+
+int32 FCompositorMPCDeltaWriter::RegisterScalarParameter(FName ParameterName)
+{
+	const UMaterialParameterCollection* CollectionPtr = Collection.Get();
+	if (!CollectionPtr)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 ExistingHandle = ScalarParameterNames.Find(ParameterName);
+	if (ExistingHandle != INDEX_NONE)
+	{
+		return ExistingHandle;
+	}
+
+	if (!CollectionPtr->GetScalarParameterByName(ParameterName))
+	{
+		UE_LOG(LogCompositor, Warning, TEXT("Scalar parameter %s is missing from %s."), *ParameterName.ToString(), *CollectionPtr->GetName());
+		return INDEX_NONE;
+	}
+
+	ScalarParameterNames.Add(ParameterName);
+	StagedScalarValues.Add(0.F);
+	WrittenScalarValues.Add(0.F);
+	bIsScalarStaged.Add(false);
+	bIsScalarWritten.Add(false);
+
+	return ScalarParameterNames.Num() - 1;
+}
+
+int32 FCompositorMPCDeltaWriter::RegisterVectorParameter(FName ParameterName)
+{
+	const UMaterialParameterCollection* CollectionPtr = Collection.Get();
+	if (!CollectionPtr)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 ExistingHandle = VectorParameterNames.Find(ParameterName);
+	if (ExistingHandle != INDEX_NONE)
+	{
+		return ExistingHandle;
+	}
+
+	if (!CollectionPtr->GetVectorParameterByName(ParameterName))
+	{
+		UE_LOG(LogCompositor, Warning, TEXT("Vector parameter %s is missing from %s."), *ParameterName.ToString(), *CollectionPtr->GetName());
+		return INDEX_NONE;
+	}
+
+	VectorParameterNames.Add(ParameterName);
+	StagedVectorValues.Add(FLinearColor::Transparent);
+	WrittenVectorValues.Add(FLinearColor::Transparent);
+	bIsVectorStaged.Add(false);
+	bIsVectorWritten.Add(false);
+
+	return VectorParameterNames.Num() - 1;
+}
+
+void FCompositorMPCDeltaWriter::Flush()
+{
+	UMaterialParameterCollectionInstance* Instance = GetCollectionInstance();
+	if (!Instance)
+	{
+		return;
+	}
+
+	uint32 NumWritten = 0;
+	uint32 NumSkipped = 0;
+
+	for (TConstSetBitIterator<> It(bIsScalarStaged); It; ++It)
+	{
+		const int32 Handle = It.GetIndex();
+		const float Value = StagedScalarValues[Handle];
+
+		if (bIsScalarWritten[Handle] && WrittenScalarValues[Handle] == Value)
+		{
+			++NumSkipped;
+			continue;
+		}
+
+		Instance->SetScalarParameterValue(ScalarParameterNames[Handle], Value);
+		WrittenScalarValues[Handle] = Value;
+		bIsScalarWritten[Handle] = true;
+		++NumWritten;
+	}
+
+	for (TConstSetBitIterator<> It(bIsVectorStaged); It; ++It)
+	{
+		const int32 Handle = It.GetIndex();
+		const FLinearColor& Value = StagedVectorValues[Handle];
+
+		if (bIsVectorWritten[Handle] && WrittenVectorValues[Handle] == Value)
+		{
+			++NumSkipped;
+			continue;
+		}
+
+		Instance->SetVectorParameterValue(VectorParameterNames[Handle], Value);
+		WrittenVectorValues[Handle] = Value;
+		bIsVectorWritten[Handle] = true;
+		++NumWritten;
+	}
+
+	bIsScalarStaged.SetRange(0, bIsScalarStaged.Num(), false);
+	bIsVectorStaged.SetRange(0, bIsVectorStaged.Num(), false);
+
+	TotalParametersWritten += NumWritten;
+	TotalParametersSkipped += NumSkipped;
+
+	INC_DWORD_STAT_BY(STAT_CompositorMPCParametersWritten, NumWritten);
+	INC_DWORD_STAT_BY(STAT_CompositorMPCParametersSkipped, NumSkipped);
+}
+
+void FCompositorMPCDeltaWriter::Invalidate()
+{
+	bIsScalarWritten.SetRange(0, bIsScalarWritten.Num(), false);
+	bIsVectorWritten.SetRange(0, bIsVectorWritten.Num(), false);
+}
+
+UMaterialParameterCollectionInstance* FCompositorMPCDeltaWriter::GetCollectionInstance()
+{
+	if (!CollectionInstance.IsValid())
+	{
+		UWorld* WorldPtr = World.Get();
+		const UMaterialParameterCollection* CollectionPtr = Collection.Get();
+		if (!WorldPtr || !CollectionPtr)
+		{
+			return nullptr;
+		}
+
+		CollectionInstance = WorldPtr->GetParameterCollectionInstance(CollectionPtr);
+
+		// A new instance starts from the collection defaults, so everything has to be written again.
+		Invalidate();
+	}
+
+	return CollectionInstance.Get();
+}
+
+void FCompositorMPCParameters::Register(FCompositorMPCDeltaWriter& Writer)
+{
+	IsKeyerEnabled = Writer.RegisterScalarParameter("IsKeyerEnabled");
+	DebugMediaOverlay = Writer.RegisterScalarParameter("DebugMediaOverlay");
+	MediaProjectionBlendAmount = Writer.RegisterScalarParameter("MediaProjectionBlendAmount");
+	MediaProjectionFoV = Writer.RegisterScalarParameter("MediaProjectionFoV");
+	MediaProjectionCameraPosition = Writer.RegisterVectorParameter("MediaProjectionCameraPosition");
+	MediaProjectionCameraForward = Writer.RegisterVectorParameter("MediaProjectionCameraForward");
+	MediaProjectionCameraRight = Writer.RegisterVectorParameter("MediaProjectionCameraRight");
+	MediaProjectionCameraUp = Writer.RegisterVectorParameter("MediaProjectionCameraUp");
+	IsMovieRenderQueueEnabled = Writer.RegisterScalarParameter("IsMovieRenderQueueEnabled");
+
+	CameraFovWithoutOverscan = Writer.RegisterScalarParameter("CameraFovWithoutOverscan");
+	CameraOverscanFactor = Writer.RegisterScalarParameter("CameraOverscanFactor");
+
+	EnableSoftMask = Writer.RegisterScalarParameter("EnableSoftMask");
+	ShadowsBlackLevel = Writer.RegisterScalarParameter("ShadowsBlackLevel");
+	ShadowsWhiteLevel = Writer.RegisterScalarParameter("ShadowsWhiteLevel");
+	ShadowsGamma = Writer.RegisterScalarParameter("ShadowsGamma");
+	ShadowsTint = Writer.RegisterVectorParameter("ShadowsTint");
+	EnablePlanarReflection = Writer.RegisterScalarParameter("EnablePlanarReflection");
+	PlanarReflectionColor = Writer.RegisterVectorParameter("PlanarReflectionColor");
+	PlanarReflectionDistortionIntensity = Writer.RegisterScalarParameter("PlanarReflectionDistortionIntensity");
+	PlanarReflectionDistortionOffset = Writer.RegisterScalarParameter("PlanarReflectionDistortionOffset");
+	MediaBlendNone = Writer.RegisterScalarParameter("MediaBlendNone");
+	MediaBlendPreToneCurve = Writer.RegisterScalarParameter("MediaBlendPreToneCurve");
+	BrightnessMaskGamma = Writer.RegisterScalarParameter("BrightnessMaskGamma");
+	ApplyInverseToneCurve = Writer.RegisterScalarParameter("ApplyInverseToneCurve");
+	OutputAlphaInvertedOpacity = Writer.RegisterScalarParameter("OutputAlphaInvertedOpacity");
+	OutputAlphaWhite = Writer.RegisterScalarParameter("OutputAlphaWhite");
+	OutputAlphaOverride = Writer.RegisterScalarParameter("OutputAlphaOverride");
+	OutputRgbEncodingSrgb = Writer.RegisterScalarParameter("OutputRgbEncodingSrgb");
+	OutputAlphaInRgb = Writer.RegisterScalarParameter("OutputAlphaInRgb");
+	DebugVisualizeCompositeMeshes = Writer.RegisterScalarParameter("DebugVisualizeCompositeMeshes");
+
+	static const TCHAR* ColorGradeRanges[3] = { TEXT("Scene"), TEXT("Media"), TEXT("Combined") };
+	for (int32 Range = 0; Range < 3; ++Range)
+	{
+		ColorGradeSaturation[Range] = Writer.RegisterVectorParameter(*FString::Printf(TEXT("ColorGrade%sSaturation"), ColorGradeRanges[Range]));
+		ColorGradeContrast[Range] = Writer.RegisterVectorParameter(*FString::Printf(TEXT("ColorGrade%sContrast"), ColorGradeRanges[Range]));
+		ColorGradeGamma[Range] = Writer.RegisterVectorParameter(*FString::Printf(TEXT("ColorGrade%sGamma"), ColorGradeRanges[Range]));
+		ColorGradeGain[Range] = Writer.RegisterVectorParameter(*FString::Printf(TEXT("ColorGrade%sGain"), ColorGradeRanges[Range]));
+		ColorGradeOffset[Range] = Writer.RegisterVectorParameter(*FString::Printf(TEXT("ColorGrade%sOffset"), ColorGradeRanges[Range]));
+	}
+
+	FilmBlackClip = Writer.RegisterScalarParameter("FilmBlackClip");
+	FilmWhiteClip = Writer.RegisterScalarParameter("FilmWhiteClip");
+	FilmShoulder = Writer.RegisterScalarParameter("FilmShoulder");
+	FilmSlope = Writer.RegisterScalarParameter("FilmSlope");
+	FilmToe = Writer.RegisterScalarParameter("FilmToe");
+	BlueCorrection = Writer.RegisterScalarParameter("BlueCorrection");
+	ToneCurveAmount = Writer.RegisterScalarParameter("ToneCurveAmount");
+}
@@ -0,0 +1,193 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Objects/CompositorRenderTargetPool.h"
+
+#include "CompositorStats.h"
+
+#include "UObject/Package.h"
+
+FCompositorRenderTargetDesc FCompositorRenderTargetDesc::FromTemplate(const UTextureRenderTarget2D* Template, const FIntPoint& InSize)
+{
+	FCompositorRenderTargetDesc Desc;
+	Desc.Size = FIntPoint(FMath::Max(InSize.X, 1), FMath::Max(InSize.Y, 1));
+
+	if (IsValid(Template))
+	{
+		Desc.Format = Template->RenderTargetFormat;
+		Desc.ClearColor = Template->ClearColor;
+		Desc.bCanCreateUAV = Template->bCanCreateUAV;
+	}
+
+	return Desc;
+}
+
+bool FCompositorRenderTargetDesc::operator==(const FCompositorRenderTargetDesc& Other) const
+{
+	return Size == Other.Size
+		&& Format == Other.Format
+		&& ClearColor == Other.ClearColor
+		&& bCanCreateUAV == Other.bCanCreateUAV;
+}
+
+uint32 GetTypeHash(const FCompositorRenderTargetDesc& Desc)
+{
+	uint32 Hash = GetTypeHash(Desc.Size);
+	Hash = HashCombine(Hash, GetTypeHash(Desc.Format.GetValue()));
+	Hash = HashCombine(Hash, GetTypeHash(Desc.ClearColor));
+	return HashCombine(Hash, GetTypeHash(Desc.bCanCreateUAV));
+}
+
+FCompositorRenderTargetPool::~FCompositorRenderTargetPool()
+{
+	Empty();
+}
+
+FIntPoint FCompositorRenderTargetPool::QuantizeSize(const FIntPoint& Size, const FIntPoint& ReferenceSize)
+{
+	auto QuantizeAxis = [](int32 Value, int32 ReferenceValue)
+	{
+		const float Step = FMath::Max(static_cast<float>(ReferenceValue) * BucketFraction, 1.F);
+
+		// The small bias keeps sizes that are exactly on a bucket, i.e. 100%, from moving up to the next one.
+		const int32 Bucket = FMath::Max(FMath::CeilToInt(static_cast<float>(Value) / Step - KINDA_SMALL_NUMBER), 1);
+		return FMath::Max(FMath::RoundToInt(static_cast<float>(Bucket) * Step), 2);
+	};
+
+	return FIntPoint(QuantizeAxis(Size.X, ReferenceSize.X), QuantizeAxis(Size.Y, ReferenceSize.Y));
+}
+
+UTextureRenderTarget2D* FCompositorRenderTargetPool::Acquire(const FCompositorRenderTargetDesc& Desc)
+{
+	// Reuse the most recently released match, it is the one least likely to have been paged out.
+	int32 FoundIndex = INDEX_NONE;
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		const FEntry& Entry = Entries[Index];
+		if (!Entry.bInUse && Entry.Desc == Desc && (FoundIndex == INDEX_NONE || Entry.ReleaseFrame > Entries[FoundIndex].ReleaseFrame))
+		{
+			FoundIndex = Index;
+		}
+	}
+
+	if (FoundIndex != INDEX_NONE)
+	{
+		FEntry& Entry = Entries[FoundIndex];
+		Entry.bInUse = true;
+		FreeMemory -= Entry.Memory;
+		UsedMemory += Entry.Memory;
+		DEC_MEMORY_STAT_BY(STAT_CompositorRenderTargetPoolFreeMemory, Entry.Memory);
+
+		return Entry.RenderTarget;
+	}
+
+	UTextureRenderTarget2D* RenderTarget = NewObject<UTextureRenderTarget2D>(GetTransientPackage(), NAME_None, RF_Transient);
+	RenderTarget->RenderTargetFormat = Desc.Format;
+	RenderTarget->ClearColor = Desc.ClearColor;
+	RenderTarget->bCanCreateUAV = Desc.bCanCreateUAV;
+	RenderTarget->bAutoGenerateMips = false;
+	RenderTarget->InitAutoFormat(Desc.Size.X, Desc.Size.Y);
+	RenderTarget->UpdateResourceImmediate(true);
+
+	FEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.RenderTarget = RenderTarget;
+	Entry.Desc = Desc;
+	Entry.Memory = RenderTarget->CalcTextureMemorySizeEnum(TMC_AllMips);
+	Entry.bInUse = true;
+
+	UsedMemory += Entry.Memory;
+	++TotalAllocations;
+	INC_MEMORY_STAT_BY(STAT_CompositorRenderTargetMemory, Entry.Memory);
+	INC_DWORD_STAT(STAT_CompositorRenderTargetAllocations);
+
+	return RenderTarget;
+}
+
+void FCompositorRenderTargetPool::Release(UTextureRenderTarget2D* RenderTarget)
+{
+	if (!RenderTarget)
+	{
+		return;
+	}
+
+	FEntry* Entry = Entries.FindByPredicate([RenderTarget](const FEntry& Entry) { return Entry.RenderTarget == RenderTarget; });
+	if (Entry && Entry->bInUse)
+	{
+		Entry->bInUse = false;
+		Entry->ReleaseFrame = GFrameCounter;
+		UsedMemory -= Entry->Memory;
+		FreeMemory += Entry->Memory;
+		INC_MEMORY_STAT_BY(STAT_CompositorRenderTargetPoolFreeMemory, Entry->Memory);
+	}
+}
+
+bool FCompositorRenderTargetPool::Update(UTextureRenderTarget2D*& InOutRenderTarget, const FCompositorRenderTargetDesc& Desc)
+{
+	if (InOutRenderTarget)
+	{
+		const FEntry* Entry = Entries.FindByPredicate([InOutRenderTarget](const FEntry& Entry) { return Entry.RenderTarget == InOutRenderTarget; });
+		if (Entry && Entry->bInUse && Entry->Desc == Desc)
+		{
+			return false;
+		}
+	}
+
+	// Acquired before releasing, the render target in use must not be handed back out for the new description.
+	UTextureRenderTarget2D* NewRenderTarget = Acquire(Desc);
+	Release(InOutRenderTarget);
+	InOutRenderTarget = NewRenderTarget;
+	INC_DWORD_STAT(STAT_CompositorRenderTargetResizes);
+
+	return true;
+}
+
+void FCompositorRenderTargetPool::Tick()
+{
+	for (int32 Index = Entries.Num() - 1; Index >= 0; --Index)
+	{
+		const FEntry& Entry = Entries[Index];
+		if (!Entry.bInUse && GFrameCounter - Entry.ReleaseFrame > HysteresisFrames)
+		{
+			FreeEntry(Index);
+		}
+	}
+}
+
+void FCompositorRenderTargetPool::Empty()
+{
+	for (int32 Index = Entries.Num() - 1; Index >= 0; --Index)
+	{
+		FreeEntry(Index);
+	}
+}
+
+void FCompositorRenderTargetPool::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (FEntry& Entry : Entries)
+	{
+		Collector.AddReferencedObject(Entry.RenderTarget);
+	}
+}
+
+void FCompositorRenderTargetPool::FreeEntry(int32 Index)
+{
+	const FEntry& Entry = Entries[Index];
+
+	DEC_MEMORY_STAT_BY(STAT_CompositorRenderTargetMemory, Entry.Memory);
+	if (Entry.bInUse)
+	{
+		UsedMemory -= Entry.Memory;
+	}
+	else
+	{
+		FreeMemory -= Entry.Memory;
+		DEC_MEMORY_STAT_BY(STAT_CompositorRenderTargetPoolFreeMemory, Entry.Memory);
+
+		// Nobody holds it anymore, free the GPU memory now instead of waiting for garbage collection.
+		if (IsValid(Entry.RenderTarget))
+		{
+			Entry.RenderTarget->ReleaseResource();
+		}
+	}
+
+	Entries.RemoveAtSwap(Index);
+}
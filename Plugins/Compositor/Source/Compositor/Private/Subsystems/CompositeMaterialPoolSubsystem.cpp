@@ -0,0 +1,161 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Subsystems/CompositeMaterialPoolSubsystem.h"
+
+#include "Kismet/KismetMaterialLibrary.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+void FCompositeMaterialParameters::ApplyTo(UMaterialInstanceDynamic* MID, const FCompositeMaterialParameters* PreviousParameters) const
+{
+	// Parameters are always added in the same order for the same parent, so values can be compared by position.
+	const bool bCanCompare = PreviousParameters
+		&& PreviousParameters->ScalarParameters.Num() == ScalarParameters.Num()
+		&& PreviousParameters->VectorParameters.Num() == VectorParameters.Num();
+
+	for (int32 Index = 0; Index < ScalarParameters.Num(); ++Index)
+	{
+		if (!bCanCompare || PreviousParameters->ScalarParameters[Index] != ScalarParameters[Index])
+		{
+			MID->SetScalarParameterValue(ScalarParameters[Index].Key, ScalarParameters[Index].Value);
+		}
+	}
+
+	for (int32 Index = 0; Index < VectorParameters.Num(); ++Index)
+	{
+		if (!bCanCompare || PreviousParameters->VectorParameters[Index] != VectorParameters[Index])
+		{
+			MID->SetVectorParameterValue(VectorParameters[Index].Key, VectorParameters[Index].Value);
+		}
+	}
+}
+
+uint32 GetTypeHash(const FCompositeMaterialParameters& Parameters)
+{
+	uint32 Hash = 0;
+
+	for (const TPair<FName, float>& Parameter : Parameters.ScalarParameters)
+	{
+		Hash = HashCombine(Hash, HashCombine(GetTypeHash(Parameter.Key), GetTypeHash(Parameter.Value)));
+	}
+
+	for (const TPair<FName, FLinearColor>& Parameter : Parameters.VectorParameters)
+	{
+		Hash = HashCombine(Hash, HashCombine(GetTypeHash(Parameter.Key), GetTypeHash(Parameter.Value)));
+	}
+
+	return Hash;
+}
+
+UMaterialInstanceDynamic* UCompositeMaterialPoolSubsystem::UpdateInstance(const UObject* Holder, UMaterialInstanceDynamic* CurrentMID, UMaterialInterface* Parent, const FCompositeMaterialParameters& Parameters)
+{
+	if (!Parent)
+	{
+		ReleaseInstance(Holder, CurrentMID);
+		return nullptr;
+	}
+
+	const uint32 ParametersHash = GetTypeHash(Parameters);
+
+	// Instances the holder got from somewhere else (i.e. copied with the actor) are never modified.
+	FEntry* CurrentEntry = CurrentMID ? Entries.Find(CurrentMID) : nullptr;
+	if (CurrentEntry && !CurrentEntry->Holders.Contains(Holder))
+	{
+		CurrentEntry = nullptr;
+	}
+
+	if (CurrentEntry && CurrentMID->Parent == Parent && CurrentEntry->ParametersHash == ParametersHash && CurrentEntry->Parameters == Parameters)
+	{
+		return CurrentMID;
+	}
+
+	UMaterialInstanceDynamic* SharedMID = FindInstance(Parent, Parameters, ParametersHash);
+
+	// Copy on write is not needed when nobody else uses the current instance and there is nothing to share, just change the values in place.
+	if (CurrentEntry && !SharedMID && CurrentMID->Parent == Parent && CurrentEntry->Holders.Num() == 1)
+	{
+		Parameters.ApplyTo(CurrentMID, &CurrentEntry->Parameters);
+
+		RemoveLookup(CurrentMID, CurrentEntry->ParametersHash);
+		CurrentEntry->Parameters = Parameters;
+		CurrentEntry->ParametersHash = ParametersHash;
+		AddLookup(CurrentMID, ParametersHash);
+
+		return CurrentMID;
+	}
+
+	if (CurrentEntry)
+	{
+		ReleaseInstance(Holder, CurrentMID);
+	}
+
+	if (!SharedMID)
+	{
+		SharedMID = UKismetMaterialLibrary::CreateDynamicMaterialInstance(this, Parent, NAME_None, EMIDCreationFlags::Transient);
+		if (!SharedMID)
+		{
+			return nullptr;
+		}
+
+		Parameters.ApplyTo(SharedMID);
+
+		FEntry& NewEntry = Entries.Add(SharedMID);
+		NewEntry.Parameters = Parameters;
+		NewEntry.ParametersHash = ParametersHash;
+		Instances.Add(SharedMID);
+		AddLookup(SharedMID, ParametersHash);
+	}
+
+	Entries.FindChecked(SharedMID).Holders.Add(Holder);
+
+	return SharedMID;
+}
+
+void UCompositeMaterialPoolSubsystem::ReleaseInstance(const UObject* Holder, UMaterialInstanceDynamic* MID)
+{
+	FEntry* Entry = MID ? Entries.Find(MID) : nullptr;
+	if (!Entry)
+	{
+		return;
+	}
+
+	Entry->Holders.Remove(Holder);
+	if (Entry->Holders.Num() == 0)
+	{
+		RemoveLookup(MID, Entry->ParametersHash);
+		Entries.Remove(MID);
+		Instances.Remove(MID);
+	}
+}
+
+void UCompositeMaterialPoolSubsystem::Deinitialize()
+{
+	Instances.Empty();
+	Entries.Empty();
+	Lookup.Empty();
+
+	Super::Deinitialize();
+}
+
+UMaterialInstanceDynamic* UCompositeMaterialPoolSubsystem::FindInstance(const UMaterialInterface* Parent, const FCompositeMaterialParameters& Parameters, uint32 ParametersHash) const
+{
+	for (auto It = Lookup.CreateConstKeyIterator(TPair<const UMaterialInterface*, uint32>(Parent, ParametersHash)); It; ++It)
+	{
+		UMaterialInstanceDynamic* MID = It.Value();
+		if (Entries.FindChecked(MID).Parameters == Parameters)
+		{
+			return MID;
+		}
+	}
+
+	return nullptr;
+}
+
+void UCompositeMaterialPoolSubsystem::AddLookup(UMaterialInstanceDynamic* MID, uint32 ParametersHash)
+{
+	Lookup.Add(TPair<const UMaterialInterface*, uint32>(MID->Parent, ParametersHash), MID);
+}
+
+void UCompositeMaterialPoolSubsystem::RemoveLookup(UMaterialInstanceDynamic* MID, uint32 ParametersHash)
+{
+	Lookup.Remove(TPair<const UMaterialInterface*, uint32>(MID->Parent, ParametersHash), MID);
+}
@@ -0,0 +1,363 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Subsystems/CompositeMeshBatchSubsystem.h"
+
+#include "Actors/CompositeMesh.h"
+#include "Components/SoftMaskCaptureComponent.h"
+#include "Subsystems/CompositorSubsystem.h"
+
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "Kismet/KismetMaterialLibrary.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+bool FCompositeMeshBatchKey::operator==(const FCompositeMeshBatchKey& Other) const
+{
+	return StaticMesh == Other.StaticMesh
+		&& OpaqueMaterial == Other.OpaqueMaterial
+		&& StencilMaterial == Other.StencilMaterial
+		&& TranslucentMaterial == Other.TranslucentMaterial
+		&& SoftMaskMaterial == Other.SoftMaskMaterial
+		&& RayTracedBackfaceColor == Other.RayTracedBackfaceColor
+		&& RayTracedOutOfFrustumColor == Other.RayTracedOutOfFrustumColor
+		&& PlanarReflectionBackgroundOcclusion == Other.PlanarReflectionBackgroundOcclusion
+		&& LightingChannels == Other.LightingChannels
+		&& Mobility == Other.Mobility
+		&& RenderSoftMask == Other.RenderSoftMask
+		&& bBypassDepthOfField == Other.bBypassDepthOfField
+		&& bCastShadows == Other.bCastShadows
+		&& bAffectDistanceFieldLighting == Other.bAffectDistanceFieldLighting
+		&& bAlignNormalsWithAtmosphereLight == Other.bAlignNormalsWithAtmosphereLight;
+}
+
+uint32 GetTypeHash(const FCompositeMeshBatchKey& Key)
+{
+	uint32 Hash = PointerHash(Key.StaticMesh);
+	Hash = HashCombine(Hash, PointerHash(Key.OpaqueMaterial));
+	Hash = HashCombine(Hash, PointerHash(Key.StencilMaterial));
+	Hash = HashCombine(Hash, PointerHash(Key.TranslucentMaterial));
+	Hash = HashCombine(Hash, PointerHash(Key.SoftMaskMaterial));
+	Hash = HashCombine(Hash, GetTypeHash(Key.RayTracedBackfaceColor));
+	Hash = HashCombine(Hash, GetTypeHash(Key.RayTracedOutOfFrustumColor));
+	Hash = HashCombine(Hash, GetTypeHash(Key.PlanarReflectionBackgroundOcclusion));
+
+	const uint32 Flags = Key.LightingChannels
+		| (Key.Mobility << 8)
+		| (static_cast<uint32>(Key.RenderSoftMask) << 16)
+		| (Key.bBypassDepthOfField << 24)
+		| (Key.bCastShadows << 25)
+		| (Key.bAffectDistanceFieldLighting << 26)
+		| (Key.bAlignNormalsWithAtmosphereLight << 27);
+
+	return HashCombine(Hash, Flags);
+}
+
+bool UCompositeMeshBatchSubsystem::DoesSupportWorldType(EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCompositeMeshBatchSubsystem::AddCompositeMesh(ACompositeMesh* CompositeMesh)
+{
+	if (!IsValid(CompositeMesh) || !CompositeMesh->AreAllComponentsValid() || Instances.Contains(CompositeMesh))
+	{
+		return;
+	}
+
+	FCompositeMeshInstance Instance;
+	Instance.Key = MakeBatchKey(*CompositeMesh);
+	Instance.BatchIndex = FindOrAddBatch(Instance.Key, *CompositeMesh);
+	if (Instance.BatchIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	FCompositeMeshBatch& Batch = Batches[Instance.BatchIndex];
+	Instance.InstanceIndex = Batch.Meshes.Add(CompositeMesh);
+
+	// The custom data is written right after, the transform here is only a placeholder.
+	const FTransform InstanceTransform = FTransform::Identity;
+	Batch.OpaqueComponent->AddInstance(InstanceTransform, true);
+	Batch.StencilComponent->AddInstance(InstanceTransform, true);
+	Batch.TranslucentComponent->AddInstance(InstanceTransform, true);
+	Batch.SoftMaskComponent->AddInstance(InstanceTransform, true);
+
+	WriteInstanceData(Instance.BatchIndex, Instance.InstanceIndex, *CompositeMesh);
+
+	Instances.Add(CompositeMesh, Instance);
+
+	CompositeMesh->GetRootComponent()->TransformUpdated.AddUObject(this, &UCompositeMeshBatchSubsystem::OnCompositeMeshTransformUpdated);
+}
+
+void UCompositeMeshBatchSubsystem::RemoveCompositeMesh(ACompositeMesh* CompositeMesh)
+{
+	FCompositeMeshInstance Instance;
+	if (!Instances.RemoveAndCopyValue(CompositeMesh, Instance))
+	{
+		return;
+	}
+
+	if (IsValid(CompositeMesh) && CompositeMesh->GetRootComponent())
+	{
+		CompositeMesh->GetRootComponent()->TransformUpdated.RemoveAll(this);
+	}
+
+	// The components remove at swap, the last instance of the batch takes the place of the removed one.
+	FCompositeMeshBatch& Batch = Batches[Instance.BatchIndex];
+	Batch.OpaqueComponent->RemoveInstance(Instance.InstanceIndex);
+	Batch.StencilComponent->RemoveInstance(Instance.InstanceIndex);
+	Batch.TranslucentComponent->RemoveInstance(Instance.InstanceIndex);
+	Batch.SoftMaskComponent->RemoveInstance(Instance.InstanceIndex);
+	Batch.Meshes.RemoveAtSwap(Instance.InstanceIndex);
+
+	if (Batch.Meshes.IsValidIndex(Instance.InstanceIndex))
+	{
+		if (FCompositeMeshInstance* MovedInstance = Instances.Find(Batch.Meshes[Instance.InstanceIndex]))
+		{
+			MovedInstance->InstanceIndex = Instance.InstanceIndex;
+		}
+	}
+
+	DirtyBatchIndices.Add(Instance.BatchIndex);
+}
+
+void UCompositeMeshBatchSubsystem::UpdateCompositeMesh(ACompositeMesh* CompositeMesh)
+{
+	const FCompositeMeshInstance* Instance = Instances.Find(CompositeMesh);
+	if (!Instance)
+	{
+		return;
+	}
+
+	if (!(MakeBatchKey(*CompositeMesh) == Instance->Key))
+	{
+		RemoveCompositeMesh(CompositeMesh);
+		AddCompositeMesh(CompositeMesh);
+		return;
+	}
+
+	WriteInstanceData(Instance->BatchIndex, Instance->InstanceIndex, *CompositeMesh);
+}
+
+UInstancedStaticMeshComponent* UCompositeMeshBatchSubsystem::GetBatchSoftMaskComponent(const ACompositeMesh* CompositeMesh) const
+{
+	const FCompositeMeshInstance* Instance = Instances.Find(CompositeMesh);
+	return Instance ? Batches[Instance->BatchIndex].SoftMaskComponent : nullptr;
+}
+
+FCompositeMeshBatchKey UCompositeMeshBatchSubsystem::MakeBatchKey(const ACompositeMesh& CompositeMesh)
+{
+	const UStaticMeshComponent* OpaqueComponent = CompositeMesh.OpaqueComponent;
+
+	FCompositeMeshBatchKey Key;
+	Key.StaticMesh = CompositeMesh.StaticMesh;
+	Key.OpaqueMaterial = CompositeMesh.OpaqueMaterial;
+	Key.StencilMaterial = CompositeMesh.StencilMaterial;
+	Key.TranslucentMaterial = CompositeMesh.TranslucentMaterial;
+	Key.SoftMaskMaterial = CompositeMesh.RenderSoftMask == ERenderSoftMaskType::TranslucentVertexColorAlpha ? CompositeMesh.SoftMaskTranslucentMaterial : CompositeMesh.SoftMaskOpaqueMaterial;
+	Key.RayTracedBackfaceColor = CompositeMesh.RayTracedBackfaceColor;
+	Key.RayTracedOutOfFrustumColor = CompositeMesh.RayTracedOutOfFrustumColor;
+	Key.PlanarReflectionBackgroundOcclusion = CompositeMesh.PlanarReflectionBackgroundOcclusion;
+	Key.LightingChannels = OpaqueComponent->LightingChannels.bChannel0 | (OpaqueComponent->LightingChannels.bChannel1 << 1) | (OpaqueComponent->LightingChannels.bChannel2 << 2);
+	Key.Mobility = OpaqueComponent->Mobility;
+	Key.RenderSoftMask = CompositeMesh.RenderSoftMask;
+	Key.bBypassDepthOfField = CompositeMesh.bBypassDepthOfField;
+	Key.bCastShadows = CompositeMesh.bCastShadows;
+	Key.bAffectDistanceFieldLighting = CompositeMesh.bAffectDistanceFieldLighting;
+	Key.bAlignNormalsWithAtmosphereLight = CompositeMesh.bAlignNormalsWithAtmosphereLight;
+
+	return Key;
+}
+
+int32 UCompositeMeshBatchSubsystem::FindOrAddBatch(const FCompositeMeshBatchKey& Key, const ACompositeMesh& CompositeMesh)
+{
+	if (const int32* BatchIndex = BatchIndices.Find(Key))
+	{
+		return *BatchIndex;
+	}
+
+	UWorld* World = GetWorld();
+	if (!IsValid(World))
+	{
+		return INDEX_NONE;
+	}
+
+	if (!IsValid(BatchActor))
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.Name = MakeUniqueObjectName(World->PersistentLevel, AActor::StaticClass(), TEXT("CompositeMeshBatch"));
+		SpawnParameters.ObjectFlags = RF_Transient;
+		BatchActor = World->SpawnActor<AActor>(SpawnParameters);
+		if (!IsValid(BatchActor))
+		{
+			return INDEX_NONE;
+		}
+
+		USceneComponent* RootComponent = NewObject<USceneComponent>(BatchActor, TEXT("RootSceneComponent"), RF_Transient);
+		RootComponent->Mobility = EComponentMobility::Static;
+		BatchActor->SetRootComponent(RootComponent);
+		RootComponent->RegisterComponent();
+	}
+
+	FCompositeMeshBatch Batch;
+
+	// Group wide values are material parameters, per mesh values are written as instance custom data.
+	Batch.OpaqueMID = UKismetMaterialLibrary::CreateDynamicMaterialInstance(this, CompositeMesh.OpaqueMaterial, NAME_None, EMIDCreationFlags::Transient);
+	Batch.OpaqueMID->SetScalarParameterValue("UsePerInstanceCustomData", 1.F);
+	Batch.OpaqueMID->SetScalarParameterValue("PlanarReflectionBackgroundOcclusion", Key.PlanarReflectionBackgroundOcclusion);
+	Batch.OpaqueMID->SetScalarParameterValue("AlignNormalsWithAtmosphereLight", Key.bAlignNormalsWithAtmosphereLight ? 1.F : 0.F);
+	Batch.OpaqueMID->SetVectorParameterValue("RayTracedBackfaceColor", Key.RayTracedBackfaceColor);
+	Batch.OpaqueMID->SetVectorParameterValue("RayTracedOutOfFrustumColor", Key.RayTracedOutOfFrustumColor);
+	Batch.OpaqueMID->SetScalarParameterValue("RenderSoftMask", 1.F);
+
+	Batch.StencilMID = UKismetMaterialLibrary::CreateDynamicMaterialInstance(this, CompositeMesh.StencilMaterial, NAME_None, EMIDCreationFlags::Transient);
+	Batch.StencilMID->SetScalarParameterValue("UsePerInstanceCustomData", 1.F);
+
+	Batch.TranslucentMID = UKismetMaterialLibrary::CreateDynamicMaterialInstance(this, CompositeMesh.TranslucentMaterial, NAME_None, EMIDCreationFlags::Transient);
+	Batch.TranslucentMID->SetScalarParameterValue("UsePerInstanceCustomData", 1.F);
+	Batch.TranslucentMID->SetVectorParameterValue("RayTracedBackfaceColor", Key.RayTracedBackfaceColor);
+	Batch.TranslucentMID->SetVectorParameterValue("RayTracedOutOfFrustumColor", Key.RayTracedOutOfFrustumColor);
+	Batch.TranslucentMID->SetScalarParameterValue("BypassDepthOfField", Key.bBypassDepthOfField ? 1.F : 0.F);
+	Batch.TranslucentMID->SetScalarParameterValue("RenderSoftMask", 1.F);
+	Batch.TranslucentMID->SetScalarParameterValue("RenderSoftMaskBlack", Key.RenderSoftMask == ERenderSoftMaskType::OpaqueBlack ? 1.F : 0.F);
+
+	UMaterialInterface* SoftMaskMaterial = Key.RenderSoftMask == ERenderSoftMaskType::TranslucentVertexColorAlpha ? CompositeMesh.SoftMaskTranslucentMaterial : CompositeMesh.SoftMaskOpaqueMaterial;
+	Batch.SoftMaskMID = UKismetMaterialLibrary::CreateDynamicMaterialInstance(this, SoftMaskMaterial, NAME_None, EMIDCreationFlags::Transient);
+	Batch.SoftMaskMID->SetScalarParameterValue("UsePerInstanceCustomData", 1.F);
+	Batch.SoftMaskMID->SetScalarParameterValue("RenderVertexColor", Key.RenderSoftMask == ERenderSoftMaskType::OpaqueVertexColorAlpha ? 1.F : 0.F);
+
+	// The components of the first mesh already have all the render settings of the batch applied.
+	Batch.OpaqueComponent = CreateBatchComponent(CompositeMesh.OpaqueComponent, Batch.OpaqueMID);
+	Batch.StencilComponent = CreateBatchComponent(CompositeMesh.StencilComponent, Batch.StencilMID);
+	Batch.TranslucentComponent = CreateBatchComponent(CompositeMesh.TranslucentComponent, Batch.TranslucentMID);
+	Batch.SoftMaskComponent = CreateBatchComponent(CompositeMesh.SoftMaskComponent, Batch.SoftMaskMID);
+
+	const UCompositorSubsystem* CompositorSubsystem = World->GetSubsystem<UCompositorSubsystem>();
+	if (IsValid(CompositorSubsystem))
+	{
+		USoftMaskCaptureComponent* SoftMaskCaptureComponent = CompositorSubsystem->GetSoftMaskCaptureComponent();
+		if (IsValid(SoftMaskCaptureComponent))
+		{
+			SoftMaskCaptureComponent->ShowOnlyComponent(Batch.SoftMaskComponent);
+		}
+	}
+
+	const int32 BatchIndex = Batches.Add(Batch);
+	BatchIndices.Add(Key, BatchIndex);
+
+	return BatchIndex;
+}
+
+UInstancedStaticMeshComponent* UCompositeMeshBatchSubsystem::CreateBatchComponent(const UStaticMeshComponent* TemplateComponent, UMaterialInterface* Material)
+{
+	UInstancedStaticMeshComponent* Component = NewObject<UInstancedStaticMeshComponent>(BatchActor, NAME_None, RF_Transient);
+	Component->SetMobility(TemplateComponent->Mobility);
+	Component->bSupportRemoveAtSwap = true;
+	Component->NumCustomDataFloats = NumCustomDataFloats;
+	Component->SetStaticMesh(TemplateComponent->GetStaticMesh());
+	for (int32 MaterialIndex = 0; MaterialIndex < Component->GetNumMaterials(); ++MaterialIndex)
+	{
+		Component->SetMaterial(MaterialIndex, Material);
+	}
+
+	Component->SetVisibility(TemplateComponent->GetVisibleFlag());
+	Component->SetCastShadow(TemplateComponent->CastShadow);
+	Component->bCastStaticShadow = TemplateComponent->bCastStaticShadow;
+	Component->bCastContactShadow = TemplateComponent->bCastContactShadow;
+	Component->bAffectDistanceFieldLighting = TemplateComponent->bAffectDistanceFieldLighting;
+	Component->LightingChannels = TemplateComponent->LightingChannels;
+	Component->bRenderInMainPass = TemplateComponent->bRenderInMainPass;
+	Component->bRenderInDepthPass = TemplateComponent->bRenderInDepthPass;
+	Component->bRenderCustomDepth = TemplateComponent->bRenderCustomDepth;
+	Component->CustomDepthStencilWriteMask = TemplateComponent->CustomDepthStencilWriteMask;
+	Component->CustomDepthStencilValue = TemplateComponent->CustomDepthStencilValue;
+	Component->bVisibleInReflectionCaptures = TemplateComponent->bVisibleInReflectionCaptures;
+	Component->bVisibleInRealTimeSkyCaptures = TemplateComponent->bVisibleInRealTimeSkyCaptures;
+	Component->bVisibleInRayTracing = TemplateComponent->bVisibleInRayTracing;
+	Component->bVisibleInSceneCaptureOnly = TemplateComponent->bVisibleInSceneCaptureOnly;
+
+	Component->SetupAttachment(BatchActor->GetRootComponent());
+	Component->RegisterComponent();
+	BatchActor->AddInstanceComponent(Component);
+
+	return Component;
+}
+
+void UCompositeMeshBatchSubsystem::WriteInstanceData(int32 BatchIndex, int32 InstanceIndex, const ACompositeMesh& CompositeMesh)
+{
+	FCompositeMeshBatch& Batch = Batches[BatchIndex];
+
+	// The other components are attached to the opaque component with an identity transform.
+	const FTransform InstanceTransform = CompositeMesh.OpaqueComponent->GetRelativeTransform() * CompositeMesh.GetRootComponent()->GetComponentTransform();
+
+	TArray<float> CustomData;
+	CustomData.SetNumZeroed(NumCustomDataFloats);
+	CustomData[CustomDataReceiveShadowsIntensity] = CompositeMesh.GetAppliedReceiveShadowsIntensity();
+	CustomData[CustomDataPlanarReflectionColorIntensity] = CompositeMesh.PlanarReflectionColorIntensity;
+	CustomData[CustomDataIsTwoSided] = CompositeMesh.bIsTwoSided ? 1.F : 0.F;
+	CustomData[CustomDataSoftMaskValue] = CompositeMesh.RenderSoftMask == ERenderSoftMaskType::OpaqueWhite ? 1.F : 0.F;
+
+	for (UInstancedStaticMeshComponent* Component : { Batch.OpaqueComponent, Batch.StencilComponent, Batch.TranslucentComponent, Batch.SoftMaskComponent })
+	{
+		Component->UpdateInstanceTransform(InstanceIndex, InstanceTransform, true, false, true);
+		Component->SetCustomData(InstanceIndex, CustomData, false);
+	}
+
+	// Moving many meshes in one frame recreates the render state of each batch once, not once per mesh.
+	DirtyBatchIndices.Add(BatchIndex);
+}
+
+void UCompositeMeshBatchSubsystem::Tick(float DeltaTime)
+{
+	FlushDirtyBatches();
+}
+
+ETickableTickType UCompositeMeshBatchSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+void UCompositeMeshBatchSubsystem::FlushDirtyBatches()
+{
+	if (DirtyBatchIndices.Num() == 0)
+	{
+		return;
+	}
+
+	for (const int32 BatchIndex : DirtyBatchIndices)
+	{
+		const FCompositeMeshBatch& Batch = Batches[BatchIndex];
+		for (UInstancedStaticMeshComponent* Component : { Batch.OpaqueComponent, Batch.StencilComponent, Batch.TranslucentComponent, Batch.SoftMaskComponent })
+		{
+			if (IsValid(Component))
+			{
+				Component->MarkRenderStateDirty();
+			}
+		}
+	}
+	DirtyBatchIndices.Reset();
+
+	RequestSoftMaskCapture();
+}
+
+void UCompositeMeshBatchSubsystem::RequestSoftMaskCapture() const
+{
+	const UCompositorSubsystem* CompositorSubsystem = GetWorld()->GetSubsystem<UCompositorSubsystem>();
+	if (IsValid(CompositorSubsystem))
+	{
+		USoftMaskCaptureComponent* SoftMaskCaptureComponent = CompositorSubsystem->GetSoftMaskCaptureComponent();
+		if (IsValid(SoftMaskCaptureComponent))
+		{
+			SoftMaskCaptureComponent->RequestCapture();
+		}
+	}
+}
+
+void UCompositeMeshBatchSubsystem::OnCompositeMeshTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	if (ACompositeMesh* CompositeMesh = Cast<ACompositeMesh>(UpdatedComponent->GetOwner()))
+	{
+		UpdateCompositeMesh(CompositeMesh);
+	}
+}
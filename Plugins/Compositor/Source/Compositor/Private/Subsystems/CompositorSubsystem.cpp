@@ -8,11 +8,15 @@
 #include "Actors/CompositeMesh.h"
 #include "Assets/Composite.h"
 #include "Assets/CompositeKeyer.h"
+#include "Assets/CompositeKeyerColorDifference.h"
 #include "Components/SoftMaskCaptureComponent.h"
 #include "Objects/CompositeWorldData.h"
 #include "Objects/CompositeColorGrade.h"
+#include "Objects/CompositeMediaFrameQueue.h"
 #include "Objects/CompositeViewExtension.h"
+#include "Objects/CompositorMPCDeltaWriter.h"
 #include "CompositeTypes.h"
+#include "CompositorStats.h"
 #include "IDisplayCluster.h"
 
 #include "GameFramework/GameModeBase.h"
@@ -22,15 +26,28 @@
 #include "Kismet/KismetRenderingLibrary.h"
 #include "Kismet/GameplayStatics.h"
 #include "MediaTexture.h"
+#include "MediaPlayer.h"
+#include "MediaPlayerFacade.h"
+#include "Misc/App.h"
+#include "ProfilingDebugging/ScopedTimers.h"
 // #include "LensDistortionComponent.h"
 #include "Camera/CameraActor.h"
 #include "Cluster/IDisplayClusterClusterManager.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
 #include "Engine/TextureRenderTarget2D.h"
 #include "Materials/MaterialInstanceDynamic.h"
 
 #include "Materials/MaterialInterface.h"
 #include "Materials/MaterialParameterCollection.h"
 #include "Slate/SceneViewport.h"
+#include "Engine/GameViewportClient.h"
+
+namespace CompositorSubsystem
+{
+	/** Texture parameter of the undistort material for the keyed media, lets it read the media directly when there is no keyer. */
+	const FName MediaInputKeyedTextureParameterName(TEXT("Compositor_MediaInputKeyedTexture"));
+}
 
 #if WITH_EDITOR
 #include "LevelEditor.h"
@@ -50,8 +67,8 @@ bool UCompositorSubsystem::ShouldCreateSubsystem(UObject* Outer) const
 	{		
 		const EDisplayClusterNodeRole DisplayClusterNodeRole = IDisplayCluster::Get().GetClusterMgr()->GetClusterRole();
 		
-		// If nDisplay is running and the engine is part of the cluster we don't create the compositor subsystem.
-		if (DisplayClusterNodeRole != EDisplayClusterNodeRole::None)
+		// If nDisplay is running and the engine is part of the cluster we don't create the compositor subsystem, unless it composites across the cluster.
+		if (DisplayClusterNodeRole != EDisplayClusterNodeRole::None && !FCompositorClusterSync::IsClusterCompositingEnabled())
 		{
 			UE_LOG(LogCompositor, Log, TEXT("Compositor Subsystem is not created because it is part of an nDisplay Cluster."));
 			return false;
@@ -70,18 +87,29 @@ void UCompositorSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	MediaInputDefaultFallbackTexture = Cast<UTexture2D>(FSoftObjectPath(TEXT("/Compositor/MediaFramework/T_Compositor_MediaInputFallback.T_Compositor_MediaInputFallback")).TryLoad());
 	PlanarReflectionTexture = Cast<UTextureRenderTarget2D>(FSoftObjectPath(TEXT("/Compositor/CompositePlanarReflection/RT_CompositePlanarReflection.RT_CompositePlanarReflection")).TryLoad());
 
-	MediaInputKeyedRenderTarget = Cast<UTextureRenderTarget2D>(FSoftObjectPath(TEXT("/Compositor/CompositeKeyer/RT_MediaInputKeyed.RT_MediaInputKeyed")).TryLoad());
-	UKismetRenderingLibrary::ClearRenderTarget2D(this, MediaInputKeyedRenderTarget, FLinearColor(0, 0, 0, 0));
+	MediaInputKeyedTextureAsset = Cast<UTextureRenderTarget2D>(FSoftObjectPath(TEXT("/Compositor/CompositeKeyer/RT_MediaInputKeyed.RT_MediaInputKeyed")).TryLoad());
+	UKismetRenderingLibrary::ClearRenderTarget2D(this, MediaInputKeyedTextureAsset, FLinearColor(0, 0, 0, 0));
+	MediaInputKeyedRenderTarget = nullptr;
 	MediaInputCompositeKeyerDisabledFallbackMaterial = Cast<UMaterialInterface>(FSoftObjectPath(TEXT("/Compositor/CompositeKeyer/M_CompositeKeyerDisabledFallback.M_CompositeKeyerDisabledFallback")).TryLoad());
 	MediaInputCompositeKeyerDisabledFallbackMID = UKismetMaterialLibrary::CreateDynamicMaterialInstance(this, MediaInputCompositeKeyerDisabledFallbackMaterial, FName("MediaKeyerDisabledFallbackMID"), EMIDCreationFlags::Transient);
 	
 	DefaultUndistortTexture = Cast<UTexture2D>(FSoftObjectPath(TEXT("/Compositor/LensData/T_DefaultUndistort.T_DefaultUndistort")).TryLoad());
-	MediaInputUndistortedTexture = Cast<UTextureRenderTarget2D>(FSoftObjectPath(TEXT("/Compositor/LensData/RT_Compositor_MediaInputUndistorted.RT_Compositor_MediaInputUndistorted")).TryLoad());
-	UKismetRenderingLibrary::ClearRenderTarget2D(this, MediaInputUndistortedTexture, FLinearColor(0, 0, 0, 0));
+	MediaInputUndistortedTextureAsset = Cast<UTextureRenderTarget2D>(FSoftObjectPath(TEXT("/Compositor/LensData/RT_Compositor_MediaInputUndistorted.RT_Compositor_MediaInputUndistorted")).TryLoad());
+	UKismetRenderingLibrary::ClearRenderTarget2D(this, MediaInputUndistortedTextureAsset, FLinearColor(0, 0, 0, 0));
+	MediaInputUndistortedTexture = nullptr;
 	MediaInputUndistortMaterial = Cast<UMaterialInterface>(FSoftObjectPath(TEXT("/Compositor/LensData/M_MediaInputUndistort.M_MediaInputUndistort")).TryLoad());
 	MediaInputUndistortMID = UKismetMaterialLibrary::CreateDynamicMaterialInstance(this, MediaInputUndistortMaterial, FName("MediaInputUndistortMID"), EMIDCreationFlags::Transient);
 
+	UTexture* KeyedTextureParameterValue = nullptr;
+	bUndistortMaterialHasKeyedTextureParameter = IsValid(MediaInputUndistortMaterial)
+		&& MediaInputUndistortMaterial->GetTextureParameterValue(FMaterialParameterInfo(CompositorSubsystem::MediaInputKeyedTextureParameterName), KeyedTextureParameterValue);
+
 	CompositorMaterialParameterCollection = Cast<UMaterialParameterCollection>(FSoftObjectPath(TEXT("/Compositor/Materials/ParameterCollections/MPC_Compositor")).TryLoad());
+	MPCDeltaWriter.Initialize(GetWorld(), CompositorMaterialParameterCollection);
+	MPCParameters.Register(MPCDeltaWriter);
+
+	ClusterSync.Initialize();
+	ClusterLensState.Reset();
 
 	CompositeWorldData = GetCompositeWorldData();
 
@@ -130,11 +158,29 @@ void UCompositorSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	{
 		UE_LOG(LogCompositor, Log, TEXT("Initializing Scene View Extention"));
 		CompositeViewExtension = FSceneViewExtensions::NewExtension<FCompositeViewExtension>(this);
+		MaterialBindingViewExtension = FSceneViewExtensions::NewExtension<FCompositeMaterialBindingViewExtension>(GetWorld());
+	}
+
+	// Every asset starts out unbound, views of this world must not read render targets another world bound to them.
+	MaterialTextureBindings.Reset();
+	bMaterialTextureBindingsDirty = true;
+	BindMaterialTexture(MediaInputKeyedTextureAsset, nullptr);
+	BindMaterialTexture(MediaInputUndistortedTextureAsset, nullptr);
+	if (IsValid(SoftMaskCaptureComponent))
+	{
+		BindMaterialTexture(SoftMaskCaptureComponent->GetMaterialTextureTarget(), nullptr);
 	}
 
 	ClearReflectionCaptureRenderTarget();
 
 	CompositeViewport = nullptr;
+
+	MediaInputKeyedRenderTargetWriter = nullptr;
+	LastFallbackDrawHash = 0;
+	MediaInputKeyedGeneration = 0;
+	LastUndistortDrawHash = 0;
+	bMediaPrePassRequested = false;
+	bPassThroughMedia = false;
 	
 #if WITH_EDITOR
 	bIsModifyViewportClientViewRegistered = false;
@@ -162,10 +208,39 @@ void UCompositorSubsystem::Deinitialize()
 		World->OnWorldBeginPlay.RemoveAll(this);
 	}
 
+	MediaFrameQueue.Reset();
+	MediaFrameQueuePlayer = nullptr;
+	MediaSampleCounter.Reset();
+	MediaSampleCounterPlayer = nullptr;
+
+	ClusterSync.Deinitialize();
+	ClusterLensState.Reset();
+
+	SetSoftMaskUpsample(nullptr, nullptr);
+
+	// The extension must not hold on to the render targets of this world once they go away.
+	for (TPair<UTexture*, UTextureRenderTarget2D*>& Binding : MaterialTextureBindings)
+	{
+		Binding.Value = nullptr;
+	}
+	bMaterialTextureBindingsDirty = true;
+	FlushMaterialTextureBindings();
+	MaterialTextureBindings.Reset();
+
+	RenderTargetPool.Empty();
+	MediaInputKeyedRenderTarget = nullptr;
+	MediaInputUndistortedTexture = nullptr;
+
 	OnCompositeWorldDataAdded.Clear();
 	OnCompositeWorldDataRemoved.Clear();
 	OnCompositeUpdateInterfaceRegistered.Clear();
 	OnCompositeUpdateInterfaceUnregistered.Clear();
+	OnCompositeMeshesRegistered.Clear();
+
+	QueuedCompositeMeshes.Reset();
+	QueuedCompositeMeshesHead = 0;
+	QueuedCompositeMeshKeys.Reset();
+	SET_DWORD_STAT(STAT_CompositorCompositeMeshesQueued, 0);
 
 #if WITH_EDITOR
 	RegisterModifyViewportClientView(false);
@@ -181,17 +256,23 @@ void UCompositorSubsystem::OnWorldBeginPlayCallback()
 	if (CompositorMaterialParameterCollection)
 	{
 		AMoviePipelineGameMode* MoviePipelineGameMode = Cast<AMoviePipelineGameMode>(UGameplayStatics::GetGameMode(this));
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("IsMovieRenderQueueEnabled"), MoviePipelineGameMode ? 1.F : 0.F);
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.IsMovieRenderQueueEnabled, MoviePipelineGameMode ? 1.F : 0.F);
+		MPCDeltaWriter.Flush();
 	}
 }
 
 void UCompositorSubsystem::UpdateLensData()
 {
+	COMPOSITOR_SCOPE_CYCLE_COUNTER(STAT_CompositorUpdateLensData);
+
 	if (GEngine)
 	{		
 		CurrentUndistortTexture = DefaultUndistortTexture;
 		CameraFovWithoutOverscan = 90;
 		CameraOverscanFactor = 1.F;
+
+		// Everything the undistorted media depends on besides the texture and factors above.
+		uint32 DistortionStateHash = 0;
 		
 #if WITH_EDITORONLY_DATA
 		UCameraComponent* EditorCameraComponent = nullptr;
@@ -238,15 +319,11 @@ void UCompositorSubsystem::UpdateLensData()
 					UCineCameraComponent* CineCameraComponent = Cast<UCineCameraComponent>(ViewTarget->GetComponentByClass(UCineCameraComponent::StaticClass()));
 					if (IsValid(CineCameraComponent))
 					{
-						FDistortionHandlerPicker DistortionHandlerPicker;
-						DistortionHandlerPicker.TargetCameraComponent = CineCameraComponent;
-						
-					
-						const ULensDistortionModelHandlerBase* DistortionModelHandlerBase = CameraCalibrationSubsystem->FindDistortionModelHandler(DistortionHandlerPicker);
+						const ULensDistortionModelHandlerBase* DistortionModelHandlerBase = FindDistortionModelHandler(CineCameraComponent);
 						if (IsValid(DistortionModelHandlerBase))
 						{
 							// The lens distortion component does not have a public function to check if the distortion is applied (4.27) so we just check of the distort MID is on the camera.
-							const TArray<FWeightedBlendable> WeightedBlendables = CineCameraComponent->PostProcessSettings.WeightedBlendables.Array;
+							const TArray<FWeightedBlendable>& WeightedBlendables = CineCameraComponent->PostProcessSettings.WeightedBlendables.Array;
 							bool bIsDistortionApplied = false;
 							for (int32 i = 0, count = WeightedBlendables.Num(); i < count; ++i)
 							{
@@ -268,6 +345,15 @@ void UCompositorSubsystem::UpdateLensData()
 								// Overrides the focal length with the original focal length in case it is adjusted for overscan.
 								CameraCalibrationSubsystem->GetOriginalFocalLength(CineCameraComponent, FocalLenth);
 								CameraFovWithoutOverscan = FMath::RadiansToDegrees(2.0f * FMath::Atan(CineCameraComponent->Filmback.SensorWidth / (2.0f * FocalLenth)));
+
+								// The displacement map is redrawn in place when focus or zoom change, so its pointer alone is not enough.
+								const FLensDistortionState DistortionState = DistortionModelHandlerBase->GetCurrentDistortionState();
+								for (const float Parameter : DistortionState.DistortionInfo.Parameters)
+								{
+									DistortionStateHash = HashCombine(DistortionStateHash, GetTypeHash(Parameter));
+								}
+								DistortionStateHash = HashCombine(DistortionStateHash, GetTypeHash(DistortionState.FocalLengthInfo.FxFy));
+								DistortionStateHash = HashCombine(DistortionStateHash, GetTypeHash(DistortionState.ImageCenter.PrincipalPoint));
 							}							
 						}
 					}
@@ -276,20 +362,105 @@ void UCompositorSubsystem::UpdateLensData()
 		}
 		
 
+		if (ClusterSync.IsActive())
+		{
+			if (ClusterSync.IsPrimary())
+			{
+				FCompositorClusterLensState LensState;
+				LensState.CameraFovWithoutOverscan = CameraFovWithoutOverscan;
+				LensState.CameraOverscanFactor = CameraOverscanFactor;
+				ClusterSync.SendState(GetWorldComposite(), LensState);
+			}
+			else if (ClusterLensState.IsSet())
+			{
+				// The nodes render their own part of the wall, the media is projected with the lens of the tracked camera on the primary node.
+				CameraFovWithoutOverscan = ClusterLensState->CameraFovWithoutOverscan;
+				CameraOverscanFactor = ClusterLensState->CameraOverscanFactor;
+			}
+		}
+
 		if (CompositorMaterialParameterCollection)
 		{
-			UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, "CameraFovWithoutOverscan", CameraFovWithoutOverscan);
-			UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, "CameraOverscanFactor", CameraOverscanFactor);
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.CameraFovWithoutOverscan, CameraFovWithoutOverscan);
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.CameraOverscanFactor, CameraOverscanFactor);
 		}
 
-		if (MediaInputUndistortMID)
+		if (MediaInputUndistortMID || MediaPrePassMode.IsSet())
 		{
-			MediaInputUndistortMID->SetTextureParameterValue("UndistortTexture", CurrentUndistortTexture);
-			UKismetRenderingLibrary::DrawMaterialToRenderTarget(this, MediaInputUndistortedTexture, MediaInputUndistortMID);
+			// Media textures get their frames on the render thread, the pre pass reads them there every frame so they show without delay.
+			// A sample picked by the media frame queue is game thread state, those requests are sent whenever the sample changes.
+			const bool bMediaPrePassEveryFrame = MediaPrePassMode.IsSet() && IsValid(CompositeWorldData) && CompositeWorldData->GetProcessMediaOnRenderThread()
+				&& Cast<UMediaTexture>(GetActiveMediaTexture()) && !GetQueuedMediaSample().IsValid();
+
+			// Only undistort again when the lens or the media changed, on fixed lens shots this skips a full resolution pass every frame.
+			uint32 UndistortDrawHash = HashCombine(DistortionStateHash, PointerHash(CurrentUndistortTexture));
+			UndistortDrawHash = HashCombine(UndistortDrawHash, MediaPrePassMode.IsSet() ? static_cast<uint32>(MediaPrePassMode.GetValue()) + 1 : 0);
+			UndistortDrawHash = HashCombine(UndistortDrawHash, PointerHash(FusedMediaPrePassKeyer.Get()));
+			UndistortDrawHash = HashCombine(UndistortDrawHash, GetTypeHash(bPassThroughMedia));
+			UndistortDrawHash = HashCombine(UndistortDrawHash, GetTypeHash(CameraOverscanFactor));
+			UndistortDrawHash = HashCombine(UndistortDrawHash, GetTypeHash(CameraFovWithoutOverscan));
+			if (!bMediaPrePassEveryFrame)
+			{
+				UndistortDrawHash = HashCombine(UndistortDrawHash, GetActiveMediaFrameHash());
+				UndistortDrawHash = HashCombine(UndistortDrawHash, GetTypeHash(MediaInputKeyedGeneration));
+			}
+			if (IsValid(MediaInputUndistortedTexture))
+			{
+				UndistortDrawHash = HashCombine(UndistortDrawHash, PointerHash(MediaInputUndistortedTexture));
+				UndistortDrawHash = HashCombine(UndistortDrawHash, PointerHash(MediaInputKeyedRenderTarget));
+				UndistortDrawHash = HashCombine(UndistortDrawHash, GetTypeHash(MediaInputUndistortedTexture->SizeX));
+				UndistortDrawHash = HashCombine(UndistortDrawHash, GetTypeHash(MediaInputUndistortedTexture->SizeY));
+			}
+
+			if (MediaPrePassMode.IsSet())
+			{
+				RequestMediaPrePass(UndistortDrawHash, bMediaPrePassEveryFrame);
+			}
+			else if (UndistortDrawHash != LastUndistortDrawHash)
+			{
+				// A pre pass that did not run yet or runs every frame would overwrite the material draw.
+				if (bMediaPrePassRequested && CompositeViewExtension.IsValid())
+				{
+					CompositeViewExtension->ClearMediaPrePass_GameThread();
+				}
+				bMediaPrePassRequested = false;
+
+				MediaInputUndistortMID->SetTextureParameterValue("UndistortTexture", CurrentUndistortTexture);
+				if (bUndistortMaterialHasKeyedTextureParameter)
+				{
+					UTexture* KeyedTexture = bPassThroughMedia ? GetActiveMediaTexture() : MediaInputKeyedRenderTarget;
+					MediaInputUndistortMID->SetTextureParameterValue(CompositorSubsystem::MediaInputKeyedTextureParameterName, KeyedTexture);
+				}
+				DrawMaterialToRenderTarget(MediaInputUndistortedTexture, MediaInputUndistortMID);
+				INC_DWORD_STAT(STAT_CompositorUndistortDraws);
+				LastUndistortDrawHash = UndistortDrawHash;
+			}
 		}
 	}
 }
 
+const ULensDistortionModelHandlerBase* UCompositorSubsystem::FindDistortionModelHandler(UCineCameraComponent* CineCameraComponent)
+{
+	if (DistortionHandlerCameraComponent.Get() == CineCameraComponent && DistortionModelHandler.IsValid())
+	{
+		return DistortionModelHandler.Get();
+	}
+
+	DistortionHandlerCameraComponent = CineCameraComponent;
+	DistortionModelHandler = nullptr;
+
+	UCameraCalibrationSubsystem* CameraCalibrationSubsystem = GEngine ? GEngine->GetEngineSubsystem<UCameraCalibrationSubsystem>() : nullptr;
+	if (IsValid(CameraCalibrationSubsystem))
+	{
+		FDistortionHandlerPicker DistortionHandlerPicker;
+		DistortionHandlerPicker.TargetCameraComponent = CineCameraComponent;
+
+		DistortionModelHandler = CameraCalibrationSubsystem->FindDistortionModelHandler(DistortionHandlerPicker);
+	}
+
+	return DistortionModelHandler.Get();
+}
+
 void UCompositorSubsystem::RegisterCompositeUpdateInterface(TScriptInterface<ICompositeUpdateInterface> CompositeUpdateInterface)
 {
 	UObject* InterfaceObject = CompositeUpdateInterface.GetObject();
@@ -306,47 +477,467 @@ void UCompositorSubsystem::RegisterCompositeUpdateInterface(TScriptInterface<ICo
 		return;
 	}
 
-	const int32 Index = CompositeUpdateInterfaceArray.AddUnique(CompositeUpdateInterface);
-	if (Index >= 0)
+	if (CompositeUpdateRegistry.Add(CompositeUpdateInterface))
 	{
 		// Always do an update for newly registered interfaces if a composite is already active.
 		UComposite* WorldComposite = GetWorldComposite();
 		if (IsValid(WorldComposite))
 		{
-			CompositeUpdateInterface->OnCompositeUpdate(*WorldComposite);
+			CompositeUpdateInterface->OnCompositeUpdate(*WorldComposite, ECompositeUpdateFlags::All);
 		}
 
-		OnCompositeUpdateInterfaceRegistered.Broadcast(CompositeUpdateInterface);
+		ACompositeMesh* CompositeMesh = bIsRegisteringCompositeMeshBatch ? Cast<ACompositeMesh>(InterfaceObject) : nullptr;
+		if (CompositeMesh != nullptr)
+		{
+			RegisteredCompositeMeshBatch.Add(CompositeMesh);
+		}
+		else
+		{
+			OnCompositeUpdateInterfaceRegistered.Broadcast(CompositeUpdateInterface);
+		}
 	}
 }
 
 void UCompositorSubsystem::UnregisterCompositeUpdateInterface(TScriptInterface<ICompositeUpdateInterface> CompositeUpdateInterface)
 {
-	const int32 Index = CompositeUpdateInterfaceArray.Remove(CompositeUpdateInterface);
-	if (Index >= 0)
+	// A mesh streamed out before its turn came never registers.
+	QueuedCompositeMeshKeys.Remove(FObjectKey(CompositeUpdateInterface.GetObject()));
+
+	if (CompositeUpdateRegistry.Remove(CompositeUpdateInterface))
 	{
 		OnCompositeUpdateInterfaceUnregistered.Broadcast(CompositeUpdateInterface);
 	}
 }
 
+bool UCompositorSubsystem::QueueCompositeMeshRegistration(ACompositeMesh* CompositeMesh)
+{
+	// Meshes loaded with the world register while it begins play, where a long frame does not show.
+	const UWorld* World = GetWorld();
+	if (!IsValid(CompositeMesh) || !IsValid(World) || !World->HasBegunPlay() || !IsValid(CompositeWorldData) || CompositeWorldData->GetCompositeMeshRegistrationBudget() <= 0.F)
+	{
+		return false;
+	}
+
+	// Spawned meshes already registered in their construction script.
+	if (CompositeUpdateRegistry.Contains(CompositeMesh))
+	{
+		return false;
+	}
+
+	bool bIsAlreadyQueued = false;
+	const FObjectKey Key(CompositeMesh);
+	QueuedCompositeMeshKeys.Add(Key, &bIsAlreadyQueued);
+	if (!bIsAlreadyQueued)
+	{
+		QueuedCompositeMeshes.Add(Key);
+	}
+
+	return true;
+}
+
+void UCompositorSubsystem::ProcessQueuedCompositeMeshRegistrations()
+{
+	if (QueuedCompositeMeshKeys.Num() == 0)
+	{
+		QueuedCompositeMeshes.Reset();
+		QueuedCompositeMeshesHead = 0;
+		return;
+	}
+
+	COMPOSITOR_SCOPE_CYCLE_COUNTER(STAT_CompositorCompositeMeshRegistration);
+
+	// Without world data there is nothing left to hold the queue back for.
+	const double Budget = IsValid(CompositeWorldData) ? CompositeWorldData->GetCompositeMeshRegistrationBudget() / 1000.0 : 0.0;
+	const double StartTime = FPlatformTime::Seconds();
+
+	// The registrations are collected so the listeners see the whole batch at once, the soft mask rebuilds its show only list a single time.
+	bIsRegisteringCompositeMeshBatch = true;
+	RegisteredCompositeMeshBatch.Reset();
+
+	int32 NumProcessed = 0;
+	while (QueuedCompositeMeshesHead < QueuedCompositeMeshes.Num())
+	{
+		// At least one mesh per tick, so the queue drains even when a single mesh takes longer than the budget.
+		if (NumProcessed > 0 && Budget > 0.0 && FPlatformTime::Seconds() - StartTime >= Budget)
+		{
+			break;
+		}
+
+		const FObjectKey Key = QueuedCompositeMeshes[QueuedCompositeMeshesHead++];
+		if (!QueuedCompositeMeshKeys.Remove(Key))
+		{
+			continue;
+		}
+
+		ACompositeMesh* CompositeMesh = Cast<ACompositeMesh>(Key.ResolveObjectPtr());
+		if (!IsValid(CompositeMesh))
+		{
+			continue;
+		}
+
+		CompositeMesh->FinishCompositeMeshRegistration();
+		++NumProcessed;
+	}
+
+	bIsRegisteringCompositeMeshBatch = false;
+
+	if (QueuedCompositeMeshesHead >= QueuedCompositeMeshes.Num())
+	{
+		QueuedCompositeMeshes.Reset();
+		QueuedCompositeMeshesHead = 0;
+	}
+
+	INC_DWORD_STAT_BY(STAT_CompositorCompositeMeshesRegistered, RegisteredCompositeMeshBatch.Num());
+	SET_DWORD_STAT(STAT_CompositorCompositeMeshesQueued, QueuedCompositeMeshKeys.Num());
+
+	if (RegisteredCompositeMeshBatch.Num() > 0)
+	{
+		OnCompositeMeshesRegistered.Broadcast(RegisteredCompositeMeshBatch);
+		RegisteredCompositeMeshBatch.Reset();
+	}
+}
+
+void UCompositorSubsystem::UpdateMediaFrameQueue()
+{
+	// Only the render thread media passes can read a picked sample, the materials always show the media texture.
+	UMediaPlayer* MediaPlayer = nullptr;
+	if (IsValid(CompositeWorldData) && CompositeWorldData->GetUseMediaFrameQueue() && CompositeWorldData->GetProcessMediaOnRenderThread())
+	{
+		if (const UMediaTexture* MediaTexture = Cast<UMediaTexture>(GetActiveMediaTexture()))
+		{
+			MediaPlayer = MediaTexture->GetMediaPlayer();
+		}
+	}
+
+	const int32 Capacity = IsValid(CompositeWorldData) ? FMath::Max(CompositeWorldData->GetMediaFrameQueueDepth(), 1) : 1;
+	if (MediaFrameQueuePlayer.Get() != MediaPlayer || (MediaFrameQueue.IsValid() && MediaFrameQueue->GetCapacity() != Capacity))
+	{
+		MediaFrameQueue.Reset();
+		MediaFrameQueuePlayer = MediaPlayer;
+
+		if (IsValid(MediaPlayer))
+		{
+			MediaFrameQueue = MakeShared<FCompositeMediaFrameQueue, ESPMode::ThreadSafe>(Capacity);
+			MediaPlayer->GetPlayerFacade()->AddVideoSampleSink(MediaFrameQueue.ToSharedRef());
+		}
+	}
+
+	if (MediaFrameQueue.IsValid())
+	{
+		MediaFrameQueue->SelectFrame(FApp::GetCurrentFrameTime(), CompositeWorldData->GetMediaFrameDelay());
+	}
+}
+
+TSharedPtr<IMediaTextureSample, ESPMode::ThreadSafe> UCompositorSubsystem::GetQueuedMediaSample() const
+{
+	if (!MediaFrameQueue.IsValid())
+	{
+		return nullptr;
+	}
+
+	const TSharedPtr<IMediaTextureSample, ESPMode::ThreadSafe>& SelectedSample = MediaFrameQueue->GetSelectedSample();
+	if (!SelectedSample.IsValid() || !FCompositeMediaFrameQueue::IsSampleFormatSupported(*SelectedSample))
+	{
+		return nullptr;
+	}
+	return SelectedSample;
+}
+
+void UCompositorSubsystem::UpdateMediaSampleCounter()
+{
+	UMediaPlayer* MediaPlayer = nullptr;
+	if (const UMediaTexture* MediaTexture = Cast<UMediaTexture>(GetActiveMediaTexture()))
+	{
+		MediaPlayer = MediaTexture->GetMediaPlayer();
+	}
+
+	if (MediaSampleCounterPlayer.Get() != MediaPlayer)
+	{
+		MediaSampleCounter.Reset();
+		MediaSampleCounterPlayer = MediaPlayer;
+
+		if (IsValid(MediaPlayer))
+		{
+			MediaSampleCounter = MakeShared<FCompositeMediaSampleCounter, ESPMode::ThreadSafe>();
+			MediaPlayer->GetPlayerFacade()->AddVideoSampleSink(MediaSampleCounter.ToSharedRef());
+		}
+	}
+}
+
+TOptional<ETextureRenderTargetFormat> UCompositorSubsystem::GetMediaRenderTargetFormat(bool bNeedsUAV) const
+{
+	// 8 bit media keyed into the half float format of the assets doubles memory and bandwidth for no precision,
+	// sRGB keeps the precision of the source in the darks. Unordered access views can't write sRGB formats.
+	const UMediaTexture* MediaTexture = Cast<UMediaTexture>(GetActiveMediaTexture());
+	if (!bNeedsUAV && IsValid(MediaTexture) && MediaTexture->OutputFormat == MTOF_Default)
+	{
+		return RTF_RGBA8_SRGB;
+	}
+
+	return {};
+}
+
+void UCompositorSubsystem::BindMaterialTexture(UTexture* MaterialTexture, UTextureRenderTarget2D* RenderTarget)
+{
+	if (!IsValid(MaterialTexture))
+	{
+		return;
+	}
+
+	UTextureRenderTarget2D*& BoundRenderTarget = MaterialTextureBindings.FindOrAdd(MaterialTexture, nullptr);
+	if (BoundRenderTarget != RenderTarget)
+	{
+		BoundRenderTarget = RenderTarget;
+		bMaterialTextureBindingsDirty = true;
+	}
+}
+
+void UCompositorSubsystem::UnbindMaterialTexture(UTexture* MaterialTexture, const UTextureRenderTarget2D* RenderTarget)
+{
+	UTextureRenderTarget2D** BoundRenderTarget = MaterialTextureBindings.Find(MaterialTexture);
+	if (BoundRenderTarget && *BoundRenderTarget == RenderTarget)
+	{
+		*BoundRenderTarget = nullptr;
+		bMaterialTextureBindingsDirty = true;
+	}
+}
+
+void UCompositorSubsystem::FlushMaterialTextureBindings()
+{
+	if (!bMaterialTextureBindingsDirty || !MaterialBindingViewExtension.IsValid())
+	{
+		return;
+	}
+
+	TArray<FCompositeMaterialTextureBinding> Bindings;
+	Bindings.Reserve(MaterialTextureBindings.Num());
+	for (const TPair<UTexture*, UTextureRenderTarget2D*>& Binding : MaterialTextureBindings)
+	{
+		if (IsValid(Binding.Key))
+		{
+			FCompositeMaterialTextureBinding& NewBinding = Bindings.AddDefaulted_GetRef();
+			NewBinding.TextureReference = &Binding.Key->TextureReference;
+			NewBinding.OwnTexture = Binding.Key->GetResource();
+			NewBinding.BoundTexture = IsValid(Binding.Value) ? Binding.Value->GetResource() : NewBinding.OwnTexture;
+		}
+	}
+
+	MaterialBindingViewExtension->SetBindings_GameThread(Bindings);
+	bMaterialTextureBindingsDirty = false;
+}
+
+void UCompositorSubsystem::DrawMaterialToRenderTarget(UTextureRenderTarget2D* RenderTarget, UMaterialInterface* Material)
+{
+	// The canvas draw renders outside of any view family, the bindings are applied around its render commands instead.
+	FlushMaterialTextureBindings();
+	if (MaterialBindingViewExtension.IsValid())
+	{
+		MaterialBindingViewExtension->ApplyBindings_GameThread();
+	}
+
+	UKismetRenderingLibrary::DrawMaterialToRenderTarget(this, RenderTarget, Material);
+
+	if (MaterialBindingViewExtension.IsValid())
+	{
+		MaterialBindingViewExtension->RestoreBindings_GameThread();
+	}
+}
+
+void UCompositorSubsystem::SetSoftMaskUpsample(UTextureRenderTarget2D* SoftMaskTexture, UTextureRenderTarget2D* OutputTexture)
+{
+	if (!IsValid(SoftMaskTexture) || !IsValid(OutputTexture))
+	{
+		SoftMaskTexture = nullptr;
+		OutputTexture = nullptr;
+	}
+
+	if (SoftMaskUpsampleSource.Get() == SoftMaskTexture && SoftMaskUpsampleOutput.Get() == OutputTexture)
+	{
+		return;
+	}
+
+	SoftMaskUpsampleSource = SoftMaskTexture;
+	SoftMaskUpsampleOutput = OutputTexture;
+
+	if (!CompositeViewExtension.IsValid())
+	{
+		return;
+	}
+
+	if (!SoftMaskTexture)
+	{
+		CompositeViewExtension->SetSoftMaskUpsample_GameThread({});
+		return;
+	}
+
+	FCompositeSoftMaskUpsampleRequest Request;
+	Request.SoftMaskTexture = SoftMaskTexture->GameThread_GetRenderTargetResource();
+	Request.OutputTexture = OutputTexture->GameThread_GetRenderTargetResource();
+	CompositeViewExtension->SetSoftMaskUpsample_GameThread(Request);
+}
+
+bool UCompositorSubsystem::RenderSoftMaskMeshPass(UTextureRenderTarget2D* OutputTexture)
+{
+	if (!IsViewExtensionRendering() || !IsValid(OutputTexture) || GMaxRHIFeatureLevel < ERHIFeatureLevel::SM5)
+	{
+		return false;
+	}
+
+	FCompositeSoftMaskMeshPassRequest Request;
+	Request.OutputTexture = OutputTexture->GameThread_GetRenderTargetResource();
+
+	for (const ACompositeMesh* CompositeMesh : CompositeUpdateRegistry.GetCompositeMeshes())
+	{
+		// Batched meshes hide their own soft mask component, but it still follows the actor.
+		const UStaticMeshComponent* SoftMaskComponent = IsValid(CompositeMesh) ? CompositeMesh->GetSoftMaskComponent() : nullptr;
+		UStaticMesh* StaticMesh = IsValid(SoftMaskComponent) ? SoftMaskComponent->GetStaticMesh() : nullptr;
+		if (!StaticMesh || !StaticMesh->HasValidRenderData() || CompositeMesh->IsHidden())
+		{
+			continue;
+		}
+
+		FCompositeSoftMaskMesh& Mesh = Request.Meshes.AddDefaulted_GetRef();
+		Mesh.RenderData = StaticMesh->GetRenderData();
+		Mesh.LocalToWorld = SoftMaskComponent->GetComponentTransform().ToMatrixWithScale();
+		Mesh.RenderSoftMask = CompositeMesh->GetRenderSoftMask();
+		Mesh.bTwoSided = CompositeMesh->GetIsTwoSided();
+	}
+
+	INC_DWORD_STAT_BY(STAT_CompositorSoftMaskMeshDraws, Request.Meshes.Num());
+
+	CompositeViewExtension->RenderSoftMaskMeshPass_GameThread(Request);
+	return true;
+}
+
+bool UCompositorSubsystem::IsCompositeViewFamily(const FSceneViewExtensionContext& Context) const
+{
+	return Context.Viewport
+		&& Context.Viewport == CompositeViewport
+		&& IsValid(CompositeWorldData)
+		&& CompositeWorldData->GetIsWorldCompositeEnabled();
+}
+
+bool UCompositorSubsystem::IsViewExtensionRendering() const
+{
+	// Movie Render Queue renders its own view families, which are not the composite viewport.
+	if (!CompositeViewExtension.IsValid() || !CompositeViewport || Cast<AMoviePipelineGameMode>(UGameplayStatics::GetGameMode(this)))
+	{
+		return false;
+	}
+
+	// The composite viewport may exist without rendering, like an editor viewport that is not realtime.
+	return IsValid(CompositeWorldData) && CompositeWorldData->GetIsWorldCompositeEnabled() && CompositeViewExtension->IsRendering_GameThread();
+}
+
+bool UCompositorSubsystem::CanRunMediaPrePass() const
+{
+	// The passes are compute shaders registered from the view extension that write into the media render targets.
+	return IsViewExtensionRendering()
+		&& IsValid(MediaInputKeyedTextureAsset)
+		&& IsValid(MediaInputUndistortedTextureAsset)
+		&& GMaxRHIFeatureLevel >= ERHIFeatureLevel::SM5;
+}
+
+UCompositeKeyerColorDifference* UCompositorSubsystem::GetFusedMediaPrePassKeyer(UCompositeKeyer* CompositeKeyer) const
+{
+	UCompositeKeyerColorDifference* ColorDifferenceKeyer = Cast<UCompositeKeyerColorDifference>(CompositeKeyer);
+	if (!IsValid(ColorDifferenceKeyer) || !ColorDifferenceKeyer->GetUseFusedMediaPrePass() || !ColorDifferenceKeyer->GetIsKeyerEnabled())
+	{
+		return nullptr;
+	}
+
+	return CanRunMediaPrePass() ? ColorDifferenceKeyer : nullptr;
+}
+
+void UCompositorSubsystem::RequestMediaPrePass(uint32 UndistortDrawHash, bool bEveryFrame)
+{
+	FCompositeMediaPrePassRequest Request;
+	Request.Mode = MediaPrePassMode.GetValue();
+	Request.bEveryFrame = bEveryFrame;
+
+	if (Request.Mode == ECompositeMediaPrePassMode::Fused)
+	{
+		const UCompositeKeyerColorDifference* FusedKeyer = FusedMediaPrePassKeyer.Get();
+		if (!FusedKeyer)
+		{
+			return;
+		}
+
+		Request.KeyerConstants = FCompositeKeyerCPU(FusedKeyer->GetKeyerCPUSettings()).GetConstants();
+
+		// Without a color grade object the post process does not grade the media either.
+		const UComposite* WorldComposite = GetWorldComposite();
+		if (IsValid(WorldComposite) && WorldComposite->GetCompositeColorGrade())
+		{
+			Request.Grade = FCompositeKeyerCPUGrade(WorldComposite->GetResolvedSettings().ColorGradeMedia);
+		}
+
+		UndistortDrawHash = HashCombine(UndistortDrawHash, FCrc::MemCrc32(&Request.KeyerConstants, sizeof(Request.KeyerConstants)));
+		UndistortDrawHash = HashCombine(UndistortDrawHash, FCrc::MemCrc32(&Request.Grade, sizeof(Request.Grade)));
+	}
+
+
+	UTexture* ActiveMediaTexture = GetActiveMediaTexture();
+	UndistortDrawHash = HashCombine(UndistortDrawHash, PointerHash(ActiveMediaTexture));
+	if (UndistortDrawHash == LastUndistortDrawHash)
+	{
+		return;
+	}
+
+	Request.MediaTexture = IsValid(ActiveMediaTexture) ? ActiveMediaTexture->GetResource() : nullptr;
+	Request.MediaSample = GetQueuedMediaSample();
+	// The default displacement map is black, sampling it would not move any pixel.
+	Request.UndistortTexture = IsValid(CurrentUndistortTexture) && CurrentUndistortTexture != DefaultUndistortTexture ? CurrentUndistortTexture->GetResource() : nullptr;
+	Request.KeyedTexture = MediaInputKeyedRenderTarget->GameThread_GetRenderTargetResource();
+	Request.OutputTexture = MediaInputUndistortedTexture->GameThread_GetRenderTargetResource();
+
+	CompositeViewExtension->RequestMediaPrePass_GameThread(Request);
+	if (Request.Mode != ECompositeMediaPrePassMode::Undistort)
+	{
+		INC_DWORD_STAT(STAT_CompositorKeyerDraws);
+	}
+	INC_DWORD_STAT(STAT_CompositorUndistortDraws);
+	LastUndistortDrawHash = UndistortDrawHash;
+	bMediaPrePassRequested = true;
+}
+
 void UCompositorSubsystem::Tick(float DeltaTime)
 {
+	COMPOSITOR_SCOPE_CYCLE_COUNTER(STAT_CompositorTick);
+
+	LastTickTimings = FCompositorTickTimings();
+
+	ProcessQueuedCompositeMeshRegistrations();
+
+	MediaPrePassMode.Reset();
+	FusedMediaPrePassKeyer = nullptr;
+	bPassThroughMedia = false;
+
+	if (ClusterSync.IsActive() && !ClusterSync.IsPrimary())
+	{
+		// Before anything reads the resolved settings this frame.
+		const uint32 SettingsGeneration = UComposite::GetSettingsGeneration();
+		ClusterLensState = ClusterSync.ApplyReceivedState(GetWorldComposite());
+
+		// The settings of the primary node changed, everything that took them from the composite has to update like after an edit.
+		if (UComposite::GetSettingsGeneration() != SettingsGeneration)
+		{
+			OnCompositeUpdate_Internal();
+		}
+	}
+
 	const UWorld* World = GetWorld();
 	const UComposite* WorldComposite = GetWorldComposite();
 
 	if (IsValid(World) && IsValid(CompositeWorldData) && IsValid(WorldComposite))
 	{
-		// Enforce new style output.
-		if (UMediaTexture* MediaTexture = Cast<UMediaTexture>(WorldComposite->GetMediaInputTexture()))
-		{
-			if (!MediaTexture->NewStyleOutput)
-			{
-				MediaTexture->NewStyleOutput = true;
-			}
-		}		
-		
+		const FResolvedCompositeSettings& Settings = WorldComposite->GetResolvedSettings();
+
 		const bool bSetFixedViewportSize = IsValid(World) && (World->WorldType == EWorldType::Game || World->WorldType == EWorldType::PIE) && CompositeWorldData->GetIsWorldCompositeEnabled();
-		UpdateCompositeViewportInfo(bSetFixedViewportSize);
+		{
+			FScopedDurationTimer Timer(LastTickTimings.UpdateCompositeViewportInfo);
+			UpdateCompositeViewportInfo(bSetFixedViewportSize);
+		}
 		
 #if WITH_EDITOR
 		if (!bIsModifyViewportClientViewRegistered && CompositeLevelEditorViewportClient)
@@ -363,68 +954,153 @@ void UCompositorSubsystem::Tick(float DeltaTime)
 
 #endif // WITH_EDITOR
 
+		{
+			FScopedDurationTimer Timer(LastTickTimings.UpdateMedia);
+			UpdateMediaFrameQueue();
+			UpdateMediaSampleCounter();
+		}
+
+		UCompositeKeyer* CompositeKeyer = Settings.MediaInputKeyer;
+		const bool bIsKeyerEnabled = IsValid(CompositeKeyer) && CompositeKeyer->GetIsKeyerEnabled();
+		const bool bProcessMediaOnRenderThread = CompositeWorldData->GetProcessMediaOnRenderThread() && CanRunMediaPrePass();
+		FusedMediaPrePassKeyer = GetFusedMediaPrePassKeyer(CompositeKeyer);
+		bPassThroughMedia = !bIsKeyerEnabled && CompositeWorldData->GetPassThroughMediaWithoutKeyer() && (bProcessMediaOnRenderThread || bUndistortMaterialHasKeyedTextureParameter);
+
 		// Update the media input related render target's size so it matches the media input texture size. 
+		{
+			FScopedDurationTimer Timer(LastTickTimings.UpdateRenderTargets);
 
-		const FIntPoint MediaTextureSize = GetMediaInputTextureSize();
+			const FIntPoint MediaTextureSize = GetMediaInputTextureSize();
+			const TOptional<ETextureRenderTargetFormat> MediaRenderTargetFormat = GetMediaRenderTargetFormat(bProcessMediaOnRenderThread);
 		
-		if (IsValid(MediaInputKeyedRenderTarget))
-		{
-			// Only update if the texture does not have the same size already.
-			if (MediaTextureSize.X != MediaInputKeyedRenderTarget->SizeX || MediaTextureSize.Y != MediaInputKeyedRenderTarget->SizeY)
+			// The render targets come from the pool, a media stream switching sizes or formats back and forth reuses the previous ones instead of reallocating.
+			// The render thread passes write them through unordered access views.
+			if (IsValid(MediaInputKeyedTextureAsset))
 			{
-				MediaInputKeyedRenderTarget->ResizeTarget(MediaTextureSize.X, MediaTextureSize.Y);
+				// Nothing draws into or reads from the keyed render target when the media skips it, so it does not need the memory.
+				const FIntPoint KeyedRenderTargetSize = bPassThroughMedia || FusedMediaPrePassKeyer.IsValid() ? FIntPoint(1, 1) : MediaTextureSize;
+
+				FCompositorRenderTargetDesc KeyedDesc = FCompositorRenderTargetDesc::FromTemplate(MediaInputKeyedTextureAsset, KeyedRenderTargetSize);
+				KeyedDesc.Format = MediaRenderTargetFormat.Get(KeyedDesc.Format);
+				KeyedDesc.bCanCreateUAV |= bProcessMediaOnRenderThread;
+				RenderTargetPool.Update(MediaInputKeyedRenderTarget, KeyedDesc);
+				BindMaterialTexture(MediaInputKeyedTextureAsset, MediaInputKeyedRenderTarget);
 			}
-		}
-		if (IsValid(MediaInputUndistortedTexture))
-		{
-			// Only update if the texture does not have the same size already.
-			if (MediaTextureSize.X != MediaInputUndistortedTexture->SizeX || MediaTextureSize.Y != MediaInputUndistortedTexture->SizeY)
+			if (IsValid(MediaInputUndistortedTextureAsset))
 			{
-				MediaInputUndistortedTexture->ResizeTarget(MediaTextureSize.X, MediaTextureSize.Y);
+				FCompositorRenderTargetDesc UndistortedDesc = FCompositorRenderTargetDesc::FromTemplate(MediaInputUndistortedTextureAsset, MediaTextureSize);
+				UndistortedDesc.Format = MediaRenderTargetFormat.Get(UndistortedDesc.Format);
+				UndistortedDesc.bCanCreateUAV |= bProcessMediaOnRenderThread;
+				RenderTargetPool.Update(MediaInputUndistortedTexture, UndistortedDesc);
+				BindMaterialTexture(MediaInputUndistortedTextureAsset, MediaInputUndistortedTexture);
 			}
 		}
 
 		if (CompositorMaterialParameterCollection)
 		{
-			UCompositeKeyer* CompositeKeyer = WorldComposite->GetMediaInputKeyer();
-			if (IsValid(CompositeKeyer) && CompositeKeyer->GetIsKeyerEnabled())
+			if (FusedMediaPrePassKeyer.IsValid())
+			{
+				// Keyed together with the undistortion in UpdateLensData, the keyed render target is not used.
+				MediaPrePassMode = ECompositeMediaPrePassMode::Fused;
+				MediaInputKeyedRenderTargetWriter = nullptr;
+				MPCDeltaWriter.SetScalarParameterValue(MPCParameters.IsKeyerEnabled, true);
+			}
+			else if (bIsKeyerEnabled)
+			{
+				// Someone else drew into the keyed render target since this keyer last did.
+				if (MediaInputKeyedRenderTargetWriter != CompositeKeyer)
+				{
+					CompositeKeyer->MarkCompositeKeyerDirty();
+					MediaInputKeyedRenderTargetWriter = CompositeKeyer;
+				}
+
+				if (UMaterialInstanceDynamic* CompositeKeyerMID = CompositeKeyer->GetCompositeKeyerMID())
+				{
+					CompositeKeyerMID->SetTextureParameterValue("Compositor_MediaInputTexture", GetActiveMediaTexture());
+				}
+				{
+					COMPOSITOR_SCOPE_CYCLE_COUNTER(STAT_CompositorUpdateCompositeKeyer);
+					FScopedDurationTimer Timer(LastTickTimings.UpdateCompositeKeyer);
+					CompositeKeyer->UpdateCompositeKeyer(this);
+				}
+				if (bProcessMediaOnRenderThread)
+				{
+					MediaPrePassMode = ECompositeMediaPrePassMode::Undistort;
+				}
+				MPCDeltaWriter.SetScalarParameterValue(MPCParameters.IsKeyerEnabled, true);
+			}
+			else if (bPassThroughMedia)
 			{
-				CompositeKeyer->UpdateCompositeKeyer(this);
-				CompositeKeyer->GetCompositeKeyerMID()->SetTextureParameterValue("Compositor_MediaInputTexture", GetActiveMediaTexture());
-				UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("IsKeyerEnabled"), true);
+				// The undistortion in UpdateLensData reads the media directly.
+				if (bProcessMediaOnRenderThread)
+				{
+					MediaPrePassMode = ECompositeMediaPrePassMode::PassThrough;
+				}
+				MediaInputKeyedRenderTargetWriter = nullptr;
+				MPCDeltaWriter.SetScalarParameterValue(MPCParameters.IsKeyerEnabled, false);
+			}
+			else if (bProcessMediaOnRenderThread)
+			{
+				// Copied into the keyed render target together with the undistortion in UpdateLensData.
+				MediaPrePassMode = ECompositeMediaPrePassMode::Fallback;
+				MediaInputKeyedRenderTargetWriter = nullptr;
+				MPCDeltaWriter.SetScalarParameterValue(MPCParameters.IsKeyerEnabled, false);
 			}
 			else
 			{
-				MediaInputCompositeKeyerDisabledFallbackMID->SetTextureParameterValue("Compositor_MediaInputTexture", GetActiveMediaTexture());
-				UKismetRenderingLibrary::DrawMaterialToRenderTarget(this, MediaInputKeyedRenderTarget, MediaInputCompositeKeyerDisabledFallbackMID);
-				UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("IsKeyerEnabled"), false);
+				UTexture* ActiveMediaTexture = GetActiveMediaTexture();
+				MediaInputCompositeKeyerDisabledFallbackMID->SetTextureParameterValue("Compositor_MediaInputTexture", ActiveMediaTexture);
+
+				// The fallback only has to draw again when there is a new media frame or the render target changed.
+				uint32 FallbackDrawHash = HashCombine(GetActiveMediaFrameHash(), PointerHash(ActiveMediaTexture));
+				if (IsValid(MediaInputKeyedRenderTarget))
+				{
+					FallbackDrawHash = HashCombine(FallbackDrawHash, PointerHash(MediaInputKeyedRenderTarget));
+					FallbackDrawHash = HashCombine(FallbackDrawHash, GetTypeHash(MediaInputKeyedRenderTarget->SizeX));
+					FallbackDrawHash = HashCombine(FallbackDrawHash, GetTypeHash(MediaInputKeyedRenderTarget->SizeY));
+				}
+
+				if (MediaInputKeyedRenderTargetWriter != MediaInputCompositeKeyerDisabledFallbackMID || FallbackDrawHash != LastFallbackDrawHash)
+				{
+					DrawMaterialToRenderTarget(MediaInputKeyedRenderTarget, MediaInputCompositeKeyerDisabledFallbackMID);
+					INC_DWORD_STAT(STAT_CompositorKeyerDraws);
+					NotifyMediaInputKeyedUpdated();
+					MediaInputKeyedRenderTargetWriter = MediaInputCompositeKeyerDisabledFallbackMID;
+					LastFallbackDrawHash = FallbackDrawHash;
+				}
+
+				MPCDeltaWriter.SetScalarParameterValue(MPCParameters.IsKeyerEnabled, false);
 			}
 			
-			UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, "DebugMediaOverlay", CompositeWorldData->GetDebugMediaOverlay());
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.DebugMediaOverlay, CompositeWorldData->GetDebugMediaOverlay());
 
 			const bool bUseDebugEditorCamera = CompositeWorldData->IsAllowedToUseDebugEditorCamera();
-			UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, "MediaProjectionBlendAmount", bUseDebugEditorCamera);
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.MediaProjectionBlendAmount, bUseDebugEditorCamera);
 			if (bUseDebugEditorCamera) // This bool already checked if the camera actors is valid.
 			{
 				const UCameraComponent* DebugCameraComponent = CompositeWorldData->GetDebugEditorCamera()->GetCameraComponent();
-				UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, "MediaProjectionFoV", DebugCameraComponent->FieldOfView);
-				UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection,
-					"MediaProjectionCameraPosition",
-					FLinearColor(DebugCameraComponent->GetComponentLocation()));
-				UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection,
-					"MediaProjectionCameraForward",
-					FLinearColor(DebugCameraComponent->GetForwardVector()));
-				UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection,
-					"MediaProjectionCameraRight",
-					FLinearColor(DebugCameraComponent->GetRightVector()));
-				UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection,
-					"MediaProjectionCameraUp",
-					FLinearColor(DebugCameraComponent->GetUpVector()));
+				MPCDeltaWriter.SetScalarParameterValue(MPCParameters.MediaProjectionFoV, DebugCameraComponent->FieldOfView);
+				MPCDeltaWriter.SetVectorParameterValue(MPCParameters.MediaProjectionCameraPosition, FLinearColor(DebugCameraComponent->GetComponentLocation()));
+				MPCDeltaWriter.SetVectorParameterValue(MPCParameters.MediaProjectionCameraForward, FLinearColor(DebugCameraComponent->GetForwardVector()));
+				MPCDeltaWriter.SetVectorParameterValue(MPCParameters.MediaProjectionCameraRight, FLinearColor(DebugCameraComponent->GetRightVector()));
+				MPCDeltaWriter.SetVectorParameterValue(MPCParameters.MediaProjectionCameraUp, FLinearColor(DebugCameraComponent->GetUpVector()));
 			}
 		}
 	}
 
-	UpdateLensData();
+	{
+		FScopedDurationTimer Timer(LastTickTimings.UpdateLensData);
+		UpdateLensData();
+	}
+
+	{
+		FScopedDurationTimer Timer(LastTickTimings.Flush);
+		MPCDeltaWriter.Flush();
+	}
+
+	// Captures tick before the subsystem, their bindings are in. Sent before the pool frees anything they might still point at.
+	FlushMaterialTextureBindings();
+	RenderTargetPool.Tick();
 }
 
 // Make sure the tick function is only called for the subsystem
@@ -453,8 +1129,10 @@ ETickableTickType UCompositorSubsystem::GetTickableTickType() const
 	return HasAnyFlags(RF_ClassDefaultObject) || !GetWorld() || GetWorld()->IsNetMode(NM_DedicatedServer) ? ETickableTickType::Never : ETickableTickType::Conditional;
 }
 
-void UCompositorSubsystem::OnCompositeUpdate_Internal()
+void UCompositorSubsystem::OnCompositeUpdate_Internal(ECompositeUpdateFlags UpdateFlags)
 {
+	COMPOSITOR_SCOPE_CYCLE_COUNTER(STAT_CompositorCompositeUpdate);
+
 	UComposite* WorldComposite = GetWorldComposite();
 	
 	if (!IsValid(WorldComposite))
@@ -463,67 +1141,98 @@ void UCompositorSubsystem::OnCompositeUpdate_Internal()
 		return;
 	}
 	
-	for (TScriptInterface<ICompositeUpdateInterface> CompositeUpdateInterface : CompositeUpdateInterfaceArray)
+	// A color grade edit on a set with many composite meshes touches none of them.
+	const TArrayView<ACompositeMesh* const> CompositeMeshes = CompositeUpdateRegistry.GetCompositeMeshes();
+	if (EnumHasAnyFlags(ACompositeMesh::CompositeUpdateSubscription, UpdateFlags))
+	{
+		for (ACompositeMesh* CompositeMesh : CompositeMeshes)
+		{
+			if (IsValid(CompositeMesh))
+			{
+				CompositeMesh->OnCompositeUpdate(*WorldComposite, UpdateFlags);
+			}
+		}
+		INC_DWORD_STAT_BY(STAT_CompositorCompositeUpdateListeners, CompositeMeshes.Num());
+	}
+	else
+	{
+		INC_DWORD_STAT_BY(STAT_CompositorCompositeUpdateListenersSkipped, CompositeMeshes.Num());
+	}
+
+	for (const TScriptInterface<ICompositeUpdateInterface>& CompositeUpdateInterface : CompositeUpdateRegistry.GetInterfaces())
 	{
-		CompositeUpdateInterface->OnCompositeUpdate(*WorldComposite);
+		if (!IsValid(CompositeUpdateInterface.GetObject()) || !EnumHasAnyFlags(CompositeUpdateInterface->GetCompositeUpdateSubscription(), UpdateFlags))
+		{
+			INC_DWORD_STAT(STAT_CompositorCompositeUpdateListenersSkipped);
+			continue;
+		}
+
+		CompositeUpdateInterface->OnCompositeUpdate(*WorldComposite, UpdateFlags);
+		INC_DWORD_STAT(STAT_CompositorCompositeUpdateListeners);
 	}
 }
 
 void UCompositorSubsystem::ComputeCompositePostProcess(FVector ViewLocation, FSceneView* SceneView)
 {
+	COMPOSITOR_SCOPE_CYCLE_COUNTER(STAT_CompositorComputeCompositePostProcess);
+
 	const UComposite* WorldComposite = GetWorldComposite();
 	
 	if (IsValid(CompositeWorldData) && IsValid(WorldComposite) && CompositorMaterialParameterCollection)
 	{
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("EnableSoftMask"), WorldComposite->GetEnableSoftMask());		
-		const float ShadowsOffset = WorldComposite->GetShadowsOffset();
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("ShadowsBlackLevel"), WorldComposite->GetShadowsBlackLevel() + ShadowsOffset);
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("ShadowsWhiteLevel"), WorldComposite->GetShadowsWhiteLevel() + ShadowsOffset);
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("ShadowsGamma"), WorldComposite->GetShadowsGamma());
-		UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ShadowsTint"), WorldComposite->GetShadowsTint());
-
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("EnablePlanarReflection"), WorldComposite->GetEnablePlanarReflection());
-		UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("PlanarReflectionColor"), WorldComposite->GetPlanarReflectionColor());
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("PlanarReflectionDistortionIntensity"), WorldComposite->GetPlanarReflectionDistortionIntensity());
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("PlanarReflectionDistortionOffset"), WorldComposite->GetPlanarReflectionDistortionOffset());
-
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("MediaBlendNone"), WorldComposite->GetMediaBlend() == EMediaBlend::None ? 1.F : 0.F);
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("MediaBlendPreToneCurve"), WorldComposite->GetMediaBlend() == EMediaBlend::PreToneCurve ? 1.F : 0.F);
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("BrightnessMaskGamma"), WorldComposite->GetBrightnessMaskGamma());
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("ApplyInverseToneCurve"), WorldComposite->GetApplyInverseToneCurve() ? 1.F : 0.F);
-
-		const EOutputAlpha OutputAlpha = WorldComposite->GetOutputAlpha();
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("OutputAlphaInvertedOpacity"), OutputAlpha == EOutputAlpha::InvertedOpacity ? 1.F : 0.F);
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("OutputAlphaWhite"), OutputAlpha == EOutputAlpha::White ? 1.F : 0.F);
+		// Called for every view, so read the flattened settings instead of walking the Composite chain per parameter.
+		const FResolvedCompositeSettings& Settings = WorldComposite->GetResolvedSettings();
+
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.EnableSoftMask, Settings.bEnableSoftMask);		
+		const float ShadowsOffset = Settings.ShadowsOffset;
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.ShadowsBlackLevel, Settings.ShadowsBlackLevel + ShadowsOffset);
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.ShadowsWhiteLevel, Settings.ShadowsWhiteLevel + ShadowsOffset);
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.ShadowsGamma, Settings.ShadowsGamma);
+		MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ShadowsTint, Settings.ShadowsTint);
+
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.EnablePlanarReflection, Settings.bEnablePlanarReflection);
+		MPCDeltaWriter.SetVectorParameterValue(MPCParameters.PlanarReflectionColor, Settings.PlanarReflectionColor);
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.PlanarReflectionDistortionIntensity, Settings.PlanarReflectionDistortionIntensity);
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.PlanarReflectionDistortionOffset, Settings.PlanarReflectionDistortionOffset);
+
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.MediaBlendNone, Settings.MediaBlend == EMediaBlend::None ? 1.F : 0.F);
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.MediaBlendPreToneCurve, Settings.MediaBlend == EMediaBlend::PreToneCurve ? 1.F : 0.F);
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.BrightnessMaskGamma, Settings.BrightnessMaskGamma);
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.ApplyInverseToneCurve, Settings.bApplyInverseToneCurve ? 1.F : 0.F);
+
+		const EOutputAlpha OutputAlpha = Settings.OutputAlpha;
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.OutputAlphaInvertedOpacity, OutputAlpha == EOutputAlpha::InvertedOpacity ? 1.F : 0.F);
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.OutputAlphaWhite, OutputAlpha == EOutputAlpha::White ? 1.F : 0.F);
 
 		const bool bOutputAlphaOverride = (OutputAlpha == EOutputAlpha::White || OutputAlpha == EOutputAlpha::Black) && !CompositeWorldData->GetDebugVisualizeCompositeMeshes() && !CompositeWorldData->GetDebugVisualizeShadows();
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("OutputAlphaOverride"), bOutputAlphaOverride ? 1.F : 0.F);
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.OutputAlphaOverride, bOutputAlphaOverride ? 1.F : 0.F);
 
-		UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("OutputRgbEncodingSrgb"), WorldComposite->GetOutputRgbEncoding() == EOutputRgbEncoding::Srgb ? 1.F : 0.F);
+		MPCDeltaWriter.SetScalarParameterValue(MPCParameters.OutputRgbEncodingSrgb, Settings.OutputRgbEncoding == EOutputRgbEncoding::Srgb ? 1.F : 0.F);
 
-		UCompositeColorGrade* CompositeColorGrade = WorldComposite->GetCompositeColorGrade();
-		if (CompositeColorGrade)
+		if (WorldComposite->GetCompositeColorGrade())
 		{
-			const FColorGradePerRangeSettings ColorGradeScene = CompositeColorGrade->GetColorGradeScene();
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeSceneSaturation"), FLinearColor(ColorGradeScene.Saturation));
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeSceneContrast"), FLinearColor(ColorGradeScene.Contrast));
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeSceneGamma"), FLinearColor(ColorGradeScene.Gamma));
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeSceneGain"), FLinearColor(ColorGradeScene.Gain));
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeSceneOffset"), FLinearColor(ColorGradeScene.Offset));
+			const FColorGradePerRangeSettings& ColorGradeScene = Settings.ColorGradeScene;
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeSaturation[0], FLinearColor(ColorGradeScene.Saturation));
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeContrast[0], FLinearColor(ColorGradeScene.Contrast));
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeGamma[0], FLinearColor(ColorGradeScene.Gamma));
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeGain[0], FLinearColor(ColorGradeScene.Gain));
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeOffset[0], FLinearColor(ColorGradeScene.Offset));
 			
-			const FColorGradePerRangeSettings ColorGradeMedia = CompositeColorGrade->GetColorGradeMedia();
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeMediaSaturation"), FLinearColor(ColorGradeMedia.Saturation));
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeMediaContrast"), FLinearColor(ColorGradeMedia.Contrast));
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeMediaGamma"), FLinearColor(ColorGradeMedia.Gamma));
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeMediaGain"), FLinearColor(ColorGradeMedia.Gain));
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeMediaOffset"), FLinearColor(ColorGradeMedia.Offset));
+			// The fused media pre pass already graded the media.
+			static const FColorGradePerRangeSettings NeutralColorGrade;
+			const FColorGradePerRangeSettings& ColorGradeMedia = FusedMediaPrePassKeyer.IsValid() ? NeutralColorGrade : Settings.ColorGradeMedia;
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeSaturation[1], FLinearColor(ColorGradeMedia.Saturation));
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeContrast[1], FLinearColor(ColorGradeMedia.Contrast));
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeGamma[1], FLinearColor(ColorGradeMedia.Gamma));
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeGain[1], FLinearColor(ColorGradeMedia.Gain));
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeOffset[1], FLinearColor(ColorGradeMedia.Offset));
 			
-			const FColorGradePerRangeSettings ColorGradeCombined = CompositeColorGrade->GetColorGradeCombined();
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeCombinedSaturation"), FLinearColor(ColorGradeCombined.Saturation));
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeCombinedContrast"), FLinearColor(ColorGradeCombined.Contrast));
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeCombinedGamma"), FLinearColor(ColorGradeCombined.Gamma));
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeCombinedGain"), FLinearColor(ColorGradeCombined.Gain));
-			UKismetMaterialLibrary::SetVectorParameterValue(this, CompositorMaterialParameterCollection, FName("ColorGradeCombinedOffset"), FLinearColor(ColorGradeCombined.Offset));
+			const FColorGradePerRangeSettings& ColorGradeCombined = Settings.ColorGradeCombined;
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeSaturation[2], FLinearColor(ColorGradeCombined.Saturation));
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeContrast[2], FLinearColor(ColorGradeCombined.Contrast));
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeGamma[2], FLinearColor(ColorGradeCombined.Gamma));
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeGain[2], FLinearColor(ColorGradeCombined.Gain));
+			MPCDeltaWriter.SetVectorParameterValue(MPCParameters.ColorGradeOffset[2], FLinearColor(ColorGradeCombined.Offset));
 		}				
 	}
 
@@ -539,8 +1248,8 @@ void UCompositorSubsystem::ComputeCompositePostProcess(FVector ViewLocation, FSc
 
 		if (CompositorMaterialParameterCollection)
 		{
-			UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("OutputAlphaInRgb"), CompositeWorldData->GetDebugVisualizeAlphaInRgb());
-			UKismetMaterialLibrary::SetScalarParameterValue(this, CompositorMaterialParameterCollection, FName("DebugVisualizeCompositeMeshes"), CompositeWorldData->GetDebugVisualizeCompositeMeshes());
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.OutputAlphaInRgb, CompositeWorldData->GetDebugVisualizeAlphaInRgb());
+			MPCDeltaWriter.SetScalarParameterValue(MPCParameters.DebugVisualizeCompositeMeshes, CompositeWorldData->GetDebugVisualizeCompositeMeshes());
 		}
 	}
 
@@ -553,12 +1262,16 @@ void UCompositorSubsystem::ComputeCompositePostProcess(FVector ViewLocation, FSc
 	}
 
 	CompositePostProcessVolume.SetIsEnabled(bIsEnabled);
+
+	MPCDeltaWriter.Flush();
 }
 
 void UCompositorSubsystem::ClearReflectionCaptureRenderTarget()
 {
 	if (PlanarReflectionTexture)
 	{
+		// Materials read the asset itself again until a planar reflection capture binds its render target.
+		BindMaterialTexture(PlanarReflectionTexture, nullptr);
 		UKismetRenderingLibrary::ClearRenderTarget2D(this, PlanarReflectionTexture);
 	}
 }
@@ -640,7 +1353,8 @@ void UCompositorSubsystem::RemoveCompositeWorldData()
 
 bool UCompositorSubsystem::IsMediaTextureValid() const
 {
-	return IsValid(GetWorldComposite()) && IsValid(GetWorldComposite()->GetMediaInputTexture());
+	const UComposite* WorldComposite = GetWorldComposite();
+	return IsValid(WorldComposite) && IsValid(WorldComposite->GetResolvedSettings().MediaInputTexture);
 }
 
 USoftMaskCaptureComponent* UCompositorSubsystem::GetSoftMaskCaptureComponent() const
@@ -655,6 +1369,8 @@ USoftMaskCaptureComponent* UCompositorSubsystem::GetSoftMaskCaptureComponent() c
 
 void UCompositorSubsystem::UpdateCompositeViewportInfo(bool bSetFixedSize)
 {
+	COMPOSITOR_SCOPE_CYCLE_COUNTER(STAT_CompositorUpdateCompositeViewportInfo);
+
 // 	// OLD STUFF
 //
 // 	// It is important to check the active world first, even in editor, just so play mode works as expected.
@@ -724,27 +1440,38 @@ void UCompositorSubsystem::UpdateCompositeViewportInfo(bool bSetFixedSize)
 	}
 #endif
 
-	if (SceneViewport.IsValid())
+	// Packaged and standalone games render the world into the game viewport.
+	FSceneViewport* ActiveSceneViewport = SceneViewport.Get();
+	if (!ActiveSceneViewport)
+	{
+		const UWorld* World = GetWorld();
+		if (UGameViewportClient* GameViewportClient = World ? World->GetGameViewport() : nullptr)
+		{
+			ActiveSceneViewport = GameViewportClient->GetGameViewport();
+		}
+	}
+
+	if (ActiveSceneViewport)
 	{
 		const FIntPoint MediaInputTextureSize = GetMediaInputTextureSize();		
 		if (bSetFixedSize && IsMediaTextureSizeValid() && GetCompositeWorldData() && GetCompositeWorldData()->GetMatchViewportResolutionWithMediaInput())
 		{	
-			if (MediaInputTextureSize != SceneViewport->GetRenderTargetTextureSizeXY())
+			if (MediaInputTextureSize != ActiveSceneViewport->GetRenderTargetTextureSizeXY())
 			{
-				SceneViewport->SetFixedViewportSize(MediaInputTextureSize.X, MediaInputTextureSize.Y);
+				ActiveSceneViewport->SetFixedViewportSize(MediaInputTextureSize.X, MediaInputTextureSize.Y);
 			}
 		}
 		else // If viewport should not be fixed.
 		{
 			// If the viewport currently has a fixed size.
-			if (SceneViewport->HasFixedSize())
+			if (ActiveSceneViewport->HasFixedSize())
 			{
-				SceneViewport->SetFixedViewportSize(0,0);
+				ActiveSceneViewport->SetFixedViewportSize(0,0);
 			}
 		}
 	}
 	
-	CompositeViewport = SceneViewport.Get();
+	CompositeViewport = ActiveSceneViewport;
 
 	
 // 	// It is important to check the active world first, even in editor, just so play mode works as expected.
@@ -841,7 +1568,7 @@ UTexture* UCompositorSubsystem::GetActiveMediaTexture() const
 	{
 		if (const UComposite* WorldComposite = CompositeWorldData->GetWorldComposite())
 		{
-			if (UTexture* MediaTexture = WorldComposite->GetMediaInputTexture())
+			if (UTexture* MediaTexture = WorldComposite->GetResolvedSettings().MediaInputTexture)
 			{
 				return MediaTexture;
 			}
@@ -850,6 +1577,40 @@ UTexture* UCompositorSubsystem::GetActiveMediaTexture() const
 	return MediaInputDefaultFallbackTexture;
 }
 
+uint32 UCompositorSubsystem::GetActiveMediaFrameHash() const
+{
+	UTexture* MediaTexture = GetActiveMediaTexture();
+
+	// The queue decides which sample is shown, not the media player time.
+	if (const TSharedPtr<IMediaTextureSample, ESPMode::ThreadSafe> QueuedMediaSample = GetQueuedMediaSample())
+	{
+		return PointerHash(QueuedMediaSample.Get());
+	}
+
+	if (const UMediaTexture* ActiveMediaTexture = Cast<UMediaTexture>(MediaTexture))
+	{
+		// Every delivered sample is a new frame, whatever the player clock says.
+		const uint32 NumSamples = MediaSampleCounter.IsValid() && MediaSampleCounterPlayer.Get() == ActiveMediaTexture->GetMediaPlayer() ? MediaSampleCounter->GetNumSamples() : 0;
+		if (NumSamples > 0)
+		{
+			return HashCombine(PointerHash(MediaTexture), GetTypeHash(NumSamples));
+		}
+
+		// Until the player feeds the sample sinks there is no way to tell frames apart.
+		if (ActiveMediaTexture->GetMediaPlayer())
+		{
+			return HashCombine(PointerHash(MediaTexture), GetTypeHash(GFrameCounter));
+		}
+	}
+	else if (Cast<UTextureRenderTarget>(MediaTexture))
+	{
+		// Render targets can be drawn into at any time without us knowing.
+		return GetTypeHash(GFrameCounter);
+	}
+
+	return PointerHash(MediaTexture);
+}
+
 UComposite* UCompositorSubsystem::GetWorldComposite() const
 {
 	if (IsValid(CompositeWorldData))
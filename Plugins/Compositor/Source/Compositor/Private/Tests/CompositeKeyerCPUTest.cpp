@@ -0,0 +1,355 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Objects/CompositeKeyerCPU.h"
+#include "CompositeMediaPrePass.h"
+
+#include "Engine/Engine.h"
+#include "Engine/Texture2D.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Kismet/KismetRenderingLibrary.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RenderingThread.h"
+#include "TextureResource.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace CompositeKeyerCPUTest
+{
+	/**
+	 * Largest difference allowed between the CPU keyer, the media pre pass and the keyer material.
+	 * All run in 32 bit float, the margin covers the different order of operations and fused multiply adds on the GPU.
+	 */
+	constexpr float MaterialTolerance = 2.E-3F;
+
+	/** Largest difference allowed between the vectorized kernels and the scalar reference. */
+	constexpr float KernelTolerance = 1.E-5F;
+
+	const TCHAR* KeyerMaterialPath = TEXT("/Compositor/CompositeKeyer/UnrealColorDifference/M_CompositeKeyer_UnrealColorDifference.M_CompositeKeyer_UnrealColorDifference");
+
+	/** Cleared to a value no key produces, the keyer material discards the pixels below its opacity mask clip value. */
+	const FLinearColor Discarded(-1.F, -1.F, -1.F, -1.F);
+
+	/** Settings covering the default green screen, every parameter moved off its default, and a blue screen. */
+	TArray<FCompositeKeyerCPUSettings> MakeSettings()
+	{
+		TArray<FCompositeKeyerCPUSettings> AllSettings;
+
+		AllSettings.Add(FCompositeKeyerCPUSettings());
+
+		FCompositeKeyerCPUSettings Tuned;
+		Tuned.KeyColor = FLinearColor(0.12F, 0.68F, 0.18F, 1.F);
+		Tuned.RedWeight = 0.7F;
+		Tuned.BlueWeight = 0.3F;
+		Tuned.AlphaThreshold = 0.05F;
+		Tuned.AlphaOffset = 0.1F;
+		Tuned.ClipBlack = 0.1F;
+		Tuned.ClipWhite = 0.9F;
+		AllSettings.Add(Tuned);
+
+		FCompositeKeyerCPUSettings BlueScreen;
+		BlueScreen.KeyColor = FLinearColor(0.05F, 0.2F, 0.75F, 1.F);
+		AllSettings.Add(BlueScreen);
+
+		return AllSettings;
+	}
+
+	/** Fixed media pixels: screens, subjects, spill and the edges in between. */
+	TArray<FLinearColor> MakePixels()
+	{
+		const FLinearColor GreenScreen(0.1F, 0.7F, 0.15F, 1.F);
+		const FLinearColor BlueScreen(0.06F, 0.18F, 0.72F, 1.F);
+		const FLinearColor Gray(0.4F, 0.45F, 0.4F, 1.F);
+		const FLinearColor Skin(0.6F, 0.4F, 0.3F, 1.F);
+
+		TArray<FLinearColor> Pixels;
+		Pixels.Add(GreenScreen);
+		Pixels.Add(BlueScreen);
+		Pixels.Add(Gray);
+		Pixels.Add(Skin);
+		Pixels.Add(FLinearColor(0.4F, 0.55F, 0.35F, 1.F));
+		Pixels.Add(FLinearColor(0.02F, 0.02F, 0.02F, 1.F));
+		Pixels.Add(FLinearColor(0.95F, 0.95F, 0.95F, 1.F));
+		for (const float Blend : { 0.25F, 0.5F, 0.75F })
+		{
+			Pixels.Add(FMath::Lerp(GreenScreen, Gray, Blend));
+			Pixels.Add(FMath::Lerp(GreenScreen, Skin, Blend));
+			Pixels.Add(FMath::Lerp(BlueScreen, Skin, Blend));
+		}
+		return Pixels;
+	}
+
+	bool IsNearlyEqual(const FLinearColor& A, const FLinearColor& B, float Tolerance)
+	{
+		return FMath::Abs(A.R - B.R) <= Tolerance && FMath::Abs(A.G - B.G) <= Tolerance && FMath::Abs(A.B - B.B) <= Tolerance && FMath::Abs(A.A - B.A) <= Tolerance;
+	}
+
+	/** Any world can draw the material, the test only needs its scene for the feature level. */
+	UWorld* FindWorld()
+	{
+		for (const FWorldContext& WorldContext : GEngine->GetWorldContexts())
+		{
+			if (UWorld* World = WorldContext.World())
+			{
+				return World;
+			}
+		}
+		return nullptr;
+	}
+
+	UTexture2D* MakeMediaTexture(const TArray<FLinearColor>& Pixels)
+	{
+		UTexture2D* Texture = UTexture2D::CreateTransient(Pixels.Num(), 1, PF_A32B32G32R32F);
+		Texture->SRGB = false;
+		Texture->Filter = TF_Nearest;
+
+		FTexture2DMipMap& Mip = Texture->GetPlatformData()->Mips[0];
+		void* Data = Mip.BulkData.Lock(LOCK_READ_WRITE);
+		FMemory::Memcpy(Data, Pixels.GetData(), Pixels.Num() * sizeof(FLinearColor));
+		Mip.BulkData.Unlock();
+
+		Texture->UpdateResource();
+		return Texture;
+	}
+
+	UTextureRenderTarget2D* MakeRenderTarget(int32 Width)
+	{
+		UTextureRenderTarget2D* RenderTarget = NewObject<UTextureRenderTarget2D>(GetTransientPackage(), NAME_None, RF_Transient);
+		RenderTarget->RenderTargetFormat = RTF_RGBA32f;
+		RenderTarget->ClearColor = Discarded;
+		RenderTarget->bCanCreateUAV = true;
+		RenderTarget->InitAutoFormat(Width, 1);
+		RenderTarget->UpdateResourceImmediate(true);
+		return RenderTarget;
+	}
+
+	TArray<FLinearColor> ReadPixels(UTextureRenderTarget2D* RenderTarget)
+	{
+		FlushRenderingCommands();
+
+		TArray<FLinearColor> Pixels;
+		RenderTarget->GameThread_GetRenderTargetResource()->ReadLinearColorPixels(Pixels);
+		return Pixels;
+	}
+
+	/** A keyer material instance reading the media texture, waiting for the material to finish compiling. */
+	UMaterialInstanceDynamic* MakeKeyerMID(UWorld* World, UMaterialInterface* KeyerMaterial, UTexture* MediaTexture)
+	{
+		if (FMaterialResource* MaterialResource = KeyerMaterial->GetMaterialResource(World->GetFeatureLevel()))
+		{
+			MaterialResource->FinishCompilation();
+		}
+
+		UMaterialInstanceDynamic* MID = UMaterialInstanceDynamic::Create(KeyerMaterial, GetTransientPackage());
+		MID->SetTextureParameterValue(TEXT("Compositor_MediaInputTexture"), MediaTexture);
+		// The soft mask is not part of the key.
+		MID->SetScalarParameterValue(TEXT("UseSoftMaskAsGarbageMask"), 0.F);
+		return MID;
+	}
+
+	TArray<FLinearColor> DrawKeyerMaterial(UWorld* World, UMaterialInstanceDynamic* MID, const FCompositeKeyerCPUSettings& Settings, UTextureRenderTarget2D* RenderTarget)
+	{
+		MID->SetVectorParameterValue(TEXT("KeyColor"), Settings.KeyColor);
+		MID->SetScalarParameterValue(TEXT("RedWeight"), Settings.RedWeight);
+		MID->SetScalarParameterValue(TEXT("BlueWeight"), Settings.BlueWeight);
+		MID->SetScalarParameterValue(TEXT("AlphaThreshold"), Settings.AlphaThreshold);
+		MID->SetScalarParameterValue(TEXT("AlphaOffset"), Settings.AlphaOffset);
+		MID->SetScalarParameterValue(TEXT("ClipBlack"), Settings.ClipBlack);
+		MID->SetScalarParameterValue(TEXT("ClipWhite"), Settings.ClipWhite);
+
+		UKismetRenderingLibrary::ClearRenderTarget2D(World, RenderTarget, Discarded);
+		UKismetRenderingLibrary::DrawMaterialToRenderTarget(World, RenderTarget, MID);
+		return ReadPixels(RenderTarget);
+	}
+
+	/** Keys the media texture with the fused media pre pass, without undistortion and grade. */
+	TArray<FLinearColor> RunMediaPrePass(UTexture* MediaTexture, const FCompositeKeyerCPUSettings& Settings, UTextureRenderTarget2D* RenderTarget)
+	{
+		FTextureResource* MediaResource = MediaTexture->GetResource();
+		FTextureRenderTargetResource* OutputResource = RenderTarget->GameThread_GetRenderTargetResource();
+		const FCompositeKeyerCPU::FConstants KeyerConstants = FCompositeKeyerCPU(Settings).GetConstants();
+
+		ENQUEUE_RENDER_COMMAND(CompositeKeyerTestMediaPrePass)([MediaResource, OutputResource, KeyerConstants](FRHICommandListImmediate& RHICmdList)
+		{
+			FRDGBuilder GraphBuilder(RHICmdList);
+
+			FCompositeMediaPrePassInputs Inputs;
+			Inputs.MediaTexture = RegisterExternalTexture(GraphBuilder, MediaResource->TextureRHI, TEXT("CompositeKeyerTest.Media"));
+			Inputs.OutputTexture = RegisterExternalTexture(GraphBuilder, OutputResource->GetRenderTargetTexture(), TEXT("CompositeKeyerTest.Output"));
+			Inputs.KeyChannel = KeyerConstants.KeyChannel;
+			Inputs.Weight1 = KeyerConstants.Weight1;
+			Inputs.Weight2 = KeyerConstants.Weight2;
+			Inputs.InvKeyDifference = KeyerConstants.InvKeyDifference;
+			Inputs.AlphaThreshold = KeyerConstants.AlphaThreshold;
+			Inputs.AlphaOffset = KeyerConstants.AlphaOffset;
+			Inputs.ClipBlack = KeyerConstants.ClipBlack;
+			Inputs.InvClipRange = KeyerConstants.InvClipRange;
+			AddCompositeMediaPrePass(GraphBuilder, Inputs);
+
+			GraphBuilder.Execute();
+		});
+
+		return ReadPixels(RenderTarget);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCompositeKeyerCPUKernelTest, "Plugins.Compositor.KeyerCPU.Kernels", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCompositeKeyerCPUKernelTest::RunTest(const FString& Parameters)
+{
+	using namespace CompositeKeyerCPUTest;
+
+	// Odd width so the scalar tail after the vectorized loop is covered as well.
+	const FIntPoint Size(67, 3);
+	const int32 NumPixels = Size.X * Size.Y;
+
+	FRandomStream RandomStream(NumPixels);
+	TArray<FColor> ColorFrame;
+	TArray<FLinearColor> LinearFrame;
+	ColorFrame.SetNumUninitialized(NumPixels);
+	LinearFrame.SetNumUninitialized(NumPixels);
+	for (int32 Index = 0; Index < NumPixels; ++Index)
+	{
+		ColorFrame[Index] = FColor(RandomStream.RandRange(0, 255), RandomStream.RandRange(0, 255), RandomStream.RandRange(0, 255), 255);
+		LinearFrame[Index] = FLinearColor(ColorFrame[Index]);
+	}
+
+	TArray<FLinearColor> KeyedFrame;
+	KeyedFrame.SetNumUninitialized(NumPixels);
+
+	for (const FCompositeKeyerCPUSettings& Settings : MakeSettings())
+	{
+		const FCompositeKeyerCPU Keyer(Settings);
+
+		int32 NumMismatches = 0;
+		Keyer.Key(LinearFrame.GetData(), KeyedFrame.GetData(), Size);
+		for (int32 Index = 0; Index < NumPixels; ++Index)
+		{
+			NumMismatches += IsNearlyEqual(KeyedFrame[Index], FCompositeKeyerCPU::KeyPixel(Settings, LinearFrame[Index]), KernelTolerance) ? 0 : 1;
+		}
+		TestEqual(FString::Printf(TEXT("Float kernel matches the scalar reference for key color %s"), *Settings.KeyColor.ToString()), NumMismatches, 0);
+
+		NumMismatches = 0;
+		Keyer.Key(ColorFrame.GetData(), KeyedFrame.GetData(), Size);
+		for (int32 Index = 0; Index < NumPixels; ++Index)
+		{
+			NumMismatches += IsNearlyEqual(KeyedFrame[Index], FCompositeKeyerCPU::KeyPixel(Settings, LinearFrame[Index]), KernelTolerance) ? 0 : 1;
+		}
+		TestEqual(FString::Printf(TEXT("8 bit kernel matches the scalar reference for key color %s"), *Settings.KeyColor.ToString()), NumMismatches, 0);
+	}
+
+	// The screen keys out and keeps no spill, a neutral subject stays opaque and unchanged.
+	const FCompositeKeyerCPUSettings Defaults;
+	const FLinearColor Screen = FCompositeKeyerCPU::KeyPixel(Defaults, Defaults.KeyColor);
+	TestEqual(TEXT("Screen alpha"), Screen.A, 0.F, KernelTolerance);
+	TestEqual(TEXT("Screen despilled"), Screen.G, 0.F, KernelTolerance);
+	const FLinearColor Gray = FCompositeKeyerCPU::KeyPixel(Defaults, FLinearColor(0.5F, 0.5F, 0.5F, 1.F));
+	TestEqual(TEXT("Gray alpha"), Gray.A, 1.F, KernelTolerance);
+	TestEqual(TEXT("Gray color"), Gray.G, 0.5F, KernelTolerance);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCompositeKeyerCPUMaterialTest, "Plugins.Compositor.KeyerCPU.MatchesMaterial", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCompositeKeyerCPUMaterialTest::RunTest(const FString& Parameters)
+{
+	using namespace CompositeKeyerCPUTest;
+
+	UWorld* World = FindWorld();
+	UMaterialInterface* KeyerMaterial = LoadObject<UMaterialInterface>(nullptr, KeyerMaterialPath);
+	if (!TestNotNull(TEXT("World"), World) || !TestNotNull(TEXT("Keyer material"), KeyerMaterial))
+	{
+		return false;
+	}
+
+	const TArray<FLinearColor> Pixels = MakePixels();
+	UTexture2D* MediaTexture = MakeMediaTexture(Pixels);
+	UTextureRenderTarget2D* RenderTarget = MakeRenderTarget(Pixels.Num());
+	UMaterialInstanceDynamic* MID = MakeKeyerMID(World, KeyerMaterial, MediaTexture);
+
+	const float OpacityMaskClipValue = KeyerMaterial->GetOpacityMaskClipValue();
+
+	for (const FCompositeKeyerCPUSettings& Settings : MakeSettings())
+	{
+		const TArray<FLinearColor> MaterialPixels = DrawKeyerMaterial(World, MID, Settings, RenderTarget);
+		if (!TestEqual(TEXT("Read back pixels"), MaterialPixels.Num(), Pixels.Num()))
+		{
+			return false;
+		}
+
+		for (int32 Index = 0; Index < Pixels.Num(); ++Index)
+		{
+			const FLinearColor Expected = FCompositeKeyerCPU::KeyPixel(Settings, Pixels[Index]);
+			const FLinearColor& Actual = MaterialPixels[Index];
+			const FString What = FString::Printf(TEXT("Key color %s, pixel %s"), *Settings.KeyColor.ToString(), *Pixels[Index].ToString());
+
+			if (Actual == Discarded)
+			{
+				TestTrue(What + TEXT(": only transparent pixels are discarded"), Expected.A < OpacityMaskClipValue + MaterialTolerance);
+			}
+			else
+			{
+				TestTrue(What + FString::Printf(TEXT(": CPU %s matches material %s"), *Expected.ToString(), *Actual.ToString()), IsNearlyEqual(Expected, Actual, MaterialTolerance));
+			}
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCompositeMediaPrePassMaterialTest, "Plugins.Compositor.MediaPrePass.MatchesMaterial", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCompositeMediaPrePassMaterialTest::RunTest(const FString& Parameters)
+{
+	using namespace CompositeKeyerCPUTest;
+
+	UWorld* World = FindWorld();
+	UMaterialInterface* KeyerMaterial = LoadObject<UMaterialInterface>(nullptr, KeyerMaterialPath);
+	if (!TestNotNull(TEXT("World"), World) || !TestNotNull(TEXT("Keyer material"), KeyerMaterial))
+	{
+		return false;
+	}
+
+	const TArray<FLinearColor> Pixels = MakePixels();
+	UTexture2D* MediaTexture = MakeMediaTexture(Pixels);
+	UTextureRenderTarget2D* MaterialRenderTarget = MakeRenderTarget(Pixels.Num());
+	UTextureRenderTarget2D* PrePassRenderTarget = MakeRenderTarget(Pixels.Num());
+	UMaterialInstanceDynamic* MID = MakeKeyerMID(World, KeyerMaterial, MediaTexture);
+
+	const float OpacityMaskClipValue = KeyerMaterial->GetOpacityMaskClipValue();
+
+	for (const FCompositeKeyerCPUSettings& Settings : MakeSettings())
+	{
+		const TArray<FLinearColor> MaterialPixels = DrawKeyerMaterial(World, MID, Settings, MaterialRenderTarget);
+		const TArray<FLinearColor> PrePassPixels = RunMediaPrePass(MediaTexture, Settings, PrePassRenderTarget);
+		if (!TestEqual(TEXT("Read back material pixels"), MaterialPixels.Num(), Pixels.Num()) || !TestEqual(TEXT("Read back pre pass pixels"), PrePassPixels.Num(), Pixels.Num()))
+		{
+			return false;
+		}
+
+		for (int32 Index = 0; Index < Pixels.Num(); ++Index)
+		{
+			const FString What = FString::Printf(TEXT("Key color %s, pixel %s"), *Settings.KeyColor.ToString(), *Pixels[Index].ToString());
+
+			// The pre pass writes the transparent pixels the material discards, only their alpha can be compared.
+			if (MaterialPixels[Index] == Discarded)
+			{
+				TestTrue(What + TEXT(": discarded pixels are transparent"), PrePassPixels[Index].A < OpacityMaskClipValue + MaterialTolerance);
+			}
+			else
+			{
+				TestTrue(What + FString::Printf(TEXT(": pre pass %s matches material %s"), *PrePassPixels[Index].ToString(), *MaterialPixels[Index].ToString()), IsNearlyEqual(PrePassPixels[Index], MaterialPixels[Index], MaterialTolerance));
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif
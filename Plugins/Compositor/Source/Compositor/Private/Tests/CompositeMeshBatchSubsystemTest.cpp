@@ -0,0 +1,107 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Actors/CompositeMesh.h"
+#include "Subsystems/CompositeMeshBatchSubsystem.h"
+
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+#include "RenderingThread.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace CompositeMeshBatchSubsystemTest
+{
+	const TCHAR* StaticMeshPath = TEXT("/Engine/BasicShapes/Cube.Cube");
+
+	/** A game world that has begun play, composite meshes are only batched in game worlds. */
+	UWorld* CreateGameWorld()
+	{
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("CompositeMeshBatchSubsystemTest"));
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+
+		return World;
+	}
+
+	void DestroyGameWorld(UWorld* World)
+	{
+		FlushRenderingCommands();
+
+		World->EndPlay(EEndPlayReason::Quit);
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	ACompositeMesh* SpawnInstancedCompositeMesh(UWorld* World, UStaticMesh* StaticMesh, const FVector& Location)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		ACompositeMesh* CompositeMesh = World->SpawnActor<ACompositeMesh>(Location, FRotator::ZeroRotator, SpawnParameters);
+		CompositeMesh->SetStaticMesh(StaticMesh);
+		CompositeMesh->SetUseInstancedRendering(true);
+		return CompositeMesh;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCompositeMeshBatchSubsystemFlushTest, "Plugins.Compositor.CompositeMeshBatch.FlushOncePerFrame", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCompositeMeshBatchSubsystemFlushTest::RunTest(const FString& Parameters)
+{
+	using namespace CompositeMeshBatchSubsystemTest;
+
+	UStaticMesh* StaticMesh = LoadObject<UStaticMesh>(nullptr, StaticMeshPath);
+	if (!TestNotNull(TEXT("Static mesh"), StaticMesh))
+	{
+		return false;
+	}
+
+	UWorld* World = CreateGameWorld();
+	UCompositeMeshBatchSubsystem* CompositeMeshBatchSubsystem = World->GetSubsystem<UCompositeMeshBatchSubsystem>();
+	if (!TestNotNull(TEXT("Batch subsystem"), CompositeMeshBatchSubsystem))
+	{
+		DestroyGameWorld(World);
+		return false;
+	}
+
+	ACompositeMesh* FirstCompositeMesh = SpawnInstancedCompositeMesh(World, StaticMesh, FVector::ZeroVector);
+	ACompositeMesh* SecondCompositeMesh = SpawnInstancedCompositeMesh(World, StaticMesh, FVector(100.F, 0.F, 0.F));
+	UInstancedStaticMeshComponent* BatchSoftMaskComponent = CompositeMeshBatchSubsystem->GetBatchSoftMaskComponent(FirstCompositeMesh);
+	if (TestNotNull(TEXT("Instanced mesh is batched"), BatchSoftMaskComponent))
+	{
+		TestTrue(TEXT("Both meshes share a batch"), CompositeMeshBatchSubsystem->GetBatchSoftMaskComponent(SecondCompositeMesh) == BatchSoftMaskComponent);
+
+		CompositeMeshBatchSubsystem->Tick(0.F);
+		TestFalse(TEXT("Nothing is left to flush after a tick"), CompositeMeshBatchSubsystem->IsTickable());
+
+		// Changing meshes only writes their instances, the batch is pushed to the renderer on the next tick.
+		FirstCompositeMesh->SetPlanarReflectionColorIntensity(0.25F);
+		SecondCompositeMesh->SetPlanarReflectionColorIntensity(0.75F);
+		TestTrue(TEXT("Changed meshes leave their batch to flush"), CompositeMeshBatchSubsystem->IsTickable());
+
+		const int32 NumCustomDataFloats = UCompositeMeshBatchSubsystem::NumCustomDataFloats;
+		const TArray<float>& CustomData = BatchSoftMaskComponent->PerInstanceSMCustomData;
+		if (TestEqual(TEXT("Custom data of both instances"), CustomData.Num(), 2 * NumCustomDataFloats))
+		{
+			const float FirstIntensity = CustomData[UCompositeMeshBatchSubsystem::CustomDataPlanarReflectionColorIntensity];
+			const float SecondIntensity = CustomData[NumCustomDataFloats + UCompositeMeshBatchSubsystem::CustomDataPlanarReflectionColorIntensity];
+			TestTrue(TEXT("Instances hold the new values before the flush"), FMath::Min(FirstIntensity, SecondIntensity) == 0.25F && FMath::Max(FirstIntensity, SecondIntensity) == 0.75F);
+		}
+
+		CompositeMeshBatchSubsystem->Tick(0.F);
+		TestFalse(TEXT("The batch is flushed once for both meshes"), CompositeMeshBatchSubsystem->IsTickable());
+	}
+
+	DestroyGameWorld(World);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
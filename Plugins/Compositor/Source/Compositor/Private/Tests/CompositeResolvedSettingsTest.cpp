@@ -0,0 +1,153 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Assets/Composite.h"
+#include "Objects/CompositeColorGrade.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace CompositeResolvedSettingsTest
+{
+	/** A chain of transient composites, the first one is the leaf and the last one the root. */
+	TArray<UComposite*> MakeChain(int32 Depth)
+	{
+		TArray<UComposite*> Chain;
+		for (int32 Level = 0; Level < Depth; ++Level)
+		{
+			UComposite* Composite = NewObject<UComposite>(GetTransientPackage(), NAME_None, RF_Transient);
+			if (Chain.Num() > 0)
+			{
+				Chain.Last()->SetParentComposite(Composite);
+			}
+			Chain.Add(Composite);
+		}
+		return Chain;
+	}
+
+	/** Checks the snapshot against the getters, which walk the chain every call. */
+	void TestMatchesGetters(FAutomationTestBase& Test, const TCHAR* What, const UComposite& Composite)
+	{
+		const FResolvedCompositeSettings& Settings = Composite.GetResolvedSettings();
+		Test.TestTrue(FString::Printf(TEXT("%s: MediaInputTexture"), What), Settings.MediaInputTexture == Composite.GetMediaInputTexture());
+		Test.TestTrue(FString::Printf(TEXT("%s: MediaInputKeyer"), What), Settings.MediaInputKeyer == Composite.GetMediaInputKeyer());
+		Test.TestTrue(FString::Printf(TEXT("%s: bEnableSoftMask"), What), Settings.bEnableSoftMask == Composite.GetEnableSoftMask());
+		Test.TestEqual(FString::Printf(TEXT("%s: SoftMaskScreenPercentage"), What), Settings.SoftMaskScreenPercentage, Composite.GetSoftMaskScreenPercentage());
+		Test.TestTrue(FString::Printf(TEXT("%s: bEnableMediaShadows"), What), Settings.bEnableMediaShadows == Composite.GetEnableMediaShadows());
+		Test.TestEqual(FString::Printf(TEXT("%s: ShadowsOffset"), What), Settings.ShadowsOffset, Composite.GetShadowsOffset());
+		Test.TestEqual(FString::Printf(TEXT("%s: ShadowsGamma"), What), Settings.ShadowsGamma, Composite.GetShadowsGamma());
+		Test.TestEqual(FString::Printf(TEXT("%s: ShadowsTint"), What), Settings.ShadowsTint, Composite.GetShadowsTint());
+		Test.TestTrue(FString::Printf(TEXT("%s: bEnablePlanarReflection"), What), Settings.bEnablePlanarReflection == Composite.GetEnablePlanarReflection());
+		Test.TestEqual(FString::Printf(TEXT("%s: PlanarReflectionColor"), What), Settings.PlanarReflectionColor, Composite.GetPlanarReflectionColor());
+		Test.TestEqual(FString::Printf(TEXT("%s: BrightnessMaskGamma"), What), Settings.BrightnessMaskGamma, Composite.GetBrightnessMaskGamma());
+		Test.TestTrue(FString::Printf(TEXT("%s: bApplyInverseToneCurve"), What), Settings.bApplyInverseToneCurve == Composite.GetApplyInverseToneCurve());
+		Test.TestTrue(FString::Printf(TEXT("%s: MediaBlend"), What), Settings.MediaBlend == Composite.GetMediaBlend());
+		Test.TestTrue(FString::Printf(TEXT("%s: OutputAlpha"), What), Settings.OutputAlpha == Composite.GetOutputAlpha());
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCompositeResolvedSettingsTest, "Plugins.Compositor.ResolvedSettings", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCompositeResolvedSettingsTest::RunTest(const FString& Parameters)
+{
+	using namespace CompositeResolvedSettingsTest;
+
+	const TArray<UComposite*> Chain = MakeChain(3);
+	UComposite* Leaf = Chain[0];
+	UComposite* Middle = Chain[1];
+	UComposite* Root = Chain[2];
+
+	TestMatchesGetters(*this, TEXT("Defaults"), *Leaf);
+
+	TestTrue(TEXT("Root overrides the shadows gamma"), Root->SetPropertyOverride(TEXT("ShadowsGamma"), true));
+	Root->SetShadowsGamma(1.7F);
+	TestEqual(TEXT("Leaf inherits the shadows gamma of the root"), Leaf->GetResolvedSettings().ShadowsGamma, 1.7F);
+
+	Middle->SetPropertyOverride(TEXT("ShadowsGamma"), true);
+	Middle->SetShadowsGamma(0.5F);
+	TestEqual(TEXT("The closest override wins"), Leaf->GetResolvedSettings().ShadowsGamma, 0.5F);
+
+	// Only the flag changes, the snapshot must not keep the value of the middle composite.
+	Middle->SetPropertyOverride(TEXT("ShadowsGamma"), false);
+	TestEqual(TEXT("Clearing an override falls back to the parent"), Leaf->GetResolvedSettings().ShadowsGamma, 1.7F);
+
+	Root->SetPropertyOverride(TEXT("MediaBlend"), true);
+	Root->SetMediaBlend(EMediaBlend::PreToneCurve);
+	Middle->SetPropertyOverride(TEXT("PlanarReflectionColor"), true);
+	Middle->SetPropertyOverride(TEXT("EnablePlanarReflection"), true);
+	Middle->SetPlanarReflectionColor(FLinearColor(0.25F, 0.5F, 0.75F, 1.F));
+	Middle->SetEnablePlanarReflection(true);
+	TestMatchesGetters(*this, TEXT("Mixed overrides"), *Leaf);
+
+	// A parent swapped out from under a resolved snapshot.
+	Leaf->SetParentComposite(Root);
+	TestMatchesGetters(*this, TEXT("Reparented"), *Leaf);
+
+	// The color grade overrides invalidate the snapshot the same way.
+	FColorGradePerRangeSettings ColorGradeMedia;
+	ColorGradeMedia.Shadows.Gain = FVector4(0.5F, 0.5F, 0.5F, 1.F);
+	Root->GetCompositeColorGrade()->SetColorGradeMedia(ColorGradeMedia);
+	TestTrue(TEXT("Root overrides the media color grade"), Root->GetCompositeColorGrade()->SetPropertyOverride(TEXT("ColorGradeMedia"), true));
+	TestEqual(TEXT("Leaf inherits the media color grade of the root"), Leaf->GetResolvedSettings().ColorGradeMedia.Shadows.Gain, ColorGradeMedia.Shadows.Gain);
+	Root->GetCompositeColorGrade()->SetPropertyOverride(TEXT("ColorGradeMedia"), false);
+	TestEqual(TEXT("Clearing a color grade override falls back to the defaults"), Leaf->GetResolvedSettings().ColorGradeMedia.Shadows.Gain, FColorGradePerRangeSettings().Shadows.Gain);
+
+	AddExpectedError(TEXT("has no override for the property"), EAutomationExpectedErrorFlags::Contains, 2);
+	TestFalse(TEXT("Properties without an override flag are rejected"), Leaf->SetPropertyOverride(TEXT("NotACompositeProperty"), true));
+	TestFalse(TEXT("Color grades without an override flag are rejected"), Leaf->GetCompositeColorGrade()->SetPropertyOverride(TEXT("ColorGradeScenes"), true));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCompositeResolvedSettingsBenchmark, "Plugins.Compositor.ResolvedSettings.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FCompositeResolvedSettingsBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace CompositeResolvedSettingsTest;
+
+	constexpr int32 Depth = 8;
+	constexpr int32 NumReads = 100000;
+
+	/** The snapshot is resolved once per settings change, reading it must not cost more the deeper the chain. Leaves room for timer noise. */
+	constexpr double MaxDeepChainCostFactor = 2.0;
+
+	const TArray<UComposite*> Chain = MakeChain(Depth);
+	Chain.Last()->SetPropertyOverride(TEXT("ShadowsGamma"), true);
+	Chain.Last()->SetShadowsGamma(1.2F);
+
+	const TArray<UComposite*> Single = MakeChain(1);
+
+	// Reads the settings the per view path reads, through the getters and through the snapshot.
+	float GetterSum = 0.F;
+	const double GetterStart = FPlatformTime::Seconds();
+	for (int32 Read = 0; Read < NumReads; ++Read)
+	{
+		GetterSum += Chain[0]->GetShadowsGamma() + Chain[0]->GetShadowsOffset() + Chain[0]->GetBrightnessMaskGamma() + Chain[0]->GetPlanarReflectionColor().A;
+	}
+	const double GetterSeconds = FPlatformTime::Seconds() - GetterStart;
+
+	auto ReadResolved = [](const UComposite& Composite, float& OutSum)
+	{
+		OutSum = 0.F;
+		const double Start = FPlatformTime::Seconds();
+		for (int32 Read = 0; Read < NumReads; ++Read)
+		{
+			const FResolvedCompositeSettings& Settings = Composite.GetResolvedSettings();
+			OutSum += Settings.ShadowsGamma + Settings.ShadowsOffset + Settings.BrightnessMaskGamma + Settings.PlanarReflectionColor.A;
+		}
+		return FPlatformTime::Seconds() - Start;
+	};
+
+	float ResolvedSum = 0.F;
+	float SingleSum = 0.F;
+	const double SingleSeconds = ReadResolved(*Single[0], SingleSum);
+	const double ResolvedSeconds = ReadResolved(*Chain[0], ResolvedSum);
+
+	TestEqual(TEXT("Both paths read the same values"), ResolvedSum, GetterSum, KINDA_SMALL_NUMBER * NumReads);
+	TestTrue(FString::Printf(TEXT("Resolved settings of a chain of %d composites read within %.1fx of a single composite"), Depth, MaxDeepChainCostFactor), ResolvedSeconds <= SingleSeconds * MaxDeepChainCostFactor);
+	AddInfo(FString::Printf(TEXT("%d reads through a chain of %d composites: getters %.3f ms, resolved settings %.3f ms, single composite %.3f ms."), NumReads, Depth, GetterSeconds * 1000.0, ResolvedSeconds * 1000.0, SingleSeconds * 1000.0));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,237 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Objects/CompositeSoftMaskUpsampleCPU.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace CompositeSoftMaskUpsampleCPUTest
+{
+	/** Largest mean error allowed of the joint bilateral upsample against capturing at full resolution. */
+	constexpr double MeanTolerance = 1.E-3;
+
+	/**
+	 * Largest mean error allowed on the edges of the full resolution mask.
+	 * The generated masks are hard edged with distinct depths, only the receding floor has samples a fraction of a sigma apart.
+	 */
+	constexpr double EdgeTolerance = 5.E-3;
+
+	/** Bilinear upsampling blurs every edge, far above the edge tolerance. Guards against measuring masks without edges. */
+	constexpr double MinBilinearEdgeError = 0.1;
+
+	/** A generated soft mask, returns the mask and linear depth at a UV. */
+	struct FSyntheticSoftMask
+	{
+		const TCHAR* Name;
+		TFunction<void(FVector2f UV, float& OutMask, float& OutDepth)> Evaluate;
+	};
+
+	/** Evaluates the mask at the pixel centers, like rasterizing without anti aliasing does. */
+	void Rasterize(const FSyntheticSoftMask& SoftMask, FIntPoint Size, TArray<float>& OutMask, TArray<float>& OutDepth)
+	{
+		OutMask.SetNumUninitialized(Size.X * Size.Y);
+		OutDepth.SetNumUninitialized(Size.X * Size.Y);
+
+		for (int32 Y = 0; Y < Size.Y; ++Y)
+		{
+			for (int32 X = 0; X < Size.X; ++X)
+			{
+				const int32 Index = Y * Size.X + X;
+				OutMask[Index] = 0.F;
+				OutDepth[Index] = FCompositeSoftMaskUpsampleCPU::FarDepth;
+				SoftMask.Evaluate(FVector2f((X + 0.5F) / Size.X, (Y + 0.5F) / Size.Y), OutMask[Index], OutDepth[Index]);
+			}
+		}
+	}
+
+	/** Mean absolute error over all pixels and over the pixels on an edge of the reference. */
+	void MeasureError(const TArray<float>& Reference, const TArray<float>& Result, FIntPoint Size, double& OutError, double& OutEdgeError)
+	{
+		double Error = 0.0;
+		double EdgeError = 0.0;
+		int32 NumEdgePixels = 0;
+
+		for (int32 Y = 0; Y < Size.Y; ++Y)
+		{
+			for (int32 X = 0; X < Size.X; ++X)
+			{
+				const int32 Index = Y * Size.X + X;
+				const double PixelError = FMath::Abs(Reference[Index] - Result[Index]);
+				Error += PixelError;
+
+				const float Value = Reference[Index];
+				const bool bIsEdge = (X > 0 && FMath::Abs(Reference[Index - 1] - Value) > 0.01F)
+					|| (X < Size.X - 1 && FMath::Abs(Reference[Index + 1] - Value) > 0.01F)
+					|| (Y > 0 && FMath::Abs(Reference[Index - Size.X] - Value) > 0.01F)
+					|| (Y < Size.Y - 1 && FMath::Abs(Reference[Index + Size.X] - Value) > 0.01F);
+				if (bIsEdge)
+				{
+					EdgeError += PixelError;
+					++NumEdgePixels;
+				}
+			}
+		}
+
+		OutError = Error / FMath::Max(Size.X * Size.Y, 1);
+		OutEdgeError = EdgeError / FMath::Max(NumEdgePixels, 1);
+	}
+
+	FSyntheticSoftMask MakeDisc(FVector2f Center)
+	{
+		return { TEXT("disc"), [Center](FVector2f UV, float& OutMask, float& OutDepth)
+		{
+			if (FVector2f::DistSquared(UV * FVector2f(16.F / 9.F, 1.F), Center * FVector2f(16.F / 9.F, 1.F)) < FMath::Square(0.25F))
+			{
+				OutMask = 1.F;
+				OutDepth = 500.F;
+			}
+		} };
+	}
+
+	TArray<FSyntheticSoftMask> MakeSoftMasks()
+	{
+		TArray<FSyntheticSoftMask> SoftMasks;
+
+		SoftMasks.Add(MakeDisc(FVector2f(0.5F, 0.5F)));
+
+		SoftMasks.Add({ TEXT("overlap"), [](FVector2f UV, float& OutMask, float& OutDepth)
+		{
+			// A white mesh in front of a half transparent one, the mask changes along an edge inside the covered area.
+			if (UV.X > 0.2F && UV.X < 0.6F && UV.Y > 0.2F && UV.Y < 0.7F)
+			{
+				OutMask = 1.F;
+				OutDepth = 300.F;
+			}
+			else if (UV.X > 0.4F && UV.X < 0.8F && UV.Y > 0.3F && UV.Y < 0.8F)
+			{
+				OutMask = 0.25F;
+				OutDepth = 800.F;
+			}
+		} });
+
+		SoftMasks.Add({ TEXT("slanted"), [](FVector2f UV, float& OutMask, float& OutDepth)
+		{
+			// A floor with a vertex alpha gradient receding into the distance, and a black mesh standing on it.
+			if (UV.Y > 0.4F)
+			{
+				OutMask = UV.X;
+				OutDepth = 200.F / (UV.Y - 0.35F);
+			}
+			if (FMath::Abs(UV.X - 0.3F) < 0.05F + UV.Y * 0.02F && UV.Y > 0.1F && UV.Y < 0.75F)
+			{
+				OutMask = 0.F;
+				OutDepth = 350.F;
+			}
+		} });
+
+		SoftMasks.Add({ TEXT("bars"), [](FVector2f UV, float& OutMask, float& OutDepth)
+		{
+			// About four full resolution pixels wide, a single quarter resolution sample lands on each bar.
+			if (FMath::Fmod(UV.X, 0.1F) < 0.004F)
+			{
+				OutMask = 1.F;
+				OutDepth = 400.F;
+			}
+		} });
+
+		return SoftMasks;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCompositeSoftMaskUpsampleCPUErrorTest, "Plugins.Compositor.SoftMaskUpsampleCPU.Error", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCompositeSoftMaskUpsampleCPUErrorTest::RunTest(const FString& Parameters)
+{
+	using namespace CompositeSoftMaskUpsampleCPUTest;
+
+	const FIntPoint Size(1024, 576);
+
+	FCompositeSoftMaskUpsampleCPUSettings BilinearSettings;
+	BilinearSettings.bBilinearOnly = true;
+	BilinearSettings.TemporalWeight = 0.F;
+
+	FCompositeSoftMaskUpsampleCPUSettings BilateralSettings;
+	BilateralSettings.TemporalWeight = 0.F;
+
+	TArray<float> ReferenceMask;
+	TArray<float> ReferenceDepth;
+	TArray<float> LowResMask;
+	TArray<float> LowResDepth;
+	TArray<float> Result;
+	Result.SetNumUninitialized(Size.X * Size.Y);
+
+	for (const FSyntheticSoftMask& SoftMask : MakeSoftMasks())
+	{
+		Rasterize(SoftMask, Size, ReferenceMask, ReferenceDepth);
+
+		for (const int32 Factor : { 2, 4 })
+		{
+			const FIntPoint LowResSize(Size.X / Factor, Size.Y / Factor);
+			Rasterize(SoftMask, LowResSize, LowResMask, LowResDepth);
+
+			double BilinearError = 0.0;
+			double BilinearEdgeError = 0.0;
+			FCompositeSoftMaskUpsampleCPU::Upsample(BilinearSettings, LowResMask.GetData(), LowResDepth.GetData(), LowResSize, ReferenceDepth.GetData(), nullptr, Result.GetData(), Size);
+			MeasureError(ReferenceMask, Result, Size, BilinearError, BilinearEdgeError);
+
+			double BilateralError = 0.0;
+			double BilateralEdgeError = 0.0;
+			FCompositeSoftMaskUpsampleCPU::Upsample(BilateralSettings, LowResMask.GetData(), LowResDepth.GetData(), LowResSize, ReferenceDepth.GetData(), nullptr, Result.GetData(), Size);
+			MeasureError(ReferenceMask, Result, Size, BilateralError, BilateralEdgeError);
+
+			AddInfo(FString::Printf(TEXT("%s 1/%d: bilinear error %.4f (edges %.4f), joint bilateral error %.6f (edges %.6f)"),
+				SoftMask.Name, Factor, BilinearError, BilinearEdgeError, BilateralError, BilateralEdgeError));
+
+			TestTrue(FString::Printf(TEXT("%s 1/%d: bilinear edges are blurred"), SoftMask.Name, Factor), BilinearEdgeError > MinBilinearEdgeError);
+			TestTrue(FString::Printf(TEXT("%s 1/%d: joint bilateral error"), SoftMask.Name, Factor), BilateralError < MeanTolerance);
+			TestTrue(FString::Printf(TEXT("%s 1/%d: joint bilateral edge error"), SoftMask.Name, Factor), BilateralEdgeError < EdgeTolerance);
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCompositeSoftMaskUpsampleCPUTemporalTest, "Plugins.Compositor.SoftMaskUpsampleCPU.Temporal", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCompositeSoftMaskUpsampleCPUTemporalTest::RunTest(const FString& Parameters)
+{
+	using namespace CompositeSoftMaskUpsampleCPUTest;
+
+	const FIntPoint Size(1024, 576);
+	const FIntPoint LowResSize(Size.X / 4, Size.Y / 4);
+
+	TArray<float> ReferenceMask;
+	TArray<float> ReferenceDepth;
+	TArray<float> LowResMask;
+	TArray<float> LowResDepth;
+	TArray<float> Result;
+	Result.SetNumUninitialized(Size.X * Size.Y);
+
+	// A disc moving a few pixels per frame, the clamped history must not trail behind it.
+	for (const float TemporalWeight : { 0.F, 0.5F, 0.9F })
+	{
+		FCompositeSoftMaskUpsampleCPUSettings Settings;
+		Settings.TemporalWeight = TemporalWeight;
+
+		for (int32 Frame = 0; Frame < 8; ++Frame)
+		{
+			const FSyntheticSoftMask SoftMask = MakeDisc(FVector2f(0.4F + Frame * 0.005F, 0.5F));
+			Rasterize(SoftMask, Size, ReferenceMask, ReferenceDepth);
+			Rasterize(SoftMask, LowResSize, LowResMask, LowResDepth);
+			FCompositeSoftMaskUpsampleCPU::Upsample(Settings, LowResMask.GetData(), LowResDepth.GetData(), LowResSize, ReferenceDepth.GetData(), Frame > 0 ? Result.GetData() : nullptr, Result.GetData(), Size);
+		}
+
+		double Error = 0.0;
+		double EdgeError = 0.0;
+		MeasureError(ReferenceMask, Result, Size, Error, EdgeError);
+
+		AddInfo(FString::Printf(TEXT("Moving disc 1/4, temporal weight %.1f: error %.6f (edges %.6f)"), TemporalWeight, Error, EdgeError));
+
+		TestTrue(FString::Printf(TEXT("Temporal weight %.1f: error"), TemporalWeight), Error < MeanTolerance);
+		TestTrue(FString::Printf(TEXT("Temporal weight %.1f: edge error"), TemporalWeight), EdgeError < EdgeTolerance);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
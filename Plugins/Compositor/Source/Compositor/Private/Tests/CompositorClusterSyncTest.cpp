@@ -0,0 +1,62 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Objects/CompositorClusterSync.h"
+#include "Assets/Composite.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCompositorClusterSyncStateTest, "Plugins.Compositor.ClusterSync.State", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FCompositorClusterSyncStateTest::RunTest(const FString& Parameters)
+{
+	UComposite* Parent = NewObject<UComposite>(GetTransientPackage(), NAME_None, RF_Transient);
+	Parent->SetEnablePlanarReflection(true);
+	Parent->SetPlanarReflectionScreenPercentage(37.F);
+
+	// The child inherits the planar reflection settings, only the resolved settings carry them.
+	UComposite* Source = NewObject<UComposite>(GetTransientPackage(), NAME_None, RF_Transient);
+	Source->SetParentComposite(Parent);
+	Source->SetSoftMaskCaptureResolution(ESoftMaskCaptureResolution::Quarter);
+
+	FCompositorClusterLensState SourceLensState;
+	SourceLensState.CameraFovWithoutOverscan = 41.5F;
+	SourceLensState.CameraOverscanFactor = 1.125F;
+
+	TArray<uint8> Data;
+	FCompositorClusterSync::WriteState(Source->GetResolvedSettings(), SourceLensState, Data);
+
+	FResolvedCompositeSettings TargetSettings;
+	FCompositorClusterLensState TargetLensState;
+	if (!TestTrue(TEXT("Round trip reads the state"), FCompositorClusterSync::ReadState(Data, TargetSettings, TargetLensState)))
+	{
+		return false;
+	}
+
+	const FResolvedCompositeSettings& SourceSettings = Source->GetResolvedSettings();
+	TestTrue(TEXT("Inherited bEnablePlanarReflection"), TargetSettings.bEnablePlanarReflection == SourceSettings.bEnablePlanarReflection);
+	TestEqual(TEXT("Inherited PlanarReflectionScreenPercentage"), TargetSettings.PlanarReflectionScreenPercentage, SourceSettings.PlanarReflectionScreenPercentage);
+	TestTrue(TEXT("SoftMaskCaptureResolution"), TargetSettings.SoftMaskCaptureResolution == SourceSettings.SoftMaskCaptureResolution);
+	TestTrue(TEXT("Lens state"), TargetLensState == SourceLensState);
+
+	// A state missing its last byte or written by another build must be rejected without touching the outputs.
+	TArray<uint8> Truncated = Data;
+	Truncated.Pop();
+
+	TArray<uint8> OtherVersion = Data;
+	++OtherVersion[0];
+
+	FResolvedCompositeSettings UntouchedSettings;
+	FCompositorClusterLensState UntouchedLensState;
+	TestFalse(TEXT("Truncated state is rejected"), FCompositorClusterSync::ReadState(Truncated, UntouchedSettings, UntouchedLensState));
+	TestTrue(TEXT("Truncated state leaves the lens state untouched"), UntouchedLensState == FCompositorClusterLensState());
+	TestFalse(TEXT("Truncated state leaves the settings untouched"), UntouchedSettings.bEnablePlanarReflection);
+
+	TestFalse(TEXT("State of another version is rejected"), FCompositorClusterSync::ReadState(OtherVersion, UntouchedSettings, UntouchedLensState));
+	TestFalse(TEXT("Empty state is rejected"), FCompositorClusterSync::ReadState(TArray<uint8>(), UntouchedSettings, UntouchedLensState));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Actors/CompositeMesh.h"
+#include "Components/SoftMaskCaptureComponent.h"
+#include "Subsystems/CompositeMeshBatchSubsystem.h"
+#include "Subsystems/CompositorSubsystem.h"
+
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+#include "RenderingThread.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace SoftMaskCaptureComponentTest
+{
+	const TCHAR* StaticMeshPath = TEXT("/Engine/BasicShapes/Cube.Cube");
+
+	/** A game world that has begun play, composite meshes are only batched in game worlds. */
+	UWorld* CreateGameWorld()
+	{
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("SoftMaskCaptureComponentTest"));
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+
+		return World;
+	}
+
+	void DestroyGameWorld(UWorld* World)
+	{
+		FlushRenderingCommands();
+
+		World->EndPlay(EEndPlayReason::Quit);
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	ACompositeMesh* SpawnCompositeMesh(UWorld* World, UStaticMesh* StaticMesh, bool bUseInstancedRendering)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		ACompositeMesh* CompositeMesh = World->SpawnActor<ACompositeMesh>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParameters);
+		CompositeMesh->SetStaticMesh(StaticMesh);
+		CompositeMesh->SetUseInstancedRendering(bUseInstancedRendering);
+		return CompositeMesh;
+	}
+
+	bool IsShownOnly(const USoftMaskCaptureComponent& SoftMaskCaptureComponent, UPrimitiveComponent* Component)
+	{
+		return SoftMaskCaptureComponent.ShowOnlyComponents.Contains(TWeakObjectPtr<UPrimitiveComponent>(Component));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSoftMaskCaptureComponentBatchTest, "Plugins.Compositor.SoftMaskCapture.KeepsBatches", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FSoftMaskCaptureComponentBatchTest::RunTest(const FString& Parameters)
+{
+	using namespace SoftMaskCaptureComponentTest;
+
+	UStaticMesh* StaticMesh = LoadObject<UStaticMesh>(nullptr, StaticMeshPath);
+	if (!TestNotNull(TEXT("Static mesh"), StaticMesh))
+	{
+		return false;
+	}
+
+	UWorld* World = CreateGameWorld();
+	const UCompositorSubsystem* CompositorSubsystem = World->GetSubsystem<UCompositorSubsystem>();
+	const UCompositeMeshBatchSubsystem* CompositeMeshBatchSubsystem = World->GetSubsystem<UCompositeMeshBatchSubsystem>();
+	USoftMaskCaptureComponent* SoftMaskCaptureComponent = CompositorSubsystem ? CompositorSubsystem->GetSoftMaskCaptureComponent() : nullptr;
+	if (!TestNotNull(TEXT("Soft mask capture"), SoftMaskCaptureComponent) || !TestNotNull(TEXT("Batch subsystem"), CompositeMeshBatchSubsystem))
+	{
+		DestroyGameWorld(World);
+		return false;
+	}
+
+	const ACompositeMesh* InstancedCompositeMesh = SpawnCompositeMesh(World, StaticMesh, true);
+	UInstancedStaticMeshComponent* BatchSoftMaskComponent = CompositeMeshBatchSubsystem->GetBatchSoftMaskComponent(InstancedCompositeMesh);
+	if (TestNotNull(TEXT("Instanced mesh is batched"), BatchSoftMaskComponent))
+	{
+		TestTrue(TEXT("Batch soft mask component is captured"), IsShownOnly(*SoftMaskCaptureComponent, BatchSoftMaskComponent));
+
+		// A queued registration batch must add to the captured components, not replace the ones of the batches.
+		ACompositeMesh* RegisteredCompositeMesh = SpawnCompositeMesh(World, StaticMesh, false);
+		ACompositeMesh* const RegisteredCompositeMeshes[] = { RegisteredCompositeMesh };
+		SoftMaskCaptureComponent->OnCompositeMeshesRegistered(MakeArrayView(RegisteredCompositeMeshes));
+
+		TestTrue(TEXT("Batch soft mask component is still captured after a registration batch"), IsShownOnly(*SoftMaskCaptureComponent, BatchSoftMaskComponent));
+		TestTrue(TEXT("Registered soft mask component is captured"), IsShownOnly(*SoftMaskCaptureComponent, RegisteredCompositeMesh->GetSoftMaskComponent()));
+	}
+
+	DestroyGameWorld(World);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
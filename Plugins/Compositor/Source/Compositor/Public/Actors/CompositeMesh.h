@@ -15,6 +15,9 @@ class COMPOSITOR_API ACompositeMesh : public AActor, public ICompositeUpdateInte
 {
 	GENERATED_BODY()
 
+	/** Reads the settings of batched meshes. */
+	friend class UCompositeMeshBatchSubsystem;
+
 public:	
 	// Sets default values for this actor's properties
 	ACompositeMesh(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
@@ -31,6 +34,8 @@ public:
 	/** Overridable function called whenever this actor is being removed from a level */
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
+	virtual void Destroyed() override;
+
 protected:
 	UPROPERTY(Category = "Composite Mesh", EditDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	class UMaterialInterface* OpaqueMaterial;
@@ -59,12 +64,31 @@ private:
 	UFUNCTION()
 	void InitializeMaterialData();
 
+	/** Swaps in the pooled material instances matching the current properties, shared with all composite meshes that use the same values. */
+	void UpdateMaterialInstances();
+
+	/** Hands the material instances back to the pool. */
+	void ReleaseMaterialInstances();
+
+	/** Applies all user properties to the components and material instances, updating the material instances and the instanced batch once. */
 	UFUNCTION()
 	void InitializeUserProperties();
 
+	/** Assigns the static mesh to every component that does not show it yet. */
+	void UpdateComponentStaticMeshes();
+
+	/** Hides the opaque and stencil components when the mesh renders as black into the soft mask. */
+	void UpdateComponentVisibility();
+
+	/** The soft mask capture of the world, null without a compositor subsystem. */
+	class USoftMaskCaptureComponent* FindSoftMaskCaptureComponent() const;
+
 	UFUNCTION()
 	void RegisterCompositeMesh();
 
+	/** Registers the mesh and applies the user properties, on this frame or a later one when the subsystem queues it. A queued mesh stays hidden until then. */
+	void BeginCompositeMeshRegistration();
+
 	UFUNCTION()
 	void UnregisterCompositeMesh();
 
@@ -74,6 +98,9 @@ private:
 	UFUNCTION()
 	void UpdateStencilValues();
 
+	/** Moves the mesh in or out of the instanced batches, or updates its instance when it already is batched. */
+	void UpdateInstancedRendering();
+
 	UPROPERTY(Category = "Composite Mesh", VisibleDefaultsOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	class USceneComponent* RootSceneComponent;
 
@@ -121,8 +148,23 @@ private:
 	 */
 	UPROPERTY(Category = "Mesh", EditAnywhere, BlueprintSetter = SetBypassDepthOfField, AdvancedDisplay, meta = (AllowPrivateAccess = "true", DisplayName = "Bypass Depth of Field (unsafe)"))
 	bool bBypassDepthOfField;
-	/** Index of the BypassDepthOfField parameter. */
-	int32 TranslucentBypassDepthOfFieldParameterIndex;
+
+	/**
+	 * Render this mesh through instanced components shared with all composite meshes that have the same mesh and settings.
+	 * Saves draw calls on sets built from many pieces, only applies while playing.
+	 * Requires materials that read the per mesh values from the per instance custom data.
+	 */
+	UPROPERTY(Category = "Mesh", EditAnywhere, BlueprintSetter = SetUseInstancedRendering, AdvancedDisplay, meta = (AllowPrivateAccess = "true"))
+	bool bUseInstancedRendering;
+
+	/** Is this mesh currently rendered by the Composite Mesh Batch Subsystem instead of its own components. */
+	bool bIsInstanced;
+
+	/** Set while the mesh registers with the compositor subsystem, the caller applies all user properties right after. */
+	bool bIsRegisteringCompositeMesh;
+
+	/** The composite settings generation the material instances were last updated for, see UComposite::GetSettingsGeneration. */
+	uint32 AppliedSettingsGeneration;
 
 	/**
 	 * Channels that this component should be in.  Lights with matching channels will affect the component.
@@ -142,8 +184,6 @@ private:
 	/** How visible the shadows are on the media. */
 	UPROPERTY(Category = "Shadows", EditAnywhere, Interp, BlueprintSetter = SetReceiveShadowsIntensity, meta = (UIMin = "0", UIMax = "1", ClampMin = "0", ClampMax = "1", AllowPrivateAccess = "true"))
 	float ReceiveShadowsIntensity;
-	/** Index of the Shadow Intensity parameter. */
-	int32 OpaqueShadowsIntensityParameterIndex;
 
 	/**
 		The intensity of the color itself over the media. 1 = Full color, 0 = black.
@@ -152,8 +192,6 @@ private:
 	*/
 	UPROPERTY(Category = "Planar Reflection", EditAnywhere, Interp, BlueprintSetter = SetPlanarReflectionColorIntensity, meta = (AllowPrivateAccess = "true", UIMin = "0", UIMax = "1", ClampMin = "0", ClampMax = "1"))
 	float PlanarReflectionColorIntensity;
-	/** Index of the PlanarReflectionColorIntensity parameter. */
-	int32 OpaquePlanarReflectionColorIntensityParameterIndex;
 
 	/**
 		Remove the background where the is reflection. This is useful when doing augmented reality on highly reflective mirror-like floors.
@@ -162,28 +200,20 @@ private:
 	*/
 	UPROPERTY(Category = "Planar Reflection", EditAnywhere, Interp, BlueprintSetter = SetPlanarReflectionBackgroundOcclusion, meta = (AllowPrivateAccess = "true", UIMin = "0", UIMax = "1", ClampMin = "0", ClampMax = "1"))
 	float PlanarReflectionBackgroundOcclusion;
-	/** Index of the PlanarReflectionMediaOcclusion parameter. */
-	int32 OpaquePlanarReflectionBackgroundOcclusionParameterIndex;
 
 	/** Is this Composite Mesh rendering on both sides of the surface. */
 	UPROPERTY(Category = "Shading", EditAnywhere, Interp, BlueprintSetter = SetIsTwoSided, meta = (AllowPrivateAccess = "true"))
 	bool bIsTwoSided;
-	/** Two sided parameter. */
-	int32 OpaqueTwoSidedParameterIndex, StencilTwoSidedParameterIndex, TranslucentTwoSidedParameterIndex, SoftMaskOpaqueTwoSidedParameterIndex, SoftMaskTranslucentTwoSidedParameterIndex;
 
 	/** Align the mesh normals with the first atmospheric light found in the scene, when not found this will be top down. When disabled it will use the mesh normal. */
 	UPROPERTY(Category = "Shading", EditAnywhere, Interp, BlueprintSetter = SetAlignNormalsWithAtmosphereLight, meta = (AllowPrivateAccess = "true"))
 	bool bAlignNormalsWithAtmosphereLight;
-	/** AlignNormalsWithAtmosphereLight parameter. */
-	int32 OpaqueAlignNormalsWithAtmosphereLightParameterIndex;
 
 	/** The color of the back side of the mesh when it is ray traced.
 	Alpha = 0: Color is multiplied with Media.
 	Alpha = 1: Only the Color is visible. */
 	UPROPERTY(Category = "Shading", EditAnywhere, Interp, BlueprintSetter = SetRayTracedBackfaceColor, AdvancedDisplay, meta = (AllowPrivateAccess = "true"))
 	FLinearColor RayTracedBackfaceColor;
-	/** Index of the RayTracedBackfaceColor parameter. */
-	int32 OpaqueRayTracedBackfaceColorParameterIndex, TranslucentRayTracedBackfaceColorParameterIndex;
 
 	/** The color of the mesh when it is ray traced outside of the camera frustum.
 	Alpha = 0: Color is multiplied with Media.
@@ -191,20 +221,10 @@ private:
 	This value only works for non keyed areas. */
 	UPROPERTY(Category = "Shading", EditAnywhere, Interp, BlueprintSetter = SetRayTracedOutOfFrustumColor, AdvancedDisplay, meta = (AllowPrivateAccess = "true"))
 	FLinearColor RayTracedOutOfFrustumColor;
-	/** Index of the RayTracedBackfaceColor parameter. */
-	int32 OpaqueRayTracedOutOfFrustumColorParameterIndex, TranslucentRayTracedOutOfFrustumColorParameterIndex;
 
 	/** Is this Composite Mesh rendering to the soft mask. This allows for soft fading the mesh using vertex color alpha. */
 	UPROPERTY(Category = "Soft Mask", EditAnywhere, Interp, BlueprintSetter = SetRenderSoftMask, meta = (AllowPrivateAccess = "true"))
 	ERenderSoftMaskType RenderSoftMask;
-	
-	/** Soft mask parameter. */
-	int32 OpaqueRenderSoftMaskParameterIndex, TranslucentRenderSoftMaskParameterIndex;
-
-	int32 TranslucentRenderSoftMaskBlackParameterIndex;
-	
-	/**  */
-	int32 SoftMaskOpaqueCustomValueParameterIndex, SoftMaskOpaqueRenderVertexColorParameterIndex;
 
 	// Pointer to the world composite for quick access.
 	UPROPERTY(Category = "Composite", BlueprintReadOnly, Transient, meta = (AllowPrivateAccess = "true"))
@@ -228,7 +248,16 @@ public:
 	static int32 StencilValueOpaqueHardMaskNoDoF;
 	static int32 StencilValueTranslucentHardMaskNoDoF;
 
-	virtual void OnCompositeUpdate(UComposite& InWorldComposite) override;
+	/** Only the media shadows feed into the material parameters of the mesh. */
+	static constexpr ECompositeUpdateFlags CompositeUpdateSubscription = ECompositeUpdateFlags::Shadows;
+
+	/** Final so the subsystem can update the meshes in its registry without dispatching through the interface. */
+	virtual void OnCompositeUpdate(UComposite& InWorldComposite, ECompositeUpdateFlags UpdateFlags) override final;
+
+	virtual ECompositeUpdateFlags GetCompositeUpdateSubscription() const override final { return CompositeUpdateSubscription; }
+
+	/** Called by the compositor subsystem when the registration queued in begin play gets its turn. */
+	void FinishCompositeMeshRegistration();
 	
 	// All getter and setter functions.
 	UStaticMeshComponent* GetSoftMaskComponent() const { return SoftMaskComponent; }
@@ -250,6 +279,11 @@ public:
 	UFUNCTION(BlueprintSetter, meta = (CallInEditor = "true"))
 	void SetStaticMesh(UStaticMesh* NewStaticMesh);
 
+	//
+	FORCEINLINE bool GetUseInstancedRendering() const { return bUseInstancedRendering; };
+	UFUNCTION(BlueprintSetter, meta = (CallInEditor = "true"))
+	void SetUseInstancedRendering(const bool bNewUseInstancedRendering);
+
 	//
 	FORCEINLINE bool GetBypassDepthOfField() const { return bBypassDepthOfField; };
 	UFUNCTION(BlueprintSetter, meta = (CallInEditor = "true"))
@@ -268,6 +302,8 @@ public:
 	void SetAffectDistanceFieldLighting(const bool bNewAffectDistanceFieldLighting);
 
 	FORCEINLINE float GetReceiveShadowsIntensity() const { return ReceiveShadowsIntensity; };
+	/** The receive shadows intensity after applying the media shadows setting of the world composite. */
+	float GetAppliedReceiveShadowsIntensity() const;
 	UFUNCTION(BlueprintSetter, meta = (CallInEditor = "true"))
 	void SetReceiveShadowsIntensity(const float NewReceiveShadowsIntensity);
 
@@ -12,6 +12,46 @@ class UCompositeKeyer;
 class UCompositeColorGrade;
 class UUserWidget;
 
+/**
+ * Flattened copy of all Composite settings, resolved through the ParentComposite chain.
+ * Readers on the per-view path use this instead of the getters so they don't walk the hierarchy every call.
+ */
+struct FResolvedCompositeSettings
+{
+	UTexture* MediaInputTexture = nullptr;
+	UCompositeKeyer* MediaInputKeyer = nullptr;
+
+	bool bEnableSoftMask = false;
+	float SoftMaskScreenPercentage = 100.F;
+	FCompositeCaptureSchedule SoftMaskCaptureSchedule;
+	ESoftMaskCaptureResolution SoftMaskCaptureResolution = ESoftMaskCaptureResolution::Full;
+
+	bool bEnableMediaShadows = false;
+	float ShadowsOffset = 0.F;
+	float ShadowsBlackLevel = 0.F;
+	float ShadowsWhiteLevel = 1.F;
+	float ShadowsGamma = 1.F;
+	FLinearColor ShadowsTint = FLinearColor::Transparent;
+
+	bool bEnablePlanarReflection = false;
+	FLinearColor PlanarReflectionColor = FLinearColor::Transparent;
+	float PlanarReflectionDistortionIntensity = 0.F;
+	float PlanarReflectionDistortionOffset = 0.F;
+	float PlanarReflectionScreenPercentage = 100.F;
+	FCompositeCaptureSchedule PlanarReflectionCaptureSchedule;
+
+	EMediaBlend MediaBlend = EMediaBlend::PostToneCurve;
+	float BrightnessMaskGamma = 1.F;
+	bool bApplyInverseToneCurve = false;
+
+	EOutputRgbEncoding OutputRgbEncoding = EOutputRgbEncoding::Srgb;
+	EOutputAlpha OutputAlpha = EOutputAlpha::Opacity;
+
+	FColorGradePerRangeSettings ColorGradeScene;
+	FColorGradePerRangeSettings ColorGradeMedia;
+	FColorGradePerRangeSettings ColorGradeCombined;
+};
+
 /**
  * 
  */
@@ -23,64 +63,73 @@ class COMPOSITOR_API UComposite : public UObject
 public:
 	UComposite();
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Media Input", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Input", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_MediaInputTexture : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Media Soft Mask", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Soft Mask", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_EnableSoftMask : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Media Soft Mask", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Soft Mask", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_SoftMaskScreenPercentage : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Media Keyer", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Soft Mask", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	uint8 bOverride_SoftMaskCaptureSchedule : 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Soft Mask", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	uint8 bOverride_SoftMaskCaptureResolution : 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Keyer", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_MediaInputKeyer : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Media Shadows", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Shadows", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_EnableMediaShadows : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Media Shadows", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Shadows", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_ShadowsOffset : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Media Shadows", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Shadows", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_ShadowsBlackLevel : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Media Shadows", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Shadows", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_ShadowsWhiteLevel : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Media Shadows", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Shadows", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_ShadowsGamma : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Media Shadows", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Shadows", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_ShadowsTint : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Planar Reflection on Mediar", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Planar Reflection on Mediar", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_EnablePlanarReflection : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Planar Reflection on Media", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Planar Reflection on Media", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_PlanarReflectionColor : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Planar Reflection on Media", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Planar Reflection on Media", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_PlanarReflectionDistortionIntensity : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Planar Reflection on Media", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Planar Reflection on Media", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_PlanarReflectionDistortionOffset : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Planar Reflection on Media", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Planar Reflection on Media", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_PlanarReflectionScreenPercentage : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Media Integration", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Planar Reflection on Media", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	uint8 bOverride_PlanarReflectionCaptureSchedule : 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Integration", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_BrightnessMaskGamma : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Media Integration", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Media Integration", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_ApplyInverseToneCurve : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Output", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_MediaBlend : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Output", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_OutputRgbEncoding : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Output", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_OutputAlpha : 1;
 
 private:
@@ -103,6 +152,18 @@ private:
 	UPROPERTY(Category = "Media Soft Mask", EditAnywhere, meta = (ClampMin = "10.0", ClampMax = "100.0", EditCondition = "bOverride_SoftMaskScreenPercentage"))
 	float SoftMaskScreenPercentage;
 
+	/** How often the soft mask is captured. Capturing less often saves the cost of rendering the scene again on locked off shots. */
+	UPROPERTY(Category = "Media Soft Mask", EditAnywhere, meta = (EditCondition = "bOverride_SoftMaskCaptureSchedule"))
+	FCompositeCaptureSchedule SoftMaskCaptureSchedule;
+
+	/**
+	 * Resolution the soft mask scene capture renders at, relative to the Soft Mask Screen Percentage.
+	 * Lower resolutions are upsampled back to the Soft Mask Screen Percentage along the edges of the composite meshes in custom depth,
+	 * and blended with the previous frames to keep moving edges from flickering.
+	 */
+	UPROPERTY(Category = "Media Soft Mask", EditAnywhere, AdvancedDisplay, meta = (EditCondition = "bOverride_SoftMaskCaptureResolution"))
+	ESoftMaskCaptureResolution SoftMaskCaptureResolution;
+
 	/** The Composite Keyer used on the media input. */
 	UPROPERTY(Category = "Media Keyer", EditAnywhere, Instanced, Export, meta = (EditCondition = "bOverride_MediaInputKeyer"))
 	UCompositeKeyer* MediaInputKeyer;
@@ -151,6 +212,10 @@ private:
 	UPROPERTY(Category = "Planar Reflection on Media", EditAnywhere, meta = (ClampMin = "10.0", ClampMax = "100.0", EditCondition = "bOverride_PlanarReflectionScreenPercentage"))
 	float PlanarReflectionScreenPercentage;
 
+	/** How often the planar reflection is captured. Capturing less often saves the cost of rendering the scene again on locked off shots. */
+	UPROPERTY(Category = "Planar Reflection on Media", EditAnywhere, meta = (EditCondition = "bOverride_PlanarReflectionCaptureSchedule"))
+	FCompositeCaptureSchedule PlanarReflectionCaptureSchedule;
+
 	UPROPERTY(Category = "Color Grading", EditInstanceOnly, Export, Instanced, BlueprintReadOnly, NoClear, meta = (AllowPrivateAccess = "true"))
 	UCompositeColorGrade* CompositeColorGrade;
 	
@@ -202,6 +267,18 @@ public:
 	UFUNCTION(Category = "Composite", BlueprintCallable)
 	void SetSoftMaskScreenPercentage(float NewSoftMaskScreenPercentage);
 
+	UFUNCTION(Category = "Composite", BlueprintPure)
+	FCompositeCaptureSchedule GetSoftMaskCaptureSchedule() const;
+
+	UFUNCTION(Category = "Composite", BlueprintCallable)
+	void SetSoftMaskCaptureSchedule(const FCompositeCaptureSchedule& NewSoftMaskCaptureSchedule);
+
+	UFUNCTION(Category = "Composite", BlueprintPure)
+	ESoftMaskCaptureResolution GetSoftMaskCaptureResolution() const;
+
+	UFUNCTION(Category = "Composite", BlueprintCallable)
+	void SetSoftMaskCaptureResolution(ESoftMaskCaptureResolution NewSoftMaskCaptureResolution);
+
 	UFUNCTION(Category = "Composite", BlueprintPure)
 	UCompositeKeyer* GetMediaInputKeyer() const;
 
@@ -273,6 +350,12 @@ public:
 
 	UFUNCTION(Category = "Composite", BlueprintCallable)
 	void SetPlanarReflectionScreenPercentage(float NewPlanarReflectionScreenPercentage);
+
+	UFUNCTION(Category = "Composite", BlueprintPure)
+	FCompositeCaptureSchedule GetPlanarReflectionCaptureSchedule() const;
+
+	UFUNCTION(Category = "Composite", BlueprintCallable)
+	void SetPlanarReflectionCaptureSchedule(const FCompositeCaptureSchedule& NewPlanarReflectionCaptureSchedule);
 	
 	UFUNCTION(Category = "Composite")
 	UCompositeColorGrade* GetCompositeColorGrade() const;
@@ -315,8 +398,56 @@ public:
 	UFUNCTION(Category = "Composite", BlueprintPure)
 	bool IsKeyerEnabled() const;
 
+	/**
+	 * Returns all settings of this Composite resolved through its parents.
+	 * The snapshot is only rebuilt when any Composite changed since it was last resolved, so reading it is O(1) regardless of the depth of the chain.
+	 */
+	const FResolvedCompositeSettings& GetResolvedSettings() const;
+
+	/**
+	 * Makes GetResolvedSettings return these settings instead of resolving them through the parents, until reset.
+	 * nDisplay cluster nodes show the settings the primary node resolved this way, see FCompositorClusterSync.
+	 */
+	void SetResolvedSettingsOverride(const TOptional<FResolvedCompositeSettings>& InResolvedSettingsOverride);
+
+	/** Bumped whenever any Composite or Composite Color Grade changes, the resolved settings of a Composite can only differ when it did. */
+	static uint32 GetSettingsGeneration() { return SettingsGeneration; }
+
+	/**
+	 * Invalidates the resolved settings of every Composite.
+	 * All setters and property edits call this already, only call it after writing to one of the bOverride_ flags directly.
+	 */
+	UFUNCTION(Category = "Composite", BlueprintCallable)
+	static void MarkSettingsDirty();
+
+	/**
+	 * Turns the override of a property on or off, i.e. ShadowsGamma for bOverride_ShadowsGamma.
+	 * The override flags are read only in Blueprint so every write invalidates the resolved settings. Returns false if the property has no override flag.
+	 */
+	UFUNCTION(Category = "Composite", BlueprintCallable)
+	bool SetPropertyOverride(FName PropertyName, bool bOverride);
+
+	/** The resolved settings hold on to the texture and keyer they resolved to, which may belong to a parent. */
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+	virtual void PostLoad() override;
+
 #if WITH_EDITOR
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 	virtual bool CanEditChange(const FProperty* InProperty) const override;
+
+	/** The property group of a Composite property, from its category. Properties outside the known categories update every group. */
+	static ECompositeUpdateFlags GetCompositeUpdateFlags(const FProperty* Property);
 #endif // WITH_EDITOR
+
+private:
+	/** Bumped whenever any Composite or Composite Color Grade changes. Only accessed from the game thread. */
+	static uint32 SettingsGeneration;
+
+	/** The settings generation the resolved settings were built for. */
+	mutable uint32 ResolvedSettingsGeneration;
+
+	mutable FResolvedCompositeSettings ResolvedSettings;
+
+	TOptional<FResolvedCompositeSettings> ResolvedSettingsOverride;
 };
@@ -7,9 +7,37 @@
 
 class UMaterialInterface;
 class UMaterialInstanceDynamic;
-class UTextureRenderTarget2D;
 class UCompositorSubsystem;
 
+enum class ECompositeKeyerParameterType : uint8
+{
+	Bool,
+	Float,
+	Double,
+	LinearColor
+};
+
+/** A property of a keyer class matching a parameter of its keyer material, shared by all keyers of that class and material. */
+struct FCompositeKeyerParameterBinding
+{
+	FName ParameterName;
+	int32 Offset;
+	ECompositeKeyerParameterType Type;
+	const FBoolProperty* BoolProperty;
+};
+
+/** A binding resolved against the material instance dynamic of a single keyer. */
+struct FCompositeKeyerParameterWrite
+{
+	int32 ParameterIndex;
+	int32 Offset;
+	ECompositeKeyerParameterType Type;
+	const FBoolProperty* BoolProperty;
+
+	/** The value last written to the material instance, scalars are stored in R. */
+	FLinearColor LastValue;
+};
+
 /**
  * 
  */
@@ -47,6 +75,19 @@ public:
 	UFUNCTION(Category = "CompositeKeyer")
 	virtual bool GetIsKeyerEnabled();
 
+	/**
+	 * Forces the CompositeKeyer to draw on its next update.
+	 * The keyer only draws when the media frame, the render target or any parameter of its material instance changed, use this when it depends on anything else.
+	 */
+	UFUNCTION(Category = "CompositeKeyer", BlueprintCallable)
+	virtual void MarkCompositeKeyerDirty();
+
+	/** Drops the parameter bindings of all keyer classes, called when a keyer blueprint or material was recompiled. */
+	static void InvalidateParameterBindings();
+
+	/** Drops the parameter bindings of keyers whose material is the given material or an instance of it, called when that material was recompiled. */
+	static void InvalidateParameterBindings(const UMaterialInterface* Material);
+
 private:
 	/** Is the CompositeKeyer enabled. */
 	UPROPERTY(Category = "CompositeKeyer", EditAnywhere, meta = (AllowPrivateAccess = "true"))
@@ -56,10 +97,18 @@ private:
 	UPROPERTY(Category = "CompositeKeyer", VisibleAnywhere, AdvancedDisplay, Transient)
 	UMaterialInstanceDynamic* CompositeKeyerMID;
 
-	UPROPERTY()
-	UTextureRenderTarget2D* MediaInputKeyedRenderTarget;
+	/** Flat list of keyer properties to write into the material instance dynamic every update. */
+	TArray<FCompositeKeyerParameterWrite> ParameterWrites;
+
+	/** The generation of the shared parameter bindings the parameter writes were built from. */
+	uint32 ParameterBindingsGeneration;
+
+	/** Builds the parameter writes from the bindings shared by all keyers with the same class and material. */
+	void InitializeParameterWrites();
+
+	/** Hash of the media frame, render target and material parameters used for the last draw, 0 when a draw is required. */
+	uint32 LastDrawHash;
 
-	TMap<int32, FBoolProperty*> BoolParametersForMID;
-	TMap<int32, float*> FloatParametersForMID;
-	TMap<int32, FLinearColor*> LinearColorParametersForMID;
+	/** Returns the hash of everything the keyed render target depends on. */
+	uint32 ComputeDrawHash(const UCompositorSubsystem* CompositorSubsystem);
 };
@@ -0,0 +1,71 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CompositeKeyer.h"
+#include "Objects/CompositeKeyerCPU.h"
+#include "CompositeKeyerColorDifference.generated.h"
+
+/**
+ * Native color difference keyer. Draws the Unreal Color Difference keyer material, or keys in the fused media pre pass when enabled.
+ */
+UCLASS(NotBlueprintable, DisplayName="Color Difference")
+class COMPOSITOR_API UCompositeKeyerColorDifference : public UCompositeKeyer
+{
+	GENERATED_BODY()
+
+public:
+	UCompositeKeyerColorDifference(const FObjectInitializer& ObjectInitializer);
+
+	/** The key settings shared by the CPU keyer and the fused media pre pass. */
+	FCompositeKeyerCPUSettings GetKeyerCPUSettings() const;
+
+	bool GetUseFusedMediaPrePass() const { return bUseFusedMediaPrePass; }
+
+	UFUNCTION(Category="Compositor|CompositeKeyer", BlueprintCallable)
+	void SetUseFusedMediaPrePass(bool bNewUseFusedMediaPrePass);
+
+protected:
+	UMaterialInterface* GetCompositeKeyerMaterial_Implementation() const override;
+
+	/** The color of the screen, its strongest channel is keyed. */
+	UPROPERTY(Category = "Color Difference", EditAnywhere, BlueprintReadOnly)
+	FLinearColor KeyColor;
+
+	/** Red channel influence, the first channel other than the key channel. */
+	UPROPERTY(Category = "Color Difference", EditAnywhere, BlueprintReadOnly)
+	float RedWeight;
+
+	/** Blue channel influence, the second channel other than the key channel. */
+	UPROPERTY(Category = "Color Difference", EditAnywhere, BlueprintReadOnly)
+	float BlueWeight;
+
+	/** Matte values at or below this are treated as screen. */
+	UPROPERTY(Category = "Color Difference", EditAnywhere, BlueprintReadOnly)
+	float AlphaThreshold;
+
+	/** Added to the matte above the threshold, good for filling interior holes. */
+	UPROPERTY(Category = "Color Difference", EditAnywhere, BlueprintReadOnly)
+	float AlphaOffset;
+
+	/** Black point of the alpha matte. */
+	UPROPERTY(Category = "Color Difference", EditAnywhere, BlueprintReadOnly)
+	float ClipBlack;
+
+	/** White point of the alpha matte. */
+	UPROPERTY(Category = "Color Difference", EditAnywhere, BlueprintReadOnly)
+	float ClipWhite;
+
+	/**
+	 * Undistorts, keys, despills and grades the media in a single compute pass instead of drawing the keyer and undistort materials.
+	 * The media color grade is baked into the keyed media, so the post process materials no longer apply it.
+	 * The key is the one of the keyer material, Plugins.Compositor.MediaPrePass.MatchesMaterial compares the two.
+	 */
+	UPROPERTY(Category = "Color Difference", EditAnywhere, BlueprintReadOnly, AdvancedDisplay)
+	bool bUseFusedMediaPrePass;
+
+private:
+	UPROPERTY(Transient)
+	UMaterialInterface* ColorDifferenceMaterial;
+};
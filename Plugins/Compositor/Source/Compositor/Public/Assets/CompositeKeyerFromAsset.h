@@ -20,6 +20,8 @@ public:
 	void UpdateCompositeKeyer(UCompositorSubsystem* CompositorSubsystem) override;
 
 	bool GetIsKeyerEnabled() override;
+
+	void MarkCompositeKeyerDirty() override;
 	
 	UFUNCTION(Category="Compositor|CompositeKeyer", BlueprintCallable)
 	void SetCompositeKeyerAsset(UCompositeKeyer* NewCompositeKeyerAsset);
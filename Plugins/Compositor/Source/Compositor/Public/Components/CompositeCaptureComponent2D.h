@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Components/SceneCaptureComponent2D.h"
 
+#include "CompositeTypes.h"
 #include "Interfaces/CompositeUpdateInterface.h"
 
 #if WITH_EDITOR
@@ -13,6 +14,7 @@
 
 #include "CompositeCaptureComponent2D.generated.h"
 
+class ACompositeMesh;
 class APlayerCameraManager;
 class UCameraComponent;
 
@@ -45,6 +47,20 @@ public:
 	virtual void OnCompositeUpdateInterfaceRegistered(TScriptInterface<ICompositeUpdateInterface> CompositeUpdateInterface){}
 	virtual void OnCompositeUpdateInterfaceUnregistered(TScriptInterface<ICompositeUpdateInterface> CompositeUpdateInterface){}
 
+	/** The composite meshes the subsystem registered from its queue in one tick, reported to OnCompositeUpdateInterfaceRegistered one by one unless overridden. */
+	virtual void OnCompositeMeshesRegistered(TArrayView<ACompositeMesh* const> CompositeMeshes);
+
+	/** The schedule deciding on which frames this capture renders. */
+	virtual FCompositeCaptureSchedule GetCaptureSchedule() const;
+
+	/** Makes the next tick capture the scene regardless of the schedule, i.e. when the captured components changed. */
+	void RequestCapture() { bCaptureRequested = true; }
+
+	UTextureRenderTarget2D* GetMaterialTextureTarget() const { return MaterialTextureTarget; }
+
+	/** The render target bound to the material texture target while this capture is active. */
+	virtual UTextureRenderTarget2D* GetBoundTextureTarget() const { return TextureTarget; }
+
 protected:
 	UPROPERTY(Transient)
 	bool bAllowDebugEditorCamera;
@@ -68,17 +84,50 @@ protected:
 	UPROPERTY(Transient)
 	UCompositeWorldData* CompositeWorldData;
 
+	/** The render target asset materials sample, the pooled texture target is bound to it while this capture is active. */
+	UPROPERTY(Transient)
+	UTextureRenderTarget2D* MaterialTextureTarget;
+
 	FVector PlanarCameraLocation;
 	FRotator PlanarCameraRotation;
 	
+	/** Size of the texture target at the screen percentage, snapped to the size buckets of the render target pool. */
+	FIntPoint GetTargetTextureSize() const;
+
 	virtual void UpdateCameraData(FVector& OutLocation, FRotator& OutRotation, float& OutFieldOfView, FVector& OutClipPlaneBase, FVector& OutClipBaseNormal) const;
 
+	/** The frame parity this capture renders on in the staggered update mode. */
+	virtual uint32 GetStaggeredCaptureSlot() const { return 0; }
+
+	/** Renders the capture on the frames the schedule picks, a scene capture unless overridden. */
+	virtual void CaptureComposite() { CaptureSceneDeferred(); }
+
+	/** Remembers the camera the capture renders from, which the camera change schedule compares against. */
+	void RecordCaptureCamera(FVector& OutClipPlaneBase, FVector& OutClipPlaneNormal);
+
 public:
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
 	void UpdateSceneCaptureContents(FSceneInterface* Scene) override;
 
 private:
+	/** Whether the schedule wants a capture this frame, the render target is always captured when its contents are stale. */
+	bool ShouldCaptureThisFrame(const FCompositeCaptureSchedule& CaptureSchedule) const;
 
 	float PreviousScreenPercentage;
+
+	/** Set when the render target no longer shows the current state, i.e. after a resize or when capturing got activated. */
+	bool bCaptureRequested;
+
+	bool bWasCaptureActive;
+
+	uint64 LastCaptureFrame;
+
+	uint32 LastCaptureMediaFrameHash;
+
+	FVector LastCaptureLocation;
+
+	FRotator LastCaptureRotation;
+
+	float LastCaptureFieldOfView;
 };
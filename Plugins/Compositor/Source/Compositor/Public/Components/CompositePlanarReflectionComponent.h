@@ -21,6 +21,54 @@ public:
 
 	virtual bool GetIsCompositeCaptureActive() const;
 
+	virtual FCompositeCaptureSchedule GetCaptureSchedule() const override;
+
+	virtual void UpdateSceneCaptureContents(FSceneInterface* Scene) override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	/** Show only actors the last capture kept after culling. */
+	int32 GetNumCapturedActors() const { return NumCapturedActors; }
+
+	/** Primitive components of the actors the last capture kept after culling. */
+	int32 GetNumCapturedPrimitives() const { return NumCapturedPrimitives; }
+
 protected:
 	virtual void UpdateCameraData(FVector& OutLocation, FRotator& OutRotation, float& OutFieldOfView, FVector& OutClipPlaneBase, FVector& OutClipBaseNormal) const override;
+
+	/** Renders on the frames the soft mask skips. */
+	virtual uint32 GetStaggeredCaptureSlot() const override { return 1; }
+
+private:
+	/** Sets the show flags of the lighting mode. */
+	void ApplyLightingMode();
+
+	/** The show only actors the reflection camera can see, nearest first and cut off at the budget. */
+	void CullShowOnlyActors(const FVector& CameraLocation, const FRotator& CameraRotation, float CameraFieldOfView, const FVector& CameraClipPlaneBase, const FVector& CameraClipPlaneNormal, TArray<TObjectPtr<AActor>>& OutActors) const;
+
+	/** Leave out show only actors outside the mirrored view frustum, below the reflection plane or beyond the cull distance. */
+	UPROPERTY(Category = "PlanarReflectionCulling", EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"))
+	bool bCullShowOnlyActors;
+
+	/** Show only actors further than this from the reflection camera are left out, 0 keeps them at any distance. */
+	UPROPERTY(Category = "PlanarReflectionCulling", EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", ClampMin = "0", Units = "cm", EditCondition = "bCullShowOnlyActors"))
+	float CullDistance;
+
+	/** Most show only actors captured, the nearest ones are kept. 0 captures all of them. */
+	UPROPERTY(Category = "PlanarReflectionCulling", EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", ClampMin = "0", EditCondition = "bCullShowOnlyActors"))
+	int32 MaxCapturedActors;
+
+	/** How the reflection is lit, the simpler modes trade the look of the reflection for a cheaper capture. */
+	UPROPERTY(Category = "PlanarReflectionCulling", EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"))
+	ECompositePlanarReflectionLighting LightingMode;
+
+	/** Show only actors the last capture kept after culling. */
+	UPROPERTY(Category = "PlanarReflectionCulling", VisibleInstanceOnly, Transient, meta = (AllowPrivateAccess = "true"))
+	int32 NumCapturedActors;
+
+	/** Primitive components of the actors the last capture kept after culling. */
+	UPROPERTY(Category = "PlanarReflectionCulling", VisibleInstanceOnly, Transient, meta = (AllowPrivateAccess = "true"))
+	int32 NumCapturedPrimitives;
 };
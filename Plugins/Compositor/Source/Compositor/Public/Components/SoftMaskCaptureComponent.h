@@ -21,6 +21,32 @@ public:
 
 	virtual void OnCompositeUpdateInterfaceRegistered(TScriptInterface<ICompositeUpdateInterface> CompositeUpdateInterface) override;
 	virtual void OnCompositeUpdateInterfaceUnregistered(TScriptInterface<ICompositeUpdateInterface> CompositeUpdateInterface) override;
+	virtual void OnCompositeMeshesRegistered(TArrayView<ACompositeMesh* const> CompositeMeshes) override;
 
 	virtual float GetTargetTextureScreenPercentage() const override;
+
+	virtual FCompositeCaptureSchedule GetCaptureSchedule() const override;
+
+	virtual void UpdateRenderTargetSize() override;
+
+	virtual UTextureRenderTarget2D* GetBoundTextureTarget() const override;
+
+	virtual void OnUnregister() override;
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	/** Draws the soft mask with the mesh pass of the composite view instead of the scene capture when the world asks for it. */
+	virtual void CaptureComposite() override;
+
+private:
+	/** How many times smaller than the soft mask the scene capture renders in each direction. */
+	int32 GetCaptureResolutionDivisor() const;
+
+	/** Stops the upsample and hands the upsampled render target back to the pool, when capturing at full resolution again. */
+	void ReleaseUpsampledTextureTarget();
+
+	/** The soft mask at the screen percentage the low resolution capture is upsampled into, null when capturing at full resolution. */
+	UPROPERTY(Transient)
+	UTextureRenderTarget2D* UpsampledTextureTarget;
 };
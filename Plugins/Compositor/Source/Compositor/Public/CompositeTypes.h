@@ -86,3 +86,121 @@ enum class ERenderSoftMaskType : uint8
 	/** Render as translucent vertex color alpha geometry into the soft mask.	*/
 	TranslucentVertexColorAlpha
 };
+
+UENUM(BlueprintType)
+enum class ESoftMaskCaptureResolution : uint8
+{
+	/** Capture the soft mask at the full Soft Mask Screen Percentage and sample it directly. */
+	Full,
+
+	/** Capture at half the width and height, a quarter of the pixels, and upsample guided by the custom depth of the composite meshes. */
+	Half,
+
+	/** Capture at a quarter of the width and height, a sixteenth of the pixels, and upsample guided by the custom depth of the composite meshes. */
+	Quarter
+};
+
+UENUM(BlueprintType)
+enum class ECompositePlanarReflectionLighting : uint8
+{
+	/** Deferred lighting with the sky light, reflection environment and global illumination, like the main view. */
+	Full,
+
+	/** Direct lighting and the sky light only, skipping the reflection environment and global illumination. */
+	Simplified,
+
+	/** No lighting at all, the reflection shows the base color of the reflected actors. */
+	Unlit
+};
+
+UENUM(BlueprintType)
+enum class ECompositeSoftMaskRenderer : uint8
+{
+	/** Render the soft mask meshes with a scene capture, using their soft mask materials. */
+	SceneCapture,
+
+	/**
+	 * Draw the soft mask meshes in a render graph pass of the composite view, with the matrices of each of its views.
+	 * Skips the scene renderer setup of a scene capture, but ignores the soft mask materials and always draws the first LOD.
+	 */
+	MeshPass
+};
+
+/**
+ * The groups of Composite properties a composite update carries, one per category of the Composite details.
+ * Composite update listeners subscribe to the groups they read and are only called when one of them changed.
+ */
+UENUM(meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class ECompositeUpdateFlags : uint16
+{
+	None = 0 UMETA(Hidden),
+	MediaInput = 1 << 0,
+	SoftMask = 1 << 1,
+	Keyer = 1 << 2,
+	Shadows = 1 << 3,
+	PlanarReflection = 1 << 4,
+	ColorGrade = 1 << 5,
+	MediaIntegration = 1 << 6,
+	Output = 1 << 7,
+
+	/** A different Composite or parent, every group may have changed. */
+	All = 0xFF UMETA(Hidden)
+};
+ENUM_CLASS_FLAGS(ECompositeUpdateFlags);
+
+UENUM(BlueprintType)
+enum class ECompositeCaptureUpdateMode : uint8
+{
+	/** Capture the scene every frame. */
+	EveryFrame,
+
+	/** Capture the scene once every Frame Interval frames. */
+	EveryNFrames,
+
+	/**
+	* Only capture the scene when the camera moved, rotated or zoomed more than the thresholds.
+	* Scene changes are not detected, use Max Frames Between Captures if the captured actors move during locked off shots.
+	*/
+	OnCameraChange,
+
+	/** Only capture the scene when the media input shows a new frame. */
+	OnMediaFrame,
+
+	/**
+	* Capture the soft mask and the planar reflection on alternating frames.
+	* Halves the capture cost when both are active, at the cost of one frame of latency for each of them.
+	*/
+	Staggered
+};
+
+/**
+ * When a Composite scene capture renders.
+ */
+USTRUCT(BlueprintType)
+struct FCompositeCaptureSchedule
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Category = "Capture Schedule", EditAnywhere, BlueprintReadWrite)
+	ECompositeCaptureUpdateMode UpdateMode = ECompositeCaptureUpdateMode::EveryFrame;
+
+	/** Number of frames from one capture to the next. */
+	UPROPERTY(Category = "Capture Schedule", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1", UIMax = "8", EditCondition = "UpdateMode == ECompositeCaptureUpdateMode::EveryNFrames", EditConditionHides))
+	int32 FrameInterval = 2;
+
+	/** Distance the camera has to move before the scene is captured again. */
+	UPROPERTY(Category = "Capture Schedule", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", Units = "cm", EditCondition = "UpdateMode == ECompositeCaptureUpdateMode::OnCameraChange", EditConditionHides))
+	float LocationThreshold = 0.1F;
+
+	/** Angle the camera has to rotate before the scene is captured again. */
+	UPROPERTY(Category = "Capture Schedule", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", Units = "deg", EditCondition = "UpdateMode == ECompositeCaptureUpdateMode::OnCameraChange", EditConditionHides))
+	float RotationThreshold = 0.01F;
+
+	/** Change in field of view before the scene is captured again. */
+	UPROPERTY(Category = "Capture Schedule", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", Units = "deg", EditCondition = "UpdateMode == ECompositeCaptureUpdateMode::OnCameraChange", EditConditionHides))
+	float FieldOfViewThreshold = 0.01F;
+
+	/** Capture anyway when this many frames passed without a capture, so changes in the scene still show up. 0 never forces a capture. */
+	UPROPERTY(Category = "Capture Schedule", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", EditCondition = "UpdateMode == ECompositeCaptureUpdateMode::OnCameraChange || UpdateMode == ECompositeCaptureUpdateMode::OnMediaFrame", EditConditionHides))
+	int32 MaxFramesBetweenCaptures = 0;
+};
@@ -4,6 +4,8 @@
 
 #include "Modules/ModuleManager.h"
 
+class UMaterialInterface;
+
 class FCompositorModule : public IModuleInterface
 {
 public:
@@ -12,4 +14,10 @@ public:
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
 
+private:
+#if WITH_EDITOR
+	void OnBlueprintCompiled();
+	void OnMaterialCompilationFinished(UMaterialInterface* MaterialInterface);
+#endif
+
 };
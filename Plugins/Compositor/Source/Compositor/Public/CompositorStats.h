@@ -0,0 +1,86 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/RealtimeGPUProfiler.h"
+#include "Trace/Trace.h"
+
+DECLARE_STATS_GROUP(TEXT("Compositor"), STATGROUP_Compositor, STATCAT_Advanced);
+
+/** Trace channel for the Compositor, enable it with -trace=cpu,gpu,compositor to see its scopes in Unreal Insights. */
+UE_TRACE_CHANNEL_EXTERN(CompositorChannel, COMPOSITOR_API);
+
+/** GPU time of the Compositor render passes. */
+DECLARE_GPU_STAT_NAMED_EXTERN(Compositor, TEXT("Compositor"));
+
+// Game thread.
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tick"), STAT_CompositorTick, STATGROUP_Compositor, COMPOSITOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Lens Data"), STAT_CompositorUpdateLensData, STATGROUP_Compositor, COMPOSITOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Composite Keyer"), STAT_CompositorUpdateCompositeKeyer, STATGROUP_Compositor, COMPOSITOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Composite Viewport Info"), STAT_CompositorUpdateCompositeViewportInfo, STATGROUP_Compositor, COMPOSITOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Compute Composite Post Process"), STAT_CompositorComputeCompositePostProcess, STATGROUP_Compositor, COMPOSITOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Composite Update"), STAT_CompositorCompositeUpdate, STATGROUP_Compositor, COMPOSITOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Composite Mesh Registration"), STAT_CompositorCompositeMeshRegistration, STATGROUP_Compositor, COMPOSITOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Setup View"), STAT_CompositorSetupView, STATGROUP_Compositor, COMPOSITOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Capture Tick"), STAT_CompositorCaptureTick, STATGROUP_Compositor, COMPOSITOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Capture Update"), STAT_CompositorCaptureUpdate, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Draws into the keyed media render target, by a keyer or the fallback material. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Keyer Draws"), STAT_CompositorKeyerDraws, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Draws into the undistorted media render target. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Undistort Draws"), STAT_CompositorUndistortDraws, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Scene captures rendered by the soft mask and planar reflection. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Capture Renders"), STAT_CompositorCaptureRenders, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Show only actors and their primitives the last planar reflection capture kept after culling. */
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Planar Reflection Actors"), STAT_CompositorPlanarReflectionActors, STATGROUP_Compositor, COMPOSITOR_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Planar Reflection Primitives"), STAT_CompositorPlanarReflectionPrimitives, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Composite update listeners called, and skipped because they are not subscribed to the property groups that changed. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Composite Update Listeners"), STAT_CompositorCompositeUpdateListeners, STATGROUP_Compositor, COMPOSITOR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Composite Update Listeners Skipped"), STAT_CompositorCompositeUpdateListenersSkipped, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Composite meshes registered from the queue this frame, and the ones still waiting for a later frame. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Composite Meshes Registered"), STAT_CompositorCompositeMeshesRegistered, STATGROUP_Compositor, COMPOSITOR_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Composite Meshes Queued"), STAT_CompositorCompositeMeshesQueued, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Meshes the soft mask mesh pass was asked to draw. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Soft Mask Mesh Draws"), STAT_CompositorSoftMaskMeshDraws, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Compositor render targets that were resized this frame. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Render Target Resizes"), STAT_CompositorRenderTargetResizes, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Render targets the pool had to allocate because no released one matched. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Render Target Allocations"), STAT_CompositorRenderTargetAllocations, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Material parameter collection values forwarded to the collection instance this frame. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("MPC Parameters Written"), STAT_CompositorMPCParametersWritten, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Material parameter collection values that were staged but did not change this frame. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("MPC Parameters Skipped"), STAT_CompositorMPCParametersSkipped, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Media samples that left the media frame queue without being composited. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Media Frames Dropped"), STAT_CompositorMediaFramesDropped, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Engine frames that composited the same media sample as the frame before. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Media Frames Repeated"), STAT_CompositorMediaFramesRepeated, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** GPU memory of the pooled render targets the Compositor draws into, including the released ones kept for reuse. */
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Render Target Memory"), STAT_CompositorRenderTargetMemory, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** GPU memory of the released render targets the pool keeps alive for reuse. */
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Render Target Pool Free Memory"), STAT_CompositorRenderTargetPoolFreeMemory, STATGROUP_Compositor, COMPOSITOR_API);
+
+/** Scoped cycle counter that also shows up as a CPU scope on the Compositor trace channel. */
+#define COMPOSITOR_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, CompositorChannel)
+
+/** Event and GPU stat scope for Compositor render graph passes. */
+#define COMPOSITOR_RDG_EVENT_SCOPE(GraphBuilder, Name) \
+	RDG_EVENT_SCOPE(GraphBuilder, Name); \
+	RDG_GPU_STAT_SCOPE(GraphBuilder, Compositor)
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "UObject/ObjectMacros.h"
 #include "UObject/Interface.h"
+#include "CompositeTypes.h"
 #include "CompositeUpdateInterface.generated.h"
 
 class UComposite;
@@ -20,6 +21,9 @@ class COMPOSITOR_API ICompositeUpdateInterface
 	GENERATED_BODY()
 
 public:
-	/** Called whenever a composite related to the world is updated. */
-	virtual void OnCompositeUpdate(UComposite& InWorldComposite) = 0;
+	/** Called whenever a composite related to the world is updated, UpdateFlags holds the property groups that changed. */
+	virtual void OnCompositeUpdate(UComposite& InWorldComposite, ECompositeUpdateFlags UpdateFlags) = 0;
+
+	/** The property groups this listener reads, updates changing none of them skip it. Newly registered listeners are always updated. */
+	virtual ECompositeUpdateFlags GetCompositeUpdateSubscription() const { return ECompositeUpdateFlags::All; }
 };
\ No newline at end of file
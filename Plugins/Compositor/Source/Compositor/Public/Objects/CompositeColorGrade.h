@@ -17,13 +17,13 @@ class COMPOSITOR_API UCompositeColorGrade : public UObject
 public:
 	UCompositeColorGrade();
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Color Grading", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Color Grading", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_ColorGradeScene : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Color Grading", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Color Grading", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_ColorGradeMedia : 1;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Color Grading", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Color Grading", meta = (AllowPrivateAccess = "true", InlineEditConditionToggle))
 	uint8 bOverride_ColorGradeCombined : 1;
 
 private:
@@ -66,4 +66,15 @@ public:
 
 	UFUNCTION(Category = "Color Grading", BlueprintCallable)
 	void SetColorGradeCombined(FColorGradePerRangeSettings NewColorGradeCombined);
+
+	/**
+	 * Turns the override of a color grade on or off, i.e. ColorGradeMedia for bOverride_ColorGradeMedia.
+	 * The override flags are read only in Blueprint so every write invalidates the resolved settings. Returns false if the property has no override flag.
+	 */
+	UFUNCTION(Category = "Color Grading", BlueprintCallable)
+	bool SetPropertyOverride(FName PropertyName, bool bOverride);
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif // WITH_EDITOR
 };
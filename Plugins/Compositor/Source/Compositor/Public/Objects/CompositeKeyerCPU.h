@@ -0,0 +1,114 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/Scene.h" // FColorGradePerRangeSettings
+
+/**
+ * Settings of the color difference key, matching the parameters of the Unreal Color Difference keyer material.
+ * The key channel is the strongest channel of the key color, the two other channels are weighted in RGB order,
+ * so for a green or blue screen the first one is red and for a green screen the second one is blue.
+ */
+struct COMPOSITOR_API FCompositeKeyerCPUSettings
+{
+	/** The color of the screen, its strongest channel is used as the key channel. */
+	FLinearColor KeyColor = FLinearColor(0.F, 1.F, 0.F, 1.F);
+
+	/** Influence of the first other channel on the color difference. */
+	float RedWeight = 0.5F;
+
+	/** Influence of the second other channel on the color difference. */
+	float BlueWeight = 0.5F;
+
+	/** Matte values at or below this are treated as screen. */
+	float AlphaThreshold = 0.F;
+
+	/** Added to the matte values above the threshold, good for filling interior holes. */
+	float AlphaOffset = 0.F;
+
+	/** Black point of the alpha matte, values below become fully transparent. */
+	float ClipBlack = 0.F;
+
+	/** White point of the alpha matte, values above become fully opaque. */
+	float ClipWhite = 1.F;
+};
+
+/**
+ * Global range of the media color grade, applied after the key by the fused media pre pass.
+ * The alpha of every value multiplies its color, like the color grading of the post process settings.
+ */
+struct COMPOSITOR_API FCompositeKeyerCPUGrade
+{
+	FCompositeKeyerCPUGrade() = default;
+
+	explicit FCompositeKeyerCPUGrade(const FColorGradePerRangeSettings& InSettings);
+
+	FVector4f Saturation = FVector4f(1.F, 1.F, 1.F, 1.F);
+	FVector4f Contrast = FVector4f(1.F, 1.F, 1.F, 1.F);
+	FVector4f Gamma = FVector4f(1.F, 1.F, 1.F, 1.F);
+	FVector4f Gain = FVector4f(1.F, 1.F, 1.F, 1.F);
+	FVector4f Offset = FVector4f(0.F, 0.F, 0.F, 0.F);
+};
+
+/**
+ * Native implementation of the DiffColorKeyer and DespillByAvg material functions the Unreal Color Difference keyer material is built from.
+ * Used where there is no GPU to run the keyer material on, the keyer tests check it against the material.
+ * Rows are keyed in parallel, pixels are processed four at a time with the platform vector intrinsics.
+ */
+class COMPOSITOR_API FCompositeKeyerCPU
+{
+public:
+	explicit FCompositeKeyerCPU(const FCompositeKeyerCPUSettings& InSettings = FCompositeKeyerCPUSettings());
+
+	void SetSettings(const FCompositeKeyerCPUSettings& InSettings);
+
+	FORCEINLINE const FCompositeKeyerCPUSettings& GetSettings() const { return Settings; }
+
+	/** Keys a tightly packed linear frame. Source and destination may be the same buffer. */
+	void Key(const FLinearColor* Source, FLinearColor* Destination, FIntPoint Size) const;
+
+	/** Keys a tightly packed 8 bit sRGB frame. */
+	void Key(const FColor* Source, FLinearColor* Destination, FIntPoint Size) const;
+
+	/** Keys a tightly packed 10 bit linear frame, with red in the lowest bits and a 2 bit alpha. */
+	void KeyRGB10A2(const uint32* Source, FLinearColor* Destination, FIntPoint Size) const;
+
+	/**
+	 * Reference of the fused media pre pass, verifies its output without a GPU.
+	 * Every destination pixel samples the displacement map at its UV, samples the source bilinearly at the displaced UV, then keys and grades the result.
+	 * Displacement holds UV offsets like the undistortion displacement map and may be null to skip the undistortion.
+	 */
+	void KeyUndistortGrade(const FLinearColor* Source, FIntPoint SourceSize, const FVector2f* Displacement, FIntPoint DisplacementSize, const FCompositeKeyerCPUGrade& Grade, FLinearColor* Destination, FIntPoint DestinationSize) const;
+
+	/** Scalar reference of the key for a single pixel. */
+	static FLinearColor KeyPixel(const FCompositeKeyerCPUSettings& InSettings, const FLinearColor& Pixel);
+
+	/** Scalar reference of the grade for a single pixel, alpha is left untouched. */
+	static FLinearColor GradePixel(const FCompositeKeyerCPUGrade& Grade, const FLinearColor& Pixel);
+
+	/** Keys generated 1080p and 2160p frames in every supported format and logs the throughput. */
+	static void RunBenchmark(int32 NumFrames);
+
+public:
+	/** Settings derived values used by the kernels. */
+	struct FConstants
+	{
+		int32 KeyChannel;
+		float Weight1;
+		float Weight2;
+		float InvKeyDifference;
+		float AlphaThreshold;
+		float AlphaOffset;
+		float ClipBlack;
+		float InvClipRange;
+	};
+
+	/** The derived values the fused media pre pass passes to its shader. */
+	FORCEINLINE const FConstants& GetConstants() const { return Constants; }
+
+private:
+	FCompositeKeyerCPUSettings Settings;
+
+	FConstants Constants;
+};
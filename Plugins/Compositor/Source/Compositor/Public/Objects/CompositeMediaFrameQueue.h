@@ -0,0 +1,98 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IMediaTextureSample.h"
+#include "MediaSampleSink.h"
+#include "Misc/QualifiedFrameTime.h"
+
+#include <atomic>
+
+/**
+ * Counts the video samples a media player delivers without holding on to any of them.
+ * The count identifies the frame the media texture shows, it advances for live sources on a paused player and stays put when the player clock jitters.
+ */
+class COMPOSITOR_API FCompositeMediaSampleCounter : public FMediaTextureSampleSink
+{
+public:
+	//~ Begin TMediaSampleSink Interface
+	virtual bool Enqueue(const TSharedRef<IMediaTextureSample, ESPMode::ThreadSafe>& Sample) override;
+	virtual int32 Num() const override { return 0; }
+	virtual bool CanAcceptSamples(int32 NumSamples) const override { return true; }
+	virtual void RequestFlush() override {}
+	//~ End TMediaSampleSink Interface
+
+	/** Samples delivered since the counter was attached, zero while the player feeds no sample sinks. */
+	uint32 GetNumSamples() const { return NumReceivedSamples.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<uint32> NumReceivedSamples{ 0 };
+};
+
+/**
+ * Holds the latest video samples of a media player, so the composite can show the sample that belongs to the engine frame
+ * instead of whatever the media texture currently holds.
+ * Samples are pushed from the media player's sample sink on any thread and selected on the game thread once per frame.
+ */
+class COMPOSITOR_API FCompositeMediaFrameQueue : public FMediaTextureSampleSink
+{
+public:
+	explicit FCompositeMediaFrameQueue(int32 InCapacity);
+
+	//~ Begin TMediaSampleSink Interface
+	virtual bool Enqueue(const TSharedRef<IMediaTextureSample, ESPMode::ThreadSafe>& Sample) override;
+	virtual int32 Num() const override;
+	virtual bool CanAcceptSamples(int32 NumSamples) const override { return true; }
+	virtual void RequestFlush() override;
+	//~ End TMediaSampleSink Interface
+
+	/**
+	 * Selects the sample to composite this frame.
+	 * With an engine frame time and timecoded samples, picks the newest sample at or before the engine timecode minus the delay.
+	 * Otherwise picks the sample the delay number of samples before the newest one.
+	 * The previous sample is kept, and counted as repeated, when nothing newer qualifies.
+	 */
+	void SelectFrame(const TOptional<FQualifiedFrameTime>& EngineFrameTime, int32 DelayFrames);
+
+	/** The sample selected by the last SelectFrame, null before the first sample arrived. */
+	const TSharedPtr<IMediaTextureSample, ESPMode::ThreadSafe>& GetSelectedSample() const { return SelectedSample; }
+
+	/**
+	 * Whether the media passes can sample the texture of the sample as RGB.
+	 * YUV and compressed samples need the conversion the media texture does, those are read through the media texture instead.
+	 */
+	static bool IsSampleFormatSupported(const IMediaTextureSample& Sample);
+
+	int32 GetCapacity() const { return Slots.Num(); }
+
+	/** Number of samples that left the queue without ever being selected. */
+	uint32 GetNumDroppedFrames() const { return NumDroppedFrames; }
+
+	/** Number of frames the previously selected sample was shown again. */
+	uint32 GetNumRepeatedFrames() const { return NumRepeatedFrames; }
+
+private:
+	struct FSlot
+	{
+		TSharedPtr<IMediaTextureSample, ESPMode::ThreadSafe> Sample;
+		bool bWasSelected = false;
+	};
+
+	/** Removes the oldest sample, counting it as dropped if it was never selected. Expects the lock to be held. */
+	void PopOldest();
+
+	FSlot& GetSlot(int32 Index) { return Slots[(Head + Index) % Slots.Num()]; }
+
+	mutable FCriticalSection CriticalSection;
+
+	/** Ring buffer of samples from oldest to newest, starting at Head. */
+	TArray<FSlot> Slots;
+	int32 Head = 0;
+	int32 Count = 0;
+
+	TSharedPtr<IMediaTextureSample, ESPMode::ThreadSafe> SelectedSample;
+
+	uint32 NumDroppedFrames = 0;
+	uint32 NumRepeatedFrames = 0;
+};
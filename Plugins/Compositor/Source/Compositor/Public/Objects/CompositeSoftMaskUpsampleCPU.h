@@ -0,0 +1,43 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Settings of the joint bilateral upsample of a low resolution soft mask capture.
+ */
+struct COMPOSITOR_API FCompositeSoftMaskUpsampleCPUSettings
+{
+	/** Depth difference relative to the output pixel depth at which a low resolution sample mostly stops contributing. */
+	float DepthSigma = 0.05F;
+
+	/** How much of the previous frame is kept. The previous frame is clamped to the low resolution samples, so moving edges do not smear. */
+	float TemporalWeight = 0.5F;
+
+	/** Ignores the depths and only filters bilinearly, like sampling the low resolution soft mask directly. */
+	bool bBilinearOnly = false;
+};
+
+/**
+ * Native implementation of the soft mask upsample pass.
+ * Every output pixel filters the four nearest low resolution samples bilinearly, weighted by how close their depth is to the depth of the output pixel,
+ * so samples from a different composite mesh or the background do not bleed across its edges.
+ * Used as the reference the upsample shader is compared against and to measure the error of the low resolution captures.
+ */
+class COMPOSITOR_API FCompositeSoftMaskUpsampleCPU
+{
+public:
+	/** Depth of pixels without a composite mesh. The capture stores depth in a half float alpha, so this is the largest half float. */
+	static constexpr float FarDepth = 65504.F;
+
+	/**
+	 * Upsamples a tightly packed low resolution soft mask.
+	 * LowResDepth and Depth are linear depths, with FarDepth where there is no composite mesh. Depth has the size of the destination.
+	 * History is the destination of the previous frame and may be null to skip the temporal accumulation. It may be the same buffer as the destination.
+	 */
+	static void Upsample(const FCompositeSoftMaskUpsampleCPUSettings& Settings, const float* LowResMask, const float* LowResDepth, FIntPoint LowResSize, const float* Depth, const float* History, float* Destination, FIntPoint Size);
+
+	/** Scalar reference of the upsample for a single output pixel. */
+	static float UpsamplePixel(const FCompositeSoftMaskUpsampleCPUSettings& Settings, const float* LowResMask, const float* LowResDepth, FIntPoint LowResSize, FVector2f UV, float PixelDepth, const float* PixelHistory);
+};
@@ -0,0 +1,59 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/CompositeUpdateInterface.h"
+#include "UObject/ObjectKey.h"
+
+#include "CompositeUpdateRegistry.generated.h"
+
+class ACompositeMesh;
+
+/**
+ * All the Composite Update Interfaces registered in a world.
+ * Composite meshes are kept in their own typed list so the subsystem can walk them without going through the interface,
+ * every other interface is kept in a second list. Both lists are dense and remove by swapping in the last entry,
+ * the index of each object is hashed so adding and removing stay constant time when a streamed level brings hundreds of meshes at once.
+ */
+USTRUCT()
+struct COMPOSITOR_API FCompositeUpdateRegistry
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns false if the object is already registered. */
+	bool Add(const TScriptInterface<ICompositeUpdateInterface>& CompositeUpdateInterface);
+
+	/** Returns false if the object was not registered. */
+	bool Remove(const TScriptInterface<ICompositeUpdateInterface>& CompositeUpdateInterface);
+
+	void Reset();
+
+	FORCEINLINE bool Contains(const UObject* Object) const { return Indices.Contains(FObjectKey(Object)); }
+
+	FORCEINLINE int32 Num() const { return CompositeMeshes.Num() + Interfaces.Num(); }
+
+	/** The registered composite meshes, in no particular order. */
+	FORCEINLINE TArrayView<ACompositeMesh* const> GetCompositeMeshes() const { return CompositeMeshes; }
+
+	/** The registered interfaces that are not composite meshes, in no particular order. */
+	FORCEINLINE TArrayView<const TScriptInterface<ICompositeUpdateInterface>> GetInterfaces() const { return Interfaces; }
+
+private:
+	template<typename ElementType>
+	void RemoveAtSwap(TArray<ElementType>& Array, TArray<FObjectKey>& Keys, int32 Index);
+
+	UPROPERTY(VisibleAnywhere, Transient, Category = "Compositor|Subsystem")
+	TArray<ACompositeMesh*> CompositeMeshes;
+
+	UPROPERTY(VisibleAnywhere, Transient, Category = "Compositor|Subsystem")
+	TArray<TScriptInterface<ICompositeUpdateInterface>> Interfaces;
+
+	/** Keys of the entries of both lists, these stay valid when the garbage collector clears an entry. */
+	TArray<FObjectKey> CompositeMeshKeys;
+	TArray<FObjectKey> InterfaceKeys;
+
+	/** Index of every registered object in the list it is kept in. */
+	TMap<FObjectKey, int32> Indices;
+};
@@ -3,8 +3,113 @@
 #pragma once
 
 #include "SceneViewExtension.h"
+#include "RendererInterface.h" // IPooledRenderTarget
+#include "Objects/CompositeKeyerCPU.h"
+#include "Objects/CompositeSoftMaskUpsampleCPU.h"
+#include "CompositeSoftMaskMeshPass.h"
+#include "CompositeTypes.h"
+#include "IMediaTextureSample.h"
+
+#include <atomic>
 
 class UCompositorSubsystem;
+class UWorld;
+class FTextureResource;
+class FTextureRenderTargetResource;
+class FTextureReference;
+class FStaticMeshRenderData;
+
+/** What the media pre pass does before the composite view renders. */
+enum class ECompositeMediaPrePassMode : uint8
+{
+	/** Undistorts, keys and grades the media into the undistorted render target. */
+	Fused,
+
+	/** Copies the media into the keyed render target and undistorts it, used when there is no keyer. */
+	Fallback,
+
+	/** Undistorts the keyed render target a keyer material drew into. */
+	Undistort,
+
+	/** Undistorts the media directly with an opaque alpha, used when there is no keyer and the keyed render target is not needed. */
+	PassThrough,
+};
+
+/** Everything the media pre pass reads, captured on the game thread. */
+struct FCompositeMediaPrePassRequest
+{
+	ECompositeMediaPrePassMode Mode = ECompositeMediaPrePassMode::Fused;
+
+	/** Runs before every frame until replaced or cleared instead of once, for media that receives frames on the render thread. */
+	bool bEveryFrame = false;
+
+	FTextureResource* MediaTexture = nullptr;
+
+	/** The sample picked by the media frame queue, read instead of the media texture when it has a texture. */
+	TSharedPtr<IMediaTextureSample, ESPMode::ThreadSafe> MediaSample;
+
+	/** The lens displacement map, null skips the undistortion. */
+	FTextureResource* UndistortTexture = nullptr;
+
+	FTextureRenderTargetResource* KeyedTexture = nullptr;
+
+	FTextureRenderTargetResource* OutputTexture = nullptr;
+
+	FCompositeKeyerCPU::FConstants KeyerConstants;
+
+	FCompositeKeyerCPUGrade Grade;
+};
+
+/** The low resolution soft mask capture and the render target it is upsampled into, captured on the game thread. */
+struct FCompositeSoftMaskUpsampleRequest
+{
+	/** The capture with the mask in red and the linear scene depth in alpha. */
+	FTextureRenderTargetResource* SoftMaskTexture = nullptr;
+
+	/** The render target bound to the soft mask asset, needs UAV support. */
+	FTextureRenderTargetResource* OutputTexture = nullptr;
+
+	FCompositeSoftMaskUpsampleCPUSettings Settings;
+};
+
+/** A composite mesh the soft mask mesh pass draws, captured on the game thread. */
+struct FCompositeSoftMaskMesh
+{
+	/** Resolved into vertex and index buffers on the render thread, before the mesh could release them. */
+	const FStaticMeshRenderData* RenderData = nullptr;
+
+	FMatrix LocalToWorld = FMatrix::Identity;
+
+	ERenderSoftMaskType RenderSoftMask = ERenderSoftMaskType::OpaqueWhite;
+
+	bool bTwoSided = false;
+};
+
+/** The render target the soft mask mesh pass draws into and the meshes it draws, captured on the game thread. */
+struct FCompositeSoftMaskMeshPassRequest
+{
+	FTextureRenderTargetResource* OutputTexture = nullptr;
+
+	TArray<FCompositeSoftMaskMesh> Meshes;
+};
+
+/** A render target asset materials sample, and the texture of this world it reads while the views of this world render. */
+struct FCompositeMaterialTextureBinding
+{
+	FTextureReference* TextureReference = nullptr;
+
+	/** The asset's own texture when nothing in this world is bound to it. */
+	FTextureResource* BoundTexture = nullptr;
+
+	/** The asset's own texture, what every other world reads. */
+	FTextureResource* OwnTexture = nullptr;
+
+	/** Points the texture reference at the bound texture, every material sampling the asset reads it from then on. */
+	void Apply_RenderThread(FRHICommandListImmediate& RHICmdList) const;
+
+	/** Points the texture reference back at the asset's own texture. */
+	void Restore_RenderThread(FRHICommandListImmediate& RHICmdList) const;
+};
 
 /**
  *
@@ -20,12 +125,106 @@ public:
 	virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override;
 	virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override {}
 	virtual void PreRenderView_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneView& InView) override {}
+	virtual void PreRenderView_RenderThread(FRDGBuilder& GraphBuilder, FSceneView& InView) override;
 	virtual void PreRenderViewFamily_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneViewFamily& InViewFamily) override {}
+	virtual void PreRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily) override;
+	virtual void PostRenderBasePassDeferred_RenderThread(FRDGBuilder& GraphBuilder, FSceneView& InView, const FRenderTargetBindingSlots& RenderTargets, TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTextures) override;
 	virtual int32 GetPriority() const override;
 
+	/** Runs the media pre pass before the next view family this extension is active for renders. */
+	void RequestMediaPrePass_GameThread(const FCompositeMediaPrePassRequest& Request);
+
+	/** Drops the pending or every frame media pre pass, when the game thread draws the media again. */
+	void ClearMediaPrePass_GameThread();
+
+	/**
+	 * Upsamples the soft mask after the base pass of every frame until cleared, custom depth is only complete from then on.
+	 * Composite meshes rendered in the base pass read the soft mask of the previous frame.
+	 */
+	void SetSoftMaskUpsample_GameThread(const TOptional<FCompositeSoftMaskUpsampleRequest>& Request);
+
+	/** Draws the soft mask meshes with the matrices of every view of the next view family this extension is active for, before they render. */
+	void RenderSoftMaskMeshPass_GameThread(const FCompositeSoftMaskMeshPassRequest& Request);
+
+	/** Whether a view family this extension is active for rendered in the last frames, so the render thread passes actually run. */
+	bool IsRendering_GameThread() const;
+
 protected:
 	virtual bool IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const override;
 
 private:
 	TWeakObjectPtr<UCompositorSubsystem> CompositorSubsystem;
-};
\ No newline at end of file
+
+	/** Only touched on the render thread, a newer request replaces one that did not run yet. */
+	TOptional<FCompositeMediaPrePassRequest> PendingMediaPrePass;
+
+	/** Frame number of the last view family this extension was active for, written on the render thread. */
+	std::atomic<uint32> LastActiveFrameNumber{ 0 };
+
+	/** Frame number of the view family the media pre pass last ran for, it runs at most once per frame. */
+	uint32 LastMediaPrePassFrameNumber = 0;
+
+	/** Only touched on the render thread. */
+	TOptional<FCompositeSoftMaskUpsampleRequest> SoftMaskUpsample;
+
+	/** The upsampled soft mask of the previous frame, dropped when the render targets change. */
+	TRefCountPtr<IPooledRenderTarget> SoftMaskUpsampleHistory;
+
+	/** Frame number of the view family the soft mask upsample last ran for, views after the first one in a frame reuse its output. */
+	uint32 LastSoftMaskUpsampleFrameNumber = 0;
+
+	/** Only touched on the render thread, the soft mask mesh pass waiting for the next view family when the output is set. */
+	FTextureRenderTargetResource* PendingSoftMaskMeshPassOutput = nullptr;
+	TArray<FCompositeSoftMaskMeshDraw> PendingSoftMaskMeshPassDraws;
+
+	/** Only touched on the render thread, the soft mask mesh pass of the view family rendering. */
+	FTextureRenderTargetResource* SoftMaskMeshPassOutput = nullptr;
+	TArray<FCompositeSoftMaskMeshDraw> SoftMaskMeshPassDraws;
+
+	/** The views of the family share the output, each view draws into its part of this rect. */
+	FIntRect SoftMaskMeshPassViewRect;
+
+	/** Frame number of the view family the soft mask mesh pass draws for, its first view clears the output. */
+	uint32 SoftMaskMeshPassFrameNumber = 0;
+	bool bSoftMaskMeshPassCleared = false;
+};
+
+/**
+ * Binds the render target assets materials sample to the render targets of one world while each view family of that world renders,
+ * scene captures included, and points them back at the assets' own textures after. Views of other worlds never see the bindings.
+ */
+class FCompositeMaterialBindingViewExtension : public FSceneViewExtensionBase
+{
+public:
+	FCompositeMaterialBindingViewExtension(const FAutoRegister& AutoRegister, UWorld* InWorld);
+
+public:
+	//~ ISceneViewExtension interface
+	virtual void SetupViewFamily(FSceneViewFamily& InViewFamily) override {}
+	virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override {}
+	virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override {}
+	virtual void PreRenderView_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneView& InView) override {}
+	virtual void PreRenderViewFamily_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneViewFamily& InViewFamily) override {}
+	virtual void PreRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily) override;
+	virtual void PostRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily) override;
+	virtual int32 GetPriority() const override;
+
+	/** Replaces the bindings applied while the view families of the world render. */
+	void SetBindings_GameThread(const TArray<FCompositeMaterialTextureBinding>& InBindings);
+
+	/**
+	 * Applies the bindings to the render commands enqueued until RestoreBindings_GameThread,
+	 * for material draws into render targets that render outside of any view family.
+	 */
+	void ApplyBindings_GameThread();
+	void RestoreBindings_GameThread();
+
+protected:
+	virtual bool IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const override;
+
+private:
+	TWeakObjectPtr<UWorld> World;
+
+	/** Only touched on the render thread. */
+	TArray<FCompositeMaterialTextureBinding> Bindings;
+};
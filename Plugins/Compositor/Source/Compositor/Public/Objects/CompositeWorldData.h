@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Engine/AssetUserData.h"
+#include "CompositeTypes.h"
 #include "CompositeWorldData.generated.h"
 
 class UComposite;
@@ -74,6 +75,50 @@ private:
 	*/
 	UPROPERTY(Category = "SceneView", EditAnywhere, BlueprintReadWrite, Transient, meta = (AllowPrivateAccess = "true"))
 	bool bEnableCameraMotionBlur;
+
+	/**
+	 * Undistort the media and copy it when there is no keyer in render graph passes right before the composite view renders,
+	 * instead of drawing materials from the game thread tick. Media textures are then shown the same frame they are received.
+	 * Keyer materials still draw from the game thread.
+	 */
+	UPROPERTY(Category = "SceneView", EditAnywhere, BlueprintReadWrite, AdvancedDisplay, meta = (AllowPrivateAccess = "true"))
+	bool bProcessMediaOnRenderThread;
+
+	/**
+	 * Without a keyer, undistort the media directly instead of copying it into the keyed render target first.
+	 * The keyed render target is shrunk while it is unused. On the game thread this requires the undistort material to have a Compositor_MediaInputKeyedTexture texture parameter.
+	 */
+	UPROPERTY(Category = "SceneView", EditAnywhere, BlueprintReadWrite, AdvancedDisplay, meta = (AllowPrivateAccess = "true"))
+	bool bPassThroughMediaWithoutKeyer;
+
+	/**
+	 * How the soft mask is rendered. The mesh pass draws straight from the matrices of the composite view,
+	 * so it follows the view every frame the capture schedule renders, including split screen and stereo views.
+	 */
+	UPROPERTY(Category = "SceneView", EditAnywhere, BlueprintReadWrite, AdvancedDisplay, meta = (AllowPrivateAccess = "true"))
+	ECompositeSoftMaskRenderer SoftMaskRenderer;
+
+	/**
+	 * Composite the media sample whose timecode matches the engine frame instead of the latest one the media texture received.
+	 * Requires the media to be processed on the render thread and a media player that outputs its samples as textures.
+	 */
+	UPROPERTY(Category = "MediaFrameQueue", EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", EditCondition = "bProcessMediaOnRenderThread"))
+	bool bUseMediaFrameQueue;
+
+	/** Number of media samples kept to pick from, has to cover the delay plus the jitter of the media input. */
+	UPROPERTY(Category = "MediaFrameQueue", EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", EditCondition = "bUseMediaFrameQueue", ClampMin = 1, ClampMax = 64))
+	int32 MediaFrameQueueDepth;
+
+	/** Frames the media is held back to line up with the camera tracking data. */
+	UPROPERTY(Category = "MediaFrameQueue", EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", EditCondition = "bUseMediaFrameQueue", ClampMin = 0))
+	int32 MediaFrameDelay;
+
+	/**
+	 * Milliseconds per frame spent registering composite meshes that stream in after the world has begun play, the rest wait for the next frames.
+	 * At least one mesh is registered every frame, zero registers all of them on the frame they begin play.
+	 */
+	UPROPERTY(Category = "Streaming", EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true", ClampMin = 0, Units = "ms"))
+	float CompositeMeshRegistrationBudget;
 	
 	/** The composite stored for this world, this is instanced so the user can adjust the variables easily per world while still able to have global settings using the parent asset. */
 	UPROPERTY(Category = "CompositeWorldData", EditInstanceOnly, Export, Instanced, BlueprintReadOnly, NoClear, meta = (AllowPrivateAccess = "true"))
@@ -107,6 +152,25 @@ public:
 	/** Is camera motion blur enabled in the scene. */
 	FORCEINLINE bool GetEnableCameraMotionBlur() const { return bEnableCameraMotionBlur; }
 
+	/** Is the media undistorted and copied on the render thread. */
+	FORCEINLINE bool GetProcessMediaOnRenderThread() const { return bProcessMediaOnRenderThread; }
+
+	/** Is the media undistorted directly when there is no keyer. */
+	FORCEINLINE bool GetPassThroughMediaWithoutKeyer() const { return bPassThroughMediaWithoutKeyer; }
+
+	/** How the soft mask is rendered. */
+	FORCEINLINE ECompositeSoftMaskRenderer GetSoftMaskRenderer() const { return SoftMaskRenderer; }
+
+	/** Is the media sample picked by timecode. */
+	FORCEINLINE bool GetUseMediaFrameQueue() const { return bUseMediaFrameQueue; }
+
+	FORCEINLINE int32 GetMediaFrameQueueDepth() const { return MediaFrameQueueDepth; }
+
+	FORCEINLINE int32 GetMediaFrameDelay() const { return MediaFrameDelay; }
+
+	/** Milliseconds per frame spent registering streamed in composite meshes. */
+	FORCEINLINE float GetCompositeMeshRegistrationBudget() const { return CompositeMeshRegistrationBudget; }
+
 	/** The composite stored for this world. */
 	FORCEINLINE UComposite* GetWorldComposite() const { return WorldComposite; }
 
@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Cluster/IDisplayClusterClusterManager.h"
+
+class UComposite;
+struct FResolvedCompositeSettings;
+struct FDisplayClusterClusterEventBinary;
+
+/** Lens state the primary node resolved, the other nodes of the cluster use it instead of resolving their own. */
+struct COMPOSITOR_API FCompositorClusterLensState
+{
+	float CameraFovWithoutOverscan = 90.F;
+	float CameraOverscanFactor = 1.F;
+
+	bool operator==(const FCompositorClusterLensState& Other) const
+	{
+		return CameraFovWithoutOverscan == Other.CameraFovWithoutOverscan && CameraOverscanFactor == Other.CameraOverscanFactor;
+	}
+};
+
+/**
+ * Keeps the composite of every node of an nDisplay cluster in step with the primary node.
+ * The primary node serializes the resolved settings of the world composite and its lens state into a binary cluster event whenever they change,
+ * the other nodes show the last one they received in place of resolving their own, see UComposite::SetResolvedSettingsOverride. Every node composites the whole media frame.
+ * Only runs when the compositor is started with -CompositorCluster, otherwise the compositor is not created on cluster nodes at all.
+ */
+class COMPOSITOR_API FCompositorClusterSync
+{
+public:
+	/** Id of the binary cluster event carrying the composite and lens state. */
+	static constexpr int32 StateEventId = 0x434D5053;
+
+	/** Frames after which the primary node sends an unchanged state again as a keepalive, so a node that missed it catches up. */
+	static constexpr uint32 ResendInterval = 120;
+
+	/** Whether the compositor runs on the nodes of an nDisplay cluster, enabled with -CompositorCluster. */
+	static bool IsClusterCompositingEnabled();
+
+	/** Writes the resolved settings of a composite and the lens state, object references as paths. */
+	static void WriteState(const FResolvedCompositeSettings& Settings, const FCompositorClusterLensState& LensState, TArray<uint8>& OutData);
+
+	/** Reads a state written by WriteState, returns false and leaves both outputs untouched when the data is not a valid state. */
+	static bool ReadState(const TArray<uint8>& Data, FResolvedCompositeSettings& OutSettings, FCompositorClusterLensState& OutLensState);
+
+	/** Starts listening to cluster events if this process is a node of a cluster. */
+	void Initialize();
+
+	void Deinitialize();
+
+	/** Whether this process is a node of a cluster with cluster compositing enabled. */
+	bool IsActive() const { return bIsActive; }
+
+	/** Whether this node resolves the state for the cluster. */
+	bool IsPrimary() const { return bIsPrimary; }
+
+	/**
+	 * On the primary node, sends the resolved settings of the composite and the lens state when they changed since they were last sent.
+	 * Unchanged states are only serialized and sent again every ResendInterval frames.
+	 */
+	void SendState(const UComposite* Composite, const FCompositorClusterLensState& LensState);
+
+	/**
+	 * On the other nodes, has the composite show the settings the primary node sent last and returns its lens state.
+	 * Unset until the first state arrived.
+	 */
+	TOptional<FCompositorClusterLensState> ApplyReceivedState(UComposite* Composite);
+
+	/** Logs the role and traffic of this node. */
+	void LogStatus() const;
+
+private:
+	void OnClusterEventBinary(const FDisplayClusterClusterEventBinary& Event);
+
+	FOnClusterEventBinaryListener ClusterEventListener;
+
+	bool bIsActive = false;
+	bool bIsPrimary = false;
+
+	TArray<uint8> LastSentData;
+	uint64 LastSentFrame = 0;
+
+	/** What the last sent state was written from, nothing has to be written while they are the same. */
+	TWeakObjectPtr<const UComposite> LastSentComposite;
+	uint32 LastSentSettingsGeneration = 0;
+	FCompositorClusterLensState LastSentLensState;
+
+	/** The latest state from the primary node, read on the next tick. */
+	TArray<uint8> ReceivedData;
+	bool bReceivedDataPending = false;
+
+	/** The last state from the primary node that could be read. */
+	TSharedPtr<FResolvedCompositeSettings> ReceivedSettings;
+	TOptional<FCompositorClusterLensState> ReceivedLensState;
+
+	/** The composite showing the received settings, it goes back to its own when the world composite changes. */
+	TWeakObjectPtr<UComposite> OverriddenComposite;
+
+	uint32 NumStatesSent = 0;
+	uint32 NumStatesReceived = 0;
+};
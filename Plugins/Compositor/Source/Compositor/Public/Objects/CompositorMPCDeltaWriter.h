@@ -0,0 +1,142 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class UWorld;
+class UMaterialParameterCollection;
+class UMaterialParameterCollectionInstance;
+
+/**
+ * Filters the writes to the Compositor material parameter collection down to the values that changed.
+ * Values are staged by handle in contiguous arrays and diffed against the last written ones on flush, the changed ones are still
+ * forwarded to the collection instance by name, the engine has no public way to write a collection instance by parameter index.
+ */
+class COMPOSITOR_API FCompositorMPCDeltaWriter
+{
+public:
+	FCompositorMPCDeltaWriter();
+
+	/** Binds the writer to the collection of a world, this drops all registered parameters and staged values. */
+	void Initialize(UWorld* InWorld, UMaterialParameterCollection* InCollection);
+
+	/** Returns the handle of a scalar parameter, an index into the staged values, or INDEX_NONE if the collection does not contain it. */
+	int32 RegisterScalarParameter(FName ParameterName);
+
+	/** Returns the handle of a vector parameter, an index into the staged values, or INDEX_NONE if the collection does not contain it. */
+	int32 RegisterVectorParameter(FName ParameterName);
+
+	FORCEINLINE void SetScalarParameterValue(int32 Handle, float Value)
+	{
+		if (StagedScalarValues.IsValidIndex(Handle))
+		{
+			StagedScalarValues[Handle] = Value;
+			bIsScalarStaged[Handle] = true;
+		}
+	}
+
+	FORCEINLINE void SetVectorParameterValue(int32 Handle, const FLinearColor& Value)
+	{
+		if (StagedVectorValues.IsValidIndex(Handle))
+		{
+			StagedVectorValues[Handle] = Value;
+			bIsVectorStaged[Handle] = true;
+		}
+	}
+
+	/** Forwards all staged values that differ from the last written ones to the collection instance, by parameter name. */
+	void Flush();
+
+	/** Forces the next flush to write all staged values, for when the collection instance might have been changed by someone else. */
+	void Invalidate();
+
+	/** Total number of values forwarded to the collection instance since initialization. */
+	FORCEINLINE uint64 GetTotalParametersWritten() const { return TotalParametersWritten; }
+
+	/** Total number of staged values skipped because they did not change since initialization. */
+	FORCEINLINE uint64 GetTotalParametersSkipped() const { return TotalParametersSkipped; }
+
+private:
+	UMaterialParameterCollectionInstance* GetCollectionInstance();
+
+	TWeakObjectPtr<UWorld> World;
+	TWeakObjectPtr<UMaterialParameterCollection> Collection;
+	TWeakObjectPtr<UMaterialParameterCollectionInstance> CollectionInstance;
+
+	TArray<FName> ScalarParameterNames;
+	TArray<float> StagedScalarValues;
+	TArray<float> WrittenScalarValues;
+	TBitArray<> bIsScalarStaged;
+	TBitArray<> bIsScalarWritten;
+
+	TArray<FName> VectorParameterNames;
+	TArray<FLinearColor> StagedVectorValues;
+	TArray<FLinearColor> WrittenVectorValues;
+	TBitArray<> bIsVectorStaged;
+	TBitArray<> bIsVectorWritten;
+
+	uint64 TotalParametersWritten;
+	uint64 TotalParametersSkipped;
+};
+
+/**
+ * Handles of all the MPC_Compositor parameters written from code.
+ */
+struct COMPOSITOR_API FCompositorMPCParameters
+{
+	void Register(FCompositorMPCDeltaWriter& Writer);
+
+	// Subsystem tick.
+	int32 IsKeyerEnabled = INDEX_NONE;
+	int32 DebugMediaOverlay = INDEX_NONE;
+	int32 MediaProjectionBlendAmount = INDEX_NONE;
+	int32 MediaProjectionFoV = INDEX_NONE;
+	int32 MediaProjectionCameraPosition = INDEX_NONE;
+	int32 MediaProjectionCameraForward = INDEX_NONE;
+	int32 MediaProjectionCameraRight = INDEX_NONE;
+	int32 MediaProjectionCameraUp = INDEX_NONE;
+	int32 IsMovieRenderQueueEnabled = INDEX_NONE;
+
+	// Lens data.
+	int32 CameraFovWithoutOverscan = INDEX_NONE;
+	int32 CameraOverscanFactor = INDEX_NONE;
+
+	// Composite post process.
+	int32 EnableSoftMask = INDEX_NONE;
+	int32 ShadowsBlackLevel = INDEX_NONE;
+	int32 ShadowsWhiteLevel = INDEX_NONE;
+	int32 ShadowsGamma = INDEX_NONE;
+	int32 ShadowsTint = INDEX_NONE;
+	int32 EnablePlanarReflection = INDEX_NONE;
+	int32 PlanarReflectionColor = INDEX_NONE;
+	int32 PlanarReflectionDistortionIntensity = INDEX_NONE;
+	int32 PlanarReflectionDistortionOffset = INDEX_NONE;
+	int32 MediaBlendNone = INDEX_NONE;
+	int32 MediaBlendPreToneCurve = INDEX_NONE;
+	int32 BrightnessMaskGamma = INDEX_NONE;
+	int32 ApplyInverseToneCurve = INDEX_NONE;
+	int32 OutputAlphaInvertedOpacity = INDEX_NONE;
+	int32 OutputAlphaWhite = INDEX_NONE;
+	int32 OutputAlphaOverride = INDEX_NONE;
+	int32 OutputRgbEncodingSrgb = INDEX_NONE;
+	int32 OutputAlphaInRgb = INDEX_NONE;
+	int32 DebugVisualizeCompositeMeshes = INDEX_NONE;
+
+	// Color grading, indexed by Scene, Media, Combined.
+	int32 ColorGradeSaturation[3] = { INDEX_NONE, INDEX_NONE, INDEX_NONE };
+	int32 ColorGradeContrast[3] = { INDEX_NONE, INDEX_NONE, INDEX_NONE };
+	int32 ColorGradeGamma[3] = { INDEX_NONE, INDEX_NONE, INDEX_NONE };
+	int32 ColorGradeGain[3] = { INDEX_NONE, INDEX_NONE, INDEX_NONE };
+	int32 ColorGradeOffset[3] = { INDEX_NONE, INDEX_NONE, INDEX_NONE };
+
+	// View extension.
+	int32 FilmBlackClip = INDEX_NONE;
+	int32 FilmWhiteClip = INDEX_NONE;
+	int32 FilmShoulder = INDEX_NONE;
+	int32 FilmSlope = INDEX_NONE;
+	int32 FilmToe = INDEX_NONE;
+	int32 BlueCorrection = INDEX_NONE;
+	int32 ToneCurveAmount = INDEX_NONE;
+};
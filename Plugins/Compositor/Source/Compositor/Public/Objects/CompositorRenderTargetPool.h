@@ -0,0 +1,97 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "UObject/GCObject.h"
+
+/**
+ * Everything that has to be the same for a pooled render target to be reused.
+ */
+struct COMPOSITOR_API FCompositorRenderTargetDesc
+{
+	FIntPoint Size = FIntPoint(2, 2);
+	TEnumAsByte<ETextureRenderTargetFormat> Format = RTF_RGBA16f;
+	FLinearColor ClearColor = FLinearColor::Transparent;
+	bool bCanCreateUAV = false;
+
+	/** Takes the format and clear color of a render target asset. */
+	static FCompositorRenderTargetDesc FromTemplate(const UTextureRenderTarget2D* Template, const FIntPoint& InSize);
+
+	bool operator==(const FCompositorRenderTargetDesc& Other) const;
+
+	friend uint32 GetTypeHash(const FCompositorRenderTargetDesc& Desc);
+};
+
+/**
+ * Hands out transient render targets so changing the size or format of a compositor render target does not reallocate the one in use.
+ * Released targets stay alive for a number of frames, switching back to a recently used size or format reuses them without touching the GPU.
+ * Every world owns its own pool, so worlds compositing media of different sizes at the same time never resize each other's render targets.
+ */
+class COMPOSITOR_API FCompositorRenderTargetPool : public FGCObject
+{
+public:
+	/** Frames a released render target is kept alive before its memory is freed. */
+	static constexpr uint32 HysteresisFrames = 120;
+
+	/** Size buckets are spaced by this fraction of the reference size, so dragging a screen percentage slider only reallocates every 5%. */
+	static constexpr float BucketFraction = 0.05F;
+
+	FCompositorRenderTargetPool() = default;
+	virtual ~FCompositorRenderTargetPool();
+
+	/** Rounds a size up to the next bucket of the reference size, i.e. the media size a screen percentage is applied to. */
+	static FIntPoint QuantizeSize(const FIntPoint& Size, const FIntPoint& ReferenceSize);
+
+	/** Returns an unused render target matching the description, only allocates when none was released recently. */
+	UTextureRenderTarget2D* Acquire(const FCompositorRenderTargetDesc& Desc);
+
+	/** Returns a render target to the pool, it is only freed when it was not acquired again within the hysteresis frames. */
+	void Release(UTextureRenderTarget2D* RenderTarget);
+
+	/**
+	 * Swaps the render target for one matching the description if it does not match already.
+	 * Returns true when the render target changed and its contents have to be drawn again.
+	 */
+	bool Update(UTextureRenderTarget2D*& InOutRenderTarget, const FCompositorRenderTargetDesc& Desc);
+
+	/** Frees the render targets that were not used for longer than the hysteresis, call once per frame. */
+	void Tick();
+
+	/** Frees all render targets, the ones in use as well. */
+	void Empty();
+
+	/** GPU memory of the render targets in use. */
+	int64 GetUsedMemory() const { return UsedMemory; }
+
+	/** GPU memory of the released render targets kept alive for reuse. */
+	int64 GetFreeMemory() const { return FreeMemory; }
+
+	/** Number of render targets the pool created since it was constructed, reused render targets do not count. */
+	uint64 GetTotalAllocations() const { return TotalAllocations; }
+
+	//~ Begin FGCObject Interface
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FCompositorRenderTargetPool"); }
+	//~ End FGCObject Interface
+
+private:
+	struct FEntry
+	{
+		UTextureRenderTarget2D* RenderTarget = nullptr;
+		FCompositorRenderTargetDesc Desc;
+		int64 Memory = 0;
+		uint64 ReleaseFrame = 0;
+		bool bInUse = false;
+	};
+
+	void FreeEntry(int32 Index);
+
+	TArray<FEntry> Entries;
+
+	int64 UsedMemory = 0;
+	int64 FreeMemory = 0;
+
+	uint64 TotalAllocations = 0;
+};
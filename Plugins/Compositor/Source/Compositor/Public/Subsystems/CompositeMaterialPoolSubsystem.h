@@ -0,0 +1,83 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+
+#include "CompositeMaterialPoolSubsystem.generated.h"
+
+class UMaterialInstanceDynamic;
+class UMaterialInterface;
+
+/**
+ * The parameter values of a pooled material instance, in the order they were added.
+ */
+struct COMPOSITOR_API FCompositeMaterialParameters
+{
+	void AddScalarParameter(FName Name, float Value) { ScalarParameters.Emplace(Name, Value); }
+
+	void AddVectorParameter(FName Name, const FLinearColor& Value) { VectorParameters.Emplace(Name, Value); }
+
+	/** Writes all values that differ from the previous parameters, or all of them when there are none. */
+	void ApplyTo(UMaterialInstanceDynamic* MID, const FCompositeMaterialParameters* PreviousParameters = nullptr) const;
+
+	bool operator==(const FCompositeMaterialParameters& Other) const { return ScalarParameters == Other.ScalarParameters && VectorParameters == Other.VectorParameters; }
+
+	friend uint32 GetTypeHash(const FCompositeMaterialParameters& Parameters);
+
+private:
+	TArray<TPair<FName, float>, TInlineAllocator<8>> ScalarParameters;
+	TArray<TPair<FName, FLinearColor>, TInlineAllocator<2>> VectorParameters;
+};
+
+/**
+ * Shares material instances between objects that use the same parent material with the same parameter values.
+ * Every instance keeps track of its holders, an instance is only modified in place when its only holder changes it, otherwise the holder gets a copy.
+ */
+UCLASS()
+class COMPOSITOR_API UCompositeMaterialPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Returns the instance of Parent with the given parameters for Holder, and releases CurrentMID if Holder no longer uses it.
+	 * Pass the instance Holder currently uses, or null if it has none yet.
+	 */
+	UMaterialInstanceDynamic* UpdateInstance(const UObject* Holder, UMaterialInstanceDynamic* CurrentMID, UMaterialInterface* Parent, const FCompositeMaterialParameters& Parameters);
+
+	/** Stops Holder from using MID, the instance is dropped from the pool when nobody uses it anymore. */
+	void ReleaseInstance(const UObject* Holder, UMaterialInstanceDynamic* MID);
+
+	/** Number of distinct material instances in the pool. */
+	int32 GetNumInstances() const { return Entries.Num(); }
+
+	//~ Begin USubsystem Interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+private:
+	struct FEntry
+	{
+		FCompositeMaterialParameters Parameters;
+		uint32 ParametersHash = 0;
+		TSet<TObjectKey<UObject>> Holders;
+	};
+
+	UMaterialInstanceDynamic* FindInstance(const UMaterialInterface* Parent, const FCompositeMaterialParameters& Parameters, uint32 ParametersHash) const;
+
+	void AddLookup(UMaterialInstanceDynamic* MID, uint32 ParametersHash);
+
+	void RemoveLookup(UMaterialInstanceDynamic* MID, uint32 ParametersHash);
+
+	/** Keeps the pooled instances alive, holders reference them as well but might not be UPROPERTYs. */
+	UPROPERTY(Transient)
+	TSet<UMaterialInstanceDynamic*> Instances;
+
+	TMap<const UMaterialInstanceDynamic*, FEntry> Entries;
+
+	/** Pooled instances by parent material and parameters hash. */
+	TMultiMap<TPair<const UMaterialInterface*, uint32>, UMaterialInstanceDynamic*> Lookup;
+};
@@ -0,0 +1,174 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CompositeTypes.h"
+#include "CompositorStats.h"
+#include "Components/SceneComponent.h" // EUpdateTransformFlags
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "UObject/ObjectKey.h"
+
+#include "CompositeMeshBatchSubsystem.generated.h"
+
+class ACompositeMesh;
+class UInstancedStaticMeshComponent;
+class UMaterialInstanceDynamic;
+class UMaterialInterface;
+class UStaticMesh;
+class UStaticMeshComponent;
+
+/**
+ * Everything that has to be the same for composite meshes to share instanced components and material instances.
+ */
+struct FCompositeMeshBatchKey
+{
+	const UStaticMesh* StaticMesh = nullptr;
+	const UMaterialInterface* OpaqueMaterial = nullptr;
+	const UMaterialInterface* StencilMaterial = nullptr;
+	const UMaterialInterface* TranslucentMaterial = nullptr;
+	const UMaterialInterface* SoftMaskMaterial = nullptr;
+	FLinearColor RayTracedBackfaceColor = FLinearColor::Black;
+	FLinearColor RayTracedOutOfFrustumColor = FLinearColor::Black;
+	float PlanarReflectionBackgroundOcclusion = 0.F;
+	uint8 LightingChannels = 0;
+	uint8 Mobility = 0;
+	ERenderSoftMaskType RenderSoftMask = ERenderSoftMaskType::OpaqueWhite;
+	bool bBypassDepthOfField = false;
+	bool bCastShadows = false;
+	bool bAffectDistanceFieldLighting = false;
+	bool bAlignNormalsWithAtmosphereLight = false;
+
+	bool operator==(const FCompositeMeshBatchKey& Other) const;
+
+	friend uint32 GetTypeHash(const FCompositeMeshBatchKey& Key);
+};
+
+/**
+ * The instanced components and material instances of all composite meshes with the same batch key.
+ * Instance N of every component belongs to Meshes[N].
+ */
+USTRUCT()
+struct FCompositeMeshBatch
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UInstancedStaticMeshComponent* OpaqueComponent = nullptr;
+
+	UPROPERTY()
+	UInstancedStaticMeshComponent* StencilComponent = nullptr;
+
+	UPROPERTY()
+	UInstancedStaticMeshComponent* TranslucentComponent = nullptr;
+
+	UPROPERTY()
+	UInstancedStaticMeshComponent* SoftMaskComponent = nullptr;
+
+	UPROPERTY()
+	UMaterialInstanceDynamic* OpaqueMID = nullptr;
+
+	UPROPERTY()
+	UMaterialInstanceDynamic* StencilMID = nullptr;
+
+	UPROPERTY()
+	UMaterialInstanceDynamic* TranslucentMID = nullptr;
+
+	UPROPERTY()
+	UMaterialInstanceDynamic* SoftMaskMID = nullptr;
+
+	UPROPERTY()
+	TArray<ACompositeMesh*> Meshes;
+};
+
+/**
+ * Renders composite meshes that opted into instanced rendering through shared instanced static mesh components,
+ * so draw calls and material instances scale with the number of distinct mesh configurations instead of the number of actors.
+ * Only runs in game worlds, in the editor every composite mesh keeps its own components so it can still be selected in the viewport.
+ * Instance updates are pushed to the renderer once per frame for every batch they touched, from the tick.
+ */
+UCLASS()
+class COMPOSITOR_API UCompositeMeshBatchSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Per instance custom data written for every composite mesh, the batch materials read these instead of their scalar parameters. */
+	static constexpr int32 CustomDataReceiveShadowsIntensity = 0;
+	static constexpr int32 CustomDataPlanarReflectionColorIntensity = 1;
+	static constexpr int32 CustomDataIsTwoSided = 2;
+	static constexpr int32 CustomDataSoftMaskValue = 3;
+	static constexpr int32 NumCustomDataFloats = 4;
+
+	/** Starts rendering a composite mesh through the batch matching its current settings. */
+	void AddCompositeMesh(ACompositeMesh* CompositeMesh);
+
+	/** Stops rendering a composite mesh through its batch. */
+	void RemoveCompositeMesh(ACompositeMesh* CompositeMesh);
+
+	/** Moves a composite mesh to another batch if its settings changed, otherwise only updates its transform and custom data. */
+	void UpdateCompositeMesh(ACompositeMesh* CompositeMesh);
+
+	bool ContainsCompositeMesh(const ACompositeMesh* CompositeMesh) const { return Instances.Contains(CompositeMesh); }
+
+	/** The instanced soft mask component rendering a composite mesh, null when the mesh is not batched. */
+	UInstancedStaticMeshComponent* GetBatchSoftMaskComponent(const ACompositeMesh* CompositeMesh) const;
+
+	/** Number of distinct batches, every batch costs one draw per pass no matter how many meshes it contains. */
+	int32 GetNumBatches() const { return BatchIndices.Num(); }
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return DirtyBatchIndices.Num() > 0; }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual ETickableTickType GetTickableTickType() const override;
+	TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(UCompositeMeshBatchSubsystem, STATGROUP_Compositor); }
+	//~ End FTickableGameObject Interface
+
+protected:
+	//~ Begin UWorldSubsystem Interface
+	virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+	//~ End UWorldSubsystem Interface
+
+private:
+	/** Where a composite mesh lives in the batches. */
+	struct FCompositeMeshInstance
+	{
+		FCompositeMeshBatchKey Key;
+		int32 BatchIndex = INDEX_NONE;
+		int32 InstanceIndex = INDEX_NONE;
+	};
+
+	static FCompositeMeshBatchKey MakeBatchKey(const ACompositeMesh& CompositeMesh);
+
+	int32 FindOrAddBatch(const FCompositeMeshBatchKey& Key, const ACompositeMesh& CompositeMesh);
+
+	UInstancedStaticMeshComponent* CreateBatchComponent(const UStaticMeshComponent* TemplateComponent, UMaterialInterface* Material);
+
+	/** Writes the transform and custom data of a composite mesh into the instances of its batch, the renderer sees them on the next flush. */
+	void WriteInstanceData(int32 BatchIndex, int32 InstanceIndex, const ACompositeMesh& CompositeMesh);
+
+	/** Marks the components of every batch changed since the last flush render state dirty and requests a single soft mask capture for all of them. */
+	void FlushDirtyBatches();
+
+	/** The soft mask capture can't see changes to instances by itself, tell it to capture again. */
+	void RequestSoftMaskCapture() const;
+
+	void OnCompositeMeshTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	/** Owner of all the instanced components. */
+	UPROPERTY(Transient)
+	AActor* BatchActor;
+
+	/** Batches are never removed, so moving a mesh in and out of a configuration does not recreate components. */
+	UPROPERTY(Transient)
+	TArray<FCompositeMeshBatch> Batches;
+
+	TMap<FCompositeMeshBatchKey, int32> BatchIndices;
+
+	TMap<TObjectKey<ACompositeMesh>, FCompositeMeshInstance> Instances;
+
+	/** Batches whose instances changed this frame. */
+	TSet<int32> DirtyBatchIndices;
+};
@@ -3,7 +3,12 @@
 #pragma once
 
 #include "Interfaces/CompositeUpdateInterface.h"
+#include "Objects/CompositeUpdateRegistry.h"
 #include "Objects/CompositePostProcessVolume.h"
+#include "Objects/CompositorClusterSync.h"
+#include "Objects/CompositorMPCDeltaWriter.h"
+#include "Objects/CompositorRenderTargetPool.h"
+#include "CompositorStats.h"
 
 #include "CoreMinimal.h"
 #include "Subsystems/WorldSubsystem.h"
@@ -19,18 +24,41 @@
 #include "CompositorSubsystem.generated.h"
 
 class UCameraComponent;
+class UCineCameraComponent;
+class ULensDistortionModelHandlerBase;
 class ACompositeMesh;
+class UCompositeKeyer;
+class UCompositeKeyerColorDifference;
+enum class ECompositeMediaPrePassMode : uint8;
 class UCompositeWorldData;
 class FCompositeViewExtension;
+class FCompositeMaterialBindingViewExtension;
+struct FSceneViewExtensionContext;
+class FCompositeMediaFrameQueue;
+class FCompositeMediaSampleCounter;
+class IMediaTextureSample;
+class UMediaPlayer;
 class UTextureRenderTarget2D;
 class UMaterialInterface;
 class UMaterialInstanceDynamic;
 class USoftMaskCaptureComponent;
 class UMaterialParameterCollection;
 class UWorld;
+class UCompositorBenchmarkCommandlet;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogCompositor, Log, All);
 
+/** Game thread time of the steps of the last subsystem tick, in seconds. */
+struct FCompositorTickTimings
+{
+	double UpdateCompositeViewportInfo = 0.0;
+	double UpdateMedia = 0.0;
+	double UpdateRenderTargets = 0.0;
+	double UpdateCompositeKeyer = 0.0;
+	double UpdateLensData = 0.0;
+	double Flush = 0.0;
+};
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnCompositeWorldDataAdded);	
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnCompositeWorldDataRemoved);
 
@@ -41,6 +69,9 @@ UCLASS()
 class COMPOSITOR_API UCompositorSubsystem : public UWorldSubsystem, public FTickableGameObject
 {
 	GENERATED_BODY()
+
+	/** Times the private update functions of the subsystem. */
+	friend class UCompositorBenchmarkCommandlet;
 	
 public:
 	DECLARE_MULTICAST_DELEGATE(FOnCompositeWorldDataAddedRaw);	
@@ -59,6 +90,10 @@ public:
 
 	DECLARE_MULTICAST_DELEGATE_OneParam(FOnCompositeUpdateInterfaceUnregistered, TScriptInterface<ICompositeUpdateInterface>);
 	FOnCompositeUpdateInterfaceUnregistered OnCompositeUpdateInterfaceUnregistered;
+
+	/** Broadcast once for all composite meshes registered from the queue in a frame, instead of OnCompositeUpdateInterfaceRegistered for each. */
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnCompositeMeshesRegistered, TArrayView<ACompositeMesh* const>);
+	FOnCompositeMeshesRegistered OnCompositeMeshesRegistered;
 	
 	/** Override to control if the Subsystem should be created at all.
 	* For example you could only have your system created on servers.
@@ -89,18 +124,27 @@ public:
 	UFUNCTION(Category = "Compositor|Subsystem", BlueprintCallable)
 	void UnregisterCompositeUpdateInterface(TScriptInterface<ICompositeUpdateInterface> CompositeUpdateInterface);
 
+	/**
+	 * Queues the registration of a composite mesh that begins play after the world did, i.e. streamed in with a level.
+	 * The queue is worked off over the next ticks within the registration budget of the world data.
+	 * Returns false when the mesh has to register right away, it then calls FinishCompositeMeshRegistration itself.
+	 */
+	bool QueueCompositeMeshRegistration(ACompositeMesh* CompositeMesh);
+
 	//~ Begin FTickableGameObject Interface
 	/** return the stat id to use for this tickable **/
 	virtual void Tick(float DeltaTime) override;
 	virtual bool IsTickable() const override;
 	virtual ETickableTickType GetTickableTickType() const override;
-	TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(UAutoDestroySubsystem, STATGROUP_Tickables); }
+	TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(UCompositorSubsystem, STATGROUP_Compositor); }
 	virtual bool IsTickableInEditor() const override { return true; }
 	//~ End FTickableGameObject Interface
 
-	/** Called by a Composite asset when it has changed and it is part of the current world. */
-	UFUNCTION()
-	void OnCompositeUpdate_Internal();
+	/**
+	 * Called by a Composite asset when it has changed and it is part of the current world.
+	 * Only the listeners subscribed to one of the changed property groups are updated.
+	 */
+	void OnCompositeUpdate_Internal(ECompositeUpdateFlags UpdateFlags = ECompositeUpdateFlags::All);
 
 	UFUNCTION(Category = Compositor, BlueprintPure)
 	UTexture* GetActiveMediaTexture() const;
@@ -112,6 +156,45 @@ public:
 	UFUNCTION(Category = Compositor, BlueprintPure)
 	FIntPoint GetMediaInputTextureSize() const;
 
+	/** Returns a hash that changes whenever the active media texture has a new frame to show, keyed on the samples its player delivered. */
+	uint32 GetActiveMediaFrameHash() const;
+
+	/** The queue picking the media sample for each frame, null when the world data does not use it. */
+	FCompositeMediaFrameQueue* GetMediaFrameQueue() const { return MediaFrameQueue.Get(); }
+
+	/** The render target the keyer draws into this frame, it changes whenever the media size or format does. */
+	UTextureRenderTarget2D* GetMediaInputKeyedRenderTarget() const { return MediaInputKeyedRenderTarget; }
+
+	/** The pool all render targets of this world are allocated from. */
+	FCompositorRenderTargetPool& GetRenderTargetPool() { return RenderTargetPool; }
+
+	/**
+	 * Makes materials sampling the render target asset read the render target of this world while the composite views of this world render.
+	 * Pass null to have them read the asset itself.
+	 */
+	void BindMaterialTexture(UTexture* MaterialTexture, UTextureRenderTarget2D* RenderTarget);
+
+	/** Drops the binding of the asset if it is still bound to the render target. */
+	void UnbindMaterialTexture(UTexture* MaterialTexture, const UTextureRenderTarget2D* RenderTarget);
+
+	/** Draws the material into the render target with the material textures bound to the render targets of this world. */
+	void DrawMaterialToRenderTarget(UTextureRenderTarget2D* RenderTarget, UMaterialInterface* Material);
+
+	/**
+	 * Has the composite view upsample the low resolution soft mask capture into the output render target every frame, after its base pass.
+	 * Pass null for either to stop the upsample.
+	 */
+	void SetSoftMaskUpsample(UTextureRenderTarget2D* SoftMaskTexture, UTextureRenderTarget2D* OutputTexture);
+
+	/**
+	 * Has the next composite view draw the soft mask of the registered composite meshes into the render target before it renders,
+	 * with the matrices of each of its views. Returns false when the mesh pass can't run, capture the soft mask with the scene capture then.
+	 */
+	bool RenderSoftMaskMeshPass(UTextureRenderTarget2D* OutputTexture);
+
+	/** Call after drawing into the keyed media render target, so everything reading from it knows to update. */
+	void NotifyMediaInputKeyedUpdated() { ++MediaInputKeyedGeneration; }
+
 	UFUNCTION(Category = Compositor, BlueprintPure) 
 	FIntPoint GetViewportSize() const;
 
@@ -119,6 +202,42 @@ public:
 	void UpdateCompositeViewportInfo(bool bSetFixedSize);
 
 private:
+	/** Returns the lens distortion handler of the camera, the lookup is only done again when the camera changes or its handler went away. */
+	const ULensDistortionModelHandlerBase* FindDistortionModelHandler(UCineCameraComponent* CineCameraComponent);
+
+	/** Attaches the media frame queue to the active media player, or drops it, and selects the sample for this frame. */
+	void UpdateMediaFrameQueue();
+
+	/** Attaches the media sample counter to the player of the active media texture. */
+	void UpdateMediaSampleCounter();
+
+	/**
+	 * The sample the media frame queue selected, when the media passes can read it directly.
+	 * Null while the player feeds no samples to the queue or delivers formats only the media texture converts, the media texture is read then.
+	 */
+	TSharedPtr<IMediaTextureSample, ESPMode::ThreadSafe> GetQueuedMediaSample() const;
+
+	/**
+	 * Whether the view extension renders for the composite viewport, and has done so in the last frames.
+	 * Everything the extension does on the render thread falls back to the game thread draws otherwise, or the render targets would go stale.
+	 */
+	bool IsViewExtensionRendering() const;
+
+	/** Can the view extension process the media in render graph passes. */
+	bool CanRunMediaPrePass() const;
+
+	/** Returns the keyer if it keys in the fused media pre pass instead of drawing its material, null otherwise. */
+	UCompositeKeyerColorDifference* GetFusedMediaPrePassKeyer(UCompositeKeyer* CompositeKeyer) const;
+
+	/** Sends the media, lens displacement map, key and media grade of this frame to the media pre pass of the view extension. */
+	void RequestMediaPrePass(uint32 UndistortDrawHash, bool bEveryFrame);
+
+	/** The format of the keyed and undistorted render targets for the active media, unset to keep the format of the assets. */
+	TOptional<ETextureRenderTargetFormat> GetMediaRenderTargetFormat(bool bNeedsUAV) const;
+
+	/** Sends the changed material texture bindings to the material binding view extension. */
+	void FlushMaterialTextureBindings();
+
 	FIntPoint CompositeViewportSize;
 	FViewport* CompositeViewport;
 
@@ -138,10 +257,14 @@ private:
 	UPROPERTY(Transient)
 	USoftMaskCaptureComponent* SoftMaskCaptureComponent;
 
-	/** The render target the CompositeKeyer is drawing to. */
-	UPROPERTY(Category = "Media CompositeKeyer", VisibleAnywhere, BlueprintReadOnly, AdvancedDisplay, meta = (AllowPrivateAccess = "true"))
+	/** The render target the CompositeKeyer is drawing to, allocated from the render target pool. */
+	UPROPERTY(Category = "Media CompositeKeyer", VisibleAnywhere, BlueprintReadOnly, AdvancedDisplay, Transient, meta = (AllowPrivateAccess = "true"))
 	UTextureRenderTarget2D* MediaInputKeyedRenderTarget;
 
+	/** The keyed render target asset materials sample, the pooled keyed render target is bound to it. */
+	UPROPERTY(Transient)
+	UTextureRenderTarget2D* MediaInputKeyedTextureAsset;
+
 	/** The fallback for not having a CompositeKeyer. */
 	UPROPERTY(Category = "Media CompositeKeyer", VisibleAnywhere, BlueprintReadOnly, AdvancedDisplay, meta = (AllowPrivateAccess = "true"))
 	UMaterialInterface* MediaInputCompositeKeyerDisabledFallbackMaterial;
@@ -150,6 +273,39 @@ private:
 	UPROPERTY(Category = "Media CompositeKeyer", VisibleAnywhere, BlueprintReadOnly, AdvancedDisplay, meta = (AllowPrivateAccess = "true"))
 	UMaterialInstanceDynamic* MediaInputCompositeKeyerDisabledFallbackMID;
 
+	/** The keyer or fallback material that last drew into the keyed render target. */
+	UPROPERTY(Transient)
+	UObject* MediaInputKeyedRenderTargetWriter;
+
+	/** Hash of the media frame and render target the fallback material last drew with. */
+	uint32 LastFallbackDrawHash;
+
+	/** Bumped every time the keyer or the fallback material drew into the keyed render target. */
+	uint32 MediaInputKeyedGeneration;
+
+	/** Hash of the lens distortion state and media frame the undistort pass last drew with. */
+	uint32 LastUndistortDrawHash;
+
+	/** What the view extension does with the media this frame instead of the game thread material draws, unset when the materials draw. */
+	TOptional<ECompositeMediaPrePassMode> MediaPrePassMode;
+
+	/** The keyer that replaces the keyer and undistort draws with the fused media pre pass this frame. */
+	TWeakObjectPtr<UCompositeKeyerColorDifference> FusedMediaPrePassKeyer;
+
+	/** Has the view extension been sent a media pre pass that may still run, it has to be cleared when the materials draw again. */
+	bool bMediaPrePassRequested;
+
+	/** Is the media undistorted directly this frame, without the keyer disabled fallback copy into the keyed render target. */
+	bool bPassThroughMedia;
+
+	/** Can the undistort material read the media instead of the keyed render target. */
+	bool bUndistortMaterialHasKeyedTextureParameter;
+
+	/** The camera the cached lens distortion handler belongs to. */
+	TWeakObjectPtr<UCineCameraComponent> DistortionHandlerCameraComponent;
+
+	TWeakObjectPtr<const ULensDistortionModelHandlerBase> DistortionModelHandler;
+
 	/** The default undistort texture used, is just black so doesn't do anything. */
 	UPROPERTY(Category = "Lens Data", VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	float CameraFovWithoutOverscan;
@@ -166,10 +322,14 @@ private:
 	UPROPERTY(Category = "Lens Data", VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	UTexture* CurrentUndistortTexture;
 	
-	/** The render target the lens undistort is drawing to. */
-	UPROPERTY(Category = "Lens Data", VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	/** The render target the lens undistort is drawing to, allocated from the render target pool. */
+	UPROPERTY(Category = "Lens Data", VisibleAnywhere, BlueprintReadOnly, Transient, meta = (AllowPrivateAccess = "true"))
 	UTextureRenderTarget2D* MediaInputUndistortedTexture;
 
+	/** The undistorted render target asset materials sample, the pooled undistorted render target is bound to it. */
+	UPROPERTY(Transient)
+	UTextureRenderTarget2D* MediaInputUndistortedTextureAsset;
+
 	/** The fallback for not having lens data. */
 	UPROPERTY(Category = "Lens Data", VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	UMaterialInterface* MediaInputUndistortMaterial;
@@ -183,8 +343,8 @@ private:
 	UTextureRenderTarget2D* CompositePlanarReflectionRenderTarget;
 
 	/** All the Composite Update Interfaces registered in the world. */
-	UPROPERTY(Category = "Compositor|Subsystem", VisibleAnywhere, BlueprintReadOnly, Transient, meta = (AllowPrivateAccess = "true"))
-	TArray<TScriptInterface<ICompositeUpdateInterface>> CompositeUpdateInterfaceArray;
+	UPROPERTY(Category = "Compositor|Subsystem", VisibleAnywhere, Transient, meta = (AllowPrivateAccess = "true"))
+	FCompositeUpdateRegistry CompositeUpdateRegistry;
 
 	/** The Compositor World Settings Asset User Data which contains the Composite used in this world. */
 	UPROPERTY(Transient)
@@ -194,10 +354,69 @@ private:
 	UPROPERTY(Transient)
 	UMaterialParameterCollection* CompositorMaterialParameterCollection;
 
+	/** Skips the values the Compositor pushes into its material parameter collection that did not change since the last frame. */
+	FCompositorMPCDeltaWriter MPCDeltaWriter;
+
+	/** Handles of the parameters in the Compositor material parameter collection. */
+	FCompositorMPCParameters MPCParameters;
+
+	/** Keeps the composite in step with the primary node when running on an nDisplay cluster. */
+	FCompositorClusterSync ClusterSync;
+
+	/** Step times of the last tick, so the steps are measured inside the tick that runs them. */
+	FCompositorTickTimings LastTickTimings;
+
+	/** The lens state the primary node of the cluster sent, replaces the one resolved on this node. */
+	TOptional<FCompositorClusterLensState> ClusterLensState;
+
+	/** Composite meshes waiting for their registration, oldest first from QueuedCompositeMeshesHead on. */
+	TArray<FObjectKey> QueuedCompositeMeshes;
+
+	int32 QueuedCompositeMeshesHead = 0;
+
+	/** The composite meshes still waiting, meshes unregistered while waiting are removed and skipped when their turn comes. */
+	TSet<FObjectKey> QueuedCompositeMeshKeys;
+
+	/** Composite meshes registered by the queue this tick, reported together once the budget is used up. */
+	TArray<ACompositeMesh*> RegisteredCompositeMeshBatch;
+
+	bool bIsRegisteringCompositeMeshBatch = false;
+
+	void ProcessQueuedCompositeMeshRegistrations();
+
 	FCompositePostProcessVolume CompositePostProcessVolume;
 
+	/** Render targets of the media and the captures, resizing them never reallocates the ones in use. */
+	FCompositorRenderTargetPool RenderTargetPool;
+
+	/** The render target each asset sampled by the materials reads in this world, null for the asset itself. */
+	UPROPERTY(Transient)
+	TMap<UTexture*, UTextureRenderTarget2D*> MaterialTextureBindings;
+
+	/** Have the bindings changed since they were last sent to the material binding view extension. */
+	bool bMaterialTextureBindingsDirty;
+
+	/** The render targets the soft mask upsample of the view extension was last sent. */
+	TWeakObjectPtr<UTextureRenderTarget2D> SoftMaskUpsampleSource;
+	TWeakObjectPtr<UTextureRenderTarget2D> SoftMaskUpsampleOutput;
+
 	TSharedPtr<FCompositeViewExtension, ESPMode::ThreadSafe> CompositeViewExtension;
 
+	/** Binds the material textures for every view family of this world, not only the composite one. */
+	TSharedPtr<FCompositeMaterialBindingViewExtension, ESPMode::ThreadSafe> MaterialBindingViewExtension;
+
+	/** Registered as a video sample sink of the media player, the player only holds it weakly. */
+	TSharedPtr<FCompositeMediaFrameQueue, ESPMode::ThreadSafe> MediaFrameQueue;
+
+	/** The media player the media frame queue receives samples from. */
+	TWeakObjectPtr<UMediaPlayer> MediaFrameQueuePlayer;
+
+	/** Registered as a video sample sink of the player of the active media texture, identifies its frames. */
+	TSharedPtr<FCompositeMediaSampleCounter, ESPMode::ThreadSafe> MediaSampleCounter;
+
+	/** The media player the media sample counter is attached to. */
+	TWeakObjectPtr<UMediaPlayer> MediaSampleCounterPlayer;
+
 	void ComputeCompositePostProcess(FVector ViewLocation, FSceneView* SceneView);
 
 	UPROPERTY(Transient)
@@ -226,14 +445,25 @@ public:
 	UFUNCTION(Category = "Compositor|Subsystem", BlueprintCallable)
 	void RemoveCompositeWorldData();
 
-	FORCEINLINE TArray<TScriptInterface<ICompositeUpdateInterface>> GetCompositeUpdateInterfaceArray() const { return CompositeUpdateInterfaceArray; }
+	FORCEINLINE const FCompositeUpdateRegistry& GetCompositeUpdateRegistry() const { return CompositeUpdateRegistry; }
 
 	FORCEINLINE UMaterialParameterCollection* GetCompositorMaterialParameterCollection() const { return CompositorMaterialParameterCollection; }
 
+	FORCEINLINE FCompositorMPCDeltaWriter& GetMPCDeltaWriter() { return MPCDeltaWriter; }
+
+	FORCEINLINE const FCompositorMPCParameters& GetMPCParameters() const { return MPCParameters; }
+
+	FORCEINLINE const FCompositorClusterSync& GetClusterSync() const { return ClusterSync; }
+
+	FORCEINLINE const FCompositorTickTimings& GetLastTickTimings() const { return LastTickTimings; }
+
 	FORCEINLINE UTexture* GetMediaInputDefaultFallbackTexture() const { return MediaInputDefaultFallbackTexture; }
 
 	FORCEINLINE FViewport* GetCompositeViewport() const { return CompositeViewport; }
 
+	/** Whether the view extension is active for the view family, the composite viewport while the world composite is enabled. */
+	bool IsCompositeViewFamily(const FSceneViewExtensionContext& Context) const;
+
 	UFUNCTION()
 	bool IsMediaTextureValid() const;
 	
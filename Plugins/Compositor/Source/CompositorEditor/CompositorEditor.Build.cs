@@ -43,6 +43,7 @@ public class CompositorEditor : ModuleRules
 				"Slate",
 				"SlateCore",
 				"EditorStyle",
+				"Json",
 
 				"PlacementMode",
 				"UMGEditor",
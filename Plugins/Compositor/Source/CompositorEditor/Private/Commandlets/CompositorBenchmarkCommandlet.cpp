@@ -0,0 +1,357 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Commandlets/CompositorBenchmarkCommandlet.h"
+
+#include "Actors/CompositeMesh.h"
+#include "Actors/CompositePlanarReflection.h"
+#include "Assets/Composite.h"
+#include "Assets/CompositeKeyer.h"
+#include "Objects/CompositeWorldData.h"
+#include "Objects/CompositorMPCDeltaWriter.h"
+#include "Subsystems/CompositorSubsystem.h"
+
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "RenderingThread.h"
+#include "SceneView.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCompositorBenchmark, Log, All);
+
+namespace CompositorBenchmark
+{
+	/** The keyer the benchmark world uses, the same one users get by default. */
+	const TCHAR* KeyerClassPath = TEXT("/Compositor/CompositeKeyer/UnrealColorDifference/BP_CompositeKeyer_UnrealColorDifference.BP_CompositeKeyer_UnrealColorDifference_C");
+
+	/** Runs a function and returns its duration in milliseconds. */
+	template<typename FunctionType>
+	double Time(FunctionType&& Function)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		Function();
+		return (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	}
+
+	double Percentile(TArray<double> Samples, double Percent)
+	{
+		if (Samples.Num() == 0)
+		{
+			return 0.0;
+		}
+
+		Samples.Sort();
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Percent / 100.0 * Samples.Num()) - 1, 0, Samples.Num() - 1);
+		return Samples[Index];
+	}
+
+	double Average(const TArray<double>& Samples)
+	{
+		double Sum = 0.0;
+		for (const double Sample : Samples)
+		{
+			Sum += Sample;
+		}
+		return Samples.Num() > 0 ? Sum / Samples.Num() : 0.0;
+	}
+}
+
+UCompositorBenchmarkCommandlet::UCompositorBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UCompositorBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 NumMeshes = 32;
+	int32 CompositeDepth = 4;
+	int32 NumFrames = 600;
+	int32 NumViews = 1;
+	FString OutputPath;
+
+	FParse::Value(*Params, TEXT("Meshes="), NumMeshes);
+	FParse::Value(*Params, TEXT("Depth="), CompositeDepth);
+	FParse::Value(*Params, TEXT("Frames="), NumFrames);
+	FParse::Value(*Params, TEXT("Views="), NumViews);
+	if (!FParse::Value(*Params, TEXT("Output="), OutputPath))
+	{
+		OutputPath = FPaths::ProjectSavedDir() / TEXT("Compositor") / FString::Printf(TEXT("Benchmark-%s"), *FDateTime::Now().ToString());
+	}
+
+	NumMeshes = FMath::Max(NumMeshes, 0);
+	CompositeDepth = FMath::Max(CompositeDepth, 1);
+	NumFrames = FMath::Max(NumFrames, 1);
+	NumViews = FMath::Max(NumViews, 1);
+
+	UE_LOG(LogCompositorBenchmark, Display, TEXT("Running Compositor benchmark with %d meshes, a composite chain of depth %d, %d views and %d frames."), NumMeshes, CompositeDepth, NumViews, NumFrames);
+
+	const FPlatformMemoryStats MemoryStatsBefore = FPlatformMemory::GetStats();
+
+	UWorld* World = CreateBenchmarkWorld(NumMeshes, CompositeDepth);
+	UCompositorSubsystem* CompositorSubsystem = World ? World->GetSubsystem<UCompositorSubsystem>() : nullptr;
+	if (!CompositorSubsystem)
+	{
+		UE_LOG(LogCompositorBenchmark, Error, TEXT("Failed to create the benchmark world or its Compositor Subsystem."));
+		DestroyBenchmarkWorld(World);
+		return 1;
+	}
+
+	UComposite* RootComposite = CompositorSubsystem->GetWorldComposite();
+	while (RootComposite && RootComposite->GetParentComposite())
+	{
+		RootComposite = RootComposite->GetParentComposite();
+	}
+
+	TArray<FTimingSamples> Timings;
+	FTimingSamples& TickTimings = Timings.Add_GetRef({ TEXT("Tick") });
+	// The steps of Tick, measured inside the tick that runs them so they add up to at most the Tick time.
+	FTimingSamples& ViewportInfoTimings = Timings.Add_GetRef({ TEXT("Tick.UpdateCompositeViewportInfo") });
+	FTimingSamples& MediaTimings = Timings.Add_GetRef({ TEXT("Tick.UpdateMedia") });
+	FTimingSamples& RenderTargetTimings = Timings.Add_GetRef({ TEXT("Tick.UpdateRenderTargets") });
+	FTimingSamples& KeyerTimings = Timings.Add_GetRef({ TEXT("Tick.UpdateCompositeKeyer") });
+	FTimingSamples& LensDataTimings = Timings.Add_GetRef({ TEXT("Tick.UpdateLensData") });
+	FTimingSamples& FlushTimings = Timings.Add_GetRef({ TEXT("Tick.Flush") });
+	FTimingSamples& PostProcessTimings = Timings.Add_GetRef({ TEXT("ComputeCompositePostProcess") });
+	FTimingSamples& CompositeUpdateTimings = Timings.Add_GetRef({ TEXT("OnCompositeUpdate_Internal") });
+	FTimingSamples& WorldTickTimings = Timings.Add_GetRef({ TEXT("WorldTick") });
+
+	// A view family without a render target, the post process setup only reads the show flags and view mode from it.
+	FSceneViewFamilyContext ViewFamily(FSceneViewFamily::ConstructionValues(nullptr, World->Scene, FEngineShowFlags(ESFIM_Game)).SetRealtimeUpdate(true));
+	for (int32 ViewIndex = 0; ViewIndex < NumViews; ++ViewIndex)
+	{
+		FSceneViewInitOptions ViewInitOptions;
+		ViewInitOptions.ViewFamily = &ViewFamily;
+		ViewInitOptions.SetViewRectangle(FIntRect(0, 0, 1920, 1080));
+		ViewInitOptions.ViewOrigin = FVector(-500.0 * ViewIndex, 0.0, 150.0);
+		ViewInitOptions.ViewRotationMatrix = FInverseRotationMatrix(FRotator::ZeroRotator) * FMatrix(FPlane(0, 0, 1, 0), FPlane(1, 0, 0, 0), FPlane(0, 1, 0, 0), FPlane(0, 0, 0, 1));
+		ViewInitOptions.ProjectionMatrix = FReversedZPerspectiveMatrix(FMath::DegreesToRadians(45.F), 1920.F, 1080.F, GNearClippingPlane);
+		ViewFamily.Views.Add(new FSceneView(ViewInitOptions));
+	}
+
+	const FCompositorMPCDeltaWriter& MPCDeltaWriter = CompositorSubsystem->GetMPCDeltaWriter();
+	const uint64 RenderTargetAllocationsBefore = CompositorSubsystem->GetRenderTargetPool().GetTotalAllocations();
+	const uint64 MPCWrittenBefore = MPCDeltaWriter.GetTotalParametersWritten();
+	const uint64 MPCSkippedBefore = MPCDeltaWriter.GetTotalParametersSkipped();
+	const float DeltaTime = 1.F / 60.F;
+
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		// Change a setting at the top of the chain every so often, like an operator adjusting the composite during a take.
+		if (RootComposite && Frame % 30 == 0)
+		{
+			RootComposite->SetShadowsGamma(1.F + (Frame / 30) % 4 * 0.1F);
+			CompositeUpdateTimings.Samples.Add(CompositorBenchmark::Time([&]() { CompositorSubsystem->OnCompositeUpdate_Internal(); }));
+		}
+
+		WorldTickTimings.Samples.Add(CompositorBenchmark::Time([&]() { World->Tick(LEVELTICK_All, DeltaTime); }));
+		TickTimings.Samples.Add(CompositorBenchmark::Time([&]() { CompositorSubsystem->Tick(DeltaTime); }));
+
+		const FCompositorTickTimings& TickStepTimings = CompositorSubsystem->GetLastTickTimings();
+		ViewportInfoTimings.Samples.Add(TickStepTimings.UpdateCompositeViewportInfo * 1000.0);
+		MediaTimings.Samples.Add(TickStepTimings.UpdateMedia * 1000.0);
+		RenderTargetTimings.Samples.Add(TickStepTimings.UpdateRenderTargets * 1000.0);
+		KeyerTimings.Samples.Add(TickStepTimings.UpdateCompositeKeyer * 1000.0);
+		LensDataTimings.Samples.Add(TickStepTimings.UpdateLensData * 1000.0);
+		FlushTimings.Samples.Add(TickStepTimings.Flush * 1000.0);
+
+		PostProcessTimings.Samples.Add(CompositorBenchmark::Time([&]()
+		{
+			for (const FSceneView* View : ViewFamily.Views)
+			{
+				CompositorSubsystem->ComputeCompositePostProcess(View->ViewLocation, const_cast<FSceneView*>(View));
+			}
+		}));
+
+		// Keep the render thread from falling behind, this is not part of any measurement.
+		FlushRenderingCommands();
+	}
+
+	const FPlatformMemoryStats MemoryStatsAfter = FPlatformMemory::GetStats();
+
+	TMap<FString, double> Counters;
+	Counters.Add(TEXT("Meshes"), NumMeshes);
+	Counters.Add(TEXT("CompositeDepth"), CompositeDepth);
+	Counters.Add(TEXT("Views"), NumViews);
+	Counters.Add(TEXT("Frames"), NumFrames);
+	Counters.Add(TEXT("MPCParametersWritten"), static_cast<double>(MPCDeltaWriter.GetTotalParametersWritten() - MPCWrittenBefore));
+	Counters.Add(TEXT("MPCParametersSkipped"), static_cast<double>(MPCDeltaWriter.GetTotalParametersSkipped() - MPCSkippedBefore));
+	Counters.Add(TEXT("RenderTargetAllocations"), static_cast<double>(CompositorSubsystem->GetRenderTargetPool().GetTotalAllocations() - RenderTargetAllocationsBefore));
+	// Process wide, this includes the benchmark world and anything the engine allocated meanwhile, it is not an allocation count.
+	Counters.Add(TEXT("UsedPhysicalMemoryDeltaBytes"), static_cast<double>(MemoryStatsAfter.UsedPhysical) - static_cast<double>(MemoryStatsBefore.UsedPhysical));
+	Counters.Add(TEXT("UsedVirtualMemoryDeltaBytes"), static_cast<double>(MemoryStatsAfter.UsedVirtual) - static_cast<double>(MemoryStatsBefore.UsedVirtual));
+
+	for (const FTimingSamples& Timing : Timings)
+	{
+		UE_LOG(LogCompositorBenchmark, Display, TEXT("%-32s avg %.4f ms, p95 %.4f ms, max %.4f ms"),
+			*Timing.Name, CompositorBenchmark::Average(Timing.Samples), CompositorBenchmark::Percentile(Timing.Samples, 95.0), CompositorBenchmark::Percentile(Timing.Samples, 100.0));
+	}
+	for (const TPair<FString, double>& Counter : Counters)
+	{
+		UE_LOG(LogCompositorBenchmark, Display, TEXT("%-32s %.0f"), *Counter.Key, Counter.Value);
+	}
+
+	const bool bWroteReports = WriteReports(OutputPath, Timings, Counters);
+
+	DestroyBenchmarkWorld(World);
+
+	return bWroteReports ? 0 : 1;
+}
+
+UWorld* UCompositorBenchmarkCommandlet::CreateBenchmarkWorld(int32 NumMeshes, int32 CompositeDepth) const
+{
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("CompositorBenchmark"));
+	if (!World)
+	{
+		return nullptr;
+	}
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	UCompositorSubsystem* CompositorSubsystem = World->GetSubsystem<UCompositorSubsystem>();
+	if (!CompositorSubsystem)
+	{
+		return World;
+	}
+
+	UCompositeWorldData* CompositeWorldData = CompositorSubsystem->FindOrAddCompositeWorldData();
+	UComposite* WorldComposite = CompositeWorldData ? CompositeWorldData->GetWorldComposite() : nullptr;
+	if (!WorldComposite)
+	{
+		return World;
+	}
+
+	// Build the parent chain above the world composite, the root overrides everything and each level in between overrides a single setting.
+	UComposite* ChildComposite = WorldComposite;
+	for (int32 Level = 1; Level < CompositeDepth; ++Level)
+	{
+		UComposite* ParentComposite = NewObject<UComposite>(GetTransientPackage(), NAME_None, RF_Transient);
+		ChildComposite->SetParentComposite(ParentComposite);
+
+		if (Level == CompositeDepth - 1)
+		{
+			ParentComposite->bOverride_EnableSoftMask = true;
+			ParentComposite->bOverride_EnableMediaShadows = true;
+			ParentComposite->bOverride_ShadowsGamma = true;
+			ParentComposite->bOverride_ShadowsTint = true;
+			ParentComposite->bOverride_EnablePlanarReflection = true;
+			ParentComposite->bOverride_PlanarReflectionColor = true;
+			ParentComposite->bOverride_MediaBlend = true;
+			ParentComposite->SetEnableSoftMask(true);
+			ParentComposite->SetEnableMediaShadows(true);
+			ParentComposite->SetEnablePlanarReflection(true);
+		}
+		else
+		{
+			ParentComposite->bOverride_ShadowsOffset = true;
+			ParentComposite->SetShadowsOffset(0.01F * Level);
+		}
+
+		ChildComposite = ParentComposite;
+	}
+
+	if (UClass* KeyerClass = LoadClass<UCompositeKeyer>(nullptr, CompositorBenchmark::KeyerClassPath))
+	{
+		WorldComposite->bOverride_MediaInputKeyer = true;
+		WorldComposite->SetMediaInputKeyer(NewObject<UCompositeKeyer>(WorldComposite, KeyerClass, NAME_None, RF_Transient));
+	}
+	else
+	{
+		UE_LOG(LogCompositorBenchmark, Warning, TEXT("Could not load the keyer %s, running without a keyer."), CompositorBenchmark::KeyerClassPath);
+	}
+	UComposite::MarkSettingsDirty();
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	ACompositePlanarReflection* CompositePlanarReflection = World->SpawnActor<ACompositePlanarReflection>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParameters);
+	CompositeWorldData->SetCompositePlanarReflection(CompositePlanarReflection);
+
+	// Lay the meshes out in a grid, like the pieces of a green screen set.
+	const int32 GridSize = FMath::Max(FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumMeshes))), 1);
+	for (int32 MeshIndex = 0; MeshIndex < NumMeshes; ++MeshIndex)
+	{
+		const FVector Location((MeshIndex % GridSize) * 200.0, (MeshIndex / GridSize) * 200.0, 0.0);
+		World->SpawnActor<ACompositeMesh>(Location, FRotator::ZeroRotator, SpawnParameters);
+	}
+
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	return World;
+}
+
+void UCompositorBenchmarkCommandlet::DestroyBenchmarkWorld(UWorld* World) const
+{
+	if (!World)
+	{
+		return;
+	}
+
+	FlushRenderingCommands();
+
+	World->EndPlay(EEndPlayReason::Quit);
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
+
+bool UCompositorBenchmarkCommandlet::WriteReports(const FString& OutputPath, const TArray<FTimingSamples>& Timings, const TMap<FString, double>& Counters) const
+{
+	TSharedRef<FJsonObject> RootObject = MakeShared<FJsonObject>();
+	TSharedRef<FJsonObject> TimingsObject = MakeShared<FJsonObject>();
+	TSharedRef<FJsonObject> CountersObject = MakeShared<FJsonObject>();
+
+	FString Csv = TEXT("Name,AverageMs,MedianMs,P95Ms,MaxMs,Samples\n");
+
+	for (const FTimingSamples& Timing : Timings)
+	{
+		const double AverageMs = CompositorBenchmark::Average(Timing.Samples);
+		const double MedianMs = CompositorBenchmark::Percentile(Timing.Samples, 50.0);
+		const double P95Ms = CompositorBenchmark::Percentile(Timing.Samples, 95.0);
+		const double MaxMs = CompositorBenchmark::Percentile(Timing.Samples, 100.0);
+
+		TSharedRef<FJsonObject> TimingObject = MakeShared<FJsonObject>();
+		TimingObject->SetNumberField(TEXT("AverageMs"), AverageMs);
+		TimingObject->SetNumberField(TEXT("MedianMs"), MedianMs);
+		TimingObject->SetNumberField(TEXT("P95Ms"), P95Ms);
+		TimingObject->SetNumberField(TEXT("MaxMs"), MaxMs);
+		TimingObject->SetNumberField(TEXT("Samples"), Timing.Samples.Num());
+		TimingsObject->SetObjectField(Timing.Name, TimingObject);
+
+		Csv += FString::Printf(TEXT("%s,%.6f,%.6f,%.6f,%.6f,%d\n"), *Timing.Name, AverageMs, MedianMs, P95Ms, MaxMs, Timing.Samples.Num());
+	}
+
+	for (const TPair<FString, double>& Counter : Counters)
+	{
+		CountersObject->SetNumberField(Counter.Key, Counter.Value);
+		Csv += FString::Printf(TEXT("%s,%.0f,,,,\n"), *Counter.Key, Counter.Value);
+	}
+
+	RootObject->SetObjectField(TEXT("Timings"), TimingsObject);
+	RootObject->SetObjectField(TEXT("Counters"), CountersObject);
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> JsonWriter = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(RootObject, JsonWriter);
+
+	const FString JsonPath = OutputPath + TEXT(".json");
+	const FString CsvPath = OutputPath + TEXT(".csv");
+
+	if (!FFileHelper::SaveStringToFile(Json, *JsonPath) || !FFileHelper::SaveStringToFile(Csv, *CsvPath))
+	{
+		UE_LOG(LogCompositorBenchmark, Error, TEXT("Failed to write the benchmark reports to %s."), *OutputPath);
+		return false;
+	}
+
+	UE_LOG(LogCompositorBenchmark, Display, TEXT("Wrote benchmark reports to %s and %s."), *JsonPath, *CsvPath);
+	return true;
+}
@@ -39,5 +39,26 @@ void FCompositePlanarReflectionDetails::CustomizeDetails(IDetailLayoutBuilder& D
 		{
 			CustomCategory.AddProperty(ChildHandle);
 		}
+
+		// Culling, level of detail and lighting of the capture, shown below the list they apply to.
+		static const FName CullingPropertyNames[] =
+		{
+			"bCullShowOnlyActors",
+			"CullDistance",
+			"MaxCapturedActors",
+			"LODDistanceFactor",
+			"LightingMode",
+			"NumCapturedActors",
+			"NumCapturedPrimitives",
+		};
+
+		for (const FName& PropertyName : CullingPropertyNames)
+		{
+			TSharedPtr<IPropertyHandle> CullingHandle = PropertyHandle->GetChildHandle(PropertyName);
+			if (CullingHandle.IsValid() && CullingHandle->IsValidHandle())
+			{
+				CustomCategory.AddProperty(CullingHandle);
+			}
+		}
 	}
 }
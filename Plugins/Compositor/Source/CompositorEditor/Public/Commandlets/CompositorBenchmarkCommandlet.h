@@ -0,0 +1,45 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CompositorBenchmarkCommandlet.generated.h"
+
+class UWorld;
+
+/**
+ * Measures the game thread cost of the Compositor in a generated world, without requiring a GPU.
+ *
+ * Usage: UnrealEditor-Cmd <Project> -run=CompositorBenchmark -nullrhi [-Meshes=32] [-Depth=4] [-Frames=600] [-Views=1] [-Output=<Path without extension>]
+ *
+ * Runs on every platform the plugin supports, Win64 and Linux, so it can run on headless build agents.
+ * The steps of the subsystem tick are timed inside the tick itself, see FCompositorTickTimings.
+ * Writes a JSON and a CSV report to Saved/Compositor unless an output path is given.
+ */
+UCLASS()
+class UCompositorBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCompositorBenchmarkCommandlet();
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+
+private:
+	/** Timing samples of a single subsystem function, in milliseconds. */
+	struct FTimingSamples
+	{
+		FString Name;
+		TArray<double> Samples;
+	};
+
+	UWorld* CreateBenchmarkWorld(int32 NumMeshes, int32 CompositeDepth) const;
+
+	void DestroyBenchmarkWorld(UWorld* World) const;
+
+	bool WriteReports(const FString& OutputPath, const TArray<FTimingSamples>& Timings, const TMap<FString, double>& Counters) const;
+};
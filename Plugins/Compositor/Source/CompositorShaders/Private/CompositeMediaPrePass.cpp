@@ -0,0 +1,129 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CompositeMediaPrePass.h"
+
+#include "GlobalShader.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "ShaderParameterStruct.h"
+
+class FCompositeMediaPrePassCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FCompositeMediaPrePassCS);
+	SHADER_USE_PARAMETER_STRUCT(FCompositeMediaPrePassCS, FGlobalShader);
+
+	static constexpr int32 ThreadGroupSize = 8;
+
+	class FUndistortDim : SHADER_PERMUTATION_BOOL("UNDISTORT");
+	class FKeyDim : SHADER_PERMUTATION_BOOL("KEY");
+	class FGradeDim : SHADER_PERMUTATION_BOOL("GRADE");
+	using FPermutationDomain = TShaderPermutationDomain<FUndistortDim, FKeyDim, FGradeDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, MediaTexture)
+		SHADER_PARAMETER_SAMPLER(SamplerState, MediaSampler)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, UndistortTexture)
+		SHADER_PARAMETER_SAMPLER(SamplerState, UndistortSampler)
+		SHADER_PARAMETER(FIntPoint, OutputExtent)
+		SHADER_PARAMETER(FVector2f, OutputExtentInverse)
+		SHADER_PARAMETER(FVector3f, KeyChannelMask)
+		SHADER_PARAMETER(FVector3f, Other1Mask)
+		SHADER_PARAMETER(FVector3f, Other2Mask)
+		SHADER_PARAMETER(float, Weight1)
+		SHADER_PARAMETER(float, Weight2)
+		SHADER_PARAMETER(float, InvKeyDifference)
+		SHADER_PARAMETER(float, AlphaThreshold)
+		SHADER_PARAMETER(float, AlphaOffset)
+		SHADER_PARAMETER(float, ClipBlack)
+		SHADER_PARAMETER(float, InvClipRange)
+		SHADER_PARAMETER(float, ForceOpaque)
+		SHADER_PARAMETER(FVector4f, GradeSaturation)
+		SHADER_PARAMETER(FVector4f, GradeContrast)
+		SHADER_PARAMETER(FVector4f, GradeGamma)
+		SHADER_PARAMETER(FVector4f, GradeGain)
+		SHADER_PARAMETER(FVector4f, GradeOffset)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, OutputTexture)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE"), ThreadGroupSize);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FCompositeMediaPrePassCS, "/Plugin/Compositor/Private/CompositeMediaPrePass.usf", "MainCS", SF_Compute);
+
+namespace CompositeMediaPrePass
+{
+	FVector3f ChannelMask(int32 Channel)
+	{
+		FVector3f Mask = FVector3f::ZeroVector;
+		Mask[Channel % 3] = 1.F;
+		return Mask;
+	}
+}
+
+void AddCompositeMediaPrePass(FRDGBuilder& GraphBuilder, const FCompositeMediaPrePassInputs& Inputs)
+{
+	if (!Inputs.MediaTexture || !Inputs.OutputTexture)
+	{
+		return;
+	}
+
+	const FIntPoint OutputExtent = Inputs.OutputTexture->Desc.Extent;
+	const bool bUndistort = Inputs.UndistortTexture != nullptr;
+	const FCompositeMediaPrePassInputs NeutralInputs;
+	const bool bGrade = Inputs.GradeSaturation != NeutralInputs.GradeSaturation
+		|| Inputs.GradeContrast != NeutralInputs.GradeContrast
+		|| Inputs.GradeGamma != NeutralInputs.GradeGamma
+		|| Inputs.GradeGain != NeutralInputs.GradeGain
+		|| Inputs.GradeOffset != NeutralInputs.GradeOffset;
+	const int32 KeyChannel = FMath::Clamp(Inputs.KeyChannel, 0, 2);
+
+	FCompositeMediaPrePassCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FCompositeMediaPrePassCS::FParameters>();
+	PassParameters->MediaTexture = Inputs.MediaTexture;
+	PassParameters->MediaSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+	// Unused without the undistort permutation, but every texture parameter has to be bound.
+	PassParameters->UndistortTexture = bUndistort ? Inputs.UndistortTexture : Inputs.MediaTexture;
+	PassParameters->UndistortSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+	PassParameters->OutputExtent = OutputExtent;
+	PassParameters->OutputExtentInverse = FVector2f(1.F / FMath::Max(OutputExtent.X, 1), 1.F / FMath::Max(OutputExtent.Y, 1));
+	PassParameters->KeyChannelMask = CompositeMediaPrePass::ChannelMask(KeyChannel);
+	// The other two channels in RGB order, like FCompositeKeyerCPU.
+	PassParameters->Other1Mask = CompositeMediaPrePass::ChannelMask(KeyChannel == 0 ? 1 : 0);
+	PassParameters->Other2Mask = CompositeMediaPrePass::ChannelMask(KeyChannel == 2 ? 1 : 2);
+	PassParameters->Weight1 = Inputs.Weight1;
+	PassParameters->Weight2 = Inputs.Weight2;
+	PassParameters->InvKeyDifference = Inputs.InvKeyDifference;
+	PassParameters->AlphaThreshold = Inputs.AlphaThreshold;
+	PassParameters->AlphaOffset = Inputs.AlphaOffset;
+	PassParameters->ClipBlack = Inputs.ClipBlack;
+	PassParameters->InvClipRange = Inputs.InvClipRange;
+	PassParameters->ForceOpaque = Inputs.bForceOpaque ? 1.F : 0.F;
+	PassParameters->GradeSaturation = Inputs.GradeSaturation;
+	PassParameters->GradeContrast = Inputs.GradeContrast;
+	PassParameters->GradeGamma = Inputs.GradeGamma;
+	PassParameters->GradeGain = Inputs.GradeGain;
+	PassParameters->GradeOffset = Inputs.GradeOffset;
+	PassParameters->OutputTexture = GraphBuilder.CreateUAV(Inputs.OutputTexture);
+
+	FCompositeMediaPrePassCS::FPermutationDomain PermutationVector;
+	PermutationVector.Set<FCompositeMediaPrePassCS::FUndistortDim>(bUndistort);
+	PermutationVector.Set<FCompositeMediaPrePassCS::FKeyDim>(Inputs.bKey);
+	PermutationVector.Set<FCompositeMediaPrePassCS::FGradeDim>(bGrade);
+	TShaderMapRef<FCompositeMediaPrePassCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+
+	FComputeShaderUtils::AddPass(
+		GraphBuilder,
+		RDG_EVENT_NAME("CompositeMediaPrePass %dx%d%s%s%s", OutputExtent.X, OutputExtent.Y, bUndistort ? TEXT(" Undistort") : TEXT(""), Inputs.bKey ? TEXT(" Key") : TEXT(""), bGrade ? TEXT(" Grade") : TEXT("")),
+		ComputeShader,
+		PassParameters,
+		FComputeShaderUtils::GetGroupCount(OutputExtent, FCompositeMediaPrePassCS::ThreadGroupSize));
+}
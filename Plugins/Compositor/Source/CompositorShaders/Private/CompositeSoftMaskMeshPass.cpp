@@ -0,0 +1,187 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CompositeSoftMaskMeshPass.h"
+
+#include "Algo/StableSort.h"
+#include "GlobalShader.h"
+#include "PipelineStateCache.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RenderResource.h"
+#include "RenderUtils.h"
+#include "SceneView.h"
+#include "ShaderParameterStruct.h"
+
+/** Largest half float, the depth of pixels without a soft mask mesh. Matches FCompositeSoftMaskUpsampleCPU::FarDepth. */
+static constexpr float CompositeSoftMaskFarDepth = 65504.F;
+
+/** Positions in stream 0, vertex colors in stream 1. Meshes without vertex colors bind a single white color with a stride of 0. */
+class FCompositeSoftMaskVertexDeclaration : public FRenderResource
+{
+public:
+	explicit FCompositeSoftMaskVertexDeclaration(uint16 InColorStride)
+		: ColorStride(InColorStride)
+	{}
+
+	FVertexDeclarationRHIRef VertexDeclarationRHI;
+
+	virtual void InitRHI() override
+	{
+		FVertexDeclarationElementList Elements;
+		Elements.Add(FVertexElement(0, 0, VET_Float3, 0, sizeof(FVector3f)));
+		Elements.Add(FVertexElement(1, 0, VET_Color, 1, ColorStride));
+		VertexDeclarationRHI = PipelineStateCache::GetOrCreateVertexDeclaration(Elements);
+	}
+
+	virtual void ReleaseRHI() override
+	{
+		VertexDeclarationRHI.SafeRelease();
+	}
+
+private:
+	uint16 ColorStride;
+};
+
+static TGlobalResource<FCompositeSoftMaskVertexDeclaration> GCompositeSoftMaskVertexDeclaration(static_cast<uint16>(sizeof(FColor)));
+static TGlobalResource<FCompositeSoftMaskVertexDeclaration> GCompositeSoftMaskVertexDeclarationNoColor(static_cast<uint16>(0));
+
+class FCompositeSoftMaskMeshVS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FCompositeSoftMaskMeshVS);
+	SHADER_USE_PARAMETER_STRUCT(FCompositeSoftMaskMeshVS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FMatrix44f, LocalToClip)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+};
+
+class FCompositeSoftMaskMeshPS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FCompositeSoftMaskMeshPS);
+	SHADER_USE_PARAMETER_STRUCT(FCompositeSoftMaskMeshPS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(float, Value)
+		SHADER_PARAMETER(float, UseVertexColorAlpha)
+		SHADER_PARAMETER(float, Translucent)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FCompositeSoftMaskMeshVS, "/Plugin/Compositor/Private/CompositeSoftMaskMeshPass.usf", "MainVS", SF_Vertex);
+IMPLEMENT_GLOBAL_SHADER(FCompositeSoftMaskMeshPS, "/Plugin/Compositor/Private/CompositeSoftMaskMeshPass.usf", "MainPS", SF_Pixel);
+
+BEGIN_SHADER_PARAMETER_STRUCT(FCompositeSoftMaskMeshPassParameters, )
+	RENDER_TARGET_BINDING_SLOTS()
+END_SHADER_PARAMETER_STRUCT()
+
+void AddCompositeSoftMaskMeshPass(FRDGBuilder& GraphBuilder, FCompositeSoftMaskMeshPassInputs&& Inputs)
+{
+	if (!Inputs.View || !Inputs.OutputTexture)
+	{
+		return;
+	}
+
+	const FIntPoint OutputExtent = Inputs.OutputTexture->Desc.Extent;
+	const FIntRect ViewRect(
+		FIntPoint(FMath::FloorToInt(Inputs.ViewportMin.X * OutputExtent.X), FMath::FloorToInt(Inputs.ViewportMin.Y * OutputExtent.Y)),
+		FIntPoint(FMath::CeilToInt(Inputs.ViewportMax.X * OutputExtent.X), FMath::CeilToInt(Inputs.ViewportMax.Y * OutputExtent.Y)));
+	if (ViewRect.Area() <= 0)
+	{
+		return;
+	}
+
+	if (Inputs.bClear)
+	{
+		AddClearRenderTargetPass(GraphBuilder, Inputs.OutputTexture, FLinearColor(0.F, 0.F, 0.F, CompositeSoftMaskFarDepth));
+	}
+
+	// Translucent meshes blend over the opaque ones, so those have to be in the depth buffer first.
+	Algo::StableSortBy(Inputs.Draws, &FCompositeSoftMaskMeshDraw::bTranslucent);
+
+	FRDGTextureRef DepthTexture = GraphBuilder.CreateTexture(
+		FRDGTextureDesc::Create2D(OutputExtent, PF_DepthStencil, FClearValueBinding::DepthFar, TexCreate_DepthStencilTargetable),
+		TEXT("Compositor.SoftMaskDepth"));
+
+	FCompositeSoftMaskMeshPassParameters* PassParameters = GraphBuilder.AllocParameters<FCompositeSoftMaskMeshPassParameters>();
+	PassParameters->RenderTargets[0] = FRenderTargetBinding(Inputs.OutputTexture, ERenderTargetLoadAction::ELoad);
+	PassParameters->RenderTargets.DepthStencil = FDepthStencilBinding(DepthTexture, ERenderTargetLoadAction::EClear, ERenderTargetLoadAction::ENoAction, FExclusiveDepthStencil::DepthWrite_StencilNop);
+
+	TShaderMapRef<FCompositeSoftMaskMeshVS> VertexShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+	TShaderMapRef<FCompositeSoftMaskMeshPS> PixelShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+
+	// Translated world space keeps the precision of the matrices far from the origin.
+	const FViewMatrices& ViewMatrices = Inputs.View->ViewMatrices;
+	const FVector PreViewTranslation = ViewMatrices.GetPreViewTranslation();
+	const FMatrix TranslatedViewProjectionMatrix = ViewMatrices.GetTranslatedViewProjectionMatrix();
+	const bool bReverseCulling = Inputs.View->bReverseCulling;
+
+	GraphBuilder.AddPass(
+		RDG_EVENT_NAME("CompositeSoftMaskMeshPass %d meshes %dx%d", Inputs.Draws.Num(), ViewRect.Width(), ViewRect.Height()),
+		PassParameters,
+		ERDGPassFlags::Raster,
+		[Draws = MoveTemp(Inputs.Draws), ViewRect, PreViewTranslation, TranslatedViewProjectionMatrix, bReverseCulling, VertexShader, PixelShader](FRHICommandList& RHICmdList)
+	{
+		RHICmdList.SetViewport(ViewRect.Min.X, ViewRect.Min.Y, 0.F, ViewRect.Max.X, ViewRect.Max.Y, 1.F);
+
+		for (const FCompositeSoftMaskMeshDraw& Draw : Draws)
+		{
+			if (!Draw.PositionBuffer || !Draw.IndexBuffer || Draw.NumIndices < 3)
+			{
+				continue;
+			}
+
+			// Mirrored transforms flip the winding, like the mesh pass processors of the renderer.
+			const bool bFlipWinding = bReverseCulling != (Draw.LocalToWorld.Determinant() < 0.0);
+			const ERasterizerCullMode CullMode = Draw.bTwoSided ? CM_None : (bFlipWinding ? CM_CCW : CM_CW);
+
+			FGraphicsPipelineStateInitializer GraphicsPSOInit;
+			RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);
+			GraphicsPSOInit.RasterizerState = CullMode == CM_None ? TStaticRasterizerState<FM_Solid, CM_None>::GetRHI()
+				: (CullMode == CM_CW ? TStaticRasterizerState<FM_Solid, CM_CW>::GetRHI() : TStaticRasterizerState<FM_Solid, CM_CCW>::GetRHI());
+
+			if (Draw.bTranslucent)
+			{
+				// Alpha holds the depth of the opaque meshes behind, translucent meshes only blend the mask.
+				GraphicsPSOInit.BlendState = TStaticBlendState<CW_RGBA, BO_Add, BF_SourceAlpha, BF_InverseSourceAlpha, BO_Add, BF_Zero, BF_One>::GetRHI();
+				GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_DepthNearOrEqual>::GetRHI();
+			}
+			else
+			{
+				GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();
+				GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<true, CF_DepthNearOrEqual>::GetRHI();
+			}
+
+			GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = Draw.ColorBuffer ? GCompositeSoftMaskVertexDeclaration.VertexDeclarationRHI : GCompositeSoftMaskVertexDeclarationNoColor.VertexDeclarationRHI;
+			GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
+			GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
+			GraphicsPSOInit.PrimitiveType = PT_TriangleList;
+			SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit, 0);
+
+			FCompositeSoftMaskMeshVS::FParameters VertexParameters;
+			VertexParameters.LocalToClip = FMatrix44f(Draw.LocalToWorld.ConcatTranslation(PreViewTranslation) * TranslatedViewProjectionMatrix);
+			SetShaderParameters(RHICmdList, VertexShader, VertexShader.GetVertexShader(), VertexParameters);
+
+			FCompositeSoftMaskMeshPS::FParameters PixelParameters;
+			PixelParameters.Value = Draw.Value;
+			PixelParameters.UseVertexColorAlpha = Draw.bUseVertexColorAlpha ? 1.F : 0.F;
+			PixelParameters.Translucent = Draw.bTranslucent ? 1.F : 0.F;
+			SetShaderParameters(RHICmdList, PixelShader, PixelShader.GetPixelShader(), PixelParameters);
+
+			RHICmdList.SetStreamSource(0, Draw.PositionBuffer.GetReference(), 0);
+			RHICmdList.SetStreamSource(1, Draw.ColorBuffer ? Draw.ColorBuffer.GetReference() : GNullColorVertexBuffer.VertexBufferRHI.GetReference(), 0);
+			RHICmdList.DrawIndexedPrimitive(Draw.IndexBuffer.GetReference(), 0, 0, Draw.NumVertices, 0, Draw.NumIndices / 3, 1);
+		}
+	});
+}
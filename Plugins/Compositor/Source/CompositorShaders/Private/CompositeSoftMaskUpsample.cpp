@@ -0,0 +1,92 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CompositeSoftMaskUpsample.h"
+
+#include "GlobalShader.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "SceneView.h"
+#include "ShaderParameterStruct.h"
+#include "SystemTextures.h"
+
+class FCompositeSoftMaskUpsampleCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FCompositeSoftMaskUpsampleCS);
+	SHADER_USE_PARAMETER_STRUCT(FCompositeSoftMaskUpsampleCS, FGlobalShader);
+
+	static constexpr int32 ThreadGroupSize = 8;
+
+	class FGuideDim : SHADER_PERMUTATION_BOOL("GUIDE");
+	class FTemporalDim : SHADER_PERMUTATION_BOOL("TEMPORAL");
+	using FPermutationDomain = TShaderPermutationDomain<FGuideDim, FTemporalDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SoftMaskTexture)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, CustomDepthTexture)
+		SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D<uint2>, CustomStencilTexture)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, HistoryTexture)
+		SHADER_PARAMETER(FIntPoint, SoftMaskExtent)
+		SHADER_PARAMETER(FIntPoint, OutputExtent)
+		SHADER_PARAMETER(FVector2f, OutputExtentInverse)
+		SHADER_PARAMETER(uint32, MinStencilValue)
+		SHADER_PARAMETER(float, DepthSigma)
+		SHADER_PARAMETER(float, TemporalWeight)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, OutputTexture)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float>, HistoryOutputTexture)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE"), ThreadGroupSize);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FCompositeSoftMaskUpsampleCS, "/Plugin/Compositor/Private/CompositeSoftMaskUpsample.usf", "MainCS", SF_Compute);
+
+void AddCompositeSoftMaskUpsamplePass(FRDGBuilder& GraphBuilder, const FCompositeSoftMaskUpsampleInputs& Inputs)
+{
+	if (!Inputs.View || !Inputs.SoftMaskTexture || !Inputs.OutputTexture || !Inputs.HistoryOutputTexture)
+	{
+		return;
+	}
+
+	const FIntPoint OutputExtent = Inputs.OutputTexture->Desc.Extent;
+	const bool bGuide = Inputs.CustomDepthTexture && Inputs.CustomStencilTexture;
+	const bool bTemporal = Inputs.HistoryTexture && Inputs.HistoryTexture->Desc.Extent == OutputExtent && Inputs.TemporalWeight > 0.F;
+
+	FCompositeSoftMaskUpsampleCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FCompositeSoftMaskUpsampleCS::FParameters>();
+	PassParameters->View = Inputs.View->ViewUniformBuffer;
+	PassParameters->SoftMaskTexture = Inputs.SoftMaskTexture;
+	// Unused without the guide or temporal permutations, but every texture parameter has to be bound.
+	PassParameters->CustomDepthTexture = bGuide ? Inputs.CustomDepthTexture : Inputs.SoftMaskTexture;
+	PassParameters->CustomStencilTexture = bGuide ? Inputs.CustomStencilTexture : GraphBuilder.CreateSRV(FRDGTextureSRVDesc::Create(GSystemTextures.GetZeroUIntDummy(GraphBuilder)));
+	PassParameters->HistoryTexture = bTemporal ? Inputs.HistoryTexture : Inputs.SoftMaskTexture;
+	PassParameters->SoftMaskExtent = Inputs.SoftMaskTexture->Desc.Extent;
+	PassParameters->OutputExtent = OutputExtent;
+	PassParameters->OutputExtentInverse = FVector2f(1.F / FMath::Max(OutputExtent.X, 1), 1.F / FMath::Max(OutputExtent.Y, 1));
+	PassParameters->MinStencilValue = static_cast<uint32>(FMath::Clamp(Inputs.MinStencilValue, 0, 255));
+	PassParameters->DepthSigma = FMath::Max(Inputs.DepthSigma, KINDA_SMALL_NUMBER);
+	PassParameters->TemporalWeight = FMath::Clamp(Inputs.TemporalWeight, 0.F, 1.F);
+	PassParameters->OutputTexture = GraphBuilder.CreateUAV(Inputs.OutputTexture);
+	PassParameters->HistoryOutputTexture = GraphBuilder.CreateUAV(Inputs.HistoryOutputTexture);
+
+	FCompositeSoftMaskUpsampleCS::FPermutationDomain PermutationVector;
+	PermutationVector.Set<FCompositeSoftMaskUpsampleCS::FGuideDim>(bGuide);
+	PermutationVector.Set<FCompositeSoftMaskUpsampleCS::FTemporalDim>(bTemporal);
+	TShaderMapRef<FCompositeSoftMaskUpsampleCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+
+	FComputeShaderUtils::AddPass(
+		GraphBuilder,
+		RDG_EVENT_NAME("CompositeSoftMaskUpsample %dx%d -> %dx%d%s%s", PassParameters->SoftMaskExtent.X, PassParameters->SoftMaskExtent.Y, OutputExtent.X, OutputExtent.Y, bGuide ? TEXT(" Guide") : TEXT(""), bTemporal ? TEXT(" Temporal") : TEXT("")),
+		ComputeShader,
+		PassParameters,
+		FComputeShaderUtils::GetGroupCount(OutputExtent, FCompositeSoftMaskUpsampleCS::ThreadGroupSize));
+}
@@ -0,0 +1,22 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CompositorShadersModule.h"
+
+#include "Interfaces/IPluginManager.h"
+#include "Misc/Paths.h"
+#include "ShaderCore.h"
+
+void FCompositorShadersModule::StartupModule()
+{
+	const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("Compositor"));
+	if (Plugin.IsValid())
+	{
+		AddShaderSourceDirectoryMapping(TEXT("/Plugin/Compositor"), FPaths::Combine(Plugin->GetBaseDir(), TEXT("Shaders")));
+	}
+}
+
+void FCompositorShadersModule::ShutdownModule()
+{
+}
+
+IMPLEMENT_MODULE(FCompositorShadersModule, CompositorShaders)
@@ -0,0 +1,50 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphDefinitions.h"
+
+class FRDGBuilder;
+
+/**
+ * Inputs of the media pre pass, which undistorts, keys, despills and grades the media in a single compute dispatch.
+ * The key values are the derived constants of the color difference key, see FCompositeKeyerCPU.
+ * Without the key the pass only undistorts or copies, keeping the source alpha unless it is forced opaque.
+ */
+struct COMPOSITORSHADERS_API FCompositeMediaPrePassInputs
+{
+	/** The media frame, sampled once per output pixel. */
+	FRDGTextureRef MediaTexture = nullptr;
+
+	/** UV offsets in RG added to the output UV to find the media pixel, null skips the undistortion. */
+	FRDGTextureRef UndistortTexture = nullptr;
+
+	/** Receives the keyed and graded media with the matte in alpha, needs UAV support. */
+	FRDGTextureRef OutputTexture = nullptr;
+
+	/** Applies the color difference key and despill of the Unreal Color Difference keyer material. */
+	bool bKey = true;
+
+	/** Writes an alpha of 1 when not keying, like the keyer disabled fallback material. */
+	bool bForceOpaque = false;
+
+	int32 KeyChannel = 1;
+	float Weight1 = 0.5F;
+	float Weight2 = 0.5F;
+	float InvKeyDifference = 1.F;
+	float AlphaThreshold = 0.F;
+	float AlphaOffset = 0.F;
+	float ClipBlack = 0.F;
+	float InvClipRange = 1.F;
+
+	/** Global range of the media color grade, the alpha of each value multiplies its color. The grade is skipped when neutral. */
+	FVector4f GradeSaturation = FVector4f(1.F, 1.F, 1.F, 1.F);
+	FVector4f GradeContrast = FVector4f(1.F, 1.F, 1.F, 1.F);
+	FVector4f GradeGamma = FVector4f(1.F, 1.F, 1.F, 1.F);
+	FVector4f GradeGain = FVector4f(1.F, 1.F, 1.F, 1.F);
+	FVector4f GradeOffset = FVector4f(0.F, 0.F, 0.F, 0.F);
+};
+
+/** Adds the fused media pre pass to the graph, does nothing when the media or output texture is missing. */
+COMPOSITORSHADERS_API void AddCompositeMediaPrePass(FRDGBuilder& GraphBuilder, const FCompositeMediaPrePassInputs& Inputs);
@@ -0,0 +1,62 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphDefinitions.h"
+#include "RHIResources.h"
+
+class FRDGBuilder;
+class FSceneView;
+
+/** A mesh drawn into the soft mask, the vertex and index buffers of its LOD. Holding the buffers keeps them alive until the pass ran. */
+struct COMPOSITORSHADERS_API FCompositeSoftMaskMeshDraw
+{
+	/** Positions as three floats per vertex. */
+	FBufferRHIRef PositionBuffer;
+
+	/** Vertex colors as FColor, null draws white. */
+	FBufferRHIRef ColorBuffer;
+
+	FBufferRHIRef IndexBuffer;
+
+	uint32 NumVertices = 0;
+	uint32 NumIndices = 0;
+
+	FMatrix LocalToWorld = FMatrix::Identity;
+
+	/** Written into the mask where the mesh is visible, multiplied by the vertex color alpha if used. */
+	float Value = 1.F;
+
+	bool bUseVertexColorAlpha = false;
+
+	/** Blends white over the meshes behind with the vertex color alpha, without occluding them. */
+	bool bTranslucent = false;
+
+	bool bTwoSided = false;
+};
+
+/**
+ * Inputs of the soft mask mesh pass, which draws the soft mask meshes from the matrices of a view without a scene capture.
+ * The mask goes into red, green and blue and the linear depth into alpha, like a scene capture of scene color and depth.
+ */
+struct COMPOSITORSHADERS_API FCompositeSoftMaskMeshPassInputs
+{
+	const FSceneView* View = nullptr;
+
+	/** Receives the soft mask. */
+	FRDGTextureRef OutputTexture = nullptr;
+
+	/** The part of the output this view draws into, as a fraction of the output size. */
+	FVector2f ViewportMin = FVector2f::ZeroVector;
+	FVector2f ViewportMax = FVector2f::UnitVector;
+
+	/** Clears the whole output before drawing, only the first view drawn into an output should clear it. */
+	bool bClear = true;
+
+	/** Opaque meshes first, translucent ones are drawn last in the order given. */
+	TArray<FCompositeSoftMaskMeshDraw> Draws;
+};
+
+/** Adds the soft mask mesh pass to the graph, does nothing when the view or output texture is missing. */
+COMPOSITORSHADERS_API void AddCompositeSoftMaskMeshPass(FRDGBuilder& GraphBuilder, FCompositeSoftMaskMeshPassInputs&& Inputs);
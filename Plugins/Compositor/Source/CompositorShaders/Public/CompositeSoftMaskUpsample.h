@@ -0,0 +1,45 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphDefinitions.h"
+
+class FRDGBuilder;
+class FSceneView;
+
+/**
+ * Inputs of the soft mask upsample, which reconstructs a low resolution soft mask capture at the output resolution.
+ * The four nearest capture pixels are filtered bilinearly, weighted by how close their depth is to the custom depth of the output pixel,
+ * see FCompositeSoftMaskUpsampleCPU.
+ */
+struct COMPOSITORSHADERS_API FCompositeSoftMaskUpsampleInputs
+{
+	/** The view whose custom depth and stencil guide the upsample. */
+	const FSceneView* View = nullptr;
+
+	/** The low resolution capture, the mask in red and the linear scene depth in alpha. */
+	FRDGTextureRef SoftMaskTexture = nullptr;
+
+	/** Custom depth and stencil of the view, null upsamples bilinearly. */
+	FRDGTextureRef CustomDepthTexture = nullptr;
+	FRDGTextureSRVRef CustomStencilTexture = nullptr;
+
+	/** The output of the previous frame, null skips the temporal accumulation. Must have the size of the output. */
+	FRDGTextureRef HistoryTexture = nullptr;
+
+	/** Receives the upsampled soft mask, needs UAV support. */
+	FRDGTextureRef OutputTexture = nullptr;
+
+	/** Receives a copy of the upsampled soft mask to pass as the history of the next frame, needs UAV support. */
+	FRDGTextureRef HistoryOutputTexture = nullptr;
+
+	/** Custom stencil values at or above this are composite meshes, custom depth of everything else is ignored. */
+	int32 MinStencilValue = 248;
+
+	float DepthSigma = 0.05F;
+	float TemporalWeight = 0.5F;
+};
+
+/** Adds the soft mask upsample to the graph, does nothing when the view, soft mask or output texture is missing. */
+COMPOSITORSHADERS_API void AddCompositeSoftMaskUpsamplePass(FRDGBuilder& GraphBuilder, const FCompositeSoftMaskUpsampleInputs& Inputs);